@@ -0,0 +1,136 @@
+/**
+ * @file bench_cgroup_view.cpp
+ *
+ * Benchmarks for the cgroup view. A host running containers is simulated by a synthetic procfs
+ * tree whose processes are spread over containers, with the matching cgroup v2 counters. The usage
+ * per container is obtained either from the cgroup view (three files per container) or by rolling
+ * up the processes (`[pid]/cgroup`, `[pid]/stat` and `[pid]/status` for every process), which is
+ * what a per-process monitor has to do without cgroups.
+ */
+
+#include "bench_fixtures.h"
+#include "cgroup_view.h"
+#include "process_info.h"
+#include "resource_monitor.h"
+#include "utils.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+
+namespace
+{
+
+// Returns a synthetic host with `containers` containers and `pids` processes, generating it on first use
+SyntheticProcTree& containerHost(int containers, int pids)
+{
+    struct Cache
+    {
+        std::map<std::pair<int, int>, std::unique_ptr<SyntheticProcTree>> trees;
+        ~Cache()
+        {
+            for (auto& entry : trees)
+            {
+                entry.second->remove();
+            }
+        }
+    };
+    static Cache cache;
+
+    auto& tree = cache.trees[{containers, pids}];
+    if (!tree)
+    {
+        std::string root = "/tmp/pm_bench_containers_" + std::to_string(containers) + "_" + std::to_string(pids);
+        SyntheticProcOptions options;
+        options.pidCount = pids;
+        options.cgroupCount = containers;
+        options.cgroupRoot = root + "_cgroup";
+        tree = std::make_unique<SyntheticProcTree>(root, options);
+        tree->remove(); // Start from a clean directory in case a previous run was interrupted
+        tree->writeTick(0);
+    }
+    return *tree;
+}
+
+// Points `cgroupRoot` at another directory for the lifetime of the object
+class ScopedCgroupRoot
+{
+  public:
+    explicit ScopedCgroupRoot(const std::string& root) : m_saved(cgroupRoot)
+    {
+        cgroupRoot = root;
+    }
+
+    ~ScopedCgroupRoot()
+    {
+        cgroupRoot = m_saved;
+    }
+
+  private:
+    std::string m_saved;
+};
+
+// Usage of one container summed over its processes
+struct Rollup
+{
+    long time = 0;
+    double memoryUsage = 0;
+    uint64_t pids = 0;
+};
+
+// Reads the cgroup v2 path of a process from `[pid]/cgroup` ("0::/<path>")
+std::string readProcessCgroup(int pid)
+{
+    std::ifstream file(procFilePath(pid, "cgroup"));
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.compare(0, 4, "0::/") == 0)
+        {
+            return line.substr(4);
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+// One sample of every cgroup: list the hierarchy and read three files per cgroup
+static void BM_CgroupView_Sample(benchmark::State& state)
+{
+    SyntheticProcTree& host = containerHost(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    ScopedCgroupRoot root(host.root() + "_cgroup");
+    CgroupSampler sampler;
+    size_t cgroups = 0;
+    for (auto _ : state)
+    {
+        auto usage = sampler.sample();
+        cgroups = usage.size();
+        benchmark::DoNotOptimize(usage);
+    }
+    state.counters["cgroups"] = static_cast<double>(cgroups);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CgroupView_Sample)->Args({500, 2000})->Args({500, 10000})->Unit(benchmark::kMillisecond);
+
+// The same totals from the processes: the cgroup, CPU time and memory of every PID
+static void BM_CgroupView_PerPidRollup(benchmark::State& state)
+{
+    SyntheticProcTree& host = containerHost(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    ScopedProcRoot root(host.root());
+    size_t cgroups = 0;
+    for (auto _ : state)
+    {
+        std::unordered_map<std::string, Rollup> totals;
+        for (int pid : getProcessIds())
+        {
+            Rollup& rollup = totals[readProcessCgroup(pid)];
+            rollup.time += getProcessTotalTime(pid);
+            rollup.memoryUsage += getProcessMemoryUsage(pid);
+            rollup.pids++;
+        }
+        cgroups = totals.size();
+        benchmark::DoNotOptimize(totals);
+    }
+    state.counters["cgroups"] = static_cast<double>(cgroups);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CgroupView_PerPidRollup)->Args({500, 2000})->Args({500, 10000})->Unit(benchmark::kMillisecond);
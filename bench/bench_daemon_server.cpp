@@ -0,0 +1,132 @@
+/**
+ * @file bench_daemon_server.cpp
+ *
+ * Benchmarks for the daemon server. A server thread serves a synthetic snapshot of 10k processes
+ * on a temporary socket, and each iteration has N connected clients send one `LIST` request each
+ * and read the complete answers, so items per second are answered requests. With one snapshot and
+ * one question the answer is serialized once and then only copied to every client; the uncached
+ * variant changes the question of every request to show the cost of serialization.
+ */
+
+#include "bench_fixtures.h"
+#include "daemon_server.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+const char* kBenchSocket = "/tmp/pm_bench_daemon.sock";
+
+// Connects a blocking client to the benchmark socket
+int connectClient()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, kBenchSocket, sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads one answer ("OK <count>" and its lines); returns the bytes read, or 0 on failure
+size_t readAnswer(int fd, std::string& buffer)
+{
+    buffer.clear();
+    size_t expectedLines = 0;
+    size_t lines = 0;
+    char chunk[65536];
+    for (;;)
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return 0;
+        buffer.append(chunk, static_cast<size_t>(received));
+        if (expectedLines == 0 && buffer.find('\n') != std::string::npos)
+        {
+            expectedLines = 1 + std::strtoul(buffer.c_str() + 3, nullptr, 10);
+        }
+        for (char* p = chunk; p < chunk + received; ++p)
+        {
+            lines += *p == '\n';
+        }
+        if (expectedLines != 0 && lines >= expectedLines)
+            return buffer.size();
+    }
+}
+
+void runListRequests(benchmark::State& state, bool cached)
+{
+    processSnapshots.publish(makeSnapshot(makeSyntheticProcesses(10000), steadyNowMs(), true));
+    DaemonServer server;
+    std::string error;
+    if (!server.start(kBenchSocket, error))
+    {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    std::atomic<bool> stopRequested(false);
+    std::thread serverThread([&]() { server.serve(stopRequested); });
+
+    std::vector<int> clients;
+    for (int i = 0; i < state.range(0); ++i)
+    {
+        clients.push_back(connectClient());
+    }
+    std::string buffer;
+    size_t bytes = 0;
+    long request = 0;
+    for (auto _ : state)
+    {
+        // Uncached: every request asks for a different number of rows
+        std::string line = cached ? "LIST 100\n" : "LIST " + std::to_string(100 + request % 2) + "\n";
+        for (int fd : clients)
+        {
+            send(fd, line.data(), line.size(), 0);
+            request++;
+            if (!cached)
+                line = "LIST " + std::to_string(100 + request % 2) + "\n";
+        }
+        for (int fd : clients)
+        {
+            bytes += readAnswer(fd, buffer);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+
+    for (int fd : clients)
+    {
+        close(fd);
+    }
+    stopRequested.store(true);
+    serverThread.join();
+    server.stop();
+    processSnapshots.reset();
+}
+
+} // namespace
+
+// One question asked by N clients in the same epoch
+static void BM_Daemon_ListCached(benchmark::State& state)
+{
+    runListRequests(state, true);
+}
+BENCHMARK(BM_Daemon_ListCached)->Arg(1)->Arg(10)->Arg(100)->UseRealTime();
+
+// Alternating questions: every answer is filtered, ranked and serialized again
+static void BM_Daemon_ListUncached(benchmark::State& state)
+{
+    runListRequests(state, false);
+}
+BENCHMARK(BM_Daemon_ListUncached)->Arg(1)->Arg(10)->Arg(100)->UseRealTime();
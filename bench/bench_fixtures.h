@@ -0,0 +1,159 @@
+/**
+ * @file bench_fixtures.h
+ * @brief Synthetic fixtures shared by the benchmark suite.
+ *
+ * Live `/proc` numbers depend on whatever happens to be running on the machine, so every
+ * benchmark that does not strictly need the kernel also runs against a deterministic,
+ * generated set of processes whose size is controlled by the benchmark argument.
+ */
+
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include "globals.h"
+#include "process_info.h"
+#include "synthetic_proc.h"
+#include <map>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Builds a deterministic list of synthetic processes.
+ *
+ * @param count Number of processes to generate.
+ * @param seed Seed for the pseudo-random generator, so runs are comparable between commits.
+ * @return A vector of `count` processes with PIDs starting at 1.
+ */
+inline std::vector<Process> makeSyntheticProcesses(int count, unsigned seed = 42)
+{
+    static const char* users[] = {"root", "postgres", "www-data", "alice", "bob", "nobody"};
+    static const char* commands[] = {"systemd", "postgres", "nginx", "bash", "cc1plus", "java", "python3", "sshd"};
+
+    std::mt19937 rng(seed);
+    std::exponential_distribution<double> cpuDist(0.2);  // Most processes are idle, a few are busy
+    std::lognormal_distribution<double> memDist(3.0, 1.5); // Long tail of memory hogs
+
+    std::vector<Process> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Process process;
+        process.pid = i + 1;
+        process.user = users[rng() % (sizeof(users) / sizeof(users[0]))];
+        process.cpuUsage = cpuDist(rng);
+        process.memoryUsage = memDist(rng);
+        process.prevTotalTime = static_cast<long>(rng() % 100000);
+        process.command = commands[rng() % (sizeof(commands) / sizeof(commands[0]))];
+        result.push_back(process);
+    }
+    return result;
+}
+
+/**
+ * @brief Builds a synthetic processes map indexed by PID, as maintained by the monitor threads.
+ *
+ * @param count Number of processes to generate.
+ * @return A map of `count` synthetic processes.
+ */
+inline std::unordered_map<int, Process> makeSyntheticProcessMap(int count)
+{
+    std::unordered_map<int, Process> result;
+    for (const auto& process : makeSyntheticProcesses(count))
+    {
+        result[process.pid] = process;
+    }
+    return result;
+}
+
+/**
+ * @brief Returns a fake procfs tree with the given number of PIDs, generating it on first use.
+ *
+ * Trees are written under `/tmp` once per process and removed when the benchmark binary exits.
+ *
+ * @param pidCount Number of PIDs in the tree.
+ * @return The generator of the tree, positioned at tick 0.
+ */
+inline SyntheticProcTree& syntheticProcTree(int pidCount)
+{
+    struct Cache
+    {
+        std::map<int, std::unique_ptr<SyntheticProcTree>> trees;
+        ~Cache()
+        {
+            for (auto& entry : trees)
+            {
+                entry.second->remove();
+            }
+        }
+    };
+    static Cache cache;
+
+    auto& tree = cache.trees[pidCount];
+    if (!tree)
+    {
+        SyntheticProcOptions options;
+        options.pidCount = pidCount;
+        tree = std::make_unique<SyntheticProcTree>("/tmp/pm_bench_proc_" + std::to_string(pidCount), options);
+        tree->remove(); // Start from a clean directory in case a previous run was interrupted
+        tree->writeTick(0);
+    }
+    return *tree;
+}
+
+/**
+ * @brief Points `procRoot` at another directory for the lifetime of the object.
+ */
+class ScopedProcRoot
+{
+  public:
+    explicit ScopedProcRoot(const std::string& root) : m_saved(procRoot)
+    {
+        procRoot = root;
+    }
+
+    ~ScopedProcRoot()
+    {
+        procRoot = m_saved;
+    }
+
+  private:
+    std::string m_saved;
+};
+
+/**
+ * @brief Stream buffer that discards everything written to it.
+ */
+class NullBuffer : public std::streambuf
+{
+  protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+/**
+ * @brief Output stream that discards everything written to it.
+ */
+class NullStream : public std::ostream
+{
+  public:
+    NullStream() : std::ostream(&m_buffer)
+    {
+    }
+
+  private:
+    NullBuffer m_buffer;
+};
+
+#endif // BENCH_FIXTURES_H
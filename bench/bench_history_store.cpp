@@ -0,0 +1,159 @@
+/**
+ * @file bench_history_store.cpp
+ *
+ * Benchmarks for the compressed history store. One hour of 1-second epochs of 10k processes is
+ * generated from the profiles of the synthetic procfs generator (70% idle, steady, bursty and
+ * leaking processes) without touching the disk; the size of the resulting segments is reported per
+ * sample and extrapolated to a day. Appending an epoch runs on the CPU monitoring thread, and the
+ * point-in-time query is what `history_at` runs.
+ */
+
+#include "history_store.h"
+#include "synthetic_proc.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+
+namespace
+{
+
+const int kProcesses = 10000;
+const int kEpochs = 3600;
+
+// Start of an hour two hours ago, so retention applied when the store is opened keeps the data
+int64_t benchBaseMs()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    int64_t base = nowMs - 2 * 3600 * 1000;
+    return base - base % (3600 * 1000);
+}
+
+// Processes of the synthetic tree at a tick, with the CPU usage a 1-second monitor would compute
+void syntheticEpoch(const SyntheticProcTree& tree, long tick, std::vector<Process>& snapshot)
+{
+    double totalDelta = static_cast<double>(tree.totalTimeAt(tick) - tree.totalTimeAt(tick - 1));
+    for (auto& process : snapshot)
+    {
+        long processDelta = tree.processTimeAt(process.pid, tick) - tree.processTimeAt(process.pid, tick - 1);
+        process.cpuUsage = processDelta / totalDelta * tree.cpuCount() * 100.0;
+        process.memoryUsage = tree.rssKbAt(process.pid, tick) / 1024.0;
+    }
+}
+
+std::vector<Process> syntheticSnapshot(const SyntheticProcTree& tree)
+{
+    std::vector<Process> snapshot(kProcesses);
+    for (int i = 0; i < kProcesses; ++i)
+    {
+        snapshot[i].pid = i + 1;
+        snapshot[i].user = "uid" + std::to_string(tree.uidOf(i + 1));
+        snapshot[i].command = tree.commandOf(i + 1);
+        snapshot[i].prevTotalTime = 0;
+    }
+    return snapshot;
+}
+
+// Writes one hour of history to `directory`; returns the number of samples seen and the size of the segments
+void writeHour(const std::string& directory, uint64_t& seen, uint64_t& written)
+{
+    std::filesystem::remove_all(directory);
+    SyntheticProcOptions options;
+    options.pidCount = kProcesses;
+    options.cpuCount = 8;
+    SyntheticProcTree tree("/nonexistent", options); // Only its closed-form values are used
+    std::vector<Process> snapshot = syntheticSnapshot(tree);
+
+    HistoryStoreOptions storeOptions;
+    storeOptions.directory = directory;
+    HistoryStore store;
+    store.open(storeOptions);
+    int64_t base = benchBaseMs();
+    for (long tick = 1; tick <= kEpochs; ++tick)
+    {
+        syntheticEpoch(tree, tick, snapshot);
+        store.append(base + tick * 1000 - 1000 + (tick * 7919) % 13, snapshot); // A few ms of jitter
+    }
+    store.close();
+    seen = static_cast<uint64_t>(kProcesses) * kEpochs;
+    written = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        written += entry.file_size();
+    }
+}
+
+} // namespace
+
+// Appending one 1-second epoch of 10k processes
+static void BM_HistoryStoreAppend(benchmark::State& state)
+{
+    const std::string directory = "/tmp/pm_bench_history_append";
+    std::filesystem::remove_all(directory);
+    SyntheticProcOptions options;
+    options.pidCount = kProcesses;
+    options.cpuCount = 8;
+    SyntheticProcTree tree("/nonexistent", options);
+    std::vector<Process> snapshot = syntheticSnapshot(tree);
+
+    HistoryStoreOptions storeOptions;
+    storeOptions.directory = directory;
+    HistoryStore store;
+    store.open(storeOptions);
+    int64_t base = benchBaseMs();
+    long tick = 1;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        syntheticEpoch(tree, tick, snapshot);
+        state.ResumeTiming();
+        store.append(base + (tick % kEpochs) * 1000, snapshot);
+        tick++;
+    }
+    state.counters["written_ratio"] = static_cast<double>(store.samplesWritten()) / store.samplesSeen();
+    store.close();
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_HistoryStoreAppend)->Unit(benchmark::kMicrosecond);
+
+// Size of one hour of history for 10k processes, extrapolated to 24 hours
+static void BM_HistoryStoreHourSize(benchmark::State& state)
+{
+    const std::string directory = "/tmp/pm_bench_history_hour";
+    uint64_t seen = 0, written = 0;
+    for (auto _ : state)
+    {
+        writeHour(directory, seen, written);
+    }
+    state.counters["bytes_per_sample"] = static_cast<double>(written) / seen;
+    state.counters["MB_per_day"] = written * 24.0 / 1e6;
+    state.counters["raw_double_MB_per_day"] = seen * 24.0 * 2 * sizeof(double) / 1e6;
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_HistoryStoreHourSize)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+// Top processes at a random time inside a closed one-hour segment of 10k processes
+static void BM_HistoryStoreProcessesAt(benchmark::State& state)
+{
+    const std::string directory = "/tmp/pm_bench_history_query";
+    uint64_t seen = 0, written = 0;
+    writeHour(directory, seen, written);
+
+    HistoryStoreOptions storeOptions;
+    storeOptions.directory = directory;
+    HistoryStore store;
+    store.open(storeOptions);
+    int64_t base = benchBaseMs();
+    std::vector<Process> result;
+    long offset = 0;
+    for (auto _ : state)
+    {
+        offset = (offset + 1237) % kEpochs;
+        store.processesAt(base + offset * 1000 + 500, 2000, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.counters["processes"] = static_cast<double>(result.size());
+    store.close();
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_HistoryStoreProcessesAt)->Unit(benchmark::kMillisecond);
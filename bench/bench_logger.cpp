@@ -0,0 +1,214 @@
+/**
+ * @file bench_logger.cpp
+ *
+ * Benchmarks for the Logger. Messages are written to `/dev/null` so the numbers reflect the cost
+ * paid by the calling threads (queueing, and waiting whenever they outrun the logger thread)
+ * rather than disk speed. The producer benchmark runs with 1 to 16 threads logging at once.
+ * The message benchmarks compare a message built by concatenation with the formatted API, both
+ * when it is logged and when its level is filtered out. The file format benchmark compares text
+ * and binary logs, and the rotation benchmark shows what rotating and gzipping files costs.
+ */
+
+#include "log_rotation.h"
+#include "logger.h"
+#include <sys/stat.h>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+
+// Number of write system calls made by this process so far (`syscw` of /proc/self/io)
+uint64_t writeSyscalls()
+{
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while (io >> key >> value)
+    {
+        if (key == "syscw:")
+            return value;
+    }
+    return 0;
+}
+
+} // namespace
+
+// Throughput of Logger::log() on the caller's thread, with one or more producers
+static void BM_LoggerLog(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        Logger::getInstance().start("/dev/null");
+    }
+    const std::string message = "Failed to open /proc/12345/stat";
+    for (auto _ : state)
+    {
+        Logger::getInstance().log(LogLevel::ERROR, message);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        Logger::getInstance().stop();
+    }
+}
+BENCHMARK(BM_LoggerLog)->ThreadRange(1, 16)->UseRealTime();
+
+// Cost of Logger::log() when logging is not active
+static void BM_LoggerLog_Inactive(benchmark::State& state)
+{
+    const std::string message = "Failed to open /proc/12345/stat";
+    for (auto _ : state)
+    {
+        Logger::getInstance().log(LogLevel::ERROR, message);
+    }
+}
+BENCHMARK(BM_LoggerLog_Inactive);
+
+// Cost on the caller's thread of a message with a path and two numbers. Arguments: formatted API
+// (1) or concatenation (0), and message logged (1) or below the minimum level (0)
+static void BM_LoggerLog_Message(benchmark::State& state)
+{
+    bool formatted = state.range(0) != 0;
+    Logger& logger = Logger::getInstance();
+    logger.start("/dev/null");
+    logger.setMinLevel(state.range(1) != 0 ? LogLevel::INFO : LogLevel::ERROR);
+    const std::string path = "/proc/12345/stat";
+    int pid = 12345;
+    double usage = 12.5;
+    for (auto _ : state)
+    {
+        if (formatted)
+            logger.warning("Failed to read {} of PID {} at {}% CPU", path, pid, usage);
+        else
+            logger.warning("Failed to read " + path + " of PID " + std::to_string(pid) + " at " +
+                           std::to_string(usage) + "% CPU");
+    }
+    logger.stop();
+    logger.setMinLevel(LogLevel::INFO);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLog_Message)->ArgsProduct({{0, 1}, {1, 0}});
+
+// Messages per second written to a file by one thread, from the first log() to the end of stop(),
+// and the write and fdatasync system calls they cost. Arguments: messages per write and sync interval
+static void BM_LoggerThroughput(benchmark::State& state)
+{
+    const int messages = 100000;
+    const std::string path = "/tmp/pm_bench_logger_" + std::to_string(getpid()) + ".log";
+    const std::string message = "Failed to open /proc/12345/stat";
+    LogFlushPolicy policy;
+    policy.maxMessages = static_cast<size_t>(state.range(0));
+    policy.syncIntervalMs = static_cast<int>(state.range(1));
+    Logger::getInstance().setFlushPolicy(policy);
+    uint64_t writes = 0;
+    LogStats before = Logger::getInstance().stats();
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::remove(path.c_str());
+        Logger::getInstance().start(path);
+        uint64_t syscallsBefore = writeSyscalls();
+        state.ResumeTiming();
+
+        for (int i = 0; i < messages; ++i)
+        {
+            Logger::getInstance().log(LogLevel::ERROR, message);
+        }
+        Logger::getInstance().stop();
+
+        state.PauseTiming();
+        writes += writeSyscalls() - syscallsBefore;
+        state.ResumeTiming();
+    }
+    LogStats after = Logger::getInstance().stats();
+    Logger::getInstance().setFlushPolicy(LogFlushPolicy());
+    std::remove(path.c_str());
+
+    double total = static_cast<double>(state.iterations() * messages);
+    state.SetItemsProcessed(state.iterations() * messages);
+    state.counters["writes_per_message"] = static_cast<double>(writes) / total; // Counted by the kernel
+    state.counters["syncs_per_message"] = static_cast<double>(after.syncCalls - before.syncCalls) / total;
+}
+BENCHMARK(BM_LoggerThroughput)
+    ->Args({1, 0})
+    ->Args({256, 0})
+    ->Args({256, 10})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Messages per second and bytes per message of a mix of typical messages, in text (0) or binary (1)
+static void BM_LoggerFileFormat(benchmark::State& state)
+{
+    const int messages = 100000;
+    const std::string path = "/tmp/pm_bench_logger_" + std::to_string(getpid()) + ".log";
+    LogFormat format = state.range(0) != 0 ? LogFormat::Binary : LogFormat::Text;
+    const std::string statPath = "/proc/12345/stat";
+    off_t bytes = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::remove(path.c_str());
+        Logger::getInstance().start(path, format);
+        state.ResumeTiming();
+
+        for (int i = 0; i < messages; i += 4)
+        {
+            Logger::getInstance().error("Failed to open {} of PID {pid}", statPath, 12345 + i);
+            Logger::getInstance().info("Daemon client killed process {pid}.", 12345 + i);
+            Logger::getInstance().info("Stream mode stopped after {} epochs and {} records.", i, 50 * i);
+            Logger::getInstance().warning("Unable to find username for UID: {}", 1000 + i % 7);
+        }
+        Logger::getInstance().stop();
+
+        state.PauseTiming();
+        struct stat status;
+        bytes = stat(path.c_str(), &status) == 0 ? status.st_size : 0;
+        state.ResumeTiming();
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * messages);
+    state.counters["bytes_per_message"] = static_cast<double>(bytes) / messages;
+}
+BENCHMARK(BM_LoggerFileFormat)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Messages per second written by one thread while the file rotates every `range(0)` bytes (0: never),
+// from the first log() to the end of stop(), which waits for the rotated files to be gzipped
+static void BM_LoggerRotation(benchmark::State& state)
+{
+    const int messages = 200000;
+    const std::string path = "/tmp/pm_bench_logger_" + std::to_string(getpid()) + ".log";
+    const std::string statPath = "/proc/12345/stat";
+    LogRotationPolicy policy;
+    policy.maxBytes = static_cast<uint64_t>(state.range(0));
+    policy.keep = 2;
+    Logger::getInstance().setRotationPolicy(policy);
+    LogStats before = Logger::getInstance().stats();
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::remove(path.c_str());
+        Logger::getInstance().start(path);
+        state.ResumeTiming();
+
+        for (int i = 0; i < messages; ++i)
+        {
+            Logger::getInstance().error("Failed to open {} of PID {pid}", statPath, 12345 + i);
+        }
+        Logger::getInstance().stop();
+    }
+    LogStats after = Logger::getInstance().stats();
+    Logger::getInstance().setRotationPolicy(LogRotationPolicy());
+    std::remove(path.c_str());
+    for (const std::string& rotated : listRotatedLogs(path))
+    {
+        std::remove(rotated.c_str());
+    }
+    state.SetItemsProcessed(state.iterations() * messages);
+    state.counters["rotations"] =
+        benchmark::Counter(static_cast<double>(after.rotations - before.rotations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_LoggerRotation)->Arg(0)->Arg(1 << 20)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+/**
+ * @file bench_metrics_server.cpp
+ *
+ * Benchmarks for the Prometheus endpoint with a synthetic snapshot of 10k processes: the rendering
+ * done once per epoch, and scrapes over a persistent local connection, which are served from the
+ * rendered response without rendering again.
+ */
+
+#include "bench_fixtures.h"
+#include "metrics_server.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+// Rendering of one epoch; the argument is the number of processes exported per ranking
+static void BM_RenderMetrics(benchmark::State& state)
+{
+    auto snapshot = makeSnapshot(makeSyntheticProcesses(10000), 0, true);
+    FrameBuffer buffer(256 * 1024);
+    for (auto _ : state)
+    {
+        buffer.clear();
+        renderMetrics(buffer, *snapshot, static_cast<size_t>(state.range(0)), 1700000000000);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 10000);
+    state.counters["bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK(BM_RenderMetrics)->Arg(50)->Arg(10000);
+
+// One scrape of a cached epoch per iteration
+static void BM_MetricsScrape(benchmark::State& state)
+{
+    processSnapshots.publish(makeSnapshot(makeSyntheticProcesses(10000), steadyNowMs(), true));
+    MetricsServer server(50);
+    std::string error;
+    if (!server.start("127.0.0.1:0", error))
+    {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    std::atomic<bool> stop(false);
+    std::thread serverThread([&]() { server.serve(stop); });
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(server.port()));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+    const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string response;
+    char chunk[65536];
+    for (auto _ : state)
+    {
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        response.clear();
+        size_t expected = std::string::npos;
+        while (expected == std::string::npos || response.size() < expected)
+        {
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0)
+                break;
+            response.append(chunk, static_cast<size_t>(received));
+            size_t headEnd = response.find("\r\n\r\n");
+            if (expected == std::string::npos && headEnd != std::string::npos)
+            {
+                size_t lengthAt = response.find("Content-Length: ");
+                expected = headEnd + 4 + std::stoul(response.substr(lengthAt + 16));
+            }
+        }
+    }
+    state.counters["renders"] = static_cast<double>(server.renderCount());
+
+    close(fd);
+    stop.store(true);
+    serverThread.join();
+    server.stop();
+    processSnapshots.reset();
+}
+BENCHMARK(BM_MetricsScrape);
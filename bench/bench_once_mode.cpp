@@ -0,0 +1,36 @@
+/**
+ * @file bench_once_mode.cpp
+ *
+ * Benchmarks for the one-shot mode. Each iteration is a complete `--once --top 20 --sort memory`
+ * run against a synthetic procfs tree (two scans, selection and the table written to /dev/null),
+ * with a 1 ms window so that the numbers reflect the work done rather than the sleep between the
+ * scans. The end-to-end runtime of the program is this plus `--window` and process startup.
+ */
+
+#include "bench_fixtures.h"
+#include "once_mode.h"
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// One-shot run on a synthetic procfs tree with N PIDs
+static void BM_OnceMode_Synthetic(benchmark::State& state)
+{
+    ScopedProcRoot root(syntheticProcTree(static_cast<int>(state.range(0))).root());
+    CliOptions options;
+    options.once = true;
+    options.windowMs = 1;
+    options.top = 20;
+    options.sortBy = "memory";
+    int fd = open("/dev/null", O_WRONLY);
+    for (auto _ : state)
+    {
+        if (runOnceMode(options, fd) != 0)
+        {
+            state.SkipWithError("write to /dev/null failed");
+            break;
+        }
+    }
+    close(fd);
+}
+BENCHMARK(BM_OnceMode_Synthetic)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
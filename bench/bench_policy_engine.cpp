@@ -0,0 +1,95 @@
+/**
+ * @file bench_policy_engine.cpp
+ *
+ * Benchmarks for the policy engine, which the sampling loops run after every epoch. Rules are
+ * evaluated against synthetic epochs of N processes whose usage changes between epochs. The mixed
+ * set spreads CPU and memory thresholds over the range of the processes and tests users, so a
+ * fraction of them matches each rule; the worst case has every rule match every process, so the state of each rule
+ * holds all of them.
+ */
+
+#include "bench_fixtures.h"
+#include "policy_engine.h"
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+// `count` rules with holds long enough that they keep state without firing
+std::vector<PolicyRule> makeRules(int count, bool matchAll)
+{
+    static const char* users[] = {"root", "postgres", "www-data", "alice", "bob", "nobody"};
+    std::vector<PolicyRule> rules;
+    for (int i = 0; i < count; ++i)
+    {
+        std::string text;
+        if (matchAll)
+            text = "cpu >= 0 and user != daemon for 1h -> alert";
+        else if (i % 3 == 0)
+            text = "cpu > " + std::to_string(5 + i % 90) + " and user != " + users[i % 6] + " for 30s -> term, alert";
+        else if (i % 3 == 1)
+            text = "memory > " + std::to_string(50 * (1 + i % 40)) + " for 5m -> renice 10, alert";
+        else
+            text = "user == " + std::string(users[i % 6]) + " and cpu >= " + std::to_string(i % 50) +
+                   " for 1h -> alert";
+
+        PolicyRule rule;
+        std::string error;
+        parsePolicyRule(text, rule, error);
+        rules.push_back(rule);
+    }
+    return rules;
+}
+
+void runEvaluate(benchmark::State& state, bool matchAll)
+{
+    ProcessSnapshot snapshot;
+    snapshot.processes = makeSyntheticProcesses(static_cast<int>(state.range(1)));
+    PolicyEngine engine;
+    engine.setRules(makeRules(static_cast<int>(state.range(0)), matchAll));
+
+    std::vector<PolicyFiring> firings;
+    int64_t nowMs = 0;
+    size_t epoch = 0;
+    for (auto _ : state)
+    {
+        // ~10% of the processes change between epochs, as in the sampling loop, alternately rising
+        // and falling back so the usage stays within its range
+        for (size_t i = epoch % 10; i < snapshot.processes.size(); i += 10)
+        {
+            snapshot.processes[i].cpuUsage *= epoch / 10 % 2 == 0 ? 1.5 : 1 / 1.5;
+        }
+        engine.evaluate(snapshot, nowMs, firings);
+        nowMs += 1000;
+        epoch++;
+    }
+
+    size_t matching = 0;
+    for (const PolicyRuleStatus& rule : engine.status())
+    {
+        matching += rule.matching;
+    }
+    state.counters["matching"] = static_cast<double>(matching);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+} // namespace
+
+// 100 rules with thresholds across the range of the processes; one rule is the cost of the pass over
+// the processes
+static void BM_PolicyEngine_Evaluate(benchmark::State& state)
+{
+    runEvaluate(state, false);
+}
+BENCHMARK(BM_PolicyEngine_Evaluate)
+    ->Args({1, 10000})
+    ->Args({100, 1000})
+    ->Args({100, 10000})
+    ->Unit(benchmark::kMicrosecond);
+
+// 100 rules matching every process
+static void BM_PolicyEngine_EvaluateAllMatch(benchmark::State& state)
+{
+    runEvaluate(state, true);
+}
+BENCHMARK(BM_PolicyEngine_EvaluateAllMatch)->Args({100, 10000})->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,115 @@
+/**
+ * @file bench_process_control.cpp
+ *
+ * Benchmarks for the Process Control module: a kill storm of N sleeping children signalled by
+ * `signalProcesses()` (pidfd, start time check, pidfd signal) with one thread or with the default
+ * number, against the plain `kill()` loop the group kills used to run while holding `processMutex`,
+ * and graceful terminations of N children by the TerminationManager thread, from the request to the
+ * report. Items per second are processes; forking and reaping the children is not timed.
+ */
+
+#include "process_control.h"
+#include "process_info.h"
+#include "termination_manager.h"
+#include <benchmark/benchmark.h>
+#include <future>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// Forks `count` children that wait for a signal, ignoring SIGTERM if asked
+std::vector<KillTarget> spawnSleepers(int count, bool ignoreTerm = false)
+{
+    std::vector<KillTarget> targets;
+    targets.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            if (ignoreTerm)
+                signal(SIGTERM, SIG_IGN);
+            for (;;)
+                pause();
+        }
+        KillTarget target{pid};
+        readProcessStartTime(pid, target.startTime);
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+void reap(const std::vector<KillTarget>& targets)
+{
+    for (const KillTarget& target : targets)
+    {
+        waitpid(target.pid, nullptr, 0);
+    }
+}
+
+} // namespace
+
+// signalProcesses() on N children; range(1) is the number of threads, 0 for the default
+static void BM_SignalProcesses(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<KillTarget> targets = spawnSleepers(static_cast<int>(state.range(0)));
+        state.ResumeTiming();
+        KillReport report = signalProcesses(targets, SIGKILL, static_cast<size_t>(state.range(1)));
+        benchmark::DoNotOptimize(report.results.data());
+        state.PauseTiming();
+        reap(targets);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SignalProcesses)->ArgsProduct({{1000, 4000}, {1, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The former loop: kill() on each PID, without checking that it still names the sampled process
+static void BM_KillLoop(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<KillTarget> targets = spawnSleepers(static_cast<int>(state.range(0)));
+        state.ResumeTiming();
+        for (const KillTarget& target : targets)
+        {
+            benchmark::DoNotOptimize(kill(target.pid, SIGKILL));
+        }
+        state.PauseTiming();
+        reap(targets);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KillLoop)->Arg(1000)->Arg(4000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// TerminationManager on N children; range(1) is 1 if they ignore SIGTERM and are killed after a
+// 100 ms grace period, 0 if SIGTERM ends them
+static void BM_TerminateGracefully(benchmark::State& state)
+{
+    bool ignoreTerm = state.range(1) != 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<KillTarget> targets = spawnSleepers(static_cast<int>(state.range(0)), ignoreTerm);
+        usleep(100000); // Let the children install their handlers
+        std::promise<void> done;
+        state.ResumeTiming();
+        TerminationManager::getInstance().terminate(targets, ignoreTerm ? 100 : 60000,
+                                                    [&done](const KillReport&) { done.set_value(); });
+        done.get_future().wait();
+        state.PauseTiming();
+        reap(targets);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TerminateGracefully)->ArgsProduct({{1000, 4000}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
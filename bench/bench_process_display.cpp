@@ -0,0 +1,184 @@
+/**
+ * @file bench_process_display.cpp
+ *
+ * Benchmarks for the Process Display module. The table is rendered into a stream that discards
+ * its input, so the numbers reflect formatting cost rather than terminal speed. The frame
+ * benchmarks compare a full redraw (clear screen + printProcesses) with the diff-based screen
+ * renderer on a steady table in which about 10% of the rows change per frame, and report the
+ * bytes that would be sent to the terminal. The table benchmarks compare the former iostream
+ * formatter (setw/fixed/endl, one flush per line) with the FrameBuffer path (std::to_chars, one
+ * write per table), both writing to /dev/null, and report the write system calls per table.
+ */
+
+#include "bench_fixtures.h"
+#include "process_display.h"
+#include "resource_monitor.h"
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+
+/**
+ * @brief File buffer counting its flushes; each flush of pending data is one write system call.
+ */
+class CountingFileBuf : public std::filebuf
+{
+  public:
+    size_t syncs = 0;
+
+  protected:
+    int sync() override
+    {
+        syncs++;
+        return std::filebuf::sync();
+    }
+};
+
+// The table formatter as it was before FrameBuffer, kept verbatim as the baseline
+void legacyPrintProcesses(const std::vector<Process>& processes, std::ostream& out)
+{
+    out << std::setw(8) << "PID"
+              << " | " << std::left << std::setw(14) << "User"
+              << " | " << std::setw(9) << "CPU (%)"
+              << " | " << std::setw(16) << "Memory (MB)"
+              << " | "
+              << "Command" << std::endl;
+    out << std::string(100, '=') << std::endl;
+
+    int count = 0;
+    for (const auto& process : processes)
+    {
+        if (count >= 30)
+            break;
+
+        std::string color;
+        if (process.cpuUsage > 20.0)
+        {
+            color = "\033[31m";
+        }
+        else if (process.cpuUsage > 10.0)
+        {
+            color = "\033[33m";
+        }
+        else
+        {
+            color = "\033[32m";
+        }
+
+        std::string command = process.command;
+        if (command.length() > 35)
+        {
+            command = command.substr(0, 32) + "...";
+        }
+
+        out << std::setw(8) << process.pid << " | " << std::left << std::setw(14) << process.user << " | "
+                  << color << std::setw(8) << std::fixed << std::setprecision(2) << process.cpuUsage << "%" << "\033[0m"
+                  << " | " << std::setw(13) << std::fixed << std::setprecision(2) << process.memoryUsage << " MB | "
+                  << command << std::endl;
+
+        count++;
+    }
+}
+
+// Changes the usage of ~10% of the processes, then re-sorts them like the display thread
+void churnProcesses(std::vector<Process>& processes, size_t frame)
+{
+    for (size_t i = frame % 10; i < processes.size(); i += 10)
+    {
+        processes[i].cpuUsage = static_cast<double>((frame * 7 + i * 13) % 4000) / 100.0;
+        processes[i].memoryUsage += 0.25;
+    }
+    sortProcesses(processes, "cpu");
+}
+
+} // namespace
+
+// Rendering a full table (the display is capped at 30 rows) to a null sink
+static void BM_PrintProcesses_NullSink(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    NullStream sink;
+    for (auto _ : state)
+    {
+        printProcesses(processes, sink);
+    }
+}
+BENCHMARK(BM_PrintProcesses_NullSink)->Arg(10)->Arg(30)->Arg(10000);
+
+// Former table output: iostream formatting with a flush per line, to /dev/null
+static void BM_Table_LegacyIostream(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    CountingFileBuf buffer;
+    buffer.open("/dev/null", std::ios::out);
+    std::ostream out(&buffer);
+    size_t tables = 0;
+    for (auto _ : state)
+    {
+        legacyPrintProcesses(processes, out);
+        tables++;
+    }
+    state.counters["writes_per_table"] = static_cast<double>(buffer.syncs) / tables;
+}
+BENCHMARK(BM_Table_LegacyIostream)->Arg(30);
+
+// Current table output: std::to_chars into a reused FrameBuffer and a single write, to /dev/null
+static void BM_Table_FrameBuffer(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    int fd = open("/dev/null", O_WRONLY);
+    FrameBuffer frame;
+    size_t tables = 0;
+    for (auto _ : state)
+    {
+        frame.clear();
+        formatProcessTable(processes, frame);
+        frame.writeTo(fd);
+        tables++;
+    }
+    close(fd);
+    state.counters["writes_per_table"] = 1.0;
+}
+BENCHMARK(BM_Table_FrameBuffer)->Arg(30);
+
+// Full redraw of every frame, as done before the screen renderer
+static void BM_Frame_FullRedraw(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    std::ostringstream out;
+    size_t frame = 0, bytes = 0;
+    for (auto _ : state)
+    {
+        churnProcesses(processes, frame++);
+        out.str("");
+        out << "\033[2J\033[H";
+        printProcesses(processes, out);
+        bytes += out.tellp();
+    }
+    state.counters["bytes_per_frame"] = static_cast<double>(bytes) / frame;
+}
+BENCHMARK(BM_Frame_FullRedraw)->Arg(30)->Arg(1000);
+
+// Diff-based rendering: only changed cells are emitted
+static void BM_Frame_ScreenRenderer(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    ScreenRenderer screen(32, 100);
+    FrameBuffer out;
+    size_t frame = 0, bytes = 0;
+    for (auto _ : state)
+    {
+        churnProcesses(processes, frame++);
+        out.clear();
+        screen.beginFrame();
+        composeProcessTable(processes, screen);
+        bytes += screen.render(out);
+    }
+    state.counters["bytes_per_frame"] = static_cast<double>(bytes) / frame;
+}
+BENCHMARK(BM_Frame_ScreenRenderer)->Arg(30)->Arg(1000);
@@ -0,0 +1,64 @@
+/**
+ * @file bench_process_history.cpp
+ *
+ * Benchmarks for the per-process history. Recording an epoch runs on the CPU monitoring thread
+ * after every scan, so its cost is compared with the cost of the scan itself (see
+ * bench_process_info.cpp). The second benchmark churns PIDs so that every epoch evicts rings.
+ */
+
+#include "bench_fixtures.h"
+#include "process_history.h"
+#include <benchmark/benchmark.h>
+
+// Recording epochs of N long-lived processes, ~10% of which change between epochs
+static void BM_ProcessHistoryRecordEpoch(benchmark::State& state)
+{
+    auto snapshot = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    std::vector<HistoryUpdate> updates;
+    for (const auto& process : snapshot)
+    {
+        updates.push_back({process.pid, process.cpuUsage, process.memoryUsage});
+    }
+
+    ProcessHistory history;
+    size_t epoch = 0;
+    for (auto _ : state)
+    {
+        for (size_t i = epoch % 10; i < updates.size(); i += 10)
+        {
+            updates[i].cpuUsage += 0.5;
+        }
+        history.recordEpoch(updates);
+        epoch++;
+    }
+    state.counters["tracked"] = static_cast<double>(history.trackedCount());
+    state.SetItemsProcessed(state.iterations() * updates.size());
+}
+BENCHMARK(BM_ProcessHistoryRecordEpoch)->Arg(1000)->Arg(10000);
+
+// Recording epochs where 5% of the processes are replaced by new PIDs, with a full history
+static void BM_ProcessHistoryChurn(benchmark::State& state)
+{
+    const int count = static_cast<int>(state.range(0));
+    std::vector<HistoryUpdate> updates;
+    for (int i = 0; i < count; ++i)
+    {
+        updates.push_back({i + 1, 1.0, 10.0});
+    }
+
+    // Budget for roughly half of the processes so every new PID evicts a ring
+    ProcessHistory history(count / 2 * (120 * sizeof(HistorySample) + 64), 120);
+    int nextPid = count + 1;
+    size_t epoch = 0;
+    for (auto _ : state)
+    {
+        for (size_t i = epoch % 20; i < updates.size(); i += 20)
+        {
+            updates[i].pid = nextPid++;
+        }
+        history.recordEpoch(updates);
+        epoch++;
+    }
+    state.counters["evictions"] = static_cast<double>(history.evictions());
+}
+BENCHMARK(BM_ProcessHistoryChurn)->Arg(10000);
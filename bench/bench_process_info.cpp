@@ -0,0 +1,62 @@
+/**
+ * @file bench_process_info.cpp
+ *
+ * Benchmarks for the Process Info module. These measure the cost of scanning the `/proc`
+ * filesystem and of the per-PID readers used by the monitoring threads, both on the live system
+ * and on synthetic procfs trees of increasing size.
+ */
+
+#include "bench_fixtures.h"
+#include "process_info.h"
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+// Full scan of the live /proc filesystem
+static void BM_GetActiveProcesses_Live(benchmark::State& state)
+{
+    size_t count = 0;
+    for (auto _ : state)
+    {
+        auto processes = getActiveProcesses();
+        count = processes.size();
+        benchmark::DoNotOptimize(processes);
+    }
+    state.counters["processes"] = static_cast<double>(count);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_GetActiveProcesses_Live)->Unit(benchmark::kMillisecond);
+
+// Full scan of a synthetic procfs tree with N PIDs
+static void BM_GetActiveProcesses_Synthetic(benchmark::State& state)
+{
+    ScopedProcRoot root(syntheticProcTree(static_cast<int>(state.range(0))).root());
+    for (auto _ : state)
+    {
+        auto processes = getActiveProcesses();
+        benchmark::DoNotOptimize(processes);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetActiveProcesses_Synthetic)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// Reading VmRSS from /proc/self/status
+static void BM_GetProcessMemoryUsage_Live(benchmark::State& state)
+{
+    int pid = getpid();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getProcessMemoryUsage(pid));
+    }
+}
+BENCHMARK(BM_GetProcessMemoryUsage_Live);
+
+// Reading VmRSS from a synthetic process
+static void BM_GetProcessMemoryUsage_Synthetic(benchmark::State& state)
+{
+    ScopedProcRoot root(syntheticProcTree(1000).root());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getProcessMemoryUsage(500));
+    }
+}
+BENCHMARK(BM_GetProcessMemoryUsage_Synthetic);
@@ -0,0 +1,101 @@
+/**
+ * @file bench_process_tree.cpp
+ *
+ * Benchmarks for the process tree. The CPU monitoring thread updates the tree after every scan, so
+ * an incremental update where ~1% of the processes change is compared with building the tree again
+ * from the same epoch. The layout is what the display thread pays per frame in tree mode.
+ */
+
+#include "bench_fixtures.h"
+#include "process_tree.h"
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+// N processes with parents: a few hundred under init, the others in chains of forks below them
+std::vector<Process> makeProcessForest(int count)
+{
+    std::vector<Process> processes = makeSyntheticProcesses(count);
+    std::mt19937 rng(7);
+    for (Process& process : processes)
+    {
+        process.startTime = 1;
+        if (process.pid > 1)
+            process.ppid = rng() % 20 == 0 ? 1 : 1 + static_cast<int>(rng() % static_cast<unsigned>(process.pid - 1));
+    }
+    return processes;
+}
+
+// Changes the usage of ~1% of the processes and replaces ~0.1% of them by new children
+void churn(std::vector<Process>& processes, std::mt19937& rng, int& nextPid)
+{
+    for (size_t i = 0; i < processes.size() / 100; ++i)
+    {
+        processes[rng() % processes.size()].cpuUsage += 0.5;
+    }
+    for (size_t i = 0; i < processes.size() / 1000; ++i)
+    {
+        Process& process = processes[1 + rng() % (processes.size() - 1)];
+        process.ppid = processes[rng() % processes.size()].pid;
+        process.pid = nextPid++;
+    }
+}
+
+} // namespace
+
+// Incremental update of a tree of N processes, ~1% of which change per epoch
+static void BM_ProcessTree_Update(benchmark::State& state)
+{
+    std::vector<Process> processes = makeProcessForest(static_cast<int>(state.range(0)));
+    std::mt19937 rng(42);
+    int nextPid = static_cast<int>(processes.size()) + 1;
+
+    ProcessTree tree;
+    tree.update(processes);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        churn(processes, rng, nextPid);
+        state.ResumeTiming();
+        tree.update(processes);
+    }
+    state.counters["processes"] = static_cast<double>(tree.size());
+    state.SetItemsProcessed(state.iterations() * processes.size());
+}
+BENCHMARK(BM_ProcessTree_Update)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// The same epochs, with the tree built from scratch each time
+static void BM_ProcessTree_Rebuild(benchmark::State& state)
+{
+    std::vector<Process> processes = makeProcessForest(static_cast<int>(state.range(0)));
+    std::mt19937 rng(42);
+    int nextPid = static_cast<int>(processes.size()) + 1;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        churn(processes, rng, nextPid);
+        state.ResumeTiming();
+        ProcessTree tree;
+        tree.update(processes);
+        benchmark::DoNotOptimize(tree);
+    }
+    state.SetItemsProcessed(state.iterations() * processes.size());
+}
+BENCHMARK(BM_ProcessTree_Rebuild)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// One frame of the tree view: the rows that fit on a screen, siblings sorted by subtree CPU usage
+static void BM_ProcessTree_Layout(benchmark::State& state)
+{
+    ProcessTree tree;
+    tree.update(makeProcessForest(static_cast<int>(state.range(0))));
+    std::vector<Process> rows;
+    for (auto _ : state)
+    {
+        tree.layout("cpu", {"", ""}, 50, rows);
+        benchmark::DoNotOptimize(rows);
+    }
+    state.SetItemsProcessed(state.iterations() * rows.size());
+}
+BENCHMARK(BM_ProcessTree_Layout)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,149 @@
+/**
+ * @file bench_resource_monitor.cpp
+ *
+ * Benchmarks for the Resource Monitor module: the per-PID CPU time reader (also for a process that
+ * exited, which the log only counts), the CPU usage calculation and the filter/sort step performed
+ * by `monitorProcesses()` on every refresh, with a full sort and with the top-K selection used by
+ * the display, and a display tick rendering from interpolated snapshots.
+ */
+
+#include "bench_fixtures.h"
+#include "logger.h"
+#include "resource_monitor.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reading utime/stime/cutime/cstime from /proc/self/stat
+static void BM_GetProcessTotalTime_Live(benchmark::State& state)
+{
+    int pid = getpid();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getProcessTotalTime(pid));
+    }
+}
+BENCHMARK(BM_GetProcessTotalTime_Live);
+
+// Reading utime/stime/cutime/cstime from a synthetic process
+static void BM_GetProcessTotalTime_Synthetic(benchmark::State& state)
+{
+    ScopedProcRoot root(syntheticProcTree(1000).root());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getProcessTotalTime(500));
+    }
+}
+BENCHMARK(BM_GetProcessTotalTime_Synthetic);
+
+// Reading the CPU time of a PID that no longer exists, with the Logger writing to a file: reports
+// the log bytes written per read
+static void BM_GetProcessTotalTime_Vanished(benchmark::State& state)
+{
+    std::string path = "/tmp/pm_bench_vanished_" + std::to_string(getpid()) + ".log";
+    std::remove(path.c_str());
+    Logger::getInstance().start(path);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getProcessTotalTime(999999999));
+    }
+    Logger::getInstance().stop();
+    struct stat status;
+    double bytes = stat(path.c_str(), &status) == 0 ? static_cast<double>(status.st_size) : 0.0;
+    state.counters["log_bytes_per_read"] = bytes / static_cast<double>(state.iterations());
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_GetProcessTotalTime_Vanished);
+
+// Reading the aggregate CPU line of /proc/stat
+static void BM_GetTotalCpuTime_Live(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getTotalCpuTime());
+    }
+}
+BENCHMARK(BM_GetTotalCpuTime_Live);
+
+// CPU usage percentage for a batch of synthetic time deltas
+static void BM_CalculateCpuUsage(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        double sum = 0.0;
+        for (const auto& process : processes)
+        {
+            sum += calculateCpuUsage(process.prevTotalTime % 500, 400 * 8, 8);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CalculateCpuUsage)->Arg(1000)->Arg(10000);
+
+// Filter + sort step of monitorProcesses() on a synthetic processes map
+static void BM_FilterAndSort(benchmark::State& state, std::pair<std::string, std::string> filter, std::string sortBy)
+{
+    auto processMap = makeSyntheticProcessMap(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        auto selected = filterProcesses(processMap, filter);
+        sortProcesses(selected, sortBy);
+        benchmark::DoNotOptimize(selected);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_FilterAndSort, NoFilter_Cpu, std::make_pair(std::string("none"), std::string("")),
+                  std::string("cpu"))
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000);
+BENCHMARK_CAPTURE(BM_FilterAndSort, User_Memory, std::make_pair(std::string("user"), std::string("postgres")),
+                  std::string("memory"))
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000);
+BENCHMARK_CAPTURE(BM_FilterAndSort, Cpu_Cpu, std::make_pair(std::string("cpu"), std::string("5")), std::string("cpu"))
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000);
+
+// Filter + top-K selection as done by the display, which only sorts one screen of rows
+static void BM_FilterAndSelectTop(benchmark::State& state)
+{
+    auto processMap = makeSyntheticProcessMap(static_cast<int>(state.range(0)));
+    const size_t visibleRows = static_cast<size_t>(state.range(1));
+    for (auto _ : state)
+    {
+        auto selected = filterProcesses(processMap, {"none", ""});
+        sortProcesses(selected, "cpu", visibleRows);
+        benchmark::DoNotOptimize(selected);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FilterAndSelectTop)->Args({10000, 30})->Args({10000, 60})->Args({100000, 60});
+
+// One display tick between two epochs: interpolation, filter and top-K selection of a snapshot
+static void BM_DisplayTick(benchmark::State& state)
+{
+    auto first = makeSyntheticProcesses(static_cast<int>(state.range(0)), 1);
+    auto second = makeSyntheticProcesses(static_cast<int>(state.range(0)), 2);
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        second[i].command = first[i].command; // Same programs, new usage
+    }
+    auto previous = makeSnapshot(first, 0, true);
+    auto latest = makeSnapshot(second, 2000, true);
+    std::vector<Process> shown;
+    for (auto _ : state)
+    {
+        interpolateSnapshots(*previous, *latest, 0.5, shown);
+        auto selected = filterProcesses(shown, {"none", ""});
+        sortProcesses(selected, "cpu", 60);
+        benchmark::DoNotOptimize(selected);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DisplayTick)->Arg(1000)->Arg(10000);
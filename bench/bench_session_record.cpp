@@ -0,0 +1,70 @@
+/**
+ * @file bench_session_record.cpp
+ *
+ * Benchmarks for session recording. Appending an epoch runs on the CPU monitoring thread, so its
+ * cost is compared with the cost of the scan it records (see bench_process_info.cpp); the size of
+ * delta frames is reported as a counter.
+ */
+
+#include "bench_fixtures.h"
+#include "session_record.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+
+// Appending epochs of N processes in which ~10% of the processes change between epochs
+static void BM_SessionRecorderAppend(benchmark::State& state)
+{
+    const std::string path = "/tmp/pm_bench_session.pmrec";
+    std::remove(path.c_str());
+    auto snapshot = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+
+    SessionRecorder recorder;
+    recorder.open(path);
+    int64_t timestamp = 0;
+    size_t epoch = 0;
+    for (auto _ : state)
+    {
+        for (size_t i = epoch % 10; i < snapshot.size(); i += 10)
+        {
+            snapshot[i].cpuUsage += 0.5;
+        }
+        recorder.append(timestamp += 1000, snapshot);
+        epoch++;
+    }
+    state.counters["bytes_per_epoch"] = static_cast<double>(recorder.bytesWritten()) / recorder.framesWritten();
+    recorder.close();
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SessionRecorderAppend)->Arg(1000)->Arg(10000);
+
+// Decoding epochs sequentially, as done by the replay thread
+static void BM_SessionReaderSequential(benchmark::State& state)
+{
+    const std::string path = "/tmp/pm_bench_session_read.pmrec";
+    std::remove(path.c_str());
+    auto snapshot = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    {
+        SessionRecorder recorder;
+        recorder.open(path);
+        for (int epoch = 0; epoch < 128; ++epoch)
+        {
+            for (size_t i = epoch % 10; i < snapshot.size(); i += 10)
+            {
+                snapshot[i].cpuUsage += 0.5;
+            }
+            recorder.append(epoch * 1000, snapshot);
+        }
+    }
+
+    SessionReader reader;
+    reader.open(path);
+    SessionFrame frame;
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        reader.readFrame(index, frame);
+        index = (index + 1) % reader.frameCount();
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SessionReaderSequential)->Arg(1000)->Arg(10000);
@@ -0,0 +1,115 @@
+/**
+ * @file bench_shm_snapshot.cpp
+ *
+ * Benchmarks for the shared-memory snapshot export with a synthetic epoch of N processes: the cost
+ * the writer adds to every sampling epoch, and the throughput of readers that copy the latest epoch
+ * or scan its CPU column in place, alone or while another thread keeps publishing. Items per second
+ * are processes.
+ */
+
+#include "bench_fixtures.h"
+#include "shm_snapshot.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <thread>
+
+namespace
+{
+
+const char* kBenchObject = "/pm_bench_shm";
+
+// Opens a writer sized for `count` processes and publishes one epoch of them
+void openAndPublish(ShmSnapshotWriter& writer, const std::vector<Process>& processes)
+{
+    std::string error;
+    if (!writer.open(kBenchObject, static_cast<uint32_t>(processes.size()), error))
+    {
+        std::abort();
+    }
+    writer.publish(processes, 0);
+}
+
+} // namespace
+
+// Cost of publishing one epoch, paid by the sampler
+static void BM_ShmWriterPublish(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    ShmSnapshotWriter writer;
+    openAndPublish(writer, processes);
+    int64_t timestamp = 0;
+    for (auto _ : state)
+    {
+        writer.publish(processes, ++timestamp);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ShmWriterPublish)->Arg(1000)->Arg(10000);
+
+// Private copy of the latest epoch
+static void BM_ShmReaderRead(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    ShmSnapshotWriter writer;
+    openAndPublish(writer, processes);
+    ShmSnapshotReader reader;
+    std::string error;
+    reader.open(kBenchObject, error);
+    ShmSnapshotCopy copy;
+    for (auto _ : state)
+    {
+        bool ok = reader.read(copy);
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ShmReaderRead)->Arg(1000)->Arg(10000);
+
+// In-place scan of the CPU column; the second argument keeps a writer publishing meanwhile
+static void BM_ShmReaderVisit(benchmark::State& state)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    ShmSnapshotWriter writer;
+    openAndPublish(writer, processes);
+    ShmSnapshotReader reader;
+    std::string error;
+    reader.open(kBenchObject, error);
+
+    std::atomic<bool> stop(false);
+    std::thread publisher;
+    if (state.range(1) != 0)
+    {
+        publisher = std::thread([&]() {
+            int64_t timestamp = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                writer.publish(processes, ++timestamp);
+            }
+        });
+    }
+
+    int64_t retries = 0;
+    for (auto _ : state)
+    {
+        float total = 0;
+        while (!reader.visit([&](const ShmSnapshotView& view) {
+            total = 0;
+            for (size_t i = 0; i < view.count; ++i)
+            {
+                total += view.cpu[i];
+            }
+        }))
+        {
+            ++retries;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    stop.store(true);
+    if (publisher.joinable())
+    {
+        publisher.join();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["retries"] = static_cast<double>(retries);
+}
+BENCHMARK(BM_ShmReaderVisit)->Args({10000, 0})->Args({10000, 1});
@@ -0,0 +1,57 @@
+/**
+ * @file bench_stream_output.cpp
+ *
+ * Benchmarks for the headless stream mode. Each iteration serializes one epoch of synthetic
+ * processes (all of them, or the top 50 by CPU) and writes it to /dev/null, so the numbers
+ * reflect serialization and row selection rather than the reader. Items per second are records.
+ */
+
+#include "bench_fixtures.h"
+#include "stream_output.h"
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+void runStreamEpochs(benchmark::State& state, StreamFormat format, size_t top)
+{
+    auto processes = makeSyntheticProcesses(static_cast<int>(state.range(0)));
+    int fd = open("/dev/null", O_WRONLY);
+    StreamWriter writer(fd, format);
+    std::vector<const Process*> rows;
+    int64_t timestampMs = 1700000000000LL;
+    for (auto _ : state)
+    {
+        selectStreamRows(processes, top, "cpu", rows);
+        if (!writer.writeEpoch(timestampMs, rows))
+        {
+            state.SkipWithError("write to /dev/null failed");
+            break;
+        }
+        timestampMs += 500;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(writer.recordsWritten()));
+    close(fd);
+}
+
+} // namespace
+
+static void BM_Stream_JsonLines(benchmark::State& state)
+{
+    runStreamEpochs(state, StreamFormat::JsonLines, 0);
+}
+BENCHMARK(BM_Stream_JsonLines)->Arg(1000)->Arg(10000);
+
+static void BM_Stream_Csv(benchmark::State& state)
+{
+    runStreamEpochs(state, StreamFormat::Csv, 0);
+}
+BENCHMARK(BM_Stream_Csv)->Arg(1000)->Arg(10000);
+
+static void BM_Stream_JsonLinesTop50(benchmark::State& state)
+{
+    runStreamEpochs(state, StreamFormat::JsonLines, 50);
+}
+BENCHMARK(BM_Stream_JsonLinesTop50)->Arg(10000);
@@ -0,0 +1,140 @@
+/**
+ * @file cgroup_view.h
+ * @brief Declares the cgroup view: resource usage per control group instead of per process.
+ *
+ * On a host running containers, the cgroup v2 hierarchy under `/sys/fs/cgroup` (or the directory
+ * configured in `cgroupRoot`) already sums the usage of every process of a container, so the view
+ * reads three small files per cgroup (`cpu.stat`, `memory.current` and `pids.current`) instead of
+ * the files of every process. The same hierarchy is used to act on whole containers: writing to
+ * `cgroup.kill` kills every process of a cgroup, and `cpu.max` caps its CPU usage.
+ *
+ * Cgroups are named by their path relative to the root, such as `system.slice/nginx.service`.
+ */
+
+#ifndef CGROUP_VIEW_H
+#define CGROUP_VIEW_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct CgroupStats
+ * @brief Raw counters of one cgroup, as read from its interface files.
+ */
+struct CgroupStats
+{
+    std::string path;         /**< Path relative to the cgroup root */
+    uint64_t usageUsec = 0;   /**< CPU time of the cgroup since it was created (`usage_usec` of `cpu.stat`) */
+    uint64_t memoryBytes = 0; /**< Memory charged to the cgroup (`memory.current`) */
+    uint64_t pids = 0;        /**< Processes and threads in the cgroup and its descendants (`pids.current`) */
+};
+
+/**
+ * @struct CgroupUsage
+ * @brief Usage of one cgroup over a sampling interval, in the units of the process table.
+ */
+struct CgroupUsage
+{
+    std::string path;       /**< Path relative to the cgroup root */
+    double cpuUsage = 0;    /**< CPU usage percentage (100 is one core busy), 0 on the first sample */
+    double memoryUsage = 0; /**< Memory usage in MB */
+    uint64_t pids = 0;      /**< Processes and threads in the cgroup */
+};
+
+/**
+ * @brief Returns `true` if the configured root is a cgroup v2 hierarchy (it has `cgroup.controllers`).
+ *
+ * On hosts that still mount cgroup v1 controllers at `/sys/fs/cgroup`, the v2 hierarchy is usually
+ * at `/sys/fs/cgroup/unified`.
+ */
+bool cgroupHierarchyAvailable();
+
+/**
+ * @brief Lists the cgroups below the configured root, parents before their children.
+ *
+ * The root itself is not listed: its counters cover the whole host.
+ *
+ * @return The paths of the cgroups, relative to the root.
+ */
+std::vector<std::string> listCgroups();
+
+/**
+ * @brief Reads the counters of a cgroup.
+ *
+ * Controllers that are not enabled for the cgroup leave their counters at 0.
+ *
+ * @param path Path of the cgroup relative to the root.
+ * @param stats Receives the counters.
+ * @return `true` if the cgroup exists, `false` otherwise.
+ */
+bool readCgroupStats(const std::string& path, CgroupStats& stats);
+
+/**
+ * @class CgroupSampler
+ * @brief Turns successive reads of every cgroup into CPU usage percentages.
+ *
+ * Each sample reads all cgroups once; the CPU usage of a cgroup is the CPU time it used since the
+ * previous sample divided by the time elapsed, so the first sample of a cgroup reports 0.
+ */
+class CgroupSampler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Reads every cgroup, timing the sample with the current time.
+     */
+    std::vector<CgroupUsage> sample();
+
+    /**
+     * @brief Reads every cgroup, as if sampled at `now`.
+     */
+    std::vector<CgroupUsage> sample(Clock::time_point now);
+
+  private:
+    std::unordered_map<std::string, uint64_t> m_previousUsage; /**< `usage_usec` of the previous sample, by path */
+    Clock::time_point m_previousTime;                          /**< Time of the previous sample */
+};
+
+/**
+ * @brief Selects the cgroups that match a filter criterion.
+ *
+ * Takes the filters of the process view: `{"cpu", "<percent>"}` and `{"memory", "<MB>"}` keep the
+ * cgroups above the threshold, and `{"cgroup", "<text>"}` those whose path contains the text. Other
+ * filters (such as a user) do not apply to cgroups and keep all of them.
+ *
+ * @param cgroups The cgroups to select from, in place.
+ * @param filter Filter type and value.
+ */
+void filterCgroups(std::vector<CgroupUsage>& cgroups, const std::pair<std::string, std::string>& filter);
+
+/**
+ * @brief Sorts cgroups in descending order of "cpu" or "memory"; any other criterion sorts by path.
+ */
+void sortCgroups(std::vector<CgroupUsage>& cgroups, const std::string& criterion);
+
+/**
+ * @brief Kills every process of a cgroup and of its descendants by writing to its `cgroup.kill`.
+ *
+ * @param path Path of the cgroup relative to the root.
+ * @param error Receives a description of the failure.
+ * @return `true` if the kernel accepted the request, `false` otherwise.
+ */
+bool killCgroup(const std::string& path, std::string& error);
+
+/**
+ * @brief Caps the CPU usage of a cgroup by writing its `cpu.max`.
+ *
+ * @param path Path of the cgroup relative to the root.
+ * @param percent The cap, in percent of one core (e.g. 50 or 250) and at most 100 per core, or 0 to
+ *                remove the cap.
+ * @param error Receives a description of the failure.
+ * @return `true` if the cap was written, `false` otherwise.
+ */
+bool setCgroupCpuMax(const std::string& path, double percent, std::string& error);
+
+#endif // CGROUP_VIEW_H
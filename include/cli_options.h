@@ -0,0 +1,115 @@
+/**
+ * @file cli_options.h
+ * @brief Declares the command-line options of the Process Manager application.
+ *
+ * Options are parsed into a CliOptions structure before anything is started, so that `main()`
+ * can pick between the interactive command loop and the headless stream mode and report usage
+ * errors up front.
+ */
+
+#ifndef CLI_OPTIONS_H
+#define CLI_OPTIONS_H
+
+#include "logger.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * @enum StreamFormat
+ * @brief Output format of the headless stream mode.
+ */
+enum class StreamFormat
+{
+    None,      /**< Interactive mode (no streaming) */
+    JsonLines, /**< One JSON object per line */
+    Csv        /**< Comma-separated values with a header line */
+};
+
+/**
+ * @struct CliOptions
+ * @brief Parsed command-line options.
+ */
+struct CliOptions
+{
+    std::string procRoot;                           /**< Alternative procfs tree, or empty for `/proc` */
+    std::string cgroupRoot;                         /**< Alternative cgroup tree, or empty for `/sys/fs/cgroup` */
+    std::string historyDir;                         /**< History store directory, or empty for none */
+    std::string policyFile;                         /**< Policy rules evaluated every epoch (`--policy`), or empty */
+    StreamFormat streamFormat = StreamFormat::None; /**< Stream mode format (`--stream`) */
+    int intervalMs = 1000;                          /**< Sampling interval of `--stream` and `--daemon` */
+    size_t top = 0;                                 /**< Records per epoch, highest first, or 0 for all (`--top`) */
+    std::string sortBy = "cpu";                     /**< Ranking used by `--top`: "cpu" or "memory" (`--sort`) */
+    long count = 0;                                 /**< Epochs to stream before exiting, or 0 for no limit */
+    bool once = false;                              /**< Sample once, print the result and exit (`--once`) */
+    int windowMs = 200;                             /**< Time between the two scans of `--once` (`--window`) */
+    std::pair<std::string, std::string> filter = {"none", ""}; /**< Filter of `--once` (`--filter`) */
+    bool daemon = false;                            /**< Serve snapshots over a Unix socket (`--daemon`) */
+    std::string socketPath;                         /**< Socket of `--daemon` (`--socket`), or empty for the default */
+    std::string shmExport;                          /**< Shared-memory object to publish epochs to (`--shm-export`) */
+    std::string metricsAddress;                     /**< Address of the metrics endpoint (`--metrics`), or empty */
+    size_t metricsTop = 50;                         /**< Processes exported individually (`--metrics-top`) */
+    LogFormat logFormat = LogFormat::Text;          /**< Encoding of the log file (`--log-format`) */
+    LogRotationPolicy logRotation;                  /**< `--log-max-size`, `--log-rotate` and `--log-keep` */
+};
+
+/**
+ * @brief Parses a duration such as `500ms`, `2s`, `1.5` (seconds), `30m` or `1h`.
+ *
+ * @param text The duration.
+ * @param milliseconds Receives the duration in milliseconds.
+ * @return `true` if `text` is a positive duration of at least one millisecond.
+ */
+bool parseDuration(const std::string& text, int& milliseconds);
+
+/**
+ * @brief Parses a size in bytes such as `4096`, `512K`, `100M` or `1.5G` (multiples of 1024).
+ *
+ * @param text The size.
+ * @param bytes Receives the size in bytes.
+ * @return `true` if `text` is a positive size.
+ */
+bool parseByteSize(const std::string& text, uint64_t& bytes);
+
+/**
+ * @brief Parses a filter such as `user=postgres`, `cpu>50` or `memory=100`.
+ *
+ * Numeric filters keep the processes above the threshold, like the `filter` command, and may be
+ * written with `=` or `>`.
+ *
+ * @param text The filter.
+ * @param filter Receives the filter type and value, in the form used by `filterProcesses()`.
+ * @return `true` if `text` names a known filter type with a valid value.
+ */
+bool parseFilter(const std::string& text, std::pair<std::string, std::string>& filter);
+
+/**
+ * @brief Parses a TCP listening address: `<port>` (on 127.0.0.1) or `<IPv4 address>:<port>`.
+ *
+ * @param text The address.
+ * @param host Receives the IPv4 address.
+ * @param port Receives the port (0 lets the system pick one).
+ * @return `true` if `text` is a valid address.
+ */
+bool parseListenAddress(const std::string& text, std::string& host, int& port);
+
+/**
+ * @brief Parses the command-line arguments.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments, starting with the program name.
+ * @param options Receives the options.
+ * @param error Receives a description of the first invalid argument.
+ * @return `true` on success, `false` if an argument is unknown, incomplete or invalid.
+ */
+bool parseCommandLine(int argc, const char* const argv[], CliOptions& options, std::string& error);
+
+/**
+ * @brief Returns the usage message of the program.
+ *
+ * @param program Name of the program (`argv[0]`).
+ */
+std::string usageText(const std::string& program);
+
+#endif // CLI_OPTIONS_H
@@ -82,6 +82,15 @@ char** commandCompleter(const char* text, int start, int end);
  */
 void handleSigint(int sig);
 
+/**
+ * @brief Handles the SIGWINCH signal (terminal resize).
+ *
+ * Only sets `terminalResized`; the display thread picks up the new size on its next check.
+ *
+ * @param sig The signal number (should be SIGWINCH).
+ */
+void handleSigwinch(int sig);
+
 /**
  * @brief Prints the help menu to the console.
  *
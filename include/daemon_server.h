@@ -0,0 +1,124 @@
+/**
+ * @file daemon_server.h
+ * @brief Declares the daemon mode, which serves process snapshots to local clients.
+ *
+ * In daemon mode (`--daemon`) a single sampling thread scans the processes and publishes a
+ * snapshot per epoch, and a DaemonServer answers any number of clients on a Unix-domain socket
+ * from the latest snapshot. Viewers therefore cost one scan in total plus the serialization of
+ * their answers, and clients asking the same question in the same epoch share one serialized
+ * answer.
+ *
+ * The protocol is line-based, one request per line:
+ *
+ * - `LIST [N]`: the N processes ranking highest (all of them without N or with 0);
+ * - `FILTER none|user=<name>|cpu>X|memory>X`: filter of the following `LIST` requests;
+ * - `SORT cpu|memory`: ranking of the following `LIST` requests;
+ * - `HISTORY <pid>`: the recorded samples of a process, oldest first;
+ * - `KILL <pid>`: sends SIGKILL to a process;
+ * - `QUIT`: closes the connection.
+ *
+ * Every answer starts with `OK <count>` followed by `count` JSON lines (the records of the stream
+ * mode for `LIST`, `{"cpu":..,"mem_mb":..}` for `HISTORY`), or is a single `ERR <message>` line.
+ * Filter and sort settings belong to the connection. Requests may be pipelined.
+ */
+
+#ifndef DAEMON_SERVER_H
+#define DAEMON_SERVER_H
+
+#include "cli_options.h"
+#include "frame_buffer.h"
+#include "poll_server.h"
+#include "process_snapshot.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class DaemonServer
+ * @brief Single-threaded, poll-based server of the daemon protocol.
+ *
+ * The client loop is the one of PollServer; this class parses the request lines and answers them
+ * from the latest snapshot of `processSnapshots`.
+ */
+class DaemonServer : public PollServer
+{
+  public:
+    /** @brief Maximum number of connected clients; further connections are closed right away. */
+    static constexpr size_t kMaxClients = 1024;
+
+    /** @brief Maximum length of a request line. */
+    static constexpr size_t kMaxRequestBytes = 4096;
+
+    DaemonServer();
+    ~DaemonServer() override;
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    /**
+     * @brief Creates the listening socket.
+     *
+     * The socket is only accessible to the owner of the process (mode 0600), since clients may
+     * kill processes. A stale socket file left by a daemon that did not exit cleanly is replaced;
+     * a socket on which another daemon is listening is not.
+     *
+     * @param socketPath Path of the socket.
+     * @param error Receives a description of the failure.
+     * @return `true` on success, `false` otherwise.
+     */
+    bool start(const std::string& socketPath, std::string& error);
+
+    /**
+     * @brief Disconnects every client, closes the listening socket and removes the socket file.
+     */
+    void stop();
+
+  private:
+    /**
+     * @brief Connection state of a client, with its `FILTER` and `SORT` settings.
+     */
+    struct DaemonClient : PollServer::Client
+    {
+        std::pair<std::string, std::string> filter = {"none", ""}; /**< Filter of `LIST` */
+        std::string sortBy = "cpu";                                /**< Ranking of `LIST` */
+    };
+
+    std::unique_ptr<Client> newClient() override;
+    void handleRequests(Client& client) override;
+    void handleRequest(DaemonClient& client, const std::string& line);
+    void answerList(DaemonClient& client, size_t limit);
+    void answerHistory(DaemonClient& client, int pid);
+
+    std::string m_socketPath;                     /**< Path of the listening socket */
+    FrameBuffer m_scratch;                        /**< Serialization buffer of answers */
+    std::vector<const Process*> m_rows;           /**< Rows of the `LIST` answer being serialized */
+
+    // Last `LIST` answer, shared by the clients asking the same question in the same epoch
+    std::shared_ptr<const ProcessSnapshot> m_cachedSnapshot;
+    std::pair<std::string, std::string> m_cachedFilter;
+    std::string m_cachedSortBy;
+    size_t m_cachedLimit;
+    std::string m_cachedAnswer;
+};
+
+/**
+ * @brief Returns the default socket path: `$XDG_RUNTIME_DIR/process_manager.sock`, or
+ *        `/tmp/process_manager-<uid>.sock` if the variable is not set.
+ */
+std::string defaultSocketPath();
+
+/**
+ * @brief Runs the daemon mode until SIGINT or SIGTERM.
+ *
+ * Starts the CPU monitoring thread with `options.intervalMs` as the sampling interval and serves
+ * clients on `options.socketPath` (or `defaultSocketPath()`).
+ *
+ * @param options The parsed command-line options.
+ * @return The process exit code: 0 on success, 1 if the socket could not be created.
+ */
+int runDaemonMode(const CliOptions& options);
+
+#endif // DAEMON_SERVER_H
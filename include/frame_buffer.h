@@ -0,0 +1,107 @@
+/**
+ * @file frame_buffer.h
+ * @brief Declares the byte buffer in which display frames are composed before being written.
+ *
+ * Streaming a table through `std::cout` with `std::setw` and `std::endl` costs a locale-aware
+ * conversion per field and a flush (one `write` system call) per line, and lets other output slip
+ * between the lines. A FrameBuffer is allocated once and reused for every frame, numbers are
+ * formatted with `std::to_chars`, and the finished frame is emitted with a single `write(2)`.
+ */
+
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @class FrameBuffer
+ * @brief Growable, reusable output buffer with fast number formatting.
+ *
+ * Padding helpers left-align their value in a field of the given width, like `std::left` with
+ * `std::setw`: longer values are not truncated. The buffer is not thread-safe.
+ */
+class FrameBuffer
+{
+  public:
+    /** @brief Initial capacity, enough for a full-screen frame with color codes. */
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    /**
+     * @brief Creates an empty buffer.
+     *
+     * @param capacity Number of bytes allocated up front.
+     */
+    explicit FrameBuffer(size_t capacity = kDefaultCapacity);
+
+    /**
+     * @brief Empties the buffer, keeping its allocation.
+     */
+    void clear();
+
+    /**
+     * @brief Appends raw bytes.
+     */
+    void append(const char* data, size_t length);
+
+    /**
+     * @brief Appends a string.
+     */
+    void append(const std::string& text);
+
+    /**
+     * @brief Appends a NUL-terminated string.
+     */
+    void append(const char* text);
+
+    /**
+     * @brief Appends `count` copies of a character.
+     */
+    void append(size_t count, char ch);
+
+    /**
+     * @brief Appends a string left-aligned in a field of `width` characters.
+     */
+    void appendPadded(const std::string& text, size_t width);
+
+    /**
+     * @brief Appends an integer left-aligned in a field of `width` characters.
+     */
+    void appendInt(long long value, size_t width = 0);
+
+    /**
+     * @brief Appends a number in fixed notation left-aligned in a field of `width` characters.
+     *
+     * @param value The number.
+     * @param precision Digits after the decimal point.
+     * @param width Minimum field width.
+     */
+    void appendFixed(double value, int precision, size_t width = 0);
+
+    /**
+     * @brief Returns the buffered bytes.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Returns the number of buffered bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Writes the buffered bytes to a file descriptor, retrying on partial writes and `EINTR`.
+     *
+     * @param fd The file descriptor (e.g., `STDOUT_FILENO`).
+     * @return `true` if every byte was written, `false` on error.
+     */
+    bool writeTo(int fd) const;
+
+  private:
+    char* reserve(size_t length);
+
+    std::vector<char> m_data; /**< Storage; only the first `m_size` bytes are valid */
+    size_t m_size;            /**< Number of buffered bytes */
+};
+
+#endif // FRAME_BUFFER_H
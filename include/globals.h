@@ -9,10 +9,18 @@
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
-#include "process_info.h" // Include the Process struct and related functions
+#include "history_store.h"    // Include the HistoryStore class
+#include "process_history.h"  // Include the ProcessHistory class
+#include "process_info.h"     // Include the Process struct and related functions
+#include "process_snapshot.h" // Include the SnapshotPublisher class
+#include "policy_engine.h"    // Include the PolicyEngine class
+#include "process_tree.h"     // Include the ProcessTree class
+#include "session_record.h"   // Include the SessionRecorder class
+#include "shm_snapshot.h"     // Include the ShmSnapshotWriter class
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 /**
@@ -23,6 +31,15 @@
  */
 extern std::atomic<bool> monitoringActive;
 
+/**
+ * @brief Number of the current monitoring session, advanced every time monitoring or a replay starts.
+ *
+ * Monitoring threads are detached and only notice a stop when they wake up. Each one keeps the
+ * number of the session it was started for and exits as soon as it differs, so a thread of a
+ * stopped session never feeds the processes map of the next one.
+ */
+extern std::atomic<unsigned> monitoringGeneration;
+
 /**
  * @brief Mutex to synchronize access to standard output (std::cout).
  *
@@ -96,11 +113,144 @@ extern std::unordered_map<int, std::string> pidToUserCache;
 extern std::unordered_map<int, std::string> pidToCommandCache;
 
 /**
- * @brief Atomic integer representing the update frequency in seconds.
+ * @brief Atomic integer representing the sampling interval in milliseconds.
+ *
+ * Determines how often the monitoring threads scan the processes and update CPU and memory usage
+ * information. Defaults to 5 seconds.
+ */
+extern std::atomic<int> sampleIntervalMs;
+
+/**
+ * @brief Atomic integer representing the display interval in milliseconds.
+ *
+ * Determines how often the display thread redraws the table from the latest snapshot, independently
+ * of the sampling interval. Defaults to 1 second.
+ */
+extern std::atomic<int> displayIntervalMs;
+
+/**
+ * @brief Latest snapshot of the processes, published by the sampling threads after every epoch.
+ *
+ * The display thread renders from it instead of locking the processes map.
+ */
+extern SnapshotPublisher processSnapshots;
+
+/**
+ * @brief Shared-memory export of the sampling epochs (`--shm-export <name>`).
+ *
+ * Closed unless the option is given; every epoch is published into it while it is open.
+ */
+extern ShmSnapshotWriter shmExport;
+
+/**
+ * @brief Root directory of the proc filesystem read by the monitoring functions.
+ *
+ * Defaults to `/proc`. Pointing it at a directory produced by the synthetic procfs generator makes
+ * scans deterministic for tests and benchmarks. It must only be changed while no monitoring
+ * threads are running.
+ */
+extern std::string procRoot;
+
+/**
+ * @brief Root directory of the cgroup v2 hierarchy read by the cgroup view.
+ *
+ * Defaults to `/sys/fs/cgroup`. Like `procRoot`, it can point at a synthetic tree, and must only be
+ * changed while no command uses the cgroup view.
+ */
+extern std::string cgroupRoot;
+
+/**
+ * @brief Atomic flag asking the display thread to redraw without waiting for the next update.
+ *
+ * Set together with a notification on `cv` whenever new data is available outside the regular
+ * update cycle (e.g., when a replayed frame is loaded).
+ */
+extern std::atomic<bool> displayRefreshRequested;
+
+/**
+ * @brief Atomic flag asking the display thread to repaint the whole table on its next frame.
+ *
+ * The display only rewrites the cells that changed between frames. Any other output (the command
+ * prompt, command results) invalidates what it knows of the screen, so the command loop sets this
+ * flag after every command.
+ */
+extern std::atomic<bool> screenRepaintRequested;
+
+/**
+ * @brief Atomic flag set by the SIGWINCH handler when the terminal was resized.
+ *
+ * The display thread queries the new size and repaints the table to fit it.
+ */
+extern std::atomic<bool> terminalResized;
+
+/**
+ * @brief Maximum number of process rows shown by the display, or `0` to fill the terminal.
+ *
+ * Changed with the `set_rows` command. The table never grows beyond the terminal.
+ */
+extern std::atomic<int> displayRowLimit;
+
+/**
+ * @brief Recorder of sampling epochs, active while the `record` command is in effect.
+ *
+ * The CPU monitoring thread appends every epoch to it while it is open.
+ */
+extern SessionRecorder sessionRecorder;
+
+/**
+ * @brief Number of frames the replay thread may still advance in single-step mode.
+ */
+extern std::atomic<int> replayStepRequests;
+
+/**
+ * @brief Pending replay seek target, as an offset in milliseconds from the start of the recording.
+ *
+ * A negative value means that no seek is pending.
+ */
+extern std::atomic<long long> replaySeekOffsetMs;
+
+/**
+ * @brief Atomic flag indicating whether the processes map holds a replayed session.
+ *
+ * Replayed PIDs may belong to other processes now, so kill commands are refused while it is set.
+ * Cleared, together with the replayed processes, when the replay ends or is stopped.
+ */
+extern std::atomic<bool> replayActive;
+
+/**
+ * @brief Recent CPU and memory samples of every tracked process.
+ *
+ * The CPU monitoring thread records every epoch into it; the `history` command reads from it.
+ * Its memory use is bounded by a fixed budget (see `set_history_budget`).
+ */
+extern ProcessHistory processHistory;
+
+/**
+ * @brief Parent/child tree of the sampled processes, with CPU and memory sums per subtree.
+ *
+ * The CPU monitoring thread updates it incrementally every epoch; the display reads it in tree mode.
+ */
+extern ProcessTree processTree;
+
+/**
+ * @brief Atomic flag selecting the tree display mode (`tree on|off`).
+ *
+ * When `true`, the display shows the processes under their parents with the sums of their subtrees.
+ */
+extern std::atomic<bool> treeView;
+
+/**
+ * @brief Rules evaluated against every live sampling epoch (`--policy`, `policy load`).
+ *
+ * The sampling loops run it after each epoch; without rules it costs nothing.
+ */
+extern PolicyEngine policyEngine;
+
+/**
+ * @brief Compressed on-disk history of every process, active while a data directory is open.
  *
- * Determines how often the monitoring threads update CPU and memory usage information.
- * Defaults to updating every 5 seconds.
+ * The CPU monitoring thread appends every epoch to it; the `history_at` command queries it.
  */
-extern std::atomic<int> updateFrequency;
+extern HistoryStore historyStore;
 
 #endif // GLOBALS_H
@@ -0,0 +1,240 @@
+/**
+ * @file history_store.h
+ * @brief Declares the compressed long-retention store of per-process CPU and memory series.
+ *
+ * The store keeps days of per-process history on disk in a few tens of megabytes, so questions such
+ * as "what was eating CPU at 03:12" can be answered after the fact.
+ *
+ * Series are compressed with the scheme of Facebook's Gorilla time-series database:
+ * - Timestamps (milliseconds) are stored as delta-of-deltas in variable-size bit buckets. Regular
+ *   sampling costs one bit per sample.
+ * - CPU usage (in hundredths of a percent) and memory usage (in kB) are stored as doubles XORed
+ *   with the previous value. An unchanged value costs one bit; a changed one only its meaningful
+ *   bits. Both values share the timestamp stream.
+ * - A sample is only written when a value moved by more than a dead band since the last written
+ *   sample, or when the heartbeat interval elapsed. Queries treat a series as a step function, so
+ *   the error of any value is bounded by the dead band.
+ *
+ * Time is cut into fixed periods (one hour by default). The samples of a process during a period
+ * form one block, kept in memory while the period is open. When the period ends, every block is
+ * appended to the period's segment file `seg-<start seconds>.pmh` under the data directory through a
+ * memory mapping. Every few epochs, the open blocks are also copied into the mapping after the
+ * complete blocks, as a checkpoint that the next checkpoint or the final blocks overwrite. A process
+ * that crashes or is killed therefore loses at most the epochs since the last checkpoint: the
+ * mapping is shared, so the file holds the checkpoint as soon as it is copied. Segments are mapped
+ * read-only for queries and only their block headers are read to build the index; a query decodes
+ * only the blocks that cover the requested process and time. Segments older than the retention are
+ * deleted.
+ *
+ * Segment layout (all integers little-endian):
+ * - Header: the 8 bytes `PMHSEG` `\0` `\1`, then the `i64` start of the period in milliseconds.
+ * - Blocks: `u32` magic `PMHB`, `u32` block length, `i32` PID, `u32` sample count, `i64` first
+ *   timestamp, `i64` last time the process was seen, `u8`-length-prefixed user and command, `u32`
+ *   bit count and the bit stream. A zeroed or truncated block marks the end of the segment.
+ */
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include "process_info.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct HistoryStoreOptions
+ * @brief Configuration of a HistoryStore.
+ */
+struct HistoryStoreOptions
+{
+    std::string directory;       /**< Data directory holding the segment files */
+    int periodSeconds = 3600;    /**< Length of a block period (one segment file per period) */
+    int retentionHours = 24;     /**< Segments older than this are deleted */
+    int heartbeatSeconds = 60;   /**< A sample is written at least this often for running processes */
+    double cpuDeadband = 0.5;    /**< Minimum CPU change (percentage points) worth a new sample */
+    long memoryDeadbandKb = 1024; /**< Minimum memory change (kB) worth a new sample */
+    int checkpointEpochs = 10;   /**< Open blocks are copied to the segment this often (0: at period end only) */
+};
+
+/**
+ * @struct HistoryPoint
+ * @brief One decoded sample of a process series.
+ */
+struct HistoryPoint
+{
+    int64_t timestampMs; /**< Wall-clock time of the sample, in milliseconds since the Unix epoch */
+    double cpuUsage;     /**< CPU usage percentage */
+    double memoryUsage;  /**< Memory usage in MB */
+};
+
+/**
+ * @class HistoryStore
+ * @brief Appends sampling epochs to compressed segment files and answers point-in-time queries.
+ *
+ * All methods are thread-safe: the CPU monitoring thread appends epochs while the command loop
+ * runs queries.
+ */
+class HistoryStore
+{
+  public:
+    HistoryStore();
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    /**
+     * @brief Opens a data directory, creating it if needed, and indexes its segments.
+     *
+     * Expired segments are deleted. Blocks appended afterwards to a period that already has a
+     * segment are added to that segment.
+     *
+     * @param options Data directory and encoding parameters.
+     * @return `true` on success, `false` if the directory cannot be created or read.
+     */
+    bool open(const HistoryStoreOptions& options);
+
+    /**
+     * @brief Writes the blocks of the open period and closes every segment. Does nothing if the
+     *        store is not open.
+     */
+    void close();
+
+    /**
+     * @brief Returns `true` while a data directory is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Appends the snapshot of one sampling epoch.
+     *
+     * When the epoch belongs to a later period than the previous one, the blocks of the previous
+     * period are written to its segment first and expired segments are deleted. Every
+     * `checkpointEpochs` epochs, the open blocks are checkpointed to the segment.
+     *
+     * @param timestampMs Wall-clock time of the epoch, in milliseconds since the Unix epoch.
+     *        Epochs must be appended in increasing time order.
+     * @param snapshot Processes seen during the epoch, in any order.
+     * @return `true` on success, `false` if the store is not open or a segment cannot be written.
+     */
+    bool append(int64_t timestampMs, const std::vector<Process>& snapshot);
+
+    /**
+     * @brief Returns the processes running at a point in time, with their usage at that time.
+     *
+     * A process is considered running if it had been seen at or before `timestampMs` and was
+     * seen again at most `toleranceMs` before it (typically the sampling interval).
+     *
+     * @param timestampMs Wall-clock time, in milliseconds since the Unix epoch.
+     * @param toleranceMs Maximum age of the last time a process was seen.
+     * @param result Receives the processes, in no particular order.
+     * @return `true` on success, `false` if the store is not open or a segment is corrupted.
+     */
+    bool processesAt(int64_t timestampMs, int64_t toleranceMs, std::vector<Process>& result);
+
+    /**
+     * @brief Returns the samples written for a process over a time range, oldest first.
+     *
+     * @param pid The Process ID.
+     * @param fromMs Start of the range, in milliseconds since the Unix epoch.
+     * @param toMs End of the range (inclusive), in milliseconds since the Unix epoch.
+     * @param points Receives the samples.
+     * @return `true` on success, `false` if the store is not open or a segment is corrupted.
+     */
+    bool series(int pid, int64_t fromMs, int64_t toMs, std::vector<HistoryPoint>& points);
+
+    /**
+     * @brief Returns the number of segment files.
+     */
+    size_t segmentCount() const;
+
+    /**
+     * @brief Returns the size of the segment files, plus the encoded size of the open blocks.
+     */
+    uint64_t bytesUsed() const;
+
+    /**
+     * @brief Returns the number of process samples received since the store was opened.
+     */
+    uint64_t samplesSeen() const;
+
+    /**
+     * @brief Returns the number of samples written since the store was opened (after the dead band).
+     */
+    uint64_t samplesWritten() const;
+
+  private:
+    /**
+     * @brief Bit-level encoder state of the block of one process in the open period.
+     */
+    struct OpenBlock
+    {
+        std::string user;
+        std::string command;
+        std::vector<uint8_t> bits; /**< Encoded bit stream */
+        uint64_t bitCount = 0;     /**< Number of bits used in `bits` */
+        uint32_t count = 0;        /**< Number of samples written */
+        int64_t firstTs = 0;       /**< Timestamp of the first sample */
+        int64_t lastTs = 0;        /**< Timestamp of the last sample written */
+        int64_t lastDelta = 0;     /**< Difference between the last two timestamps written */
+        int64_t lastSeenTs = 0;    /**< Last time the process was part of an epoch */
+        uint64_t cpuBits = 0;      /**< Last CPU value written, as the bits of a double */
+        uint64_t memoryBits = 0;   /**< Last memory value written, as the bits of a double */
+        uint8_t cpuLeading = 0xFF; /**< XOR window of the CPU stream (0xFF: none yet) */
+        uint8_t cpuTrailing = 0;
+        uint8_t memoryLeading = 0xFF; /**< XOR window of the memory stream (0xFF: none yet) */
+        uint8_t memoryTrailing = 0;
+    };
+
+    /**
+     * @brief Location and coverage of a block inside a segment.
+     */
+    struct BlockInfo
+    {
+        int pid;
+        int64_t firstTs;
+        int64_t lastSeenTs;
+        uint32_t offset; /**< Offset of the block from the start of the segment */
+    };
+
+    /**
+     * @brief A segment file, mapped in memory.
+     */
+    struct Segment
+    {
+        std::string path;
+        int64_t startMs = 0;
+        int fd = -1;
+        uint8_t* data = nullptr; /**< Mapping of the file */
+        size_t mapped = 0;       /**< Size of the mapping */
+        size_t used = 0;         /**< Bytes holding the header and complete blocks */
+        bool writable = false;
+        std::vector<BlockInfo> blocks;
+    };
+
+    bool indexSegment(Segment& segment);
+    bool openWritableSegment(int64_t startMs);
+    bool ensureCapacity(Segment& segment, size_t bytes);
+    bool writeBlock(int pid, const OpenBlock& block);
+    bool checkpointLocked();
+    bool flushOpenBlocksLocked();
+    void closeSegment(Segment& segment);
+    void applyRetentionLocked(int64_t nowMs);
+    void encodeSample(OpenBlock& block, int64_t timestampMs, double cpuCenti, double memoryKb);
+
+    mutable std::mutex m_mutex;                             /**< Protects every member below */
+    bool m_open;                                            /**< `true` while a directory is open */
+    HistoryStoreOptions m_options;                          /**< Options given to `open()` */
+    std::map<int64_t, std::unique_ptr<Segment>> m_segments; /**< Segments by period start */
+    int64_t m_periodStartMs;                                /**< Start of the open period, or -1 */
+    std::unordered_map<int, OpenBlock> m_openBlocks;        /**< Blocks of the open period by PID */
+    uint64_t m_samplesSeen;                                 /**< Samples received since `open()` */
+    uint64_t m_samplesWritten;                              /**< Samples encoded since `open()` */
+    int m_epochsSinceCheckpoint;                            /**< Epochs appended since the last checkpoint */
+};
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,164 @@
+/**
+ * @file log_record.h
+ * @brief Declares the formatting of log messages and the binary log format.
+ *
+ * The functions and classes declared here are shared by the Logger, which formats messages as
+ * text or encodes them as binary records, and by the `pm_logcat` tool, which decodes binary logs.
+ *
+ * A binary log starts with the 8 bytes `PMBLOG01`, followed by records. Each record is the
+ * number of bytes that follow as an unsigned LEB128 varint, then a type byte and its fields:
+ *
+ * - `S` (start), written each time the Logger starts: the time in seconds since the Unix epoch
+ *   (int64). Template ids and the time of the previous message restart from there.
+ * - `T` (template), written the first time a format string is used: its id (varint), then the
+ *   format string.
+ * - `M` (message): the level (byte), the seconds since the previous message or start record
+ *   (zigzag varint), the template id (varint), then the arguments. Id 0 is a message logged as a
+ *   string, whose text takes the rest of the record. Arguments are a LogArgs tag followed by a
+ *   zigzag varint (kSigned), a varint (kUnsigned), 8 bytes (kDouble), 1 byte (kChar and kBool) or
+ *   a varint length and the characters (kString).
+ *
+ * Fixed-size fields are in host byte order. Readers skip records of unknown types.
+ */
+
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include "logger.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <zlib.h>
+
+/** @brief First bytes of a binary log. */
+constexpr char kBinaryLogMagic[] = "PMBLOG01";
+
+/** @brief Bytes of kBinaryLogMagic, without its terminating NUL. */
+constexpr size_t kBinaryLogMagicBytes = sizeof(kBinaryLogMagic) - 1;
+
+/**
+ * @brief Returns the name of a level as written in text logs ("INFO", "WARNING", ...).
+ */
+const char* logLevelName(LogLevel level);
+
+/**
+ * @brief Parses a level name, in any case ("info", "WARNING", ...).
+ *
+ * @return `true` if `name` is a level.
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+/**
+ * @brief Appends `format` with each placeholder replaced by the next argument packed by LogArgs.
+ *
+ * Placeholders are `{}` and `{pid}`; the latter marks an integer argument as a process ID, which
+ * `pm_logcat --pid` filters on. Placeholders without an argument are written as is.
+ *
+ * @param out Buffer the message is appended to.
+ * @param format The format string.
+ * @param args The packed arguments.
+ * @param length Bytes of `args`.
+ * @param pid If not null, receives the argument of the first `{pid}` placeholder, or -1.
+ */
+void appendFormatted(std::string& out, const char* format, const char* args, size_t length, int64_t* pid = nullptr);
+
+/**
+ * @class BinaryLogEncoder
+ * @brief Encodes queued messages as binary log records.
+ */
+class BinaryLogEncoder
+{
+  public:
+    BinaryLogEncoder();
+
+    /**
+     * @brief Appends a start record and forgets the templates and time of earlier records.
+     *
+     * @param out Buffer the record is appended to.
+     * @param time Current time in seconds since the Unix epoch.
+     */
+    void begin(std::string& out, int64_t time);
+
+    /**
+     * @brief Appends a message record, preceded by a template record if `format` was not used yet.
+     *
+     * @param out Buffer the records are appended to.
+     * @param time Time the message was logged.
+     * @param level Severity of the message.
+     * @param format Format string with static storage duration, or `nullptr` for a plain message.
+     * @param text The message, or the arguments packed by LogArgs.
+     * @param length Bytes of `text`.
+     */
+    void append(std::string& out, int64_t time, LogLevel level, const char* format, const char* text,
+                size_t length);
+
+  private:
+    std::unordered_map<const char*, uint32_t> m_templateIds; /**< Ids of the format strings written */
+    int64_t m_lastTime;                                      /**< Time of the previous record */
+    std::string m_record;                                    /**< Record being encoded */
+};
+
+/**
+ * @struct LogEntry
+ * @brief One decoded message of a binary log.
+ */
+struct LogEntry
+{
+    int64_t time = 0;              /**< Seconds since the Unix epoch */
+    LogLevel level = LogLevel::INFO; /**< Severity */
+    std::string message;           /**< Formatted message */
+    int64_t pid = -1;              /**< Argument of the `{pid}` placeholder, or -1 */
+};
+
+/**
+ * @class BinaryLogReader
+ * @brief Decodes the messages of a binary log file, in order.
+ *
+ * Rotated logs compressed with gzip are read as they are.
+ */
+class BinaryLogReader
+{
+  public:
+    BinaryLogReader();
+    ~BinaryLogReader();
+
+    BinaryLogReader(const BinaryLogReader&) = delete;
+    BinaryLogReader& operator=(const BinaryLogReader&) = delete;
+
+    /**
+     * @brief Opens a binary log and checks its magic.
+     *
+     * @param path The log file, possibly gzipped.
+     * @param error Receives a description of the failure.
+     * @return `true` on success, `false` otherwise.
+     */
+    bool open(const std::string& path, std::string& error);
+
+    /**
+     * @brief Decodes the next message.
+     *
+     * @param entry Receives the message.
+     * @return `true` if a message was decoded, `false` at the end of the file or at a damaged
+     *         record (see `damaged()`).
+     */
+    bool next(LogEntry& entry);
+
+    /**
+     * @brief Returns `true` if reading stopped at a truncated or malformed record rather than at the
+     *        end of the file.
+     */
+    bool damaged() const;
+
+  private:
+    bool decodeMessage(const std::string& record, LogEntry& entry);
+
+    gzFile m_file;                                      /**< The log, or null */
+    std::unordered_map<uint32_t, std::string> m_templates; /**< Format strings by id */
+    int64_t m_lastTime;                                 /**< Time of the previous record */
+    bool m_damaged;                                     /**< See damaged() */
+    std::string m_record;                               /**< Record being decoded */
+    std::string m_args;                                 /**< Arguments decoded back into the LogArgs layout */
+};
+
+#endif // LOG_RECORD_H
@@ -0,0 +1,100 @@
+/**
+ * @file log_rotation.h
+ * @brief Declares the archiving of rotated log files: naming, compression and retention.
+ *
+ * When the rotation policy of the Logger says so, the logging thread renames the log file to
+ * `<log>.<YYYYmmdd-HHMMSS>` (with a `.<n>` suffix if several rotations happen in one second) and
+ * opens a new one. A LogArchiver then gzips the rotated file on its own thread, into
+ * `<rotated name>.gz`, and deletes the oldest rotated files beyond the retention count.
+ */
+
+#ifndef LOG_ROTATION_H
+#define LOG_ROTATION_H
+
+#include "logger.h"
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Returns a name for the log file `path` rotated at `time` that no file has yet.
+ */
+std::string rotatedLogName(const std::string& path, std::time_t time);
+
+/**
+ * @brief Lists the rotated files of the log file `path`, compressed or not, oldest first.
+ */
+std::vector<std::string> listRotatedLogs(const std::string& path);
+
+/**
+ * @brief Gzips `path` into `path.gz` and deletes `path`.
+ *
+ * The compressed file only gets its final name once it is complete, so a failure never leaves a
+ * partial `.gz` file.
+ *
+ * @param path The rotated log file.
+ * @param error Receives a description of the failure.
+ * @return `true` on success, `false` otherwise (`path` is then kept).
+ */
+bool compressLogFile(const std::string& path, std::string& error);
+
+/**
+ * @brief Deletes the oldest rotated files of the log file `path` beyond the newest `keep`.
+ */
+void pruneRotatedLogs(const std::string& path, size_t keep);
+
+/**
+ * @class LogArchiver
+ * @brief Background thread compressing rotated log files and applying the retention count.
+ *
+ * The thread is started by the first submitted file, so a Logger that never rotates has none.
+ */
+class LogArchiver
+{
+  public:
+    LogArchiver();
+
+    /**
+     * @brief Waits for the submitted files to be archived.
+     */
+    ~LogArchiver();
+
+    LogArchiver(const LogArchiver&) = delete;
+    LogArchiver& operator=(const LogArchiver&) = delete;
+
+    /**
+     * @brief Queues a rotated file for compression (if `policy.compress`) and retention.
+     *
+     * @param logPath The log file it was rotated from.
+     * @param rotatedPath The rotated file.
+     * @param policy The rotation policy in force.
+     */
+    void submit(const std::string& logPath, const std::string& rotatedPath, const LogRotationPolicy& policy);
+
+    /**
+     * @brief Archives every submitted file, then stops the thread.
+     */
+    void finish();
+
+  private:
+    struct Job
+    {
+        std::string logPath;      /**< Log file the rotated file came from */
+        std::string rotatedPath;  /**< The rotated file */
+        LogRotationPolicy policy; /**< Rotation policy in force */
+    };
+
+    void run();
+
+    std::thread m_thread;          /**< Archiving thread, once started */
+    std::mutex m_mutex;            /**< Protects `m_jobs` and `m_stopping` */
+    std::condition_variable m_cv;  /**< Signals new jobs and the stop request */
+    std::deque<Job> m_jobs;        /**< Files waiting to be archived */
+    bool m_stopping;               /**< Set by finish() */
+};
+
+#endif // LOG_ROTATION_H
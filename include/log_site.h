@@ -0,0 +1,107 @@
+/**
+ * @file log_site.h
+ * @brief Declares LogSite, which protects the log from floods of messages from one call site.
+ *
+ * A call site that can fail once per process per sampling epoch (reading `/proc/<pid>/stat`, for
+ * instance) would otherwise write thousands of lines per epoch on a host where processes come and
+ * go. Such sites keep a static LogSite and either:
+ *
+ * - count expected failures with `count(errno)`, which costs one atomic increment; or
+ * - ask `allow()` before logging, a token bucket that lets a burst through and then a steady rate.
+ *
+ * The logger thread turns the counts into one summary line per site and error every summary
+ * interval, e.g. "412 stat reads failed with ENOENT in the last 5 s", and reports how many
+ * messages the token bucket held back.
+ */
+
+#ifndef LOG_SITE_H
+#define LOG_SITE_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @class LogSite
+ * @brief Rate limit and failure counters of one logging call site.
+ *
+ * Sites register themselves in a global list for the lifetime of the object; they are meant to be
+ * function-local statics.
+ */
+class LogSite
+{
+  public:
+    /** @brief Errors counted separately; any other error is counted as "other". */
+    static constexpr int kTrackedErrors[] = {ENOENT, ESRCH, EACCES};
+
+    /** @brief Names of kTrackedErrors and of "other", as written in summaries. */
+    static constexpr const char* kCounterNames[] = {"ENOENT", "ESRCH", "EACCES", "other errors"};
+
+    /** @brief Number of failure counters: the tracked errors and "other". */
+    static constexpr size_t kCounters = sizeof(kTrackedErrors) / sizeof(kTrackedErrors[0]) + 1;
+
+    /**
+     * @brief Registers a call site.
+     *
+     * @param description What the site does, in the plural ("stat reads"); a string literal.
+     * @param ratePerSecond Messages per second `allow()` lets through in the long run.
+     * @param burst Messages `allow()` lets through at once.
+     */
+    LogSite(const char* description, double ratePerSecond = 1.0, int burst = 10);
+
+    /**
+     * @brief Unregisters the site.
+     */
+    ~LogSite();
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    /**
+     * @brief Takes a token from the bucket of the site.
+     *
+     * @return `true` if the caller may log, `false` if the message must be dropped (it is then
+     *         counted in the summary).
+     */
+    bool allow();
+
+    /**
+     * @brief Counts an expected failure, reported in the next summary instead of on its own.
+     *
+     * @param error The `errno` value of the failure.
+     */
+    void count(int error);
+
+    /**
+     * @brief Returns what the site does, as given to the constructor.
+     */
+    const char* description() const;
+
+    /**
+     * @brief Returns and resets the failures counted for `kTrackedErrors[index]` (or "other" for
+     *        the last index), for the logger thread.
+     */
+    uint64_t takeFailures(size_t index);
+
+    /**
+     * @brief Returns and resets the number of messages `allow()` refused, for the logger thread.
+     */
+    uint64_t takeSuppressed();
+
+    /**
+     * @brief Calls `visit(LogSite&)` for every registered site, with registration blocked.
+     */
+    static void forEach(const std::function<void(LogSite&)>& visit);
+
+  private:
+    const char* m_description;                   /**< What the site does */
+    int64_t m_intervalNs;                        /**< Time to earn one token */
+    int64_t m_burstNs;                           /**< How far ahead of time the bucket may run */
+    std::atomic<int64_t> m_theoreticalTime;      /**< When the bucket is full again (GCRA) */
+    std::atomic<uint64_t> m_suppressed;          /**< Messages refused since the last summary */
+    std::atomic<uint64_t> m_failures[kCounters]; /**< Failures since the last summary, per error */
+};
+
+#endif // LOG_SITE_H
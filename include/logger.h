@@ -4,18 +4,33 @@
  *
  * The Logger class implements a thread-safe singleton pattern to manage log messages
  * with different severity levels. It supports asynchronous logging to a specified file.
+ *
+ * Messages travel from the logging threads to the logger thread through a LogRing, a bounded
+ * lock-free ring of fixed-size slots, so that threads logging at the same time do not serialize
+ * on a lock and a call to `log()` costs a copy of the message rather than its formatting.
+ *
+ * Formatted messages (`log(level, "Failed to open {}", path)`) go further: the calling thread only
+ * copies the address of the format string and the raw arguments into the slot, and the logger
+ * thread does the formatting. A message below the minimum level costs a load and a comparison.
  */
 
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
 
 /**
  * @enum LogLevel
@@ -31,6 +46,233 @@ enum class LogLevel
     CRITICAL /**< Critical error messages */
 };
 
+/**
+ * @enum LogFormat
+ * @brief Encoding of the log file.
+ */
+enum class LogFormat
+{
+    Text,  /**< One line per message: date, time, level and message */
+    Binary /**< Length-prefixed records with template ids and packed arguments (see log_record.h) */
+};
+
+class BinaryLogEncoder;
+class LogArchiver;
+
+/**
+ * @class LogRing
+ * @brief Bounded multi-producer, single-consumer ring of log messages.
+ *
+ * Each slot carries a sequence number that tells producers and the consumer whose turn it is
+ * (Vyukov's bounded queue), so producers only contend on one atomic counter and the consumer
+ * takes no lock at all. Messages longer than a slot are cut.
+ */
+class LogRing
+{
+  public:
+    /** @brief Number of slots (a power of two). */
+    static constexpr size_t kCapacity = 4096;
+
+    /** @brief Longest message (or packed arguments) stored in a slot, in bytes; longer ones are cut. */
+    static constexpr size_t kTextBytes = 224;
+
+    /**
+     * @struct Slot
+     * @brief One queued message, the size of four cache lines.
+     */
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> sequence; /**< Ticket the slot is ready for (see LogRing) */
+        std::time_t time;               /**< Time the message was logged */
+        const char* format;             /**< Format string, or `nullptr` if `text` is the message */
+        LogLevel level;                 /**< Severity of the message */
+        uint32_t length;                /**< Bytes of `text` in use */
+        char text[kTextBytes];          /**< The message or the packed arguments (see LogArgs) */
+    };
+
+    LogRing();
+
+    /**
+     * @brief Queues a message, unless the ring is full.
+     *
+     * Safe to call from any number of threads at once.
+     *
+     * @param level Severity of the message.
+     * @param time Time the message was logged.
+     * @param format Format string with static storage duration, or `nullptr` for a plain message.
+     * @param text The message, or the arguments packed by LogArgs.
+     * @param length Bytes of `text`; at most `kTextBytes` are kept.
+     * @param pending Receives the number of messages queued, this one included.
+     * @return `true` if the message was queued, `false` if the ring is full.
+     */
+    bool tryPush(LogLevel level, std::time_t time, const char* format, const char* text, size_t length,
+                 size_t& pending);
+
+    /**
+     * @brief Hands up to `limit` queued messages to `consumer(const Slot&)`, oldest first, and frees
+     *        their slots.
+     *
+     * Must only be called by one thread at a time.
+     *
+     * @return The number of messages consumed.
+     */
+    template <typename Consumer> size_t drain(Consumer&& consumer, size_t limit = kCapacity)
+    {
+        size_t consumed = 0;
+        uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        while (consumed < limit)
+        {
+            Slot& slot = m_slots[position & (kCapacity - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+            {
+                break; // Not written yet
+            }
+            consumer(static_cast<const Slot&>(slot));
+            slot.sequence.store(position + kCapacity, std::memory_order_release);
+            ++position;
+            ++consumed;
+        }
+        m_dequeuePosition.store(position, std::memory_order_relaxed);
+        return consumed;
+    }
+
+  private:
+    std::unique_ptr<Slot[]> m_slots;                  /**< The slots */
+    alignas(64) std::atomic<uint64_t> m_enqueuePosition; /**< Ticket of the next message */
+    alignas(64) std::atomic<uint64_t> m_dequeuePosition; /**< Ticket of the next message to consume */
+};
+
+/**
+ * @class LogArgs
+ * @brief Arguments of a formatted message, packed into at most the bytes of a ring slot.
+ *
+ * Each argument is stored as a one-byte tag followed by its value: 8 bytes for integers and
+ * floating-point numbers, 1 byte for characters and booleans, and a 2-byte length followed by the
+ * characters for strings. Strings are cut to the space left; an argument that does not fit at all
+ * is dropped with every argument after it, and its placeholder is written as is.
+ */
+class LogArgs
+{
+  public:
+    /** @brief Tags of the packed arguments. */
+    enum Tag : char
+    {
+        kSigned = 'i',   /**< int64_t */
+        kUnsigned = 'u', /**< uint64_t */
+        kDouble = 'd',   /**< double */
+        kChar = 'c',     /**< char */
+        kBool = 'b',     /**< bool, as one byte */
+        kString = 's'    /**< uint16_t length, then the characters */
+    };
+
+    LogArgs() : m_size(0), m_full(false) {}
+
+    /**
+     * @brief Packs one argument: an arithmetic type, an enumeration (as its value), or anything a
+     *        `std::string_view` can be built from.
+     */
+    template <typename T> void add(const T& value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            addScalar(kBool, static_cast<char>(value ? 1 : 0));
+        else if constexpr (std::is_same_v<T, char>)
+            addScalar(kChar, value);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            addScalar(kSigned, static_cast<int64_t>(value));
+        else if constexpr (std::is_integral_v<T>)
+            addScalar(kUnsigned, static_cast<uint64_t>(value));
+        else if constexpr (std::is_floating_point_v<T>)
+            addScalar(kDouble, static_cast<double>(value));
+        else if constexpr (std::is_enum_v<T>)
+            add(static_cast<std::underlying_type_t<T>>(value));
+        else if constexpr (std::is_pointer_v<T>)
+            addString(value != nullptr ? std::string_view(value) : std::string_view("(null)"));
+        else
+            addString(std::string_view(value));
+    }
+
+    /** @brief Returns the packed bytes. */
+    const char* data() const { return m_bytes; }
+
+    /** @brief Returns the number of packed bytes. */
+    size_t size() const { return m_size; }
+
+  private:
+    template <typename T> void addScalar(Tag tag, T value)
+    {
+        if (m_full || m_size + 1 + sizeof(T) > sizeof(m_bytes))
+        {
+            m_full = true;
+            return;
+        }
+        m_bytes[m_size] = tag;
+        std::memcpy(m_bytes + m_size + 1, &value, sizeof(T));
+        m_size += 1 + sizeof(T);
+    }
+
+    void addString(std::string_view value)
+    {
+        if (m_full || m_size + 1 + sizeof(uint16_t) > sizeof(m_bytes))
+        {
+            m_full = true;
+            return;
+        }
+        auto length = static_cast<uint16_t>(std::min(value.size(), sizeof(m_bytes) - m_size - 1 - sizeof(uint16_t)));
+        m_bytes[m_size] = kString;
+        std::memcpy(m_bytes + m_size + 1, &length, sizeof(length));
+        std::memcpy(m_bytes + m_size + 1 + sizeof(length), value.data(), length);
+        m_size += 1 + sizeof(length) + length;
+    }
+
+    char m_bytes[LogRing::kTextBytes]; /**< Packed arguments */
+    size_t m_size;                     /**< Bytes of `m_bytes` in use */
+    bool m_full;                       /**< An argument did not fit; later ones are dropped */
+};
+
+/**
+ * @struct LogFlushPolicy
+ * @brief When the logging thread writes queued messages to the file, and syncs the file.
+ *
+ * Messages are collected in memory and written in one system call as soon as any condition holds.
+ */
+struct LogFlushPolicy
+{
+    size_t maxMessages = 256;     /**< Write once this many messages are waiting */
+    int maxDelayMs = 50;          /**< Write once the oldest waiting message is this old */
+    bool flushOnCritical = true;  /**< Write as soon as a CRITICAL message is logged */
+    int syncIntervalMs = 0;       /**< Call fdatasync() this often while messages are written (0: never) */
+    int summaryIntervalMs = 5000; /**< Log the counts of the LogSite call sites this often (0: never) */
+};
+
+/**
+ * @struct LogRotationPolicy
+ * @brief When the logging thread moves the log file aside and starts a new one, and what becomes of
+ *        the rotated files (see log_rotation.h).
+ *
+ * The file is rotated before the message that makes it reach `maxBytes`, or the first message
+ * logged after a multiple of `intervalSeconds` since the Unix epoch; a file without messages is
+ * never rotated.
+ */
+struct LogRotationPolicy
+{
+    uint64_t maxBytes = 0;   /**< Rotate once the file reaches this size (0: never) */
+    int intervalSeconds = 0; /**< Rotate at each multiple of this period (0: never) */
+    size_t keep = 5;         /**< Rotated files kept; older ones are deleted */
+    bool compress = true;    /**< Gzip rotated files on a background thread */
+};
+
+/**
+ * @struct LogStats
+ * @brief Counters of the messages written by the Logger and the system calls they cost.
+ */
+struct LogStats
+{
+    uint64_t messages = 0;   /**< Messages written to the file */
+    uint64_t writeCalls = 0; /**< write() system calls */
+    uint64_t syncCalls = 0;  /**< fdatasync() system calls */
+    uint64_t rotations = 0;  /**< Log files rotated */
+};
+
 /**
  * @class Logger
  * @brief Singleton class responsible for managing log messages.
@@ -53,11 +295,13 @@ class Logger
      * @brief Starts logging by opening the specified log file.
      *
      * Initializes the logging system by opening the given file and starting the logging thread.
+     * Messages are appended to the file, which must be empty or already be in `format`.
      *
      * @param filename The name of the file to which log messages will be written.
+     * @param format Encoding of the file.
      * @return `true` if logging was successfully started, `false` otherwise.
      */
-    bool start(const std::string& filename);
+    bool start(const std::string& filename, LogFormat format = LogFormat::Text);
 
     /**
      * @brief Stops logging gracefully.
@@ -70,13 +314,56 @@ class Logger
      * @brief Logs a message with the specified log level.
      *
      * Queues the message for asynchronous logging. The message will be written to the log file
-     * with a timestamp and appropriate severity prefix.
+     * with a timestamp and appropriate severity prefix, according to the flush policy. The logger
+     * thread is only woken by the message completing a batch of `maxMessages` and by CRITICAL
+     * messages; when the ring is full, the caller waits for the logger thread to free a slot.
      *
      * @param level The severity level of the log message.
      * @param message The content of the log message.
      */
     void log(LogLevel level, const std::string& message);
 
+    /**
+     * @brief Logs a message formatted by the logger thread.
+     *
+     * Each `{}` of `format` is replaced by the next argument, as is `{pid}`, which also marks the
+     * argument as a process ID in binary logs; placeholders without an argument are written as is.
+     * Nothing is formatted or copied when the level is below the minimum level or logging is not
+     * active. Only the address of `format` is queued, so it must be a string literal (or another
+     * array that outlives the logger).
+     *
+     * @param level The severity level of the log message.
+     * @param format The message, with a `{}` placeholder per argument.
+     * @param args Arithmetic values, enumerations or strings (see LogArgs).
+     */
+    template <size_t N, typename... Args> void log(LogLevel level, const char (&format)[N], const Args&... args)
+    {
+        if (!shouldLog(level))
+            return;
+        LogArgs packed;
+        (packed.add(args), ...);
+        push(level, format, packed.data(), packed.size());
+    }
+
+    /**
+     * @brief Returns whether a message of `level` would be queued, to skip building it otherwise.
+     */
+    bool shouldLog(LogLevel level) const
+    {
+        return level >= m_minLevel.load(std::memory_order_relaxed) && m_active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the lowest severity that is logged; messages below it are discarded by the
+     *        calling thread (INFO by default).
+     */
+    void setMinLevel(LogLevel level);
+
+    /**
+     * @brief Returns the lowest severity that is logged.
+     */
+    LogLevel minLevel() const;
+
     /**
      * @brief Logs an informational message.
      *
@@ -86,6 +373,14 @@ class Logger
      */
     void info(const std::string& message);
 
+    /**
+     * @brief Logs an informational message formatted by the logger thread (see the formatted `log()`).
+     */
+    template <size_t N, typename... Args> void info(const char (&format)[N], const Args&... args)
+    {
+        log(LogLevel::INFO, format, args...);
+    }
+
     /**
      * @brief Logs a warning message.
      *
@@ -95,6 +390,14 @@ class Logger
      */
     void warning(const std::string& message);
 
+    /**
+     * @brief Logs a warning message formatted by the logger thread (see the formatted `log()`).
+     */
+    template <size_t N, typename... Args> void warning(const char (&format)[N], const Args&... args)
+    {
+        log(LogLevel::WARNING, format, args...);
+    }
+
     /**
      * @brief Logs an error message.
      *
@@ -104,6 +407,14 @@ class Logger
      */
     void error(const std::string& message);
 
+    /**
+     * @brief Logs an error message formatted by the logger thread (see the formatted `log()`).
+     */
+    template <size_t N, typename... Args> void error(const char (&format)[N], const Args&... args)
+    {
+        log(LogLevel::ERROR, format, args...);
+    }
+
     /**
      * @brief Logs a critical error message.
      *
@@ -113,6 +424,47 @@ class Logger
      */
     void critical(const std::string& message);
 
+    /**
+     * @brief Logs a critical error message formatted by the logger thread (see the formatted `log()`).
+     */
+    template <size_t N, typename... Args> void critical(const char (&format)[N], const Args&... args)
+    {
+        log(LogLevel::CRITICAL, format, args...);
+    }
+
+    /**
+     * @brief Sets when queued messages are written and when the file is synced.
+     *
+     * Takes effect at the next wakeup of the logging thread; may be called before `start()`.
+     *
+     * @param policy The flush policy.
+     */
+    void setFlushPolicy(const LogFlushPolicy& policy);
+
+    /**
+     * @brief Returns the current flush policy.
+     */
+    LogFlushPolicy flushPolicy();
+
+    /**
+     * @brief Sets when the log file is rotated, and how rotated files are archived.
+     *
+     * Takes effect at the next wakeup of the logging thread; may be called before `start()`.
+     *
+     * @param policy The rotation policy.
+     */
+    void setRotationPolicy(const LogRotationPolicy& policy);
+
+    /**
+     * @brief Returns the current rotation policy.
+     */
+    LogRotationPolicy rotationPolicy();
+
+    /**
+     * @brief Returns the counters of written messages and system calls since the program started.
+     */
+    LogStats stats() const;
+
   private:
     /**
      * @brief Private constructor to enforce singleton pattern.
@@ -133,38 +485,96 @@ class Logger
     /**
      * @brief Processes the queued log messages in a dedicated thread.
      *
-     * Continuously monitors the message queue and writes log entries to the file.
-     * Terminates when `m_active` is set to `false`.
+     * Sleeps until woken or until the oldest collected message is due, formats the queued messages
+     * into one buffer and writes it when the flush policy says so. Terminates when `m_active` is
+     * set to `false`, after writing and (if enabled) syncing everything.
      */
     void processQueue();
 
     /**
-     * @brief Formats a log message with a timestamp and severity level.
+     * @brief Turns the counters of every LogSite into summary messages, reset to zero, and hands them
+     *        to `collect(const LogRing::Slot&)` like queued messages.
      *
-     * Constructs a formatted string that includes the current timestamp, the log level,
-     * and the message content.
+     * @param elapsed Time since the previous summaries, which the messages mention.
+     */
+    template <typename Collect>
+    void collectSiteSummaries(std::chrono::steady_clock::duration elapsed, Collect& collect);
+
+    /**
+     * @brief Writes `buffer` to the log file, retrying partial writes, and empties it.
+     */
+    void writeBatch(std::string& buffer);
+
+    /**
+     * @brief Opens `m_path` for appending in `m_format`, writing the binary header if it is new.
      *
-     * @param level The severity level of the log message.
-     * @param message The content of the log message.
-     * @return A formatted log message string.
+     * @return `false` if the file cannot be opened or holds messages in the other format.
+     */
+    bool openFile();
+
+    /**
+     * @brief Returns whether the file must be rotated before a message logged at `time`, with
+     *        `pendingBytes` collected but not written yet.
+     */
+    bool rotationDue(const LogRotationPolicy& rotation, size_t pendingBytes, std::time_t time) const;
+
+    /**
+     * @brief Renames the log file aside, opens a new one and hands the old one to the archiver.
+     *
+     * Called by the logging thread, with nothing left to write to the old file.
+     */
+    void rotateFile(const LogRotationPolicy& rotation);
+
+    /**
+     * @brief Queues a message or packed arguments, waiting for a free slot if the ring is full,
+     *        and wakes the logger thread when the flush policy says so.
      */
-    std::string formatLogMessage(LogLevel level, const std::string& message);
+    void push(LogLevel level, const char* format, const char* text, size_t length);
 
     /**
-     * @brief Converts a LogLevel enum to its corresponding string representation.
+     * @brief Wakes the logger thread before its timeout.
+     */
+    void wakeLoggerThread();
+
+    /**
+     * @brief Appends a log line with a timestamp and severity level to `out`, formatting the
+     *        message first if it was queued with its arguments.
+     *
+     * The date and time are only converted when the second changes.
      *
-     * @param level The LogLevel to convert.
-     * @return A string representing the log level (e.g., "INFO", "WARNING").
+     * @param out Buffer the line is appended to, with its newline.
+     * @param slot The queued message.
      */
-    std::string logLevelToString(LogLevel level);
+    void formatLogMessage(std::string& out, const LogRing::Slot& slot);
 
-    std::ofstream m_logFile;         /**< Output file stream for logging. */
+    int m_fd;                        /**< Descriptor of the log file, or -1. */
+    std::string m_path;              /**< Path of the log file, set by `start()`. */
+    LogFormat m_format;              /**< Encoding of the log file, set by `start()`. */
+    uint64_t m_fileBytes;            /**< Size of the log file, for the logging thread. */
+    uint64_t m_emptyBytes;           /**< Size of the log file before its first message (its header). */
+    std::time_t m_openedAt;          /**< When the log file was opened. */
+    bool m_rotationFailed;           /**< The file could not be renamed; no rotation until restarted. */
+    LogRotationPolicy m_rotation;    /**< Rotation policy, protected by `m_wakeMutex`. */
+    std::unique_ptr<LogArchiver> m_archiver; /**< Compresses and prunes rotated files. */
+    std::unique_ptr<BinaryLogEncoder> m_encoder; /**< Encoder of binary records, for the logging thread. */
     std::atomic<bool> m_active;      /**< Atomic flag indicating if logging is active. */
     std::thread m_logThread;         /**< Thread dedicated to processing log messages. */
     std::mutex m_mutex;              /**< Mutex for synchronizing start/stop operations. */
-    std::mutex m_queueMutex;         /**< Mutex for protecting access to the message queue. */
-    std::condition_variable m_cv;    /**< Condition variable for notifying the logging thread. */
-    std::queue<std::string> m_queue; /**< Queue holding pending log messages. */
+    LogRing m_ring;                  /**< Messages waiting for the logging thread. */
+    std::mutex m_wakeMutex;          /**< Mutex protecting `m_wakeRequested`. */
+    std::condition_variable m_cv;    /**< Condition variable for waking the logging thread. */
+    bool m_wakeRequested;            /**< Set when the logging thread should not wait for its timeout. */
+    LogFlushPolicy m_policy;         /**< Flush policy, protected by `m_wakeMutex`. */
+    std::atomic<size_t> m_wakeBatch; /**< `m_policy.maxMessages`, read by the logging threads. */
+    std::atomic<bool> m_flushOnCritical; /**< `m_policy.flushOnCritical`, read by the logging threads. */
+    std::atomic<uint64_t> m_messagesWritten; /**< See LogStats. */
+    std::atomic<uint64_t> m_writeCalls;      /**< See LogStats. */
+    std::atomic<uint64_t> m_syncCalls;       /**< See LogStats. */
+    std::atomic<uint64_t> m_rotations;       /**< See LogStats. */
+    std::atomic<LogLevel> m_minLevel;        /**< Lowest severity that is logged. */
+    std::time_t m_cachedSecond;              /**< Second of `m_cachedDate`, for the logging thread. */
+    char m_cachedDate[32];                   /**< "YYYY-MM-DD HH:MM:SS" of `m_cachedSecond`. */
+    size_t m_cachedDateLength;               /**< Characters of `m_cachedDate`. */
 };
 
 #endif // LOGGER_H
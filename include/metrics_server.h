@@ -0,0 +1,112 @@
+/**
+ * @file metrics_server.h
+ * @brief Declares the Prometheus exposition endpoint.
+ *
+ * With `--metrics [<address>:]<port>` a MetricsServer answers `GET /metrics` over HTTP with gauges
+ * computed from the latest snapshot, in the Prometheus text format (version 0.0.4):
+ *
+ * - `process_manager_processes`: processes in the snapshot;
+ * - `process_manager_snapshot_timestamp_seconds`: wall-clock time of the snapshot;
+ * - `process_manager_process_cpu_percent` and `process_manager_process_resident_bytes`, labelled
+ *   with `pid`, `user` and `command`, for the `--metrics-top` processes using the most CPU and the
+ *   `--metrics-top` processes using the most memory. Every other process is summed into one series
+ *   with `pid="other"`, so the number of series does not grow with the number of processes and
+ *   the sum over a metric is still the total;
+ * - `process_manager_other_processes`: processes summed into the `other` series;
+ * - `process_manager_user_cpu_percent`, `process_manager_user_resident_bytes` and
+ *   `process_manager_user_processes`, labelled with `user`.
+ *
+ * The response is rendered once per snapshot and then served as is, so the cost of a scrape does
+ * not depend on how often Prometheus scrapes.
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "frame_buffer.h"
+#include "poll_server.h"
+#include "process_snapshot.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Renders the metrics of a snapshot in the Prometheus text format.
+ *
+ * @param out Buffer the metrics are appended to.
+ * @param snapshot The snapshot.
+ * @param top Processes exported individually per ranking (CPU and memory).
+ * @param timestampMs Wall-clock time of the snapshot in milliseconds since the Unix epoch.
+ */
+void renderMetrics(FrameBuffer& out, const ProcessSnapshot& snapshot, size_t top, int64_t timestampMs);
+
+/**
+ * @class MetricsServer
+ * @brief Single-threaded, poll-based HTTP server of the metrics endpoint.
+ *
+ * Only the small subset of HTTP/1.1 that scrapers use is supported: `GET` requests without a
+ * body, answered in order on persistent connections. The client loop is the one of PollServer.
+ */
+class MetricsServer : public PollServer
+{
+  public:
+    /** @brief Maximum number of connected clients; further connections are closed right away. */
+    static constexpr size_t kMaxClients = 64;
+
+    /** @brief Maximum size of a request head (request line and headers). */
+    static constexpr size_t kMaxRequestBytes = 8192;
+
+    /**
+     * @brief Constructs a server exporting `top` processes per ranking.
+     */
+    explicit MetricsServer(size_t top = 50);
+    ~MetricsServer() override;
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Creates the listening socket.
+     *
+     * @param address `<port>` (on 127.0.0.1) or `<IPv4 address>:<port>`; port 0 picks a free port.
+     * @param error Receives a description of the failure.
+     * @return `true` on success, `false` otherwise.
+     */
+    bool start(const std::string& address, std::string& error);
+
+    /**
+     * @brief Disconnects every client and closes the listening socket.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the port the server listens on, or 0 if it is not started.
+     */
+    int port() const;
+
+    /**
+     * @brief Returns how many times the metrics were rendered, i.e. the number of distinct
+     *        snapshots scraped so far.
+     */
+    uint64_t renderCount() const;
+
+  private:
+    void handleRequests(Client& client) override;
+    void handleRequest(Client& client, const std::string& head);
+    void appendResponse(Client& client, const char* status, const std::string& body, bool keepAlive);
+    const std::string* metricsBody();
+
+    size_t m_top;                                     /**< Processes exported per ranking */
+    int m_port;                                       /**< Bound port */
+    FrameBuffer m_scratch;                            /**< Rendering buffer */
+    std::atomic<uint64_t> m_renderCount;              /**< Renders so far */
+
+    // Metrics rendered for the last scraped snapshot, served to every scrape of the same epoch
+    std::shared_ptr<const ProcessSnapshot> m_cachedSnapshot;
+    std::string m_cachedBody;
+};
+
+#endif // METRICS_SERVER_H
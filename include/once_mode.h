@@ -0,0 +1,31 @@
+/**
+ * @file once_mode.h
+ * @brief Declares the one-shot mode, which prints the processes once and exits.
+ *
+ * The one-shot mode (`--once`) is meant for cron jobs and health checks. It scans the processes
+ * twice over a short window, so that CPU usage can be measured, prints the result as a table (or
+ * as JSON Lines or CSV) and returns. The readline loop, the monitoring threads and the logger
+ * thread are never started, which keeps its runtime close to the cost of the two scans.
+ */
+
+#ifndef ONCE_MODE_H
+#define ONCE_MODE_H
+
+#include "cli_options.h"
+#include <unistd.h>
+
+/**
+ * @brief Samples the processes over `options.windowMs`, writes the result and returns.
+ *
+ * The processes matching `options.filter` are ranked by `options.sortBy` and the first
+ * `options.top` are written (all of them with `top` 0). Without a stream format the output is the
+ * process table, sized to the terminal and color-coded when `fd` is a terminal; with a stream
+ * format it is one epoch of records, as in the stream mode.
+ *
+ * @param options The parsed command-line options.
+ * @param fd The file descriptor receiving the output.
+ * @return The process exit code: 0 on success, 1 if writing failed.
+ */
+int runOnceMode(const CliOptions& options, int fd = STDOUT_FILENO);
+
+#endif // ONCE_MODE_H
@@ -0,0 +1,282 @@
+/**
+ * @file policy_engine.h
+ * @brief Declares the policy engine: rules evaluated against every sampling epoch, with actions
+ *        taken on the processes that keep matching them.
+ *
+ * A policy file holds one rule per line, such as
+ *
+ *     cpu > 95 for 30s and user != root -> term 10s, renice 10, alert
+ *
+ * Conditions compare a field of a process (`cpu` in percent, `memory` in MB, `pid`, `user` or
+ * `command`) with a value and are joined by `and`. With `for <duration>`, a process must match in
+ * every epoch for that long before the rule fires; without it, the rule fires on the first epoch
+ * that matches. A rule fires once per process and fires again only after the process stopped
+ * matching for an epoch. The actions after `->` (or `→`) run in order, separated by commas or
+ * `then`:
+ * - `term` sends SIGTERM; `term <duration>` also sends SIGKILL if the process still runs after
+ *   that grace period (see TerminationManager).
+ * - `kill` sends SIGKILL.
+ * - `renice <n>` sets the nice value of the process.
+ * - `alert` writes a critical message to the log.
+ * Blank lines and text after `#` are ignored.
+ *
+ * Rules are compiled once, when the file is loaded. Each epoch, the fields the rules test are copied
+ * into columns in one pass over the processes, strings replaced by the index of the rule literal
+ * they equal. A rule starts from the processes with its string value if it tests one for
+ * equality; otherwise thresholds on the same column are evaluated from the loosest to the
+ * strictest, each scanning only the processes that passed the one before. Only the processes that
+ * pass that first test are checked against the other conditions. The processes that match a rule
+ * are kept in a sorted array with the time they started matching, so the state of a rule is as
+ * small as the set of processes it currently matches.
+ */
+
+#ifndef POLICY_ENGINE_H
+#define POLICY_ENGINE_H
+
+#include "process_snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @enum PolicyField
+ * @brief Field of a process a condition tests.
+ */
+enum class PolicyField : uint8_t
+{
+    Cpu,    /**< CPU usage percentage */
+    Memory, /**< Memory usage in MB */
+    Pid,    /**< Process ID */
+    User,   /**< User owning the process */
+    Command /**< Command name */
+};
+
+/**
+ * @enum PolicyOperator
+ * @brief Comparison of a condition; strings support `==` and `!=` only.
+ */
+enum class PolicyOperator : uint8_t
+{
+    Greater,      /**< `>` */
+    GreaterEqual, /**< `>=` */
+    Less,         /**< `<` */
+    LessEqual,    /**< `<=` */
+    Equal,        /**< `==` (or `=`) */
+    NotEqual      /**< `!=` */
+};
+
+/**
+ * @struct PolicyCondition
+ * @brief One comparison of a rule.
+ */
+struct PolicyCondition
+{
+    PolicyField field; /**< Field tested */
+    PolicyOperator op; /**< Comparison */
+    double number = 0; /**< Value of a numeric field */
+    std::string text;  /**< Value as written (compared with a string field) */
+};
+
+/**
+ * @enum PolicyActionType
+ * @brief What a rule does to a process that matched it long enough.
+ */
+enum class PolicyActionType : uint8_t
+{
+    Terminate, /**< SIGTERM, escalated to SIGKILL after `graceMs` if it is not 0 */
+    Kill,      /**< SIGKILL */
+    Renice,    /**< `setpriority()` to `nice` */
+    Alert      /**< Critical log message */
+};
+
+/**
+ * @struct PolicyAction
+ * @brief One action of a rule.
+ */
+struct PolicyAction
+{
+    PolicyActionType type; /**< Action */
+    int nice = 0;          /**< Nice value of Renice */
+    int graceMs = 0;       /**< Grace period of Terminate, or 0 for SIGTERM only */
+};
+
+/**
+ * @struct PolicyRule
+ * @brief A compiled rule.
+ */
+struct PolicyRule
+{
+    std::string text;                        /**< The rule as written, for messages */
+    int line = 0;                            /**< Line of the rule in its file, or 0 */
+    std::vector<PolicyCondition> conditions; /**< Numeric conditions first, all of which must hold */
+    int64_t holdMs = 0;                      /**< Time the conditions must hold before the rule fires */
+    std::vector<PolicyAction> actions;       /**< Actions, in order */
+};
+
+/**
+ * @struct PolicyFiring
+ * @brief A rule that fired for a process, with the values that made it fire.
+ */
+struct PolicyFiring
+{
+    size_t rule;                       /**< Index of the rule */
+    std::string text;                  /**< The rule as written */
+    std::vector<PolicyAction> actions; /**< Actions of the rule, copied so the rules can be replaced meanwhile */
+    Process process;                   /**< The process, as sampled in the epoch that fired */
+};
+
+/**
+ * @struct PolicyRuleStatus
+ * @brief State of a rule, for the `policy` command.
+ */
+struct PolicyRuleStatus
+{
+    std::string text;     /**< The rule as written */
+    size_t matching = 0;  /**< Processes matching the rule in the last epoch */
+    uint64_t firings = 0; /**< Times the rule fired since it was loaded */
+};
+
+/**
+ * @brief Compiles one rule.
+ *
+ * @param text The rule, without comment.
+ * @param rule Receives the compiled rule.
+ * @param error Receives a description of the first error.
+ * @return `true` if the rule is valid, `false` otherwise.
+ */
+bool parsePolicyRule(const std::string& text, PolicyRule& rule, std::string& error);
+
+/**
+ * @brief Compiles every rule of a policy file.
+ *
+ * @param path The policy file.
+ * @param rules Receives the compiled rules.
+ * @param error Receives the line and description of the first error.
+ * @return `true` if the file could be read and every rule is valid, `false` otherwise.
+ */
+bool loadPolicyFile(const std::string& path, std::vector<PolicyRule>& rules, std::string& error);
+
+/**
+ * @class PolicyEngine
+ * @brief Evaluates compiled rules against each epoch and runs the actions of those that fire.
+ *
+ * Rules can be replaced from another thread while epochs are evaluated.
+ */
+class PolicyEngine
+{
+  public:
+    /**
+     * @brief Replaces the rules, forgetting the state of the previous ones.
+     */
+    void setRules(std::vector<PolicyRule> rules);
+
+    /**
+     * @brief Removes every rule.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of rules.
+     */
+    size_t ruleCount() const;
+
+    /**
+     * @brief Returns the state of every rule, in the order of the file.
+     */
+    std::vector<PolicyRuleStatus> status() const;
+
+    /**
+     * @brief Evaluates every rule against an epoch.
+     *
+     * @param snapshot The processes of the epoch, sorted by PID.
+     * @param nowMs Time of the epoch on a monotonic clock, in milliseconds.
+     * @param firings Receives the rules that fired, by rule then by PID.
+     */
+    void evaluate(const ProcessSnapshot& snapshot, int64_t nowMs, std::vector<PolicyFiring>& firings);
+
+    /**
+     * @brief Runs the actions of rules that fired, logging each one.
+     *
+     * Signals go through pidfds with the sampled start time (see `signalProcesses()`), so a process
+     * that exited and whose PID was reused is left alone.
+     */
+    void execute(const std::vector<PolicyFiring>& firings);
+
+    /**
+     * @brief Evaluates an epoch and runs the actions of the rules that fired; does nothing without rules.
+     *
+     * Called by the sampling loops after every epoch.
+     */
+    void run(const ProcessSnapshot& snapshot, int64_t nowMs);
+
+  private:
+    /** @brief Columns of an epoch, one per PolicyField; strings are replaced by the index of a rule literal. */
+    static constexpr size_t kColumns = 5;
+
+    /** @brief A condition as evaluated: a column compared with a value. */
+    struct Test
+    {
+        uint8_t column;    /**< PolicyField of the column */
+        PolicyOperator op; /**< Comparison */
+        double value;      /**< Number, or index of the literal for a string field */
+    };
+
+    /** @brief Where the processes checked against a rule come from. */
+    enum class Source : uint8_t
+    {
+        All,     /**< Every process: the rule has no condition */
+        Scan,    /**< The column of its first test */
+        Chain,   /**< The processes that passed the first test of the previous step, a looser threshold */
+        Postings /**< The processes with the string value of its first test */
+    };
+
+    /** @brief A rule in evaluation order. */
+    struct Step
+    {
+        uint32_t rule; /**< Index of the rule */
+        Source source; /**< Processes passing its first test */
+    };
+
+    /** @brief A process matching a rule. */
+    struct Match
+    {
+        int pid;                      /**< Process ID */
+        uint32_t fired;               /**< 1 if the rule fired for it since it started matching */
+        unsigned long long startTime; /**< Start time, telling a reused PID apart */
+        int64_t sinceMs;              /**< Time it started matching */
+    };
+
+    /** @brief Processes matching a rule, sorted by PID. */
+    struct RuleState
+    {
+        std::vector<Match> matches; /**< Matching processes */
+        uint64_t firings = 0;       /**< Times the rule fired */
+    };
+
+    /**
+     * @brief Returns the index of the rule literal equal to a string of a process, or -1, and lists
+     *        the process with that literal.
+     */
+    double internLiteral(size_t column, const std::string& text, uint32_t row);
+
+    mutable std::mutex m_mutex;                                /**< Protects everything below */
+    std::vector<PolicyRule> m_rules;                           /**< Compiled rules */
+    std::vector<std::vector<Test>> m_tests;                    /**< Conditions of each rule, the first one first */
+    std::vector<Step> m_steps;                                 /**< Rules grouped by the source of their processes */
+    std::vector<RuleState> m_states;                           /**< State of each rule */
+    std::unordered_map<std::string, int> m_literals[kColumns]; /**< Index of each string of the rules, by field */
+    bool m_usesColumn[kColumns] = {};                          /**< Columns some rule tests */
+    std::vector<double> m_columns[kColumns];                   /**< Fields of every process of the epoch */
+    std::vector<std::vector<uint32_t>> m_postings[kColumns];   /**< Processes with each literal, by field */
+    std::vector<int> m_pids;                                   /**< PID of every process of the epoch */
+    std::vector<unsigned long long> m_startTimes;              /**< Start time of every process of the epoch */
+    std::vector<uint32_t> m_passed;                            /**< Processes passing the first test of a step */
+    std::vector<uint32_t> m_candidates;                        /**< Processes passing every test of a rule */
+    std::vector<Match> m_scratch;                              /**< State being built, swapped with the rule's */
+    std::vector<PolicyFiring> m_firings;                       /**< Firings of the epoch being run */
+};
+
+#endif // POLICY_ENGINE_H
@@ -0,0 +1,103 @@
+/**
+ * @file poll_server.h
+ * @brief Declares the poll()-based client loop shared by the daemon and metrics servers.
+ *
+ * A PollServer owns a listening socket and its connected clients, all non-blocking, and runs one
+ * thread over them with poll(). It accepts connections, reads what the clients send and writes
+ * their pending output; the protocol is left to the derived class, which turns the received bytes
+ * of a client into output in `handleRequests()`.
+ */
+
+#ifndef POLL_SERVER_H
+#define POLL_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class PollServer
+ * @brief Single-threaded, poll-based loop over non-blocking client sockets.
+ *
+ * A client with unsent output is not read from until the output is written, so a slow client
+ * holds at most one answer in memory and cannot delay the others.
+ */
+class PollServer
+{
+  public:
+    virtual ~PollServer();
+
+    PollServer(const PollServer&) = delete;
+    PollServer& operator=(const PollServer&) = delete;
+
+    /**
+     * @brief Serves clients until `stopRequested` becomes `true` or the listening socket is closed.
+     *
+     * @param stopRequested Flag checked at least every 100 ms.
+     */
+    void serve(const std::atomic<bool>& stopRequested);
+
+    /**
+     * @brief Returns the number of connected clients.
+     */
+    size_t clientCount() const;
+
+  protected:
+    /**
+     * @brief Connection state of a client; derived servers may extend it (see `newClient()`).
+     */
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        int fd = -1;              /**< Connected socket */
+        std::string input;        /**< Received bytes not handled yet */
+        std::string output;       /**< Answer bytes not written yet */
+        size_t written = 0;       /**< Bytes of `output` already written */
+        bool closing = false;     /**< Close once `output` is written */
+        bool inputClosed = false; /**< The client will send no more requests */
+    };
+
+    /**
+     * @param name Name of the server in log messages (e.g., "Daemon").
+     * @param maxClients Maximum number of connected clients; further connections are closed right away.
+     * @param maxBufferedInput Received bytes above which a client is not read from until its
+     *        requests are handled.
+     */
+    PollServer(const char* name, size_t maxClients, size_t maxBufferedInput);
+
+    /**
+     * @brief Returns the state of a new client. Override to add protocol state.
+     */
+    virtual std::unique_ptr<Client> newClient();
+
+    /**
+     * @brief Handles the complete requests in `client.input`, appending the answers to
+     *        `client.output` and removing the requests from `client.input`.
+     *
+     * Called after bytes were received and whenever the output of the client was fully written.
+     * Set `client.closing` to close the connection once the output is written.
+     */
+    virtual void handleRequests(Client& client) = 0;
+
+    /**
+     * @brief Disconnects every client and closes the listening socket.
+     */
+    void closeSockets();
+
+    int m_listenFd;                                 /**< Listening socket, set by the derived class, or -1 */
+    std::vector<std::unique_ptr<Client>> m_clients; /**< Connected clients */
+
+  private:
+    void acceptClients();
+    bool readRequests(Client& client);
+    bool writeOutput(Client& client);
+
+    const char* m_name;       /**< Name of the server in log messages */
+    size_t m_maxClients;      /**< Maximum number of connected clients */
+    size_t m_maxBufferedInput; /**< Received bytes read ahead of the handled requests, at most */
+};
+
+#endif // POLL_SERVER_H
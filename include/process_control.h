@@ -9,7 +9,118 @@
 #ifndef PROCESS_CONTROL_H
 #define PROCESS_CONTROL_H
 
+#include "process_info.h"
+#include <csignal>
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @enum KillOutcome
+ * @brief What became of one process asked to be signalled.
+ */
+enum class KillOutcome
+{
+    Killed,           /**< The signal was delivered (SIGKILL, after the grace period if there was one) */
+    Terminated,       /**< The process exited within the grace period after SIGTERM */
+    NotFound,         /**< No process has the PID any more */
+    Recycled,         /**< The PID now belongs to another process (its start time differs); not signalled */
+    PermissionDenied, /**< The process belongs to another user */
+    Refused,          /**< Invalid PID, the Process Manager itself or an unknown start time; not signalled */
+    Failed            /**< Another error, in `KillResult::error` */
+};
+
+/**
+ * @brief Returns a short description of an outcome ("killed", "no such process", ...).
+ */
+const char* killOutcomeName(KillOutcome outcome);
+
+/**
+ * @struct KillTarget
+ * @brief A process to signal, as seen when it was sampled.
+ */
+struct KillTarget
+{
+    int pid;                          /**< Process ID */
+    unsigned long long startTime = 0; /**< Start time when sampled (see Process); 0 (unknown) is refused */
+};
+
+/**
+ * @brief Returns a target for the process holding `pid` now, with its start time read from the
+ *        proc filesystem.
+ *
+ * For PIDs named by the user rather than taken from a snapshot. The start time is 0, and the
+ * target thus not signalled, if no process has the PID.
+ */
+KillTarget currentKillTarget(int pid);
+
+/**
+ * @struct KillResult
+ * @brief Outcome of signalling one target.
+ */
+struct KillResult
+{
+    int pid;             /**< Process ID of the target */
+    KillOutcome outcome; /**< What happened */
+    int error;           /**< `errno` of the failure, or 0 */
+};
+
+/**
+ * @struct KillReport
+ * @brief Outcomes of signalling a set of processes, in the order of the targets.
+ */
+struct KillReport
+{
+    std::vector<KillResult> results; /**< One result per target */
+
+    /** @brief Returns the number of targets with the given outcome. */
+    size_t count(KillOutcome outcome) const;
+
+    /** @brief Returns the number of processes signalled. */
+    size_t killed() const { return count(KillOutcome::Killed); }
+
+    /** @brief Returns the number of targets that were not signalled. */
+    size_t failed() const { return results.size() - killed(); }
+};
+
+/**
+ * @brief Resolves a target to a pidfd and checks that it is still the sampled process.
+ *
+ * @param target The process, with its sampled start time. Without one (0), the target is refused:
+ *               nothing tells the sampled process apart from one that reused its PID.
+ * @param self PID of the Process Manager, which is never signalled.
+ * @param pidfd Receives the pidfd, to close by the caller, or -1 if the kernel has no pidfds or no
+ *              descriptor is left (the target must then be signalled by PID; its start time was checked).
+ * @param result Receives why the target must not be signalled, when `false` is returned.
+ * @return `true` if the target may be signalled.
+ */
+bool openProcessHandle(const KillTarget& target, pid_t self, int& pidfd, KillResult& result);
+
+/**
+ * @brief Sends a signal to a target opened by `openProcessHandle()`.
+ *
+ * @return The outcome: Killed if the signal was delivered.
+ */
+KillResult signalProcessHandle(const KillTarget& target, int pidfd, int signal);
+
+/**
+ * @brief Signals a set of processes without risking a process that reused one of their PIDs.
+ *
+ * Each target is resolved to a pidfd (`pidfd_open()`), which pins the process it refers to, and
+ * its start time is compared with the sampled one before the signal is sent through the pidfd
+ * (`pidfd_send_signal()`). On kernels without pidfds, the start time is checked right before
+ * `kill()`. Large sets are split into batches signalled by several threads at once.
+ *
+ * Does not touch the shared processes map, so it may be called without holding `processMutex`.
+ *
+ * @param targets The processes to signal.
+ * @param signal The signal to send.
+ * @param threads Number of threads to use, or 0 to decide from the number of targets and cores.
+ * @return The outcome of each target, in order.
+ */
+KillReport signalProcesses(const std::vector<KillTarget>& targets, int signal = SIGKILL, size_t threads = 0);
 
 /**
  * @brief Attempts to terminate a process with the specified PID.
@@ -22,26 +133,57 @@
  */
 bool killProcess(int pid);
 
+/**
+ * @brief Returns the monitored processes for which `selected` is true, with their sampled start times.
+ *
+ * Holds `processMutex` only while selecting; `selected` is called under it.
+ */
+std::vector<KillTarget> selectKillTargets(const std::function<bool(const Process&)>& selected);
+
 /**
  * @brief Terminates all processes exceeding a specified CPU usage threshold.
  *
- * Iterates through the monitored processes and sends a SIGKILL signal to any process whose CPU usage
- * surpasses the provided threshold. Provides a summary of successful and failed termination attempts.
+ * Selects the monitored processes whose CPU usage surpasses the provided threshold, then releases
+ * `processMutex` and sends them SIGKILL with `signalProcesses()`, so the sampler is not held up and
+ * a PID reused since the sample is left alone. Prints each result and a summary.
  *
  * @param threshold The CPU usage percentage threshold. Processes exceeding this value will be killed.
- * @return `true` if at least one process was successfully terminated, `false` otherwise.
+ * @return The outcome of each selected process.
  */
-bool killProcessesByCpu(double threshold);
+KillReport killProcessesByCpu(double threshold);
 
 /**
  * @brief Terminates all processes owned by a specified user.
  *
- * Iterates through the monitored processes and sends a SIGKILL signal to any process owned by the
- * specified username. Provides a summary of successful and failed termination attempts.
+ * Selects the monitored processes owned by the specified username and kills them like
+ * `killProcessesByCpu()`. Prints each result and a summary.
  *
  * @param username The username whose processes should be terminated.
- * @return `true` if at least one process was successfully terminated, `false` otherwise.
+ * @return The outcome of each selected process.
+ */
+KillReport killProcessesByUser(const std::string& username);
+
+/**
+ * @brief Selects a process and all of its descendants, parents before their children.
+ *
+ * The parent links are read from the `stat` files when called (see `scanProcessTree()`) rather than
+ * taken from the last sampling epoch, so children forked since then are included. Each target
+ * carries the start time just read, so a PID reused before the signal is left alone.
+ *
+ * @param pid The Process ID of the root of the subtree.
+ * @return The targets, or an empty vector if no process has the PID.
+ */
+std::vector<KillTarget> selectProcessTree(int pid);
+
+/**
+ * @brief Terminates a process and all of its descendants.
+ *
+ * Selects the subtree with `selectProcessTree()` and kills it like `killProcessesByCpu()`. A process
+ * forked by the subtree after the selection escapes. Prints each result and a summary.
+ *
+ * @param pid The Process ID of the root of the subtree.
+ * @return The outcome of each selected process.
  */
-bool killProcessesByUser(const std::string& username);
+KillReport killProcessTree(int pid);
 
 #endif // PROCESS_CONTROL_H
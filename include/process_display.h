@@ -9,18 +9,104 @@
 #ifndef PROCESS_DISPLAY_H
 #define PROCESS_DISPLAY_H
 
+#include "cgroup_view.h"
+#include "frame_buffer.h"
 #include "process_info.h"
+#include "screen_renderer.h"
+#include <cstddef>
+#include <ostream>
 #include <vector>
 
+/** @brief Number of process rows printed when the terminal size is unknown or not relevant. */
+const size_t kDefaultTableRows = 30;
+
+/** @brief Table width, in columns, used when the terminal size is unknown. */
+const int kDefaultTableWidth = 100;
+
 /**
  * @brief Displays a list of processes in a formatted table.
  *
  * Prints the details of each process, including PID, user, CPU usage, memory usage, and command,
  * to the console. Applies current sorting and filtering criteria to determine the order and inclusion
- * of processes in the display.
+ * of processes in the display. The command column is sized to the width of the terminal. The table
+ * is written with a single `write(2)` under `coutMutex`, after flushing `std::cout`, so other
+ * output cannot end up between its lines.
  *
  * @param processes A vector of Process structs containing information about active processes.
  */
 void printProcesses(const std::vector<Process>& processes);
 
+/**
+ * @brief Writes the formatted process table to the given output stream.
+ *
+ * Same output as `printProcesses(processes)`, but rendered into `out` instead of the console.
+ * This allows the table to be captured or discarded (e.g., by benchmarks using a null sink).
+ *
+ * @param processes A vector of Process structs containing information about active processes.
+ * @param out The stream receiving the table.
+ */
+void printProcesses(const std::vector<Process>& processes, std::ostream& out);
+
+/**
+ * @brief Appends the formatted process table to a frame buffer.
+ *
+ * This is the formatter behind both `printProcesses()` overloads: a header, a separator and up to
+ * `maxRows` color-coded rows, with left-aligned columns. Commands are truncated (ending in "...")
+ * so that rows fit in `width` columns.
+ *
+ * @param processes A vector of Process structs containing information about active processes.
+ * @param out The buffer receiving the table.
+ * @param maxRows Maximum number of process rows.
+ * @param width Width of the table in columns.
+ * @param color `false` to leave out the color escape sequences (e.g., when the output is not a terminal).
+ */
+void formatProcessTable(const std::vector<Process>& processes, FrameBuffer& out, size_t maxRows = kDefaultTableRows,
+                        int width = kDefaultTableWidth, bool color = true);
+
+/**
+ * @brief Composes the process table into the frame of a screen renderer.
+ *
+ * Lays out the same table as `printProcesses()` so that the renderer can repaint only the cells
+ * that changed since the previous frame. The table fills the renderer's area: the separator spans
+ * its width, the command column takes the remaining columns, and there are as many process rows
+ * as fit below the header (the caller only needs to sort that many processes, see
+ * `tableRowsFor()`). The caller is responsible for `beginFrame()` and `render()`.
+ *
+ * @param processes A vector of Process structs containing information about active processes.
+ * @param screen The renderer receiving the frame.
+ */
+void composeProcessTable(const std::vector<Process>& processes, ScreenRenderer& screen);
+
+/**
+ * @brief Returns the number of process rows `composeProcessTable()` shows on a screen area.
+ *
+ * @param screen The renderer receiving the table.
+ * @return The rows of the area minus the header and separator.
+ */
+size_t tableRowsFor(const ScreenRenderer& screen);
+
+/**
+ * @brief Displays a list of cgroups in a formatted table, like `printProcesses()`.
+ *
+ * @param cgroups The cgroups to show, in order.
+ * @param maxRows Maximum number of cgroup rows.
+ */
+void printCgroups(const std::vector<CgroupUsage>& cgroups, size_t maxRows = kDefaultTableRows);
+
+/**
+ * @brief Appends the formatted cgroup table to a frame buffer.
+ *
+ * Same layout as `formatProcessTable()`, with the CPU and memory usage, the number of processes
+ * and the path of each cgroup. Paths are truncated (ending in "...") so that rows fit in `width`
+ * columns.
+ *
+ * @param cgroups The cgroups to show, in order.
+ * @param out The buffer receiving the table.
+ * @param maxRows Maximum number of cgroup rows.
+ * @param width Width of the table in columns.
+ * @param color `false` to leave out the color escape sequences.
+ */
+void formatCgroupTable(const std::vector<CgroupUsage>& cgroups, FrameBuffer& out, size_t maxRows = kDefaultTableRows,
+                       int width = kDefaultTableWidth, bool color = true);
+
 #endif // PROCESS_DISPLAY_H
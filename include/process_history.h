@@ -0,0 +1,177 @@
+/**
+ * @file process_history.h
+ * @brief Declares the per-process time-series history kept by the monitor.
+ *
+ * Every tracked process owns a fixed-size ring of recent CPU and memory samples. All rings live in
+ * one slab that is preallocated from a global memory budget, so the history never allocates while
+ * sampling and never grows beyond the budget. When the slab is full, the history of a process that
+ * has exited or has been idle the longest is evicted (least recently active first).
+ */
+
+#ifndef PROCESS_HISTORY_H
+#define PROCESS_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct HistorySample
+ * @brief One sample of a process, stored in single precision to halve the slab size.
+ */
+struct HistorySample
+{
+    float cpuUsage;    /**< CPU usage percentage */
+    float memoryUsage; /**< Memory usage in MB */
+};
+
+/**
+ * @struct HistoryUpdate
+ * @brief Sample of one process produced by a sampling epoch.
+ */
+struct HistoryUpdate
+{
+    int pid;            /**< Process ID */
+    double cpuUsage;    /**< CPU usage percentage */
+    double memoryUsage; /**< Memory usage in MB */
+};
+
+/**
+ * @struct HistoryStats
+ * @brief Summary statistics of a series of samples.
+ */
+struct HistoryStats
+{
+    size_t count = 0; /**< Number of samples */
+    double min = 0.0; /**< Smallest sample */
+    double avg = 0.0; /**< Arithmetic mean */
+    double max = 0.0; /**< Largest sample */
+    double p95 = 0.0; /**< 95th percentile (nearest rank) */
+};
+
+/**
+ * @class ProcessHistory
+ * @brief Fixed-budget store of recent samples for every tracked process.
+ *
+ * All methods are thread-safe.
+ */
+class ProcessHistory
+{
+  public:
+    /** @brief Default memory budget of the history, in bytes. */
+    static constexpr size_t kDefaultBudgetBytes = 8 * 1024 * 1024;
+
+    /** @brief Default number of samples kept per process. */
+    static constexpr size_t kDefaultWindow = 120;
+
+    /**
+     * @brief Creates a history with the given budget and window.
+     *
+     * @param budgetBytes Maximum memory used by the slab and its per-process bookkeeping.
+     * @param window Number of samples kept per process.
+     */
+    explicit ProcessHistory(size_t budgetBytes = kDefaultBudgetBytes, size_t window = kDefaultWindow);
+
+    /**
+     * @brief Changes the budget and window. All recorded samples are discarded.
+     *
+     * @param budgetBytes Maximum memory used by the slab and its per-process bookkeeping.
+     * @param window Number of samples kept per process.
+     */
+    void configure(size_t budgetBytes, size_t window);
+
+    /**
+     * @brief Records the samples of one sampling epoch.
+     *
+     * Processes that are not part of the epoch are considered exited and become the first
+     * candidates for eviction. Processes whose usage did not change are considered idle and are
+     * not refreshed in the LRU order.
+     *
+     * @param updates Samples of the processes seen during the epoch.
+     */
+    void recordEpoch(const std::vector<HistoryUpdate>& updates);
+
+    /**
+     * @brief Copies the samples of a process, oldest first.
+     *
+     * @param pid The Process ID.
+     * @param out Receives the samples.
+     * @return `true` if the process has a history, `false` otherwise.
+     */
+    bool samples(int pid, std::vector<HistorySample>& out) const;
+
+    /**
+     * @brief Returns the number of processes with a history.
+     */
+    size_t trackedCount() const;
+
+    /**
+     * @brief Returns the maximum number of processes that can have a history at the same time.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Returns the number of samples kept per process.
+     */
+    size_t window() const;
+
+    /**
+     * @brief Returns the memory budget, in bytes.
+     */
+    size_t budgetBytes() const;
+
+    /**
+     * @brief Returns the number of histories evicted to make room for other processes.
+     */
+    uint64_t evictions() const;
+
+    /**
+     * @brief Computes min/avg/max/p95 of a series.
+     *
+     * @param values The series (order does not matter).
+     * @return The statistics, with `count` set to 0 for an empty series.
+     */
+    static HistoryStats computeStats(const std::vector<double>& values);
+
+    /**
+     * @brief Renders a series as a sparkline of Unicode block characters.
+     *
+     * Consecutive samples are averaged when the series is longer than `width`.
+     *
+     * @param values The series, oldest first.
+     * @param width Maximum number of characters.
+     * @return The UTF-8 encoded sparkline.
+     */
+    static std::string sparkline(const std::vector<double>& values, size_t width);
+
+  private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    void resetLocked();
+    uint32_t acquireSlotLocked();
+    void unlinkLocked(uint32_t slot);
+    void pushFrontLocked(uint32_t slot);
+
+    mutable std::mutex m_mutex;                    /**< Protects every member below */
+    size_t m_budgetBytes;                          /**< Memory budget in bytes */
+    size_t m_window;                               /**< Samples per process */
+    size_t m_slots;                                /**< Number of rings in the slab */
+    std::vector<HistorySample> m_slab;             /**< `m_slots * m_window` samples */
+    std::vector<int> m_slotPid;                    /**< PID owning each ring */
+    std::vector<uint32_t> m_head;                  /**< Index of the next sample to write in each ring */
+    std::vector<uint32_t> m_count;                 /**< Number of valid samples in each ring */
+    std::vector<uint32_t> m_lastEpoch;             /**< Last epoch in which each ring's process was seen */
+    std::vector<uint32_t> m_prev;                  /**< LRU list: towards the most recently active ring */
+    std::vector<uint32_t> m_next;                  /**< LRU list: towards the least recently active ring */
+    uint32_t m_lruHead;                            /**< Most recently active ring */
+    uint32_t m_lruTail;                            /**< Least recently active ring */
+    uint32_t m_used;                               /**< Rings handed out since the last reset */
+    std::unordered_map<int, uint32_t> m_pidToSlot; /**< Ring owned by each tracked PID */
+    uint32_t m_epoch;                              /**< Number of epochs recorded */
+    uint64_t m_evictions;                          /**< Histories evicted so far */
+};
+
+#endif // PROCESS_HISTORY_H
@@ -27,6 +27,9 @@ struct Process
     double memoryUsage;  /**< Memory usage in MB */
     long prevTotalTime;  /**< Previous total CPU time of the process */
     std::string command; /**< Command associated with the process */
+    unsigned long long startTime = 0; /**< Start time in clock ticks since boot, telling apart processes that
+                                           reuse a PID (0 if unknown) */
+    int ppid = 0;                     /**< Parent process ID (0 if unknown or for the first process) */
 };
 
 /**
@@ -68,4 +71,24 @@ std::string getProcessCommand(int pid);
  */
 double getProcessMemoryUsage(int pid);
 
+/**
+ * @brief Reads the start time of a process, in clock ticks since boot (field 22 of `/proc/[pid]/stat`).
+ *
+ * A PID and its start time identify a process: a process reusing the PID has a later start time.
+ *
+ * @param pid The Process ID of the target process.
+ * @param startTime Receives the start time.
+ * @return `true` on success, `false` if the process does not exist or its stat file cannot be parsed.
+ */
+bool readProcessStartTime(int pid, unsigned long long& startTime);
+
+/**
+ * @brief Lists the PIDs of the running processes.
+ *
+ * Scans the `/proc` directory like `getActiveProcesses()`, without reading any per-process file.
+ *
+ * @return The PIDs found, in directory order.
+ */
+std::vector<int> getProcessIds();
+
 #endif // PROCESS_INFO_H
@@ -0,0 +1,94 @@
+/**
+ * @file process_snapshot.h
+ * @brief Declares the immutable process snapshots shared between the sampler and the display.
+ *
+ * The sampling threads publish a complete, immutable snapshot of the processes after every epoch.
+ * The display thread renders from the latest snapshot at its own rate, without taking the lock of
+ * the processes map, and interpolates the usage of every process between the last two snapshots so
+ * that a slow sample interval does not leave the screen frozen between samples.
+ */
+
+#ifndef PROCESS_SNAPSHOT_H
+#define PROCESS_SNAPSHOT_H
+
+#include "process_info.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @struct ProcessSnapshot
+ * @brief The processes of one sampling epoch.
+ */
+struct ProcessSnapshot
+{
+    int64_t timestampMs;              /**< Publication time on the steady clock, in milliseconds */
+    bool continuous;                  /**< `true` if the values continue the previous snapshot (live
+                                           sampling), `false` if they replace it (e.g., replay seeks) */
+    std::vector<Process> processes;   /**< Processes sorted by PID */
+};
+
+/**
+ * @class SnapshotPublisher
+ * @brief Holds the latest published snapshot.
+ *
+ * Publishing and reading only swap a shared pointer under a short lock; readers keep the snapshot
+ * they obtained alive for as long as they use it.
+ */
+class SnapshotPublisher
+{
+  public:
+    /**
+     * @brief Replaces the latest snapshot.
+     */
+    void publish(std::shared_ptr<const ProcessSnapshot> snapshot);
+
+    /**
+     * @brief Returns the latest snapshot, or `nullptr` if none was published since the last reset.
+     */
+    std::shared_ptr<const ProcessSnapshot> latest() const;
+
+    /**
+     * @brief Forgets the latest snapshot (e.g., when monitoring stops).
+     */
+    void reset();
+
+  private:
+    mutable std::mutex m_mutex;                      /**< Protects `m_latest` */
+    std::shared_ptr<const ProcessSnapshot> m_latest; /**< Latest published snapshot */
+};
+
+/**
+ * @brief Builds a snapshot from the processes of an epoch.
+ *
+ * @param processes The processes, in any order.
+ * @param timestampMs Publication time on the steady clock, in milliseconds.
+ * @param continuous Whether the snapshot continues the previous one (see ProcessSnapshot).
+ * @return The snapshot, with its processes sorted by PID.
+ */
+std::shared_ptr<const ProcessSnapshot> makeSnapshot(std::vector<Process> processes, int64_t timestampMs,
+                                                    bool continuous);
+
+/**
+ * @brief Computes the processes shown between two snapshots.
+ *
+ * Processes present in both snapshots (same PID and command) get their CPU and memory usage
+ * interpolated linearly: `fraction` 0 gives the values of `previous`, 1 those of `latest`. Processes
+ * that only appear in `latest` are shown with their latest values, and processes that exited are
+ * left out.
+ *
+ * @param previous The snapshot before `latest`.
+ * @param latest The latest snapshot.
+ * @param fraction Position between the two snapshots, clamped to [0, 1].
+ * @param out Receives the interpolated processes, sorted by PID.
+ */
+void interpolateSnapshots(const ProcessSnapshot& previous, const ProcessSnapshot& latest, double fraction,
+                          std::vector<Process>& out);
+
+/**
+ * @brief Returns the current time on the steady clock in milliseconds, as used for snapshot timestamps.
+ */
+int64_t steadyNowMs();
+
+#endif // PROCESS_SNAPSHOT_H
@@ -0,0 +1,136 @@
+/**
+ * @file process_tree.h
+ * @brief Declares the process tree: parent/child links and CPU and memory sums per subtree.
+ *
+ * The tree is kept up to date from one sampling epoch to the next instead of being rebuilt: a
+ * process that appears is linked under its parent, one that exits is unlinked, and a change in
+ * the usage of a process is added to the sums of its ancestors only. An epoch in which few
+ * processes change therefore costs a lookup per process plus the depth of the tree per change.
+ * This is what makes a runaway build visible as one `make` whose subtree holds the CPU time of
+ * hundreds of `cc1plus` children.
+ */
+
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include "process_info.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ProcessTree
+ * @brief Incrementally maintained tree of the sampled processes.
+ *
+ * A process whose parent is not part of the epoch (PID 1, kernel threads, processes of another PID
+ * namespace) is a root. Sums are kept in fixed point (hundredths of a percent and kB), so adding
+ * and removing the same values always leaves them exact. All methods are thread-safe.
+ */
+class ProcessTree
+{
+  public:
+    ProcessTree();
+
+    /**
+     * @brief Brings the tree to the state of a sampling epoch.
+     *
+     * Processes missing from `epoch` have exited and are removed; their children stay in the tree
+     * as roots until an epoch reports their new parent. A PID whose start time changed is a new
+     * process.
+     *
+     * @param epoch Every process of the epoch, with its parent PID.
+     */
+    void update(const std::vector<Process>& epoch);
+
+    /**
+     * @brief Removes every process.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of processes in the tree.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Reads the sums of the subtree rooted at a process (the process included).
+     *
+     * @param pid The Process ID.
+     * @param cpuUsage Receives the CPU usage of the subtree, in percent.
+     * @param memoryUsage Receives the memory usage of the subtree, in MB.
+     * @param count Receives the number of processes in the subtree.
+     * @return `true` if the process is in the tree, `false` otherwise.
+     */
+    bool subtreeUsage(int pid, double& cpuUsage, double& memoryUsage, size_t& count) const;
+
+    /**
+     * @brief Returns the process a subtree is rooted at followed by its descendants, parents before
+     *        their children.
+     *
+     * @param pid The Process ID of the root of the subtree.
+     * @return The processes, or an empty vector if `pid` is not in the tree.
+     */
+    std::vector<Process> subtree(int pid) const;
+
+    /**
+     * @brief Lays out the tree as rows of the process table.
+     *
+     * Rows come in depth-first order, children after their parent and siblings in descending order
+     * of the criterion. Each row holds the sums of its subtree as CPU and memory usage, and its
+     * command is indented by its depth. With a `cpu` or `memory` filter, subtrees below the
+     * threshold are left out (their descendants are below it too); with a `user` filter, only the
+     * rows of that user are kept, at the depth they have in the tree.
+     *
+     * @param criterion "cpu" or "memory"; any other value orders siblings by PID.
+     * @param filter Filter type and value, as for `filterProcesses()`.
+     * @param limit Maximum number of rows.
+     * @param rows Receives the rows.
+     */
+    void layout(const std::string& criterion, const std::pair<std::string, std::string>& filter, size_t limit,
+                std::vector<Process>& rows) const;
+
+  private:
+    /** @brief One process and its links, with the sums of its subtree. */
+    struct Node
+    {
+        Process process;           /**< Latest sample of the process */
+        int64_t cpu = 0;           /**< CPU usage of the process, in hundredths of a percent */
+        int64_t memory = 0;        /**< Memory usage of the process, in kB */
+        int64_t subtreeCpu = 0;    /**< `cpu` summed over the subtree */
+        int64_t subtreeMemory = 0; /**< `memory` summed over the subtree */
+        int64_t subtreeCount = 1;  /**< Processes in the subtree */
+        int parent = 0;            /**< PID the node is linked under, or 0 for a root */
+        int firstChild = 0;        /**< First child, or 0 */
+        int nextSibling = 0;       /**< Next child of the same parent, or 0 */
+        int previousSibling = 0;   /**< Previous child of the same parent, or 0 */
+        uint64_t seen = 0;         /**< Last epoch that reported the process */
+    };
+
+    void addToAncestors(int pid, int64_t cpu, int64_t memory, int64_t count);
+    void link(int pid, int parent);
+    void unlink(int pid);
+    void remove(int pid);
+    bool isAncestor(int ancestor, int pid) const;
+    void appendSubtree(int pid, std::vector<Process>& out) const;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<int, Node> m_nodes; /**< Processes by PID */
+    int m_firstRoot;                       /**< First root, linked through the sibling fields */
+    uint64_t m_epoch;                      /**< Number of updates so far */
+};
+
+/**
+ * @brief Builds the tree of the processes running now, from their `stat` files only.
+ *
+ * Used to act on a subtree (e.g., `kill_tree`) with fresh parent links rather than those of the
+ * last epoch. The processes have a PID, a parent PID and a start time.
+ *
+ * @param tree Receives the processes.
+ */
+void scanProcessTree(ProcessTree& tree);
+
+#endif // PROCESS_TREE_H
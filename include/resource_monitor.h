@@ -10,31 +10,154 @@
 #define RESOURCE_MONITOR_H
 
 #include "process_info.h"
+#include "process_snapshot.h"
+#include "session_record.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 /**
  * @brief Monitors and updates the list of active processes.
  *
  * Continuously scans for active processes, applies filtering and sorting criteria,
- * and updates the global processes map with the latest information.
+ * and updates the global processes map with the latest information. Redraws every
+ * `displayIntervalMs` milliseconds, or earlier when `displayRefreshRequested` or `terminalResized`
+ * is set.
+ *
+ * @param generation Session the thread belongs to, as returned by `beginMonitoring()`.
+ */
+void monitorProcesses(unsigned generation);
+
+/**
+ * @brief Renders the current processes map once.
+ *
+ * Applies the current filter and sorting criteria to the latest snapshot in `processSnapshots`
+ * (interpolated from the previous one during live monitoring) and draws the resulting table,
+ * rewriting only the cells that changed since the previous call (the whole table after
+ * `screenRepaintRequested` is set). The table is sized to the terminal and `displayRowLimit`, and
+ * only the processes it can show are sorted. This is the body of the display loop in
+ * `monitorProcesses()`.
+ */
+void displayProcessTable();
+
+/**
+ * @brief Replays a recorded session into the processes map.
+ *
+ * Runs in place of the CPU and memory monitoring threads: every frame of the session replaces the
+ * contents of the global processes map and asks the display thread to redraw, so recorded epochs go
+ * through the same filter/sort/display code as live data. Honors `monitoringPaused`,
+ * `replaySeekOffsetMs` and, in single-step mode, `replayStepRequests`. Returns when the last frame
+ * has been shown, clearing `monitoringActive` so the display stops too, or when monitoring is
+ * stopped.
+ *
+ * @param reader Opened session reader.
+ * @param speed Replay speed relative to the recording (e.g., 10 for ten times faster).
+ * @param stepMode If `true`, each frame is shown only after a step request.
+ * @param generation Session the thread belongs to, as returned by `beginMonitoring()`.
+ */
+void replaySession(std::shared_ptr<SessionReader> reader, double speed, bool stepMode, unsigned generation);
+
+/**
+ * @brief Selects the processes that match a filter criterion.
+ *
+ * Implements the filtering step of `monitorProcesses()`. The caller is responsible for holding
+ * `processMutex` when passing the global processes map.
+ *
+ * @param processMap Map of processes indexed by PID.
+ * @param filter Filter type and value (e.g., `{"user", "root"}`, `{"cpu", "50"}` or `{"none", ""}`).
+ * @return A vector with copies of the processes that pass the filter.
+ */
+std::vector<Process> filterProcesses(const std::unordered_map<int, Process>& processMap,
+                                     const std::pair<std::string, std::string>& filter);
+
+/**
+ * @brief Selects the processes of a list that match a filter criterion.
+ *
+ * Same as the map overload, for the processes of a snapshot.
+ *
+ * @param processList The processes to select from.
+ * @param filter Filter type and value (e.g., `{"user", "root"}`, `{"cpu", "50"}` or `{"none", ""}`).
+ * @return A vector with copies of the processes that pass the filter, in their original order.
+ */
+std::vector<Process> filterProcesses(const std::vector<Process>& processList,
+                                     const std::pair<std::string, std::string>& filter);
+
+/**
+ * @brief Sorts processes in descending order of the given criterion.
+ *
+ * Implements the sorting step of `monitorProcesses()`.
+ *
+ * @param processList The processes to sort in place.
+ * @param criterion Either "cpu" or "memory". Any other value leaves the order unchanged.
+ */
+void sortProcesses(std::vector<Process>& processList, const std::string& criterion);
+
+/**
+ * @brief Keeps the `limit` processes ranking highest for the given criterion, in descending order.
+ *
+ * Equivalent to sorting and truncating the list, but only the processes that are kept are fully
+ * sorted (selection is linear in the size of the list), which is what the display needs: it shows
+ * at most one screen of rows out of possibly thousands of processes.
+ *
+ * @param processList The processes to select from, in place.
+ * @param criterion Either "cpu" or "memory". With any other value the first `limit` processes are kept.
+ * @param limit Maximum number of processes to keep.
+ */
+void sortProcesses(std::vector<Process>& processList, const std::string& criterion, size_t limit);
+
+/**
+ * @brief Scans the processes once and updates the processes map.
+ *
+ * Computes the CPU usage of every process since the previous epoch, replaces the entries of the
+ * processes map (dropping processes that exited) and publishes the epoch to `processSnapshots`.
+ * This is the sampling step of `monitorCpu()`, also used by the headless stream mode.
+ *
+ * @param previousTotalCpuTime Total CPU time at the previous epoch; updated to the current one.
+ * @return The published snapshot of the epoch.
  */
-void monitorProcesses();
+std::shared_ptr<const ProcessSnapshot> sampleEpoch(long& previousTotalCpuTime);
+
+/**
+ * @brief Records the CPU time of every running process in the processes map.
+ *
+ * Reads only `[pid]/stat`, so it is much cheaper than a full epoch. The next `sampleEpoch()`
+ * then reports the CPU usage since this call instead of since the start of each process. Use it
+ * with a `previousTotalCpuTime` taken just before the call.
+ */
+void primeProcessTimes();
 
 /**
  * @brief Monitors CPU usage of processes.
  *
- * Periodically calculates the CPU usage for each monitored process by comparing
- * the current and previous total CPU times. Updates the CPU usage attribute of each process.
+ * Every `sampleIntervalMs` milliseconds, calculates the CPU usage for each monitored process by
+ * comparing the current and previous total CPU times. Updates the CPU usage attribute of each
+ * process and publishes the epoch to `processSnapshots`. Waits on `cv`, so a stop wakes it at once.
+ *
+ * @param generation Session the thread belongs to, as returned by `beginMonitoring()`.
  */
-void monitorCpu();
+void monitorCpu(unsigned generation);
 
 /**
  * @brief Monitors memory usage of processes.
  *
  * Periodically updates the memory usage attribute for each monitored process by reading
  * the latest data from the system.
+ *
+ * @param generation Session the thread belongs to, as returned by `beginMonitoring()`.
+ */
+void monitorMemory(unsigned generation);
+
+/**
+ * @brief Starts a monitoring session.
+ *
+ * Sets `monitoringActive` and advances `monitoringGeneration`. Threads of an earlier session that
+ * are still waiting exit when they wake up instead of running alongside the new ones.
+ *
+ * @return The generation to pass to the threads of the new session.
  */
-void monitorMemory();
+unsigned beginMonitoring();
 
 /**
  * @brief Retrieves the total CPU time from the system.
@@ -51,9 +174,12 @@ long getTotalCpuTime();
  * Reads the `/proc/[pid]/stat` file to calculate the total CPU time (user + system) consumed by the process.
  *
  * @param pid The Process ID of the target process.
+ * @param startTime If not null, receives the start time of the process read from the same line (see
+ *                  `readProcessStartTime()`), or 0.
+ * @param ppid If not null, receives the parent process ID read from the same line, or 0.
  * @return The total CPU time in jiffies, or 0 if it cannot be determined.
  */
-long getProcessTotalTime(int pid);
+long getProcessTotalTime(int pid, unsigned long long* startTime = nullptr, int* ppid = nullptr);
 
 /**
  * @brief Calculates the CPU usage percentage for a process.
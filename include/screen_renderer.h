@@ -0,0 +1,150 @@
+/**
+ * @file screen_renderer.h
+ * @brief Declares the screen model used to repaint only the parts of the terminal that changed.
+ *
+ * The renderer keeps the frame currently shown on the terminal as a grid of cells (a character and
+ * a color). A new frame is composed into a second grid; rendering compares both grids and emits
+ * cursor-addressed runs for the changed cells only, merging runs separated by a few unchanged cells
+ * (rewriting them is cheaper than another cursor movement) and erasing the ends of lines that became
+ * blank. A full repaint is only emitted for the first frame or after `invalidate()`.
+ */
+
+#ifndef SCREEN_RENDERER_H
+#define SCREEN_RENDERER_H
+
+#include "frame_buffer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @enum ScreenColor
+ * @brief Foreground colors available to screen cells.
+ */
+enum class ScreenColor : uint8_t
+{
+    FG_DEFAULT,
+    FG_RED,
+    FG_YELLOW,
+    FG_GREEN
+};
+
+/**
+ * @class ScreenRenderer
+ * @brief Double-buffered screen model producing minimal terminal updates.
+ *
+ * A frame is produced by calling `beginFrame()`, then `put()` for every piece of text, then
+ * `render()`. The renderer is not thread-safe; it is owned by the display thread.
+ */
+class ScreenRenderer
+{
+  public:
+    /**
+     * @brief Creates a renderer for a screen area of the given size.
+     *
+     * @param rows Number of rows of the area.
+     * @param columns Number of columns of the area.
+     */
+    ScreenRenderer(int rows, int columns);
+
+    /**
+     * @brief Changes the size of the area. The next frame is a full repaint.
+     */
+    void resize(int rows, int columns);
+
+    /**
+     * @brief Forgets what the terminal shows (e.g., after other output scrolled it), so the next
+     *        frame is a full repaint.
+     */
+    void invalidate();
+
+    /**
+     * @brief Starts composing a new frame on a blank grid.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Writes text into the frame being composed.
+     *
+     * Text is clipped to the area. Control characters and non-ASCII bytes are replaced with `?` so
+     * that every byte occupies exactly one cell.
+     *
+     * @param row Zero-based row.
+     * @param column Zero-based column.
+     * @param text The text to write.
+     * @param length Number of bytes of `text`.
+     * @param color The foreground color of the text.
+     * @return The column following the written text.
+     */
+    int put(int row, int column, const char* text, size_t length, ScreenColor color = ScreenColor::FG_DEFAULT);
+
+    /**
+     * @brief Convenience overload of `put()` for strings.
+     */
+    int put(int row, int column, const std::string& text, ScreenColor color = ScreenColor::FG_DEFAULT);
+
+    /**
+     * @brief Appends the escape sequences turning the previous frame into the composed one.
+     *
+     * Afterwards the cursor is left at the start of the line below the last non-blank row. Nothing
+     * is appended if the frame did not change.
+     *
+     * @param out Receives the escape sequences and text.
+     * @return The number of bytes appended.
+     */
+    size_t render(FrameBuffer& out);
+
+    /**
+     * @brief Returns the number of rows of the area.
+     */
+    int rows() const;
+
+    /**
+     * @brief Returns the number of columns of the area.
+     */
+    int columns() const;
+
+  private:
+    /**
+     * @brief One character cell of the screen.
+     */
+    struct Cell
+    {
+        char ch;
+        ScreenColor color;
+
+        bool operator==(const Cell& other) const
+        {
+            return ch == other.ch && color == other.color;
+        }
+        bool operator!=(const Cell& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    void moveCursor(FrameBuffer& out, int row, int column);
+    void setColor(FrameBuffer& out, ScreenColor color);
+    int lastUsedRow(const std::vector<Cell>& grid) const;
+
+    int m_rows;                 /**< Rows of the area */
+    int m_columns;              /**< Columns of the area */
+    std::vector<Cell> m_shown;  /**< Frame currently shown on the terminal */
+    std::vector<Cell> m_next;   /**< Frame being composed */
+    bool m_fullRepaint;         /**< `true` if the terminal contents are unknown */
+    int m_cursorRow;            /**< Cursor row while rendering, or -1 if unknown */
+    int m_cursorColumn;         /**< Cursor column while rendering */
+    ScreenColor m_color;        /**< Terminal color while rendering */
+};
+
+/**
+ * @brief Queries the size of the terminal attached to a file descriptor (`TIOCGWINSZ`).
+ *
+ * @param fd The file descriptor (e.g., `STDOUT_FILENO`).
+ * @param rows Receives the number of rows; left unchanged on failure.
+ * @param columns Receives the number of columns; left unchanged on failure.
+ * @return `true` on success, `false` if `fd` is not a terminal or reports no size.
+ */
+bool queryTerminalSize(int fd, int& rows, int& columns);
+
+#endif // SCREEN_RENDERER_H
@@ -0,0 +1,219 @@
+/**
+ * @file session_record.h
+ * @brief Declares the recorder and reader of sampling sessions in a compact binary format.
+ *
+ * A session file stores the snapshot of processes seen by the monitor at every sampling epoch, so
+ * that an incident can be replayed later through the same filter/sort/display code.
+ *
+ * File layout (all integers little-endian):
+ * - Header: the 8 bytes `PMREC` `\0` `\0` `\1` (magic and format version).
+ * - Frames, each made of a `u32` length (bytes that follow), a `u8` type (0 = key frame,
+ *   1 = delta frame), an `i64` wall-clock timestamp in milliseconds and a varint-encoded payload.
+ *
+ * Key frames hold every process. Delta frames only hold the PIDs that disappeared and the fields
+ * that changed since the previous frame. A key frame is written every `kKeyFrameInterval` frames
+ * and whenever a file is (re)opened for appending, so any timestamp can be reached by decoding at
+ * most one key frame and the deltas that follow it. CPU usage is stored in hundredths of a percent
+ * and memory usage in kB, which is exact for the values shown by the display.
+ */
+
+#ifndef SESSION_RECORD_H
+#define SESSION_RECORD_H
+
+#include "process_info.h"
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct SessionFrame
+ * @brief Snapshot of processes decoded from a session file.
+ */
+struct SessionFrame
+{
+    int64_t timestampMs = 0;        /**< Wall-clock time of the epoch, in milliseconds since the Unix epoch */
+    std::vector<Process> processes; /**< Processes sorted by PID */
+};
+
+/**
+ * @class SessionRecorder
+ * @brief Appends sampling epochs to a session file.
+ *
+ * All methods are thread-safe: the command loop opens and closes the recording while the sampling
+ * thread appends frames.
+ */
+class SessionRecorder
+{
+  public:
+    /** @brief Number of frames between two key frames. */
+    static const int kKeyFrameInterval = 64;
+
+    SessionRecorder();
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /**
+     * @brief Opens a session file for appending, creating it if needed.
+     *
+     * @param path Path of the session file.
+     * @return `true` on success, `false` if the file cannot be opened or is not a session file.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Flushes and closes the session file. Does nothing if no file is open.
+     */
+    void close();
+
+    /**
+     * @brief Returns `true` while a session file is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Appends the snapshot of one sampling epoch.
+     *
+     * @param timestampMs Wall-clock time of the epoch, in milliseconds since the Unix epoch.
+     * @param snapshot Processes seen during the epoch, in any order.
+     * @return `true` if the frame was written, `false` if no file is open or the write failed.
+     */
+    bool append(int64_t timestampMs, const std::vector<Process>& snapshot);
+
+    /**
+     * @brief Returns the path of the open session file (empty if none).
+     */
+    std::string path() const;
+
+    /**
+     * @brief Returns the number of frames appended since the file was opened.
+     */
+    uint64_t framesWritten() const;
+
+    /**
+     * @brief Returns the number of bytes appended since the file was opened.
+     */
+    uint64_t bytesWritten() const;
+
+  private:
+    /**
+     * @brief Compact form of a process as stored in the session file.
+     */
+    struct Entry
+    {
+        int pid;
+        int64_t cpuCenti; /**< CPU usage in hundredths of a percent */
+        int64_t rssKb;    /**< Memory usage in kB */
+        std::string user;
+        std::string command;
+    };
+
+    void encodeKeyFrame();
+    void encodeDeltaFrame();
+    void discardPartialFrame(long offset);
+
+    mutable std::mutex m_mutex;    /**< Protects every member below */
+    FILE* m_file;                  /**< Open session file, or `nullptr` */
+    std::string m_path;            /**< Path of the open session file */
+    std::vector<Entry> m_previous; /**< Entries of the previous frame, sorted by PID */
+    std::vector<Entry> m_current;  /**< Entries of the frame being encoded, sorted by PID */
+    std::string m_payload;         /**< Reusable encoding buffer */
+    std::string m_changes;         /**< Reusable buffer for the entries of a delta frame */
+    int m_framesSinceKey;          /**< Frames written since the last key frame */
+    uint64_t m_framesWritten;      /**< Frames written since the file was opened */
+    uint64_t m_bytesWritten;       /**< Bytes written since the file was opened */
+};
+
+/**
+ * @class SessionReader
+ * @brief Random-access reader of session files.
+ *
+ * Opening a file only reads the frame headers to build an index of timestamps and offsets; frame
+ * payloads are decoded on demand. Reading frames in increasing order decodes each frame once.
+ * The reader is not thread-safe.
+ */
+class SessionReader
+{
+  public:
+    SessionReader();
+    ~SessionReader();
+
+    SessionReader(const SessionReader&) = delete;
+    SessionReader& operator=(const SessionReader&) = delete;
+
+    /**
+     * @brief Opens a session file and indexes its frames.
+     *
+     * A truncated last frame (e.g., from a crash while recording) is ignored.
+     *
+     * @param path Path of the session file.
+     * @return `true` on success, `false` if the file cannot be read or is not a session file.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Returns the number of complete frames in the file.
+     */
+    size_t frameCount() const;
+
+    /**
+     * @brief Returns the timestamp of a frame, in milliseconds since the Unix epoch.
+     *
+     * @param index Index of the frame, lower than `frameCount()`.
+     */
+    int64_t frameTimestamp(size_t index) const;
+
+    /**
+     * @brief Finds the last frame recorded at or before a timestamp.
+     *
+     * @param timestampMs Timestamp in milliseconds since the Unix epoch.
+     * @return Index of the frame, or 0 if the timestamp precedes the first frame.
+     */
+    size_t findFrame(int64_t timestampMs) const;
+
+    /**
+     * @brief Decodes a frame.
+     *
+     * @param index Index of the frame, lower than `frameCount()`.
+     * @param frame Receives the timestamp and processes of the frame.
+     * @return `true` on success, `false` if the index is out of range or the file is corrupted.
+     */
+    bool readFrame(size_t index, SessionFrame& frame);
+
+  private:
+    /**
+     * @brief Location of a frame inside the session file.
+     */
+    struct FrameInfo
+    {
+        int64_t timestampMs;
+        long offset;     /**< Offset of the payload */
+        uint32_t length; /**< Length of the payload */
+        bool keyFrame;
+    };
+
+    /**
+     * @brief Decoded state of a process, updated by every frame.
+     */
+    struct Entry
+    {
+        int64_t cpuCenti;
+        int64_t rssKb;
+        std::string user;
+        std::string command;
+    };
+
+    bool applyFrame(size_t index);
+
+    FILE* m_file;                           /**< Open session file, or `nullptr` */
+    std::vector<FrameInfo> m_frames;        /**< Index of complete frames */
+    std::unordered_map<int, Entry> m_state; /**< Processes after applying frame `m_nextFrame - 1` */
+    size_t m_nextFrame;                     /**< Next frame that can be applied incrementally */
+    std::string m_payload;                  /**< Reusable decoding buffer */
+};
+
+#endif // SESSION_RECORD_H
@@ -0,0 +1,83 @@
+/**
+ * @file shm_snapshot.h
+ * @brief Declares the writer of the shared-memory snapshot export.
+ *
+ * The ShmSnapshotWriter publishes each sampling epoch into a POSIX shared-memory region, in the
+ * columnar layout described in shm_snapshot_reader.h, for local programs that want the process
+ * table at a high rate without a socket or any serialization.
+ */
+
+#ifndef SHM_SNAPSHOT_H
+#define SHM_SNAPSHOT_H
+
+#include "process_info.h"
+#include "shm_snapshot_reader.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class ShmSnapshotWriter
+ * @brief Owner of a snapshot region, publishing one epoch at a time.
+ *
+ * The region is sized once, when it is opened. Processes beyond the capacity, and strings that
+ * no longer fit in the string pool, are left out (or cut) and the epoch is flagged as truncated.
+ */
+class ShmSnapshotWriter
+{
+  public:
+    /** @brief Default maximum number of processes per epoch. */
+    static constexpr uint32_t kDefaultCapacity = 65536;
+
+    /** @brief Bytes of string pool reserved per process (user and command together). */
+    static constexpr uint32_t kStringBytesPerProcess = 48;
+
+    ShmSnapshotWriter();
+    ~ShmSnapshotWriter();
+
+    ShmSnapshotWriter(const ShmSnapshotWriter&) = delete;
+    ShmSnapshotWriter& operator=(const ShmSnapshotWriter&) = delete;
+
+    /**
+     * @brief Creates (or replaces) the shared-memory object `name` and maps it.
+     *
+     * An existing object of that name is removed first; programs that still map it keep their old
+     * (no longer updated) mapping. The new object is only accessible to its owner (mode 0600), and
+     * its pages are only allocated as epochs fill them.
+     *
+     * @param name Name of the shared-memory object (a leading '/' is added if missing).
+     * @param capacity Maximum number of processes per epoch.
+     * @param error Receives a description of the failure.
+     * @return `true` on success, `false` otherwise.
+     */
+    bool open(const std::string& name, uint32_t capacity, std::string& error);
+
+    /**
+     * @brief Unmaps the region and removes the shared-memory object.
+     */
+    void close();
+
+    /**
+     * @brief Returns `true` while a region is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Publishes the processes of one epoch.
+     *
+     * @param processes The processes of the epoch.
+     * @param timestampMs Time of the epoch in milliseconds since the Unix epoch.
+     */
+    void publish(const std::vector<Process>& processes, int64_t timestampMs);
+
+  private:
+    mutable std::mutex m_mutex;      /**< Serializes publish() and close() */
+    char* m_region;                  /**< Mapped region, or nullptr */
+    size_t m_regionBytes;            /**< Size of the mapping */
+    ShmSnapshotHeader* m_header;     /**< Header at the start of the region */
+    uint64_t m_columnOffsets[6];     /**< Column offsets within a buffer */
+    std::string m_name;              /**< Name of the shared-memory object */
+};
+
+#endif // SHM_SNAPSHOT_H
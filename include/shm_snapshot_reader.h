@@ -0,0 +1,208 @@
+/**
+ * @file shm_snapshot_reader.h
+ * @brief Declares the layout of the shared-memory snapshot export and its reader library.
+ *
+ * With `--shm-export <name>` every sampling epoch is published, in columnar form, into the POSIX
+ * shared-memory object `<name>`. This header is all that other programs need to consume it: link
+ * with the `pm_shm_reader` library, open the object once, and then read the latest epoch as often
+ * as needed without any system call.
+ *
+ * The region holds two buffers. The writer fills the buffer that does not hold the latest epoch
+ * and then makes it the active one, so a reader has a whole sampling interval to read an epoch
+ * before it is overwritten. Each buffer is also guarded by a sequence counter (a seqlock: odd
+ * while the buffer is written), which lets a reader detect the rare case of a read that was too
+ * slow and retry.
+ *
+ * This header only depends on the C++ standard library.
+ */
+
+#ifndef SHM_SNAPSHOT_READER_H
+#define SHM_SNAPSHOT_READER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** @brief Identifies a snapshot region ("PMSS"). */
+const uint32_t kShmSnapshotMagic = 0x53534d50;
+
+/** @brief Version of the region layout; readers refuse other versions. */
+const uint32_t kShmSnapshotVersion = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+/**
+ * @struct ShmSnapshotHeader
+ * @brief Header at the start of the region. Written once, except for the atomic fields.
+ */
+struct ShmSnapshotHeader
+{
+    uint32_t magic;                     /**< `kShmSnapshotMagic` */
+    uint32_t version;                   /**< `kShmSnapshotVersion` */
+    uint32_t capacity;                  /**< Maximum processes per buffer */
+    uint32_t stringCapacity;            /**< Bytes of the string pool of each buffer */
+    uint64_t regionBytes;               /**< Size of the whole region */
+    uint64_t bufferOffset[2];           /**< Offsets of the two buffers from the start of the region */
+    int32_t writerPid;                  /**< PID of the publishing process */
+    std::atomic<uint32_t> active;       /**< Buffer holding the latest epoch */
+    std::atomic<uint64_t> epoch;        /**< Epochs published so far (0 until the first one) */
+    std::atomic<uint64_t> sequence[2];  /**< Seqlock of each buffer: odd while it is written */
+};
+
+/**
+ * @struct ShmBufferHeader
+ * @brief Header of a buffer, followed by its columns.
+ *
+ * The columns, each aligned to 64 bytes and `capacity` entries long, are: `int32_t pid`,
+ * `float cpu` (percent), `float memory` (MB), and `uint32_t user` and `uint32_t command` (offsets
+ * of NUL-terminated strings in the string pool, which follows the columns).
+ */
+struct ShmBufferHeader
+{
+    uint64_t epoch;       /**< Epoch number of the buffer contents */
+    int64_t timestampMs;  /**< Time of the epoch in milliseconds since the Unix epoch */
+    uint32_t count;       /**< Processes in the buffer */
+    uint32_t stringBytes; /**< Bytes used in the string pool */
+    uint32_t truncated;   /**< 1 if processes or strings did not fit and were left out or cut */
+    uint32_t reserved;    /**< Zero */
+};
+
+/**
+ * @struct ShmSnapshotView
+ * @brief Columns of one epoch, pointing into the shared region or into a ShmSnapshotCopy.
+ */
+struct ShmSnapshotView
+{
+    uint64_t epoch = 0;           /**< Epoch number */
+    int64_t timestampMs = 0;      /**< Time of the epoch in milliseconds since the Unix epoch */
+    size_t count = 0;             /**< Number of processes */
+    bool truncated = false;       /**< Some processes or strings were left out or cut */
+    const int32_t* pid = nullptr;
+    const float* cpu = nullptr;
+    const float* memory = nullptr;
+    const uint32_t* userOffset = nullptr;
+    const uint32_t* commandOffset = nullptr;
+    const char* strings = nullptr;
+
+    /** @brief Returns the user of process `i`. */
+    const char* user(size_t i) const
+    {
+        return strings + userOffset[i];
+    }
+
+    /** @brief Returns the command of process `i`. */
+    const char* command(size_t i) const
+    {
+        return strings + commandOffset[i];
+    }
+};
+
+/**
+ * @struct ShmSnapshotCopy
+ * @brief Private copy of one epoch, kept by `ShmSnapshotReader::read()` across calls.
+ */
+struct ShmSnapshotCopy
+{
+    ShmSnapshotView view;          /**< Columns of the copy */
+    std::vector<char> storage;     /**< Memory the view points into */
+};
+
+/**
+ * @brief Returns the byte layout of a region: buffer size and column offsets within a buffer.
+ *
+ * Shared by the writer and the readers so that both compute identical offsets.
+ *
+ * @param capacity Maximum processes per buffer.
+ * @param stringCapacity Bytes of the string pool.
+ * @param columnOffsets Receives the offsets of the pid, cpu, memory, user, command and string
+ *        columns within a buffer.
+ * @return The size of one buffer, a multiple of 64 bytes.
+ */
+uint64_t shmBufferLayout(uint32_t capacity, uint32_t stringCapacity, uint64_t columnOffsets[6]);
+
+/**
+ * @class ShmSnapshotReader
+ * @brief Maps a snapshot region read-only and reads consistent epochs from it.
+ *
+ * After `open()`, `epoch()`, `visit()` and `read()` only access memory.
+ */
+class ShmSnapshotReader
+{
+  public:
+    ShmSnapshotReader();
+    ~ShmSnapshotReader();
+
+    ShmSnapshotReader(const ShmSnapshotReader&) = delete;
+    ShmSnapshotReader& operator=(const ShmSnapshotReader&) = delete;
+
+    /**
+     * @brief Maps the region published under `name`.
+     *
+     * @param name Name of the shared-memory object (a leading '/' is added if missing).
+     * @param error Receives a description of the failure.
+     * @return `true` on success, `false` if the object does not exist or is not a snapshot region.
+     */
+    bool open(const std::string& name, std::string& error);
+
+    /**
+     * @brief Unmaps the region.
+     */
+    void close();
+
+    /**
+     * @brief Returns `true` while a region is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Returns the number of the latest published epoch, or 0 if none was published yet.
+     *
+     * Cheap enough to poll for new epochs.
+     */
+    uint64_t epoch() const;
+
+    /**
+     * @brief Calls `visitor(const ShmSnapshotView&)` on the latest epoch, in place.
+     *
+     * Nothing is copied: the view points into the shared region. If the writer started rewriting
+     * the buffer while the visitor ran, what the visitor saw may be inconsistent; `visit()` then
+     * returns `false` and the caller should discard its results and try again.
+     *
+     * @return `true` if an epoch was visited and was not modified during the visit.
+     */
+    template <typename Visitor> bool visit(Visitor&& visitor) const
+    {
+        ShmSnapshotView view;
+        uint32_t buffer = 0;
+        uint64_t sequence = 0;
+        if (!beginRead(view, buffer, sequence))
+        {
+            return false;
+        }
+        visitor(static_cast<const ShmSnapshotView&>(view));
+        return endRead(buffer, sequence);
+    }
+
+    /**
+     * @brief Copies the latest epoch into `out`, retrying if it is modified during the copy.
+     *
+     * `out` keeps its storage between calls, so repeated reads do not allocate.
+     *
+     * @param out Receives the copy.
+     * @return `true` on success, `false` if no epoch was published or no consistent copy could be made.
+     */
+    bool read(ShmSnapshotCopy& out) const;
+
+  private:
+    bool beginRead(ShmSnapshotView& view, uint32_t& buffer, uint64_t& sequence) const;
+    bool endRead(uint32_t buffer, uint64_t sequence) const;
+
+    const char* m_region;               /**< Mapped region, or nullptr */
+    size_t m_regionBytes;               /**< Size of the mapping */
+    const ShmSnapshotHeader* m_header;  /**< Header at the start of the region */
+    uint64_t m_columnOffsets[6];        /**< Column offsets within a buffer */
+};
+
+#endif // SHM_SNAPSHOT_READER_H
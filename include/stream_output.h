@@ -0,0 +1,105 @@
+/**
+ * @file stream_output.h
+ * @brief Declares the headless stream mode, which writes process records for other programs.
+ *
+ * In stream mode the application does not start the command loop or the display. It samples the
+ * processes at a fixed interval and writes one record per process per epoch to standard output,
+ * as JSON Lines or CSV. Records are serialized directly into a reusable FrameBuffer (no allocation
+ * per row) and written with one system call per epoch, or more often for very large epochs.
+ */
+
+#ifndef STREAM_OUTPUT_H
+#define STREAM_OUTPUT_H
+
+#include "cli_options.h"
+#include "frame_buffer.h"
+#include "process_info.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class StreamWriter
+ * @brief Streaming serializer of process records.
+ *
+ * JSON records have the form
+ * `{"ts":<ms since epoch>,"pid":<pid>,"user":"...","cpu":<percent>,"mem_mb":<MB>,"command":"..."}`.
+ * CSV output starts with the header line `ts,pid,user,cpu,mem_mb,command`; fields containing a
+ * comma, quote or line break are quoted. CPU and memory are written with two decimals.
+ */
+class StreamWriter
+{
+  public:
+    /** @brief Buffered bytes above which records are written before the end of an epoch. */
+    static constexpr size_t kFlushThreshold = 256 * 1024;
+
+    /**
+     * @brief Creates a writer for a file descriptor.
+     *
+     * @param fd The file descriptor receiving the records (e.g., `STDOUT_FILENO`).
+     * @param format The record format (JSON Lines or CSV).
+     */
+    StreamWriter(int fd, StreamFormat format);
+
+    /**
+     * @brief Serializes the records of one epoch and writes them.
+     *
+     * @param timestampMs Time of the epoch in milliseconds since the Unix epoch.
+     * @param rows The processes of the epoch, in output order.
+     * @return `true` on success, `false` if writing failed (e.g., the reader closed the pipe).
+     */
+    bool writeEpoch(int64_t timestampMs, const std::vector<const Process*>& rows);
+
+    /**
+     * @brief Returns the number of records written so far.
+     */
+    size_t recordsWritten() const;
+
+  private:
+    bool flush();
+
+    int m_fd;                /**< Destination file descriptor */
+    StreamFormat m_format;   /**< Record format */
+    FrameBuffer m_buffer;    /**< Serialized records not written yet */
+    bool m_headerWritten;    /**< `true` once the CSV header was buffered */
+    size_t m_records;        /**< Records written so far */
+};
+
+/**
+ * @brief Appends one record, in the format described for StreamWriter, to a buffer.
+ *
+ * @param out The buffer receiving the record, including its trailing newline.
+ * @param format JSON Lines or CSV.
+ * @param timestampMs Time of the epoch in milliseconds since the Unix epoch.
+ * @param process The process to serialize.
+ */
+void appendStreamRecord(FrameBuffer& out, StreamFormat format, int64_t timestampMs, const Process& process);
+
+/**
+ * @brief Selects the rows of an epoch for output.
+ *
+ * With `top` 0 every process is kept, in the order of `processes`. Otherwise the `top` processes
+ * ranking highest for `sortBy` are kept, in descending order. Only pointers are stored, so a
+ * reused `rows` vector does not allocate in the steady state.
+ *
+ * @param processes The processes of the epoch.
+ * @param top Maximum number of rows, or 0 for all.
+ * @param sortBy Either "cpu" or "memory".
+ * @param rows Receives pointers into `processes`.
+ */
+void selectStreamRows(const std::vector<Process>& processes, size_t top, const std::string& sortBy,
+                      std::vector<const Process*>& rows);
+
+/**
+ * @brief Runs the headless stream mode until interrupted, the reader goes away or `options.count`
+ *        epochs were written.
+ *
+ * SIGINT and SIGTERM stop the mode after the current epoch; SIGPIPE is ignored so that a closed
+ * pipe ends it cleanly.
+ *
+ * @param options The parsed command-line options (format, interval, top, sort and count).
+ * @return The process exit code: 0 on success, 1 if writing failed.
+ */
+int runStreamMode(const CliOptions& options);
+
+#endif // STREAM_OUTPUT_H
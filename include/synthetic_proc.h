@@ -0,0 +1,177 @@
+/**
+ * @file synthetic_proc.h
+ * @brief Declares a generator for fake procfs trees used in reproducible scale tests.
+ *
+ * The generator writes a directory that mimics the parts of `/proc` read by the Process Manager
+ * (`stat`, and `[pid]/stat`, `[pid]/status`, `[pid]/comm` for each PID). The CPU and memory usage
+ * of every process follows a deterministic script, so the tree can be advanced tick by tick and
+ * the same numbers are observed on any machine.
+ *
+ * Optionally, the processes are spread over containers: each PID gets a `[pid]/cgroup` file, and a
+ * second directory mimics the cgroup v2 hierarchy, with `cpu.stat`, `memory.current` and
+ * `pids.current` files holding the sums of the processes of each container.
+ */
+
+#ifndef SYNTHETIC_PROC_H
+#define SYNTHETIC_PROC_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @enum SyntheticProfile
+ * @brief Behaviour scripted for a synthetic process across ticks.
+ */
+enum class SyntheticProfile
+{
+    IDLE,   /**< Never accumulates CPU time, constant RSS */
+    STEADY, /**< Constant CPU usage, constant RSS */
+    BURSTY, /**< Alternates between busy and idle periods, RSS grows while busy */
+    LEAKING /**< Moderate CPU usage, RSS grows every tick */
+};
+
+/**
+ * @struct SyntheticProcOptions
+ * @brief Parameters of a synthetic procfs tree.
+ */
+struct SyntheticProcOptions
+{
+    int pidCount = 10000;      /**< Number of processes to generate */
+    int firstPid = 1;          /**< PID of the first generated process */
+    uint64_t seed = 42;        /**< Seed that determines every per-process parameter */
+    int cpuCount = 0;          /**< Cores reported in the aggregate stat line, 0 uses the host value */
+    int jiffiesPerTick = 100;  /**< Clock ticks elapsed per generator tick on each core */
+    int cgroupCount = 0;       /**< Containers the processes are spread over, 0 for none */
+    std::string cgroupRoot;    /**< Directory playing the role of `/sys/fs/cgroup` when `cgroupCount` > 0 */
+};
+
+/**
+ * @class SyntheticProcTree
+ * @brief Writes and advances a fake procfs tree with scripted CPU and RSS evolution.
+ *
+ * All values are pure functions of the options, the PID and the tick, so any tick can be written
+ * directly without replaying the previous ones. A process with a CPU rate of `r` accumulates `r`
+ * percent of `jiffiesPerTick` per tick, which `calculateCpuUsage()` reports as `r` percent.
+ */
+class SyntheticProcTree
+{
+  public:
+    /**
+     * @brief Creates a generator for the given root directory.
+     *
+     * Nothing is written until `writeTick()` is called.
+     *
+     * @param root Directory that will play the role of `/proc`.
+     * @param options Parameters of the generated tree.
+     */
+    SyntheticProcTree(std::string root, SyntheticProcOptions options = {});
+
+    /**
+     * @brief Writes the whole tree as it looks at the given tick.
+     *
+     * Process directories and `comm` files are created on the first call; later calls only rewrite
+     * the files whose contents change between ticks.
+     *
+     * @param tick The tick to materialize (0 for the initial state).
+     * @return `true` if every file was written, `false` otherwise.
+     */
+    bool writeTick(long tick);
+
+    /**
+     * @brief Writes the next tick after the last one written.
+     *
+     * @return `true` if every file was written, `false` otherwise.
+     */
+    bool advance();
+
+    /**
+     * @brief Removes the generated tree from disk.
+     */
+    void remove();
+
+    /**
+     * @brief Returns the root directory of the tree.
+     */
+    const std::string& root() const;
+
+    /**
+     * @brief Returns the last tick written, or -1 if nothing has been written yet.
+     */
+    long currentTick() const;
+
+    /**
+     * @brief Returns the number of cores reported in the aggregate stat line.
+     */
+    int cpuCount() const;
+
+    /**
+     * @brief Returns the scripted profile of a generated PID.
+     */
+    SyntheticProfile profileOf(int pid) const;
+
+    /**
+     * @brief Returns the CPU time (utime + stime, in jiffies) of a PID at a tick.
+     */
+    long processTimeAt(int pid, long tick) const;
+
+    /**
+     * @brief Returns the aggregate CPU time of all cores (in jiffies) at a tick.
+     */
+    long totalTimeAt(long tick) const;
+
+    /**
+     * @brief Returns the resident set size of a PID at a tick, in kB.
+     */
+    long rssKbAt(int pid, long tick) const;
+
+    /**
+     * @brief Returns the UID owning a PID.
+     */
+    int uidOf(int pid) const;
+
+    /**
+     * @brief Returns the command name of a PID.
+     */
+    std::string commandOf(int pid) const;
+
+    /**
+     * @brief Returns the parent PID of a PID.
+     */
+    int parentOf(int pid) const;
+
+    /**
+     * @brief Returns the cgroup of a PID relative to the cgroup root (e.g. `system.slice/container-7.scope`),
+     *        or an empty string if the tree has no cgroups.
+     */
+    std::string cgroupOf(int pid) const;
+
+  private:
+    /**
+     * @brief Per-process parameters derived from the seed and the PID.
+     */
+    struct Params
+    {
+        SyntheticProfile profile;
+        int rate;       /**< CPU percentage while busy */
+        int period;     /**< Length of a busy/idle cycle in ticks (BURSTY) */
+        int busyTicks;  /**< Busy ticks per cycle (BURSTY) */
+        long baseTime;  /**< CPU time at tick 0 */
+        long baseRssKb; /**< RSS at tick 0 */
+        long growthKb;  /**< RSS growth per growing tick */
+        int uid;
+        int command;    /**< Index into the command name table */
+        long startTime; /**< Start time in jiffies since boot */
+    };
+
+    Params paramsOf(int pid) const;
+    long busyTicksUntil(const Params& params, long tick) const;
+    bool writeProcess(int pid, long tick, bool createFiles);
+    bool writeAggregateStat(long tick);
+    bool writeCgroups(long tick, bool createFiles);
+
+    std::string m_root;
+    SyntheticProcOptions m_options;
+    long m_tick;
+};
+
+#endif // SYNTHETIC_PROC_H
@@ -0,0 +1,123 @@
+/**
+ * @file termination_manager.h
+ * @brief Declares the TerminationManager, which ends processes gracefully: SIGTERM, a grace period,
+ *        then SIGKILL for those still running.
+ *
+ * A single thread watches every pending termination. Each process is held through a pidfd (see
+ * `openProcessHandle()`), which becomes readable when the process exits, so the thread sleeps in
+ * `epoll_wait()` until a process exits or the earliest grace period ends, however many processes
+ * are pending. Requests return at once; their outcome is handed to a completion callback, called
+ * on the manager thread once every process of the request has exited or been killed.
+ */
+
+#ifndef TERMINATION_MANAGER_H
+#define TERMINATION_MANAGER_H
+
+#include "process_control.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class TerminationManager
+ * @brief Singleton thread escalating SIGTERM to SIGKILL after a grace period.
+ *
+ * The thread starts with the first request and runs until `stop()`.
+ */
+class TerminationManager
+{
+  public:
+    /** @brief Called on the manager thread with the outcome of each target, in the order of the request. */
+    using Completion = std::function<void(const KillReport&)>;
+
+    /**
+     * @brief Retrieves the singleton instance.
+     */
+    static TerminationManager& getInstance();
+
+    TerminationManager(const TerminationManager&) = delete;
+    TerminationManager& operator=(const TerminationManager&) = delete;
+
+    /**
+     * @brief Queues a graceful termination of `targets` and returns without waiting.
+     *
+     * Each target that is still the sampled process gets SIGTERM. Those that exit within `graceMs`
+     * are reported as Terminated; the others get SIGKILL and are reported as Killed. Targets that
+     * cannot be signalled are reported as by `signalProcesses()`.
+     *
+     * @param targets The processes to terminate.
+     * @param graceMs Time the processes have to exit after SIGTERM, in milliseconds.
+     * @param done Called once every target has an outcome; may be empty.
+     */
+    void terminate(std::vector<KillTarget> targets, int graceMs, Completion done);
+
+    /**
+     * @brief Returns the number of processes that got SIGTERM and have neither exited nor been killed.
+     */
+    size_t pending() const;
+
+    /**
+     * @brief Waits for the queued requests to complete (each at most its grace period), then stops the
+     *        thread.
+     */
+    void stop();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using Deadline = std::pair<Clock::time_point, uint64_t>; /**< End of a grace period, and the key of its watch */
+
+    /** @brief A request being processed. */
+    struct Job
+    {
+        std::vector<KillTarget> targets; /**< The processes to terminate */
+        int graceMs = 0;                 /**< Grace period after SIGTERM */
+        Completion done;                 /**< Completion callback */
+        KillReport report;               /**< Outcomes, filled as they are known */
+        size_t remaining = 0;            /**< Targets without an outcome yet */
+    };
+
+    /** @brief A process that got SIGTERM and is waited for. */
+    struct Watch
+    {
+        std::shared_ptr<Job> job; /**< Request of the process */
+        size_t index = 0;         /**< Index of the process in the request */
+        int pidfd = -1;           /**< Descriptor watched by epoll, or -1 if the kernel gave none */
+    };
+
+    TerminationManager();
+    ~TerminationManager();
+
+    bool startThread();
+    void closeDescriptors();
+    void killNow(Job& job);
+    void run();
+    void abandon();
+    void startJob(const std::shared_ptr<Job>& job);
+    void escalate(uint64_t key);
+    void finish(uint64_t key, const KillResult& result);
+    void complete(Job& job, size_t index, const KillResult& result);
+
+    mutable std::mutex m_mutex;                  /**< Protects the members up to `m_wakeup` */
+    std::deque<std::shared_ptr<Job>> m_requests; /**< Requests not picked up by the thread yet */
+    bool m_stopping;                             /**< Set by stop() */
+    bool m_running;                              /**< Cleared when the thread exits */
+    std::thread m_thread;                        /**< Manager thread, once started */
+    int m_epoll;                                 /**< Watches the pidfds and `m_wakeup` */
+    int m_wakeup;                                /**< eventfd signalled by terminate() and stop() */
+    std::atomic<size_t> m_pending;               /**< See pending() */
+
+    // Owned by the manager thread
+    std::unordered_map<uint64_t, Watch> m_watches; /**< Waited-for processes, by key */
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> m_deadlines; /**< Earliest first */
+    uint64_t m_nextKey;                            /**< Key of the next watch (0 is `m_wakeup`) */
+};
+
+#endif // TERMINATION_MANAGER_H
@@ -3,7 +3,7 @@
  * @brief Declares utility functions for miscellaneous tasks.
  *
  * This header file provides function declarations for common utility operations such as
- * converting UIDs to usernames.
+ * converting UIDs to usernames and building paths inside the proc filesystem.
  */
 
 #ifndef UTILS_H
@@ -21,4 +21,15 @@
  */
 std::string getUserNameFromUid(int uid);
 
+/**
+ * @brief Builds the path of a per-process file inside the configured proc root.
+ *
+ * For example, `procFilePath(42, "stat")` returns `/proc/42/stat` with the default root.
+ *
+ * @param pid The Process ID.
+ * @param name The file name inside the process directory (e.g., "stat", "status", "comm").
+ * @return The full path of the file.
+ */
+std::string procFilePath(int pid, const char* name);
+
 #endif // UTILS_H
@@ -0,0 +1,281 @@
+/**
+ * @file cgroup_view.cpp
+ * @brief Implements the cgroup view and the actions on whole cgroups.
+ *
+ * The hierarchy is walked with `opendir`/`readdir`, like the proc root, and the interface files
+ * are small text files read whole. Controllers that are not enabled in a cgroup simply have no
+ * interface file there, which is why a missing file is not an error.
+ */
+
+#include "cgroup_view.h"
+#include "globals.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+// Period written to cpu.max with a cap, in microseconds (the kernel's default)
+const uint64_t kCpuMaxPeriodUsec = 100000;
+
+// Smallest quota the kernel accepts in cpu.max, in microseconds
+const uint64_t kCpuMaxMinQuotaUsec = 1000;
+
+bool isDirectory(const std::string& path)
+{
+    struct stat status;
+    return stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+// Appends the cgroups below `relative` (empty for the root) to `paths`, parents first
+void collectCgroups(const std::string& relative, std::vector<std::string>& paths)
+{
+    std::string directory = relative.empty() ? cgroupRoot : cgroupRoot + "/" + relative;
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr)
+    {
+        return; // Removed while walking the hierarchy
+    }
+    std::vector<std::string> children;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        std::string child = relative.empty() ? entry->d_name : relative + "/" + entry->d_name;
+        if (entry->d_type == DT_DIR || (entry->d_type == DT_UNKNOWN && isDirectory(cgroupRoot + "/" + child)))
+        {
+            children.push_back(std::move(child));
+        }
+    }
+    closedir(dir);
+
+    std::sort(children.begin(), children.end());
+    for (std::string& child : children)
+    {
+        paths.push_back(child);
+        collectCgroups(child, paths);
+    }
+}
+
+// Reads the first number of a file, or leaves `value` alone if the file cannot be read
+bool readNumber(const std::string& path, uint64_t& value)
+{
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+
+// Reads `usage_usec` from a cpu.stat file
+bool readUsageUsec(const std::string& path, uint64_t& usageUsec)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::string key;
+    uint64_t value;
+    while (file >> key >> value)
+    {
+        if (key == "usage_usec")
+        {
+            usageUsec = value;
+            return true;
+        }
+    }
+    return true; // Present, but without CPU accounting
+}
+
+// Checks that `path` names a cgroup below the root and returns its directory. The root itself is
+// refused: killing or capping it would act on the whole host.
+bool resolveCgroup(const std::string& path, std::string& directory, std::string& error)
+{
+    size_t begin = path.find_first_not_of('/');
+    size_t end = path.find_last_not_of('/');
+    if (begin == std::string::npos)
+    {
+        error = "The root cgroup cannot be selected";
+        return false;
+    }
+    std::string relative = path.substr(begin, end - begin + 1);
+    std::string component;
+    for (size_t start = 0; start <= relative.size();)
+    {
+        size_t slash = std::min(relative.find('/', start), relative.size());
+        component = relative.substr(start, slash - start);
+        if (component == ".." || component == ".")
+        {
+            error = "Invalid cgroup path: " + path;
+            return false;
+        }
+        start = slash + 1;
+    }
+    directory = cgroupRoot + "/" + relative;
+    if (!isDirectory(directory))
+    {
+        error = "No such cgroup: " + relative;
+        return false;
+    }
+    return true;
+}
+
+// Writes a value to an interface file of a cgroup, like `echo value > file` (interface files are never created)
+bool writeInterfaceFile(const std::string& directory, const char* name, const std::string& value, std::string& error)
+{
+    std::string path = directory + "/" + name;
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        if (errno == ENOENT)
+        {
+            error += " (not a cgroup v2 hierarchy, or the controller is not enabled)";
+        }
+        return false;
+    }
+    bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    if (!ok)
+    {
+        error = "Cannot write " + path + ": " + std::strerror(errno);
+    }
+    close(fd);
+    return ok;
+}
+
+} // namespace
+
+bool cgroupHierarchyAvailable()
+{
+    struct stat status;
+    return stat((cgroupRoot + "/cgroup.controllers").c_str(), &status) == 0;
+}
+
+std::vector<std::string> listCgroups()
+{
+    std::vector<std::string> paths;
+    collectCgroups("", paths);
+    return paths;
+}
+
+bool readCgroupStats(const std::string& path, CgroupStats& stats)
+{
+    std::string directory = cgroupRoot + "/" + path;
+    stats = CgroupStats();
+    stats.path = path;
+    bool found = readUsageUsec(directory + "/cpu.stat", stats.usageUsec);
+    found = readNumber(directory + "/memory.current", stats.memoryBytes) || found;
+    found = readNumber(directory + "/pids.current", stats.pids) || found;
+    return found || isDirectory(directory);
+}
+
+std::vector<CgroupUsage> CgroupSampler::sample()
+{
+    return sample(Clock::now());
+}
+
+std::vector<CgroupUsage> CgroupSampler::sample(Clock::time_point now)
+{
+    double elapsedUsec = std::chrono::duration<double, std::micro>(now - m_previousTime).count();
+    bool measured = !m_previousUsage.empty() && elapsedUsec > 0;
+
+    std::vector<std::string> paths = listCgroups();
+    std::vector<CgroupUsage> usage;
+    usage.reserve(paths.size());
+    std::unordered_map<std::string, uint64_t> current;
+    current.reserve(paths.size());
+    for (const std::string& path : paths)
+    {
+        CgroupStats stats;
+        if (!readCgroupStats(path, stats))
+        {
+            continue; // Removed since it was listed
+        }
+        CgroupUsage row;
+        row.path = path;
+        row.memoryUsage = stats.memoryBytes / (1024.0 * 1024.0);
+        row.pids = stats.pids;
+        auto previous = m_previousUsage.find(path);
+        if (measured && previous != m_previousUsage.end() && stats.usageUsec >= previous->second)
+        {
+            row.cpuUsage = (stats.usageUsec - previous->second) / elapsedUsec * 100.0;
+        }
+        current.emplace(path, stats.usageUsec);
+        usage.push_back(std::move(row));
+    }
+    m_previousUsage = std::move(current);
+    m_previousTime = now;
+    return usage;
+}
+
+void filterCgroups(std::vector<CgroupUsage>& cgroups, const std::pair<std::string, std::string>& filter)
+{
+    const std::string& type = filter.first;
+    if (type == "cgroup")
+    {
+        auto unmatched = [&](const CgroupUsage& c) { return c.path.find(filter.second) == std::string::npos; };
+        cgroups.erase(std::remove_if(cgroups.begin(), cgroups.end(), unmatched), cgroups.end());
+    }
+    else if (type == "cpu" || type == "memory")
+    {
+        double threshold = std::atof(filter.second.c_str());
+        bool cpu = type == "cpu";
+        auto below = [&](const CgroupUsage& c) { return (cpu ? c.cpuUsage : c.memoryUsage) <= threshold; };
+        cgroups.erase(std::remove_if(cgroups.begin(), cgroups.end(), below), cgroups.end());
+    }
+}
+
+void sortCgroups(std::vector<CgroupUsage>& cgroups, const std::string& criterion)
+{
+    if (criterion == "cpu" || criterion == "memory")
+    {
+        bool cpu = criterion == "cpu";
+        std::stable_sort(cgroups.begin(), cgroups.end(), [cpu](const CgroupUsage& a, const CgroupUsage& b) {
+            return cpu ? a.cpuUsage > b.cpuUsage : a.memoryUsage > b.memoryUsage;
+        });
+    }
+    else
+    {
+        std::sort(cgroups.begin(), cgroups.end(),
+                  [](const CgroupUsage& a, const CgroupUsage& b) { return a.path < b.path; });
+    }
+}
+
+bool killCgroup(const std::string& path, std::string& error)
+{
+    std::string directory;
+    return resolveCgroup(path, directory, error) && writeInterfaceFile(directory, "cgroup.kill", "1", error);
+}
+
+bool setCgroupCpuMax(const std::string& path, double percent, std::string& error)
+{
+    // A cap above every core is no cap; refusing it keeps the quota in range of its integer type
+    unsigned maxPercent = 100 * std::max(1u, std::thread::hardware_concurrency());
+    if (!std::isfinite(percent) || percent < 0 || percent > maxPercent)
+    {
+        error = "Invalid CPU cap: " + std::to_string(percent) + " (expected 0 to " + std::to_string(maxPercent) + ")";
+        return false;
+    }
+    std::string directory;
+    if (!resolveCgroup(path, directory, error))
+    {
+        return false;
+    }
+    std::string value = "max " + std::to_string(kCpuMaxPeriodUsec);
+    if (percent > 0)
+    {
+        uint64_t quota = static_cast<uint64_t>(percent / 100.0 * kCpuMaxPeriodUsec);
+        value = std::to_string(std::max(quota, kCpuMaxMinQuotaUsec)) + " " + std::to_string(kCpuMaxPeriodUsec);
+    }
+    return writeInterfaceFile(directory, "cpu.max", value, error);
+}
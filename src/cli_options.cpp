@@ -0,0 +1,310 @@
+/**
+ * @file cli_options.cpp
+ * @brief Implements command-line parsing.
+ *
+ * This source file contains the parser of the command-line options. Every option taking a value
+ * is validated here, so that the rest of the application only deals with well-formed settings.
+ */
+
+#include "cli_options.h"
+#include <arpa/inet.h>
+#include <cmath>
+#include <sstream>
+
+bool parseDuration(const std::string& text, int& milliseconds)
+{
+    std::istringstream stream(text);
+    double value = 0.0;
+    if (!(stream >> value))
+    {
+        return false;
+    }
+    std::string unit;
+    stream >> unit;
+
+    double scale = 0.0;
+    if (unit.empty() || unit == "s")
+        scale = 1000.0;
+    else if (unit == "ms")
+        scale = 1.0;
+    else if (unit == "m")
+        scale = 60 * 1000.0;
+    else if (unit == "h")
+        scale = 3600 * 1000.0;
+    else
+        return false;
+
+    double result = std::round(value * scale);
+    if (!stream.eof() || result < 1.0 || result > 24 * 3600 * 1000.0)
+    {
+        return false;
+    }
+    milliseconds = static_cast<int>(result);
+    return true;
+}
+
+bool parseByteSize(const std::string& text, uint64_t& bytes)
+{
+    std::istringstream stream(text);
+    double value = 0.0;
+    if (!(stream >> value))
+    {
+        return false;
+    }
+    std::string unit;
+    stream >> unit;
+
+    double scale = 0.0;
+    if (unit.empty())
+        scale = 1.0;
+    else if (unit == "K")
+        scale = 1024.0;
+    else if (unit == "M")
+        scale = 1024.0 * 1024;
+    else if (unit == "G")
+        scale = 1024.0 * 1024 * 1024;
+    else
+        return false;
+
+    double result = std::round(value * scale);
+    if (!stream.eof() || result < 1.0 || result > 1e18)
+    {
+        return false;
+    }
+    bytes = static_cast<uint64_t>(result);
+    return true;
+}
+
+bool parseFilter(const std::string& text, std::pair<std::string, std::string>& filter)
+{
+    size_t separator = text.find_first_of("=>");
+    if (separator == std::string::npos || separator + 1 >= text.size())
+    {
+        return false;
+    }
+    std::string type = text.substr(0, separator);
+    std::string value = text.substr(separator + 1);
+
+    if (type == "user" && text[separator] == '=')
+    {
+        filter = {type, value};
+        return true;
+    }
+    if (type == "cpu" || type == "memory")
+    {
+        std::istringstream stream(value);
+        double threshold = 0.0;
+        if (!(stream >> threshold) || !stream.eof() || !std::isfinite(threshold))
+        {
+            return false;
+        }
+        filter = {type, value};
+        return true;
+    }
+    return false;
+}
+
+bool parseListenAddress(const std::string& text, std::string& host, int& port)
+{
+    size_t separator = text.rfind(':');
+    host = separator == std::string::npos ? "127.0.0.1" : text.substr(0, separator);
+    std::string portText = separator == std::string::npos ? text : text.substr(separator + 1);
+
+    std::istringstream stream(portText);
+    long number = -1;
+    in_addr address;
+    if (portText.empty() || !(stream >> number) || !stream.eof() || number < 0 || number > 65535 ||
+        inet_pton(AF_INET, host.c_str(), &address) != 1)
+    {
+        return false;
+    }
+    port = static_cast<int>(number);
+    return true;
+}
+
+bool parseCommandLine(int argc, const char* const argv[], CliOptions& options, std::string& error)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--once")
+        {
+            options.once = true;
+            continue;
+        }
+        if (option == "--daemon")
+        {
+            options.daemon = true;
+            continue;
+        }
+        bool takesValue = option == "--proc-root" || option == "--cgroup-root" || option == "--history-dir" ||
+                          option == "--stream" || option == "--interval" || option == "--top" || option == "--sort" ||
+                          option == "--count" || option == "--window" || option == "--filter" || option == "--socket" ||
+                          option == "--shm-export" || option == "--metrics" || option == "--metrics-top" ||
+                          option == "--log-format" || option == "--log-max-size" || option == "--log-rotate" ||
+                          option == "--log-keep" || option == "--policy";
+        if (!takesValue)
+        {
+            error = "Unknown option: " + option;
+            return false;
+        }
+        if (i + 1 >= argc)
+        {
+            error = "Missing value for " + option;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (option == "--proc-root")
+        {
+            options.procRoot = value; // Read processes from an alternative procfs tree
+        }
+        else if (option == "--cgroup-root")
+        {
+            options.cgroupRoot = value;
+        }
+        else if (option == "--history-dir")
+        {
+            options.historyDir = value;
+        }
+        else if (option == "--policy")
+        {
+            options.policyFile = value;
+        }
+        else if (option == "--socket")
+        {
+            options.socketPath = value;
+        }
+        else if (option == "--log-format")
+        {
+            if (value != "text" && value != "binary")
+            {
+                error = "Invalid log format: " + value + " (use 'text' or 'binary')";
+                return false;
+            }
+            options.logFormat = value == "binary" ? LogFormat::Binary : LogFormat::Text;
+        }
+        else if (option == "--log-max-size")
+        {
+            if (!parseByteSize(value, options.logRotation.maxBytes))
+            {
+                error = "Invalid log size: " + value + " (e.g., 100M or 1G)";
+                return false;
+            }
+        }
+        else if (option == "--log-rotate")
+        {
+            int milliseconds = 0;
+            if (!parseDuration(value, milliseconds) || milliseconds % 1000 != 0)
+            {
+                error = "Invalid log rotation period: " + value + " (whole seconds, e.g., 1h or 30m)";
+                return false;
+            }
+            options.logRotation.intervalSeconds = milliseconds / 1000;
+        }
+        else if (option == "--shm-export")
+        {
+            options.shmExport = value;
+        }
+        else if (option == "--metrics")
+        {
+            std::string host;
+            int port = 0;
+            if (!parseListenAddress(value, host, port))
+            {
+                error = "Invalid metrics address: " + value + " (e.g., 9256 or 127.0.0.1:9256)";
+                return false;
+            }
+            options.metricsAddress = value;
+        }
+        else if (option == "--stream")
+        {
+            if (value == "jsonl")
+                options.streamFormat = StreamFormat::JsonLines;
+            else if (value == "csv")
+                options.streamFormat = StreamFormat::Csv;
+            else
+            {
+                error = "Invalid stream format: " + value + " (use 'jsonl' or 'csv')";
+                return false;
+            }
+        }
+        else if (option == "--interval")
+        {
+            if (!parseDuration(value, options.intervalMs))
+            {
+                error = "Invalid interval: " + value + " (e.g., 500ms or 2s)";
+                return false;
+            }
+        }
+        else if (option == "--window")
+        {
+            if (!parseDuration(value, options.windowMs))
+            {
+                error = "Invalid window: " + value + " (e.g., 200ms or 1s)";
+                return false;
+            }
+        }
+        else if (option == "--filter")
+        {
+            if (!parseFilter(value, options.filter))
+            {
+                error = "Invalid filter: " + value + " (use user=<name>, cpu><percent> or memory><MB>)";
+                return false;
+            }
+        }
+        else if (option == "--top" || option == "--count" || option == "--metrics-top" || option == "--log-keep")
+        {
+            std::istringstream stream(value);
+            long number = 0;
+            if (!(stream >> number) || !stream.eof() || number < 0)
+            {
+                error = "Invalid value for " + option + ": " + value;
+                return false;
+            }
+            if (option == "--top")
+                options.top = static_cast<size_t>(number);
+            else if (option == "--metrics-top")
+                options.metricsTop = static_cast<size_t>(number);
+            else if (option == "--log-keep")
+                options.logRotation.keep = static_cast<size_t>(number);
+            else
+                options.count = number;
+        }
+        else if (option == "--sort")
+        {
+            if (value != "cpu" && value != "memory")
+            {
+                error = "Invalid sorting criterion: " + value + " (use 'cpu' or 'memory')";
+                return false;
+            }
+            options.sortBy = value;
+        }
+    }
+    if (options.daemon && (options.once || options.streamFormat != StreamFormat::None))
+    {
+        error = "--daemon cannot be combined with --once or --stream";
+        return false;
+    }
+    if (options.once && (!options.shmExport.empty() || !options.metricsAddress.empty()))
+    {
+        error = "--shm-export and --metrics cannot be combined with --once";
+        return false;
+    }
+    return true;
+}
+
+std::string usageText(const std::string& program)
+{
+    return "Usage: " + program + " [--proc-root <dir>] [--cgroup-root <dir>] [--history-dir <dir>]" +
+           " [--policy <file>] [--shm-export <name>] [--metrics [<address>:]<port>] [--metrics-top <N>]\n" +
+           "       " + std::string(program.size(), ' ') +
+           " [--log-format <text|binary>] [--log-max-size <size>] [--log-rotate <duration>] [--log-keep <N>]\n" +
+           "       " + program +
+           " --stream <jsonl|csv> [--interval <duration>] [--top <N>] [--sort <cpu|memory>] [--count <epochs>]\n" +
+           "       " + program +
+           " --once [--window <duration>] [--top <N>] [--sort <cpu|memory>] [--filter <filter>]"
+           " [--stream <jsonl|csv>]\n" +
+           "       " + program +
+           " --daemon [--socket <path>] [--interval <duration>] [--history-dir <dir>] [--shm-export <name>]\n";
+}
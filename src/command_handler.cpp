@@ -9,20 +9,32 @@
  */
 
 #include "command_handler.h"
+#include "cgroup_view.h"
 #include "globals.h"
+#include "log_record.h"
 #include "logger.h"
 #include "process_control.h"
 #include "process_display.h"
 #include "resource_monitor.h"
+#include "session_record.h"
+#include "termination_manager.h"
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <csignal>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <readline/history.h>
 #include <readline/readline.h>
+#include <signal.h> // For sigaction()
 #include <sstream>
 #include <string>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 // Thread used for monitoring processes
 std::thread monitoringThread;
@@ -30,7 +42,9 @@ std::thread monitoringThread;
 // List of available commands for the command completer
 const std::vector<std::string> commands = {
     "start_monitor", "stop_monitor", "pause_monitor", "resume_monitor", "list_processes",  "kill", "kill_all", "filter",
-    "sort_by",       "log",          "help",          "clear",          "set_update_freq", "exit", "quit"};
+    "sort_by",       "log",          "help",          "clear",          "set_update_freq", "exit", "quit",     "record",
+    "replay",        "step",         "seek",          "history",        "set_history_budget", "set_rows",
+    "history_store", "history_at", "log_flush", "log_level", "list_cgroups", "throttle", "tree", "kill_tree", "policy"};
 
 char* commandGenerator(const char* text, int state)
 {
@@ -83,6 +97,124 @@ void handleSigint(int sig)
     std::cout.flush();
 }
 
+namespace
+{
+
+// Shortest and longest sampling or display interval accepted by set_update_freq
+const int kMinIntervalMs = 50;
+const int kMaxIntervalMs = 24 * 60 * 60 * 1000;
+
+// Time between the two reads of the cgroups that list_cgroups measures the CPU usage over
+const int kCgroupWindowMs = 200;
+
+// Largest number of samples per process accepted by set_history_budget
+const int kMaxHistoryWindow = 100000;
+
+// Largest budget accepted by set_history_budget, in MB: a quarter of the physical memory
+double maxHistoryBudgetMb()
+{
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+    {
+        return 1024.0; // Unknown: allow 1 GB
+    }
+    return static_cast<double>(pages) * static_cast<double>(pageSize) / 4 / (1024 * 1024);
+}
+
+// Asks the display thread to redraw now (e.g., after the sort or filter criterion changed)
+void requestDisplayRefresh()
+{
+    displayRefreshRequested.store(true);
+    cv.notify_all();
+}
+
+// Reads the optional "--grace <ms>" that may follow the arguments of kill and kill_all; leaves
+// `graceMs` at 0 without it, and returns false if it is malformed
+bool readGraceOption(std::istringstream& iss, int& graceMs)
+{
+    graceMs = 0;
+    std::string option;
+    if (!(iss >> option))
+        return true;
+    return option == "--grace" && (iss >> graceMs) && graceMs > 0;
+}
+
+// Outcome of a graceful termination, written by the TerminationManager thread and printed by the
+// command thread: only it may call into readline, and output must not land inside a frame
+struct TerminationReport
+{
+    std::string summary;  // For std::cout
+    std::string failures; // For std::cerr
+};
+std::mutex terminationReportsMutex;
+std::vector<TerminationReport> terminationReports;
+
+// Prints the terminations that finished. Readline calls it while waiting for input (as its event
+// hook), and the command loop before each prompt.
+int printTerminationReports()
+{
+    std::vector<TerminationReport> reports;
+    {
+        std::lock_guard<std::mutex> lock(terminationReportsMutex);
+        reports.swap(terminationReports);
+    }
+    if (reports.empty())
+        return 0;
+
+    bool atPrompt = RL_ISSTATE(RL_STATE_READCMD);
+    {
+        std::lock_guard<std::mutex> lock(coutMutex);
+        for (const TerminationReport& report : reports)
+        {
+            std::cout << (atPrompt ? "\n" : "") << report.summary << std::flush;
+            std::cerr << report.failures << std::flush;
+        }
+    }
+    if (atPrompt)
+    {
+        // Redraw the prompt and the line being typed below the reports
+        rl_on_new_line();
+        rl_redisplay();
+    }
+    return 0;
+}
+
+// Sends SIGTERM to the targets and returns; the TerminationManager kills those still running after
+// the grace period, and the outcome is printed once every target has one
+void terminateGracefully(std::vector<KillTarget> targets, int graceMs, const std::string& what)
+{
+    std::cout << "Sending SIGTERM to " << targets.size() << " process(es) (" << what << "); those still running after "
+              << graceMs << " ms will be killed.\n";
+    Logger::getInstance().info("User requested termination of {} process(es) ({}) with a {} ms grace period.",
+                               targets.size(), what, graceMs);
+    TerminationManager::getInstance().terminate(std::move(targets), graceMs, [what](const KillReport& report) {
+        size_t exited = report.count(KillOutcome::Terminated);
+        size_t failed = report.results.size() - exited - report.killed();
+        std::ostringstream summary, failures;
+        summary << "Termination finished (" << what << "): " << exited << " exited after SIGTERM, "
+                << report.killed() << " killed after the grace period, " << failed << " failed.\n";
+        for (const KillResult& result : report.results)
+        {
+            if (result.outcome != KillOutcome::Terminated && result.outcome != KillOutcome::Killed)
+                failures << "Failed to terminate process " << result.pid << ": " << killOutcomeName(result.outcome)
+                         << ".\n";
+        }
+        Logger::getInstance().info("Termination finished ({}): {} exited after SIGTERM, {} killed, {} failed.", what,
+                                   exited, report.killed(), failed);
+        std::lock_guard<std::mutex> lock(terminationReportsMutex);
+        terminationReports.push_back({summary.str(), failures.str()});
+    });
+}
+
+} // namespace
+
+void handleSigwinch(int sig)
+{
+    (void)sig;
+    terminalResized.store(true); // Lock-free, hence async-signal-safe
+}
+
 void printHelp()
 {
     std::cout << BOLD << GREEN << "Available Commands:\n" << RESET;
@@ -108,16 +240,42 @@ void printHelp()
               << "- Display the current list of processes.\n"
               << RESET;
 
-    std::cout << BOLD << CYAN << "  kill <PID>" << RESET << "              " << YELLOW
-              << "- Kill the process with the specified PID.\n"
+    std::cout << BOLD << CYAN << "  tree [on|off]" << RESET << "            " << YELLOW
+              << "- Show the processes under their parents, each with the CPU and memory of its subtree.\n"
+              << RESET << "                     Without an argument, switches between the tree and the table.\n";
+
+    std::cout << BOLD << CYAN << "  kill <PID> [--grace <ms>]" << RESET << " " << YELLOW
+              << "- Kill the process with the specified PID; with --grace, send SIGTERM and kill it if it is\n"
+              << "    still running after that many milliseconds.\n"
               << RESET;
 
-    std::cout << BOLD << CYAN << "  kill_all <cpu|user> <value>" << RESET << " " << YELLOW
+    std::cout << BOLD << CYAN << "  kill_all <cpu|user> <value> [--grace <ms>]" << RESET << " " << YELLOW
               << "- Kill processes exceeding a CPU usage threshold or belonging to a user.\n"
               << RESET;
 
-    std::cout << BOLD << CYAN << "  filter <user|cpu|memory> <value>" << RESET << " " << YELLOW
-              << "- Filter processes by user, CPU usage, or memory usage.\n"
+    std::cout << BOLD << CYAN << "  kill_tree <PID> [--grace <ms>]" << RESET << " " << YELLOW
+              << "- Kill a process and all of its descendants, as listed when the command runs.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  kill_all cgroup <path>" << RESET << "   " << YELLOW
+              << "- Kill every process of a cgroup and its descendants (through cgroup.kill).\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  list_cgroups [N]" << RESET << "         " << YELLOW
+              << "- Show the N cgroups (default 30) using the most CPU or memory, one read per cgroup.\n"
+              << RESET << "                     Follows sort_by and the cpu, memory and cgroup filters.\n";
+
+    std::cout << BOLD << CYAN << "  throttle <path> <percent|max>" << RESET << " " << YELLOW
+              << "- Cap the CPU usage of a cgroup (100 is one core) through cpu.max, or remove the cap.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  policy [load <file>|off]" << RESET << " " << YELLOW
+              << "- Show the policy rules with their matches and firings, load rules from a file, or remove them.\n"
+              << RESET << "                     Rules act on processes every epoch, e.g. "
+              << "'cpu > 95 for 30s and user != root -> term 10s, alert'.\n";
+
+    std::cout << BOLD << CYAN << "  filter <user|cpu|memory|cgroup> <value>" << RESET << " " << YELLOW
+              << "- Filter processes by user, CPU usage, or memory usage, or cgroups by path.\n"
               << RESET;
 
     std::cout << BOLD << CYAN << "  sort_by <cpu|memory>" << RESET << "      " << YELLOW
@@ -128,9 +286,56 @@ void printHelp()
               << "- Log process information to a file. Default file: 'process_log.txt'.\n"
               << RESET;
 
-    std::cout << BOLD << CYAN << "  set_update_freq <seconds>" << RESET << "  " << YELLOW
-              << "- Change the update frequency for resource monitoring.\n"
-              << RESET << "                     For example, 'set_update_freq 10' updates data every 10 seconds.\n";
+    std::cout << BOLD << CYAN << "  log_flush <messages> <ms> [sync_ms]" << RESET << " " << YELLOW
+              << "- Write log messages in batches of this many, or once the oldest is this old (256, 50 ms).\n"
+              << RESET << "                     Critical messages are written at once; sync_ms > 0 adds fdatasync.\n";
+
+    std::cout << BOLD << CYAN << "  log_level <info|warning|error|critical>" << RESET << " " << YELLOW
+              << "- Discard log messages below this severity (info by default).\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  set_update_freq [sample|display] <seconds>" << RESET << " " << YELLOW
+              << "- Change how often processes are sampled (default 5) or the table redrawn (default 1).\n"
+              << RESET << "                     For example, 'set_update_freq 10' updates data every 10 seconds.\n"
+              << "                     Between samples, the table moves smoothly from the previous values to the new"
+              << " ones.\n";
+
+    std::cout << BOLD << CYAN << "  record <file|stop>" << RESET << "       " << YELLOW
+              << "- Record every sampling epoch to a session file, or stop recording.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  replay <file> [speed|step]" << RESET << " " << YELLOW
+              << "- Replay a recorded session instead of live data.\n"
+              << RESET
+              << "                     Speed is a multiplier (e.g. 10); 'step' advances one frame per 'step'.\n";
+
+    std::cout << BOLD << CYAN << "  step [count]" << RESET << "             " << YELLOW
+              << "- Advance a single-stepped replay by one or more frames.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  seek <seconds>" << RESET << "           " << YELLOW
+              << "- Jump to an offset (in seconds) from the start of the replayed session.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  history <PID>" << RESET << "            " << YELLOW
+              << "- Show min/avg/max/p95 and a sparkline of the recent CPU and memory usage of a process.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  set_history_budget <MB> [samples]" << RESET << " " << YELLOW
+              << "- Change the memory budget and per-process window of the history.\n"
+              << RESET << "                     Processes idle the longest are evicted when the budget is full.\n";
+
+    std::cout << BOLD << CYAN << "  history_store <dir|stop>" << RESET << " " << YELLOW
+              << "- Keep a compressed 24-hour history of every process in a data directory.\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  history_at <HH:MM[:SS]> [N]" << RESET << " " << YELLOW
+              << "- Show the N processes using the most CPU at a past time (default 20).\n"
+              << RESET;
+
+    std::cout << BOLD << CYAN << "  set_rows <n|auto>" << RESET << "        " << YELLOW
+              << "- Show at most n process rows, or as many as fit in the terminal (default).\n"
+              << RESET;
 
     std::cout << BOLD << CYAN << "  clear" << RESET << "                   " << YELLOW
               << "- Clear the terminal screen.\n"
@@ -148,10 +353,21 @@ void printHelp()
     std::cout << "  " << GREEN << "start_monitor" << RESET << " memory\n";
     std::cout << "  " << GREEN << "kill 1234" << RESET << "\n";
     std::cout << "  " << GREEN << "kill_all cpu 50" << RESET << "\n";
+    std::cout << "  " << GREEN << "kill_all user postgres --grace 10000" << RESET << "\n";
+    std::cout << "  " << GREEN << "kill_tree 4242 --grace 5000" << RESET << "\n";
+    std::cout << "  " << GREEN << "tree on" << RESET << "\n";
+    std::cout << "  " << GREEN << "list_cgroups 10" << RESET << "\n";
+    std::cout << "  " << GREEN << "throttle system.slice/docker-4f2a.scope 50" << RESET << "\n";
+    std::cout << "  " << GREEN << "policy load /etc/process_manager.policy" << RESET << "\n";
     std::cout << "  " << GREEN << "filter user root" << RESET << "\n";
     std::cout << "  " << GREEN << "sort_by memory" << RESET << "\n";
     std::cout << "  " << GREEN << "log process_log.txt" << RESET << "\n";
     std::cout << "  " << GREEN << "set_update_freq 10" << RESET << "\n";
+    std::cout << "  " << GREEN << "set_update_freq display 0.25" << RESET << "\n";
+    std::cout << "  " << GREEN << "record incident.pmrec" << RESET << "\n";
+    std::cout << "  " << GREEN << "replay incident.pmrec 10" << RESET << "\n";
+    std::cout << "  " << GREEN << "history 1234" << RESET << "\n";
+    std::cout << "  " << GREEN << "history_at 03:12 10" << RESET << "\n";
 
     // Provide additional notes for clarification
     std::cout << BOLD << GREEN << "\nNotes:\n" << RESET;
@@ -166,13 +382,25 @@ void startCommandLoop()
     // Set up the tab completion function for Readline
     rl_attempted_completion_function = commandCompleter;
 
+    // Print the outcome of graceful terminations while waiting for input
+    rl_event_hook = printTerminationReports;
+
     // Register the SIGINT signal handler for graceful shutdown on Ctrl+C
     std::signal(SIGINT, handleSigint);
 
+    // Register the SIGWINCH handler so the process table follows the terminal size. Readline
+    // forwards the signal to it while it is reading a line.
+    struct sigaction resizeAction = {};
+    resizeAction.sa_handler = handleSigwinch;
+    sigemptyset(&resizeAction.sa_mask);
+    resizeAction.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &resizeAction, nullptr);
+
     std::string input;
     while (true)
     {
         // Use readline to get user input with a prompt
+        printTerminationReports();
         char* line = readline("ProcessManager> ");
         if (!line)
         {
@@ -184,6 +412,9 @@ void startCommandLoop()
         input = std::string(line);
         free(line);
 
+        // The prompt and the command output scroll the terminal under the process table
+        screenRepaintRequested.store(true);
+
         // Trim leading and trailing whitespace from the input
         input.erase(0, input.find_first_not_of(" \t\n\r\f\v"));
         input.erase(input.find_last_not_of(" \t\n\r\f\v") + 1);
@@ -217,14 +448,21 @@ void startCommandLoop()
                     }
                 }
                 sortingCriterion = sortBy; // Update the global sorting criterion
+                {
+                    std::lock_guard<std::mutex> lock(processMutex);
+                    processes.clear(); // Do not keep the processes of a replayed session
+                }
+                processSnapshots.reset(); // Do not show the processes of a previous session
+                processTree.clear();
+                replayActive.store(false);
 
                 // Start monitoring by setting the active flag
-                monitoringActive.store(true);
+                unsigned generation = beginMonitoring();
 
                 // Create separate threads for CPU monitoring, memory monitoring, and process display
-                std::thread cpuThread(monitorCpu);
-                std::thread memoryThread(monitorMemory);
-                std::thread displayThread(monitorProcesses);
+                std::thread cpuThread(monitorCpu, generation);
+                std::thread memoryThread(monitorMemory, generation);
+                std::thread displayThread(monitorProcesses, generation);
 
                 // Detach threads to allow them to run independently
                 cpuThread.detach();
@@ -301,6 +539,74 @@ void startCommandLoop()
             Logger::getInstance().info("User listed all processes.");
         }
 
+        // Handle the "list_cgroups" command
+        else if (command == "list_cgroups")
+        {
+            int count = static_cast<int>(kDefaultTableRows);
+            if (iss.eof() || ((iss >> count) && count > 0 && iss.eof()))
+            {
+                // The CPU usage is measured over a short window, like --once does for processes
+                CgroupSampler sampler;
+                if (!cgroupHierarchyAvailable())
+                {
+                    std::cout << "No cgroup v2 hierarchy found at " << cgroupRoot
+                              << " (start the program with --cgroup-root <dir>).\n";
+                }
+                else if (sampler.sample().empty())
+                {
+                    std::cout << "No cgroups below " << cgroupRoot << ".\n";
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(kCgroupWindowMs));
+                    std::vector<CgroupUsage> cgroups = sampler.sample();
+                    filterCgroups(cgroups, filterCriterion);
+                    sortCgroups(cgroups, sortingCriterion);
+                    printCgroups(cgroups, static_cast<size_t>(count));
+                }
+                Logger::getInstance().info("User listed cgroups.");
+            }
+            else
+            {
+                std::cout << "Usage: list_cgroups [N]\n";
+            }
+        }
+
+        // Handle the "throttle" command
+        else if (command == "throttle")
+        {
+            std::string path, limit;
+            double percent = 0.0;
+            if ((iss >> path >> limit) && iss.eof() &&
+                (limit == "max" || (std::istringstream(limit) >> percent && std::isfinite(percent) && percent > 0)))
+            {
+                std::string error;
+                if (setCgroupCpuMax(path, percent, error))
+                {
+                    if (limit == "max")
+                        std::cout << "CPU cap of cgroup " << path << " removed.\n";
+                    else
+                        std::cout << "Cgroup " << path << " is capped at " << percent << "% CPU.\n";
+                    Logger::getInstance().info("User set the CPU cap of cgroup {} to {}.", path, limit);
+                }
+                else
+                {
+                    std::cerr << "Failed to throttle cgroup " << path << ": " << error << "\n";
+                    Logger::getInstance().error("Failed to throttle cgroup {}: {}", path, error);
+                }
+            }
+            else
+            {
+                std::cout << "Usage: throttle <path> <percent|max>\n";
+            }
+        }
+
+        // Replayed processes are not the ones running now: refuse the kill commands during a replay
+        else if ((command == "kill" || command == "kill_all" || command == "kill_tree") && replayActive.load())
+        {
+            std::cout << "Kill commands are disabled while a session is replayed. Use 'stop_monitor' first.\n";
+        }
+
         // Handle the "kill_all" command
         else if (command == "kill_all")
         {
@@ -310,7 +616,8 @@ void startCommandLoop()
                 if (filterType == "cpu")
                 {
                     double threshold;
-                    if (iss >> threshold)
+                    int graceMs;
+                    if ((iss >> threshold) && readGraceOption(iss, graceMs))
                     {
                         std::cout << "Are you sure you want to terminate all processes with CPU usage above "
                                   << threshold << "%? (y/n): ";
@@ -319,7 +626,16 @@ void startCommandLoop()
 
                         if (confirmation == 'y' || confirmation == 'Y')
                         {
-                            if (killProcessesByCpu(threshold))
+                            std::vector<KillTarget> targets;
+                            if (graceMs > 0)
+                                targets = selectKillTargets([&](const Process& p) { return p.cpuUsage > threshold; });
+                            if (!targets.empty())
+                            {
+                                std::ostringstream what;
+                                what << "CPU usage above " << threshold << "%";
+                                terminateGracefully(std::move(targets), graceMs, what.str());
+                            }
+                            else if (graceMs == 0 && killProcessesByCpu(threshold).killed() > 0)
                             {
                                 std::cout << "Processes exceeding " << threshold
                                           << "% CPU usage have been terminated.\n";
@@ -341,14 +657,15 @@ void startCommandLoop()
                     }
                     else
                     {
-                        std::cout << "Usage: kill_all cpu <threshold>\n";
+                        std::cout << "Usage: kill_all cpu <threshold> [--grace <ms>]\n";
                         Logger::getInstance().warning("User provided invalid arguments for kill_all cpu command.");
                     }
                 }
                 else if (filterType == "user")
                 {
                     std::string user;
-                    if (iss >> user)
+                    int graceMs;
+                    if ((iss >> user) && readGraceOption(iss, graceMs))
                     {
                         std::cout << "Are you sure you want to terminate all processes for user " << user
                                   << "? (y/n): ";
@@ -357,7 +674,14 @@ void startCommandLoop()
 
                         if (confirmation == 'y' || confirmation == 'Y')
                         {
-                            if (killProcessesByUser(user))
+                            std::vector<KillTarget> targets;
+                            if (graceMs > 0)
+                                targets = selectKillTargets([&](const Process& p) { return p.user == user; });
+                            if (!targets.empty())
+                            {
+                                terminateGracefully(std::move(targets), graceMs, "user " + user);
+                            }
+                            else if (graceMs == 0 && killProcessesByUser(user).killed() > 0)
                             {
                                 std::cout << "All processes for user " << user << " have been terminated.\n";
                                 Logger::getInstance().info("User killed all processes belonging to user: " + user +
@@ -379,20 +703,53 @@ void startCommandLoop()
                     }
                     else
                     {
-                        std::cout << "Usage: kill_all user <username>\n";
+                        std::cout << "Usage: kill_all user <username> [--grace <ms>]\n";
                         Logger::getInstance().warning("User provided invalid arguments for kill_all user command.");
                     }
                 }
+                else if (filterType == "cgroup")
+                {
+                    std::string path;
+                    if ((iss >> path) && iss.eof())
+                    {
+                        std::cout << "Are you sure you want to kill every process of cgroup " << path << "? (y/n): ";
+                        char confirmation;
+                        std::cin >> confirmation;
+
+                        std::string error;
+                        if (confirmation != 'y' && confirmation != 'Y')
+                        {
+                            std::cout << "Termination canceled.\n";
+                            Logger::getInstance().info("User canceled termination of cgroup {}.", path);
+                        }
+                        else if (killCgroup(path, error))
+                        {
+                            std::cout << "All processes of cgroup " << path << " have been killed.\n";
+                            Logger::getInstance().info("User killed all processes of cgroup {}.", path);
+                        }
+                        else
+                        {
+                            std::cerr << "Failed to kill cgroup " << path << ": " << error << "\n";
+                            Logger::getInstance().error("Failed to kill cgroup {}: {}", path, error);
+                        }
+                    }
+                    else
+                    {
+                        // cgroup.kill only sends SIGKILL, hence no --grace
+                        std::cout << "Usage: kill_all cgroup <path>\n";
+                        Logger::getInstance().warning("User provided invalid arguments for kill_all cgroup command.");
+                    }
+                }
                 else
                 {
-                    std::cout << "Invalid criterion. Use 'cpu' or 'user'.\n";
+                    std::cout << "Invalid criterion. Use 'cpu', 'user' or 'cgroup'.\n";
                     Logger::getInstance().warning("User provided invalid filter type for kill_all command: " +
                                                   filterType);
                 }
             }
             else
             {
-                std::cout << "Usage: kill_all <cpu|user> [value]\n";
+                std::cout << "Usage: kill_all <cpu|user|cgroup> [value] [--grace <ms>]\n";
                 Logger::getInstance().warning("User attempted to use kill_all command without sufficient arguments.");
             }
         }
@@ -406,6 +763,7 @@ void startCommandLoop()
                 if (sortBy == "cpu" || sortBy == "memory")
                 {
                     sortingCriterion = sortBy;
+                    requestDisplayRefresh();
                     std::cout << "Sorting criterion updated to: " << sortBy << "\n";
                     Logger::getInstance().info("User changed sorting criterion to: " + sortBy + ".");
                 }
@@ -422,6 +780,27 @@ void startCommandLoop()
             }
         }
 
+        // Handle the "tree" command
+        else if (command == "tree")
+        {
+            std::string mode;
+            if (!(iss >> mode))
+                mode = treeView.load() ? "off" : "on";
+
+            if ((mode == "on" || mode == "off") && iss.eof())
+            {
+                treeView.store(mode == "on");
+                requestDisplayRefresh();
+                std::cout << "Tree view " << (mode == "on" ? "enabled" : "disabled") << ".\n";
+                Logger::getInstance().info("User turned the tree view {}.", mode);
+            }
+            else
+            {
+                std::cout << "Usage: tree [on|off]\n";
+                Logger::getInstance().warning("User provided invalid arguments for tree command.");
+            }
+        }
+
         // Handle the "filter" command
         else if (command == "filter")
         {
@@ -434,6 +813,7 @@ void startCommandLoop()
                     if (iss >> user)
                     {
                         filterCriterion = {"user", user};
+                        requestDisplayRefresh();
                         Logger::getInstance().info("User applied filter by user: " + user);
                         std::cout << "Filter applied by user: " << user << "\n";
                     }
@@ -460,6 +840,7 @@ void startCommandLoop()
                             oss << cpuThreshold;
                         }
                         filterCriterion = {"cpu", oss.str()};
+                        requestDisplayRefresh();
                         Logger::getInstance().info("User applied CPU filter: > " + oss.str() + "%");
                         std::cout << "CPU filter applied: > " << oss.str() << "%\n";
                     }
@@ -486,6 +867,7 @@ void startCommandLoop()
                             oss << memoryThreshold;
                         }
                         filterCriterion = {"memory", oss.str()};
+                        requestDisplayRefresh();
                         Logger::getInstance().info("User applied Memory filter: > " + oss.str() + " MB");
                         std::cout << "Memory filter applied: > " << oss.str() << " MB\n";
                     }
@@ -496,15 +878,33 @@ void startCommandLoop()
                             "User attempted to use filter memory command without specifying a threshold.");
                     }
                 }
+                else if (filterType == "cgroup")
+                {
+                    std::string text;
+                    if (iss >> text)
+                    {
+                        // Only list_cgroups applies it; the process view shows every process
+                        filterCriterion = {"cgroup", text};
+                        requestDisplayRefresh();
+                        Logger::getInstance().info("User applied cgroup filter: " + text);
+                        std::cout << "Cgroup filter applied: paths containing " << text << "\n";
+                    }
+                    else
+                    {
+                        std::cout << "Usage: filter cgroup <text>\n";
+                        Logger::getInstance().warning(
+                            "User attempted to use filter cgroup command without specifying a path.");
+                    }
+                }
                 else
                 {
-                    std::cout << "Invalid filter type. Use 'user', 'cpu', or 'memory'.\n";
+                    std::cout << "Invalid filter type. Use 'user', 'cpu', 'memory' or 'cgroup'.\n";
                     Logger::getInstance().warning("User provided invalid filter type: " + filterType + ".");
                 }
             }
             else
             {
-                std::cout << "Usage: filter <user|cpu|memory> [value]\n";
+                std::cout << "Usage: filter <user|cpu|memory|cgroup> [value]\n";
                 Logger::getInstance().warning("User attempted to use filter command without sufficient arguments.");
             }
         }
@@ -542,6 +942,47 @@ void startCommandLoop()
             }
         }
 
+        // Handle the "log_flush" command
+        else if (command == "log_flush")
+        {
+            long messages = 0;
+            int delayMs = 0;
+            int syncMs = 0;
+            if ((iss >> messages >> delayMs) && messages > 0 && delayMs > 0 && (!(iss >> syncMs) || syncMs >= 0) &&
+                iss.eof())
+            {
+                LogFlushPolicy policy = Logger::getInstance().flushPolicy();
+                policy.maxMessages = static_cast<size_t>(messages);
+                policy.maxDelayMs = delayMs;
+                policy.syncIntervalMs = syncMs;
+                Logger::getInstance().setFlushPolicy(policy);
+                std::cout << "Log messages are written in batches of " << messages << " or after " << delayMs << " ms"
+                          << (syncMs > 0 ? ", synced every " + std::to_string(syncMs) + " ms.\n" : ".\n");
+                Logger::getInstance().info("User changed the log flush policy.");
+            }
+            else
+            {
+                std::cout << "Usage: log_flush <messages> <ms> [sync_ms]\n";
+            }
+        }
+
+        // Handle the "log_level" command
+        else if (command == "log_level")
+        {
+            std::string name;
+            LogLevel level;
+            if ((iss >> name) && parseLogLevel(name, level) && iss.eof())
+            {
+                Logger::getInstance().info("User changed the log level to {}.", logLevelName(level));
+                Logger::getInstance().setMinLevel(level);
+                std::cout << "Log messages below " << logLevelName(level) << " are discarded.\n";
+            }
+            else
+            {
+                std::cout << "Usage: log_level <info|warning|error|critical>\n";
+            }
+        }
+
         // Handle the "stop_monitor" command
         else if (command == "stop_monitor")
         {
@@ -571,39 +1012,504 @@ void startCommandLoop()
         else if (command == "kill")
         {
             int pid;
-            if (iss >> pid)
+            int graceMs;
+            if ((iss >> pid) && readGraceOption(iss, graceMs))
             {
                 std::cout << "Are you sure you want to terminate process " << pid << "? (y/n): ";
                 char confirmation;
                 std::cin >> confirmation;
 
-                if (confirmation == 'y' || confirmation == 'Y')
+                if ((confirmation == 'y' || confirmation == 'Y') && graceMs > 0)
+                {
+                    // Use the sampled start time if the process is monitored, so a reused PID is left alone
+                    std::vector<KillTarget> targets = selectKillTargets([&](const Process& p) { return p.pid == pid; });
+                    if (targets.empty())
+                        targets.push_back(currentKillTarget(pid));
+                    terminateGracefully(std::move(targets), graceMs, "PID " + std::to_string(pid));
+                }
+                else if (confirmation == 'y' || confirmation == 'Y')
                 {
                     if (killProcess(pid))
                     {
                         std::cout << "Process " << pid << " has been terminated.\n";
-                        Logger::getInstance().info("User terminated process PID: " + std::to_string(pid) + ".");
+                        Logger::getInstance().info("User terminated process PID: {pid}.", pid);
                     }
                     else
                     {
                         std::cerr << "Failed to terminate process " << pid << ".\n";
-                        Logger::getInstance().error("Failed to terminate process PID: " + std::to_string(pid) + ".");
+                        Logger::getInstance().error("Failed to terminate process PID: {pid}.", pid);
                     }
                 }
                 else
                 {
                     std::cout << "Termination of process " << pid << " canceled.\n";
-                    Logger::getInstance().info("User canceled termination of process PID: " + std::to_string(pid) +
-                                               ".");
+                    Logger::getInstance().info("User canceled termination of process PID: {pid}.", pid);
                 }
             }
             else
             {
-                std::cerr << "Usage: kill <PID>\n";
+                std::cerr << "Usage: kill <PID> [--grace <ms>]\n";
                 Logger::getInstance().warning("User attempted to use kill command without specifying a PID.");
             }
         }
 
+        // Handle the "kill_tree" command
+        else if (command == "kill_tree")
+        {
+            int pid;
+            int graceMs;
+            if ((iss >> pid) && readGraceOption(iss, graceMs))
+            {
+                std::cout << "Are you sure you want to terminate process " << pid
+                          << " and all of its descendants? (y/n): ";
+                char confirmation;
+                std::cin >> confirmation;
+
+                if ((confirmation == 'y' || confirmation == 'Y') && graceMs > 0)
+                {
+                    std::vector<KillTarget> targets = selectProcessTree(pid);
+                    if (!targets.empty())
+                    {
+                        terminateGracefully(std::move(targets), graceMs, "tree of PID " + std::to_string(pid));
+                    }
+                    else
+                    {
+                        std::cout << "No process found with PID: " << pid << "\n";
+                        Logger::getInstance().info("User attempted to kill the tree of missing PID {pid}.", pid);
+                    }
+                }
+                else if (confirmation == 'y' || confirmation == 'Y')
+                {
+                    KillReport report = killProcessTree(pid);
+                    if (report.killed() > 0)
+                    {
+                        Logger::getInstance().info("User killed {} process(es) of the tree of PID {pid}.",
+                                                   report.killed(), pid);
+                    }
+                    else
+                    {
+                        Logger::getInstance().error("Failed to kill the tree of PID {pid}.", pid);
+                    }
+                }
+                else
+                {
+                    std::cout << "Termination of the tree of process " << pid << " canceled.\n";
+                    Logger::getInstance().info("User canceled termination of the tree of PID {pid}.", pid);
+                }
+            }
+            else
+            {
+                std::cerr << "Usage: kill_tree <PID> [--grace <ms>]\n";
+                Logger::getInstance().warning("User attempted to use kill_tree command without specifying a PID.");
+            }
+        }
+
+        // Handle the "record" command
+        else if (command == "record")
+        {
+            std::string target;
+            if (!(iss >> target))
+            {
+                std::cout << "Usage: record <file|stop>\n";
+                Logger::getInstance().warning("User attempted to use record command without specifying a file.");
+            }
+            else if (target == "stop")
+            {
+                if (sessionRecorder.isOpen())
+                {
+                    std::string path = sessionRecorder.path();
+                    uint64_t frames = sessionRecorder.framesWritten();
+                    uint64_t bytes = sessionRecorder.bytesWritten();
+                    sessionRecorder.close();
+                    std::cout << "Recording stopped: " << frames << " epochs, " << bytes << " bytes written to "
+                              << path << ".\n";
+                    Logger::getInstance().info("User stopped recording to " + path + ".");
+                }
+                else
+                {
+                    std::cout << "Recording is not active.\n";
+                }
+            }
+            else if (sessionRecorder.isOpen())
+            {
+                std::cout << "Already recording to " << sessionRecorder.path() << ". Use 'record stop' first.\n";
+            }
+            else if (!sessionRecorder.open(target))
+            {
+                std::cerr << "Failed to open session file: " << target << "\n";
+                Logger::getInstance().error("Failed to open session file: " + target + ".");
+            }
+            else
+            {
+                std::cout << "Recording sampling epochs to " << target << ".\n";
+                Logger::getInstance().info("User started recording to " + target + ".");
+            }
+        }
+
+        // Handle the "replay" command
+        else if (command == "replay")
+        {
+            std::string file;
+            if (!(iss >> file))
+            {
+                std::cout << "Usage: replay <file> [speed|step]\n";
+                Logger::getInstance().warning("User attempted to use replay command without specifying a file.");
+            }
+            else if (monitoringActive.load())
+            {
+                std::cout << "Monitoring is active. Use 'stop_monitor' before replaying a session.\n";
+            }
+            else
+            {
+                // Parse the replay mode: a speed multiplier or single-step
+                double speed = 1.0;
+                bool stepMode = false;
+                std::string mode;
+                if (iss >> mode)
+                {
+                    if (mode == "step")
+                    {
+                        stepMode = true;
+                    }
+                    else
+                    {
+                        try
+                        {
+                            speed = std::stod(mode);
+                        }
+                        catch (const std::exception&)
+                        {
+                            speed = 0.0;
+                        }
+                    }
+                }
+
+                auto reader = std::make_shared<SessionReader>();
+                if (speed <= 0.0)
+                {
+                    std::cout << "Invalid replay speed. Please provide a positive number or 'step'.\n";
+                }
+                else if (!reader->open(file) || reader->frameCount() == 0)
+                {
+                    std::cerr << "Failed to read session file: " << file << "\n";
+                    Logger::getInstance().error("Failed to read session file: " + file + ".");
+                }
+                else
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(processMutex);
+                        processes.clear(); // Do not mix live and recorded processes
+                    }
+                    processSnapshots.reset();
+                    processTree.clear();
+                    replayStepRequests.store(stepMode ? 1 : 0); // Show the first frame right away
+                    replaySeekOffsetMs.store(-1);
+                    replayActive.store(true);
+                    unsigned generation = beginMonitoring();
+
+                    // The replay thread feeds the processes map in place of the CPU and memory threads.
+                    // Monitoring threads of the stopped session exit when they wake up, before sampling.
+                    std::thread replayThread(replaySession, reader, speed, stepMode, generation);
+                    std::thread displayThread(monitorProcesses, generation);
+                    replayThread.detach();
+                    displayThread.detach();
+
+                    std::cout << "Replaying " << reader->frameCount() << " epochs from " << file;
+                    if (stepMode)
+                        std::cout << " in single-step mode. Use 'step' to advance.\n";
+                    else
+                        std::cout << " at " << speed << "x speed.\n";
+                    Logger::getInstance().info("User started replay of session file: " + file + ".");
+                }
+            }
+        }
+
+        // Handle the "step" command
+        else if (command == "step")
+        {
+            int count = 1;
+            if (!(iss >> count) || count <= 0)
+            {
+                count = 1;
+            }
+            if (monitoringActive.load())
+            {
+                replayStepRequests.fetch_add(count);
+            }
+            else
+            {
+                std::cout << "No session is being replayed.\n";
+            }
+        }
+
+        // Handle the "seek" command
+        else if (command == "seek")
+        {
+            double seconds;
+            if (iss >> seconds && seconds >= 0)
+            {
+                if (monitoringActive.load())
+                {
+                    replaySeekOffsetMs.store(static_cast<long long>(seconds * 1000.0));
+                    Logger::getInstance().info("User seeked replay to +" + std::to_string(seconds) + " seconds.");
+                }
+                else
+                {
+                    std::cout << "No session is being replayed.\n";
+                }
+            }
+            else
+            {
+                std::cout << "Usage: seek <seconds>\n";
+            }
+        }
+
+        // Handle the "history" command
+        else if (command == "history")
+        {
+            int pid;
+            std::vector<HistorySample> samples;
+            if (!(iss >> pid))
+            {
+                std::cout << "Usage: history <PID>\n";
+                Logger::getInstance().warning("User attempted to use history command without specifying a PID.");
+            }
+            else if (!processHistory.samples(pid, samples))
+            {
+                std::cout << "No history recorded for process " << pid << ".\n";
+            }
+            else
+            {
+                std::vector<double> cpuValues, memoryValues;
+                for (const auto& sample : samples)
+                {
+                    cpuValues.push_back(sample.cpuUsage);
+                    memoryValues.push_back(sample.memoryUsage);
+                }
+
+                // One line per metric: statistics followed by a sparkline of the window
+                auto printSeries = [](const char* label, const char* unit, const std::vector<double>& values) {
+                    HistoryStats stats = ProcessHistory::computeStats(values);
+                    std::cout << std::fixed << std::setprecision(2) << "  " << label << " min " << stats.min << unit
+                              << "  avg " << stats.avg << unit << "  max " << stats.max << unit << "  p95 "
+                              << stats.p95 << unit << "  " << ProcessHistory::sparkline(values, 60) << "\n";
+                };
+
+                std::cout << "History of process " << pid << " (" << samples.size() << " of "
+                          << processHistory.window() << " samples, oldest first):\n";
+                printSeries("CPU   ", "%", cpuValues);
+                printSeries("Memory", " MB", memoryValues);
+            }
+        }
+
+        // Handle the "set_history_budget" command
+        else if (command == "set_history_budget")
+        {
+            double megabytes = 0.0;
+            int window = static_cast<int>(processHistory.window());
+            bool valid = (iss >> megabytes) && megabytes > 0;
+            int requestedWindow;
+            if (valid && iss >> requestedWindow)
+            {
+                window = requestedWindow; // Optional second argument
+            }
+            double maxMegabytes = maxHistoryBudgetMb();
+            if (valid && (!std::isfinite(megabytes) || megabytes > maxMegabytes))
+            {
+                std::cout << "Invalid budget. Please provide at most " << std::floor(maxMegabytes)
+                          << " MB (a quarter of the physical memory).\n";
+            }
+            else if (valid && window > kMaxHistoryWindow)
+            {
+                std::cout << "Invalid window. Please provide at most " << kMaxHistoryWindow << " samples.\n";
+            }
+            else if (valid && window > 0)
+            {
+                processHistory.configure(static_cast<size_t>(megabytes * 1024 * 1024), static_cast<size_t>(window));
+                std::cout << "History budget set to " << megabytes << " MB: " << processHistory.capacity()
+                          << " processes of " << processHistory.window()
+                          << " samples. Recorded samples were discarded.\n";
+                Logger::getInstance().info("User set history budget to " + std::to_string(megabytes) +
+                                           " MB and window to " + std::to_string(window) + " samples.");
+            }
+            else
+            {
+                std::cout << "Usage: set_history_budget <MB> [samples]\n";
+            }
+        }
+
+        // Handle the "set_rows" command
+        else if (command == "set_rows")
+        {
+            std::string value;
+            iss >> value;
+            int rows = 0;
+            bool valid = value == "auto";
+            if (!valid)
+            {
+                std::istringstream number(value);
+                valid = (number >> rows) && number.eof() && rows > 0;
+            }
+            if (valid)
+            {
+                displayRowLimit.store(rows);
+                requestDisplayRefresh(); // Redraw with the new size right away
+                std::cout << (rows > 0 ? "Showing at most " + std::to_string(rows) + " process rows.\n"
+                                       : std::string("Showing as many process rows as fit in the terminal.\n"));
+                Logger::getInstance().info("User set display rows to " + (rows > 0 ? std::to_string(rows) : value) +
+                                           ".");
+            }
+            else
+            {
+                std::cout << "Usage: set_rows <n|auto>\n";
+            }
+        }
+
+        // Handle the "policy" command
+        else if (command == "policy")
+        {
+            std::string action, path;
+            iss >> action;
+            if (action.empty())
+            {
+                std::vector<PolicyRuleStatus> rules = policyEngine.status();
+                if (rules.empty())
+                {
+                    std::cout << "No policy rules. Use 'policy load <file>' to load some.\n";
+                }
+                for (size_t i = 0; i < rules.size(); ++i)
+                {
+                    std::cout << std::setw(3) << i + 1 << ". " << rules[i].text << "\n"
+                              << "     matching " << rules[i].matching << " process(es), fired " << rules[i].firings
+                              << " time(s)\n";
+                }
+            }
+            else if (action == "load" && (iss >> path) && iss.eof())
+            {
+                std::vector<PolicyRule> rules;
+                std::string error;
+                if (loadPolicyFile(path, rules, error))
+                {
+                    size_t count = rules.size();
+                    policyEngine.setRules(std::move(rules));
+                    std::cout << "Loaded " << count << " policy rule(s) from " << path << ".\n";
+                    Logger::getInstance().info("User loaded {} policy rule(s) from {}.", count, path);
+                }
+                else
+                {
+                    std::cerr << error << "\n";
+                    Logger::getInstance().error("Failed to load policy file: {}", error);
+                }
+            }
+            else if (action == "off" && iss.eof())
+            {
+                policyEngine.clear();
+                std::cout << "Policy rules removed.\n";
+                Logger::getInstance().info("User removed the policy rules.");
+            }
+            else
+            {
+                std::cout << "Usage: policy [load <file>|off]\n";
+                Logger::getInstance().warning("User provided invalid arguments for policy command.");
+            }
+        }
+
+        // Handle the "history_store" command
+        else if (command == "history_store")
+        {
+            std::string target;
+            if (!(iss >> target))
+            {
+                std::cout << "Usage: history_store <dir|stop>\n";
+            }
+            else if (target == "stop")
+            {
+                if (historyStore.isOpen())
+                {
+                    historyStore.close();
+                    std::cout << "History store closed.\n";
+                    Logger::getInstance().info("User closed the history store.");
+                }
+                else
+                {
+                    std::cout << "History store is not open.\n";
+                }
+            }
+            else
+            {
+                HistoryStoreOptions options;
+                options.directory = target;
+                if (historyStore.open(options))
+                {
+                    std::cout << "Storing process history in " << target << " (" << historyStore.segmentCount()
+                              << " existing segments, " << options.retentionHours << " hours retention).\n";
+                    Logger::getInstance().info("User opened history store in " + target + ".");
+                }
+                else
+                {
+                    std::cerr << "Failed to open history directory: " << target << "\n";
+                    Logger::getInstance().error("Failed to open history directory: " + target + ".");
+                }
+            }
+        }
+
+        // Handle the "history_at" command
+        else if (command == "history_at")
+        {
+            std::string clock;
+            int count = 20;
+            int hours = 0, minutes = 0, seconds = 0;
+            bool valid = (iss >> clock) && sscanf(clock.c_str(), "%d:%d:%d", &hours, &minutes, &seconds) >= 2 &&
+                         hours >= 0 && hours < 24 && minutes >= 0 && minutes < 60 && seconds >= 0 && seconds < 60;
+            if (valid && !(iss >> count))
+            {
+                count = 20;
+            }
+
+            if (!valid || count <= 0)
+            {
+                std::cout << "Usage: history_at <HH:MM[:SS]> [N]\n";
+            }
+            else if (!historyStore.isOpen())
+            {
+                std::cout << "History store is not open. Use 'history_store <dir>' first.\n";
+            }
+            else
+            {
+                // Resolve the local time of day to the most recent such moment
+                time_t now = time(nullptr);
+                struct tm local;
+                localtime_r(&now, &local);
+                local.tm_hour = hours;
+                local.tm_min = minutes;
+                local.tm_sec = seconds;
+                local.tm_isdst = -1;
+                time_t target = mktime(&local);
+                if (target > now)
+                {
+                    target -= 24 * 3600;
+                }
+
+                std::vector<Process> snapshot;
+                int64_t toleranceMs = sampleIntervalMs.load() + 1000LL;
+                if (!historyStore.processesAt(target * 1000LL, toleranceMs, snapshot))
+                {
+                    std::cerr << "History store is corrupted; showing the readable part.\n";
+                    Logger::getInstance().error("Failed to decode part of the history store.");
+                }
+                sortProcesses(snapshot, "cpu");
+                if (snapshot.size() > static_cast<size_t>(count))
+                {
+                    snapshot.resize(count);
+                }
+
+                char when[32];
+                strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime_r(&target, &local));
+                std::cout << "Top " << snapshot.size() << " processes by CPU at " << when << ":\n";
+                printProcesses(snapshot);
+            }
+        }
+
         // Handle the "help" command
         else if (command == "help")
         {
@@ -620,24 +1526,51 @@ void startCommandLoop()
         // Handle the "set_update_freq" command
         else if (command == "set_update_freq")
         {
-            int newFreq;
-            if (iss >> newFreq)
+            // "set_update_freq <seconds>" sets the sampling interval, like "set_update_freq sample <seconds>"
+            std::string target = "sample";
+            std::string argument;
+            double seconds = 0.0;
+            if (iss >> argument && (argument == "sample" || argument == "display"))
             {
-                if (newFreq <= 0)
+                target = argument;
+                argument.clear();
+                iss >> argument;
+            }
+            // The whole word must be a number in both forms
+            std::istringstream number(argument);
+            bool parsed = !argument.empty() && (number >> seconds) && number.eof();
+
+            if (!parsed)
+            {
+                std::cout << "Usage: set_update_freq <seconds>\n"
+                          << "       set_update_freq <sample|display> <seconds>\n";
+            }
+            else if (!std::isfinite(seconds) || seconds * 1000 < kMinIntervalMs || seconds * 1000 > kMaxIntervalMs)
+            {
+                std::cout << "Invalid frequency. Please provide a value between " << kMinIntervalMs / 1000.0 << " and "
+                          << kMaxIntervalMs / 1000 << " seconds.\n";
+            }
+            else
+            {
+                int intervalMs = static_cast<int>(std::lround(seconds * 1000));
+                if (target == "sample")
                 {
-                    std::cout << "Invalid frequency. Please provide a positive integer value.\n";
+                    sampleIntervalMs.store(intervalMs);
+                    std::cout << "Update frequency set to " << seconds << " seconds.\n";
                 }
                 else
                 {
-                    updateFrequency.store(newFreq);
-                    std::cout << "Update frequency set to " << newFreq << " seconds.\n";
-                    Logger::getInstance().info("User changed update frequency to " + std::to_string(newFreq) +
-                                               " seconds.");
+                    {
+                        // Stored under the lock so that the display thread cannot miss the notification
+                        // between checking its deadline and waiting: it re-checks it against the new interval
+                        std::lock_guard<std::mutex> lock(cvMutex);
+                        displayIntervalMs.store(intervalMs);
+                    }
+                    cv.notify_all();
+                    std::cout << "Display frequency set to " << seconds << " seconds.\n";
                 }
-            }
-            else
-            {
-                std::cout << "Usage: set_update_freq <seconds>\n";
+                Logger::getInstance().info("User changed " + target + " interval to " + std::to_string(intervalMs) +
+                                           " ms.");
             }
         }
 
@@ -654,6 +1587,9 @@ void startCommandLoop()
                     monitoringThread.join();
                 }
             }
+            // Flush and close any recording in progress
+            sessionRecorder.close();
+            historyStore.close();
             Logger::getInstance().info("User exited the application.");
             // Stop the logger to ensure all logs are flushed and the file is closed
             Logger::getInstance().stop();
@@ -0,0 +1,345 @@
+/**
+ * @file daemon_server.cpp
+ * @brief Implements the daemon mode and its Unix-socket server.
+ *
+ * This source file contains the implementation of the DaemonServer class and of the daemon mode
+ * loop. The server runs the poll() loop of PollServer; requests are answered from the
+ * snapshots published by the CPU monitoring thread, using the filter and selection functions of
+ * the other modes and the record serializer of the stream mode.
+ */
+
+#include "daemon_server.h"
+#include "globals.h"
+#include "logger.h"
+#include "process_control.h"
+#include "resource_monitor.h"
+#include "stream_output.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+// Set by SIGINT and SIGTERM
+std::atomic<bool> daemonStopRequested(false);
+
+// Unsent answer size above which a client's pipelined requests wait for the answers to be written
+const size_t kOutputHighWater = 1024 * 1024;
+
+void handleDaemonSignal(int sig)
+{
+    (void)sig;
+    daemonStopRequested.store(true);
+}
+
+// Fills a socket address for `path`; returns false if the path does not fit
+bool makeAddress(const std::string& path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+DaemonServer::DaemonServer()
+    : PollServer("Daemon", kMaxClients, 16 * kMaxRequestBytes), m_scratch(64 * 1024), m_cachedLimit(0)
+{
+}
+
+DaemonServer::~DaemonServer()
+{
+    stop();
+}
+
+bool DaemonServer::start(const std::string& socketPath, std::string& error)
+{
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address))
+    {
+        error = "Invalid socket path: " + socketPath;
+        return false;
+    }
+
+    // Replace a socket left behind by a daemon that was killed, but never a live one or another file
+    struct stat status;
+    if (lstat(socketPath.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            error = socketPath + " exists and is not a socket";
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (live)
+        {
+            error = "Another daemon is listening on " + socketPath;
+            return false;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0)
+    {
+        error = std::string("Failed to create socket: ") + std::strerror(errno);
+        return false;
+    }
+    mode_t previousMask = umask(0177); // Clients may kill processes: owner only
+    int bound = bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(previousMask);
+    if (bound != 0 || listen(m_listenFd, SOMAXCONN) != 0)
+    {
+        error = "Failed to listen on " + socketPath + ": " + std::strerror(errno);
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    m_socketPath = socketPath;
+    return true;
+}
+
+void DaemonServer::stop()
+{
+    if (m_listenFd >= 0)
+    {
+        unlink(m_socketPath.c_str());
+    }
+    closeSockets();
+    m_cachedSnapshot.reset();
+}
+
+std::unique_ptr<PollServer::Client> DaemonServer::newClient()
+{
+    return std::make_unique<DaemonClient>();
+}
+
+void DaemonServer::handleRequests(Client& connection)
+{
+    DaemonClient& client = static_cast<DaemonClient&>(connection);
+    size_t start = 0;
+    while (!client.closing && client.output.size() < kOutputHighWater)
+    {
+        size_t end = client.input.find('\n', start);
+        if (end == std::string::npos)
+            break;
+        std::string line = client.input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        start = end + 1;
+        handleRequest(client, line);
+    }
+    client.input.erase(0, start);
+
+    if (client.input.size() > kMaxRequestBytes && client.input.find('\n') == std::string::npos)
+    {
+        client.output += "ERR Request too long\n";
+        client.closing = true;
+    }
+}
+
+void DaemonServer::handleRequest(DaemonClient& client, const std::string& line)
+{
+    std::istringstream iss(line);
+    std::string command;
+    if (!(iss >> command))
+        return; // Empty lines are ignored
+    std::transform(command.begin(), command.end(), command.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+
+    std::string argument, extra;
+    bool hasArgument = static_cast<bool>(iss >> argument);
+    bool hasExtra = static_cast<bool>(iss >> extra);
+
+    if (command == "LIST")
+    {
+        long limit = 0;
+        std::istringstream number(argument);
+        if (hasExtra || (hasArgument && (!(number >> limit) || !number.eof() || limit < 0)))
+        {
+            client.output += "ERR Usage: LIST [N]\n";
+            return;
+        }
+        answerList(client, static_cast<size_t>(limit));
+    }
+    else if (command == "FILTER")
+    {
+        std::pair<std::string, std::string> filter = {"none", ""};
+        if (!hasArgument || hasExtra || (argument != "none" && !parseFilter(argument, filter)))
+        {
+            client.output += "ERR Usage: FILTER none|user=<name>|cpu><percent>|memory><MB>\n";
+            return;
+        }
+        client.filter = filter;
+        client.output += "OK 0\n";
+    }
+    else if (command == "SORT")
+    {
+        if (hasExtra || (argument != "cpu" && argument != "memory"))
+        {
+            client.output += "ERR Usage: SORT cpu|memory\n";
+            return;
+        }
+        client.sortBy = argument;
+        client.output += "OK 0\n";
+    }
+    else if (command == "HISTORY" || command == "KILL")
+    {
+        int pid = 0;
+        std::istringstream number(argument);
+        if (hasExtra || !(number >> pid) || !number.eof())
+        {
+            client.output += "ERR Usage: " + command + " <pid>\n";
+            return;
+        }
+        if (command == "HISTORY")
+        {
+            answerHistory(client, pid);
+        }
+        else if (killProcess(pid))
+        {
+            Logger::getInstance().info("Daemon client killed process {pid}.", pid);
+            client.output += "OK 0\n";
+        }
+        else
+        {
+            client.output += "ERR Failed to kill process " + std::to_string(pid) + "\n";
+        }
+    }
+    else if (command == "QUIT")
+    {
+        client.output += "OK 0\n";
+        client.closing = true;
+    }
+    else
+    {
+        client.output += "ERR Unknown command: " + command + "\n";
+    }
+}
+
+void DaemonServer::answerList(DaemonClient& client, size_t limit)
+{
+    auto snapshot = processSnapshots.latest();
+    if (!snapshot)
+    {
+        client.output += "ERR No snapshot yet\n";
+        return;
+    }
+
+    // Serialize only when the question or the epoch changed since the last answer
+    if (snapshot != m_cachedSnapshot || client.filter != m_cachedFilter || client.sortBy != m_cachedSortBy ||
+        limit != m_cachedLimit)
+    {
+        // Without a filter the rows point into the snapshot itself
+        std::vector<Process> filtered;
+        bool filtering = client.filter.first != "none";
+        if (filtering)
+            filtered = filterProcesses(snapshot->processes, client.filter);
+        const std::vector<Process>& selected = filtering ? filtered : snapshot->processes;
+        selectStreamRows(selected, limit == 0 ? selected.size() : limit, client.sortBy, m_rows);
+
+        // Snapshots are stamped on the steady clock; records carry wall-clock time
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count() -
+                              (steadyNowMs() - snapshot->timestampMs);
+
+        m_scratch.clear();
+        m_scratch.append("OK ");
+        m_scratch.appendInt(static_cast<long long>(m_rows.size()));
+        m_scratch.append(1, '\n');
+        for (const Process* process : m_rows)
+        {
+            appendStreamRecord(m_scratch, StreamFormat::JsonLines, timestampMs, *process);
+        }
+        m_cachedAnswer.assign(m_scratch.data(), m_scratch.size());
+        m_cachedSnapshot = snapshot;
+        m_cachedFilter = client.filter;
+        m_cachedSortBy = client.sortBy;
+        m_cachedLimit = limit;
+    }
+    client.output += m_cachedAnswer;
+}
+
+void DaemonServer::answerHistory(DaemonClient& client, int pid)
+{
+    std::vector<HistorySample> samples;
+    if (!processHistory.samples(pid, samples))
+    {
+        client.output += "ERR No history recorded for process " + std::to_string(pid) + "\n";
+        return;
+    }
+    m_scratch.clear();
+    m_scratch.append("OK ");
+    m_scratch.appendInt(static_cast<long long>(samples.size()));
+    m_scratch.append(1, '\n');
+    for (const auto& sample : samples)
+    {
+        m_scratch.append("{\"cpu\":");
+        m_scratch.appendFixed(sample.cpuUsage, 2);
+        m_scratch.append(",\"mem_mb\":");
+        m_scratch.appendFixed(sample.memoryUsage, 2);
+        m_scratch.append("}\n");
+    }
+    client.output.append(m_scratch.data(), m_scratch.size());
+}
+
+std::string defaultSocketPath()
+{
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir != nullptr && *runtimeDir != '\0')
+    {
+        return std::string(runtimeDir) + "/process_manager.sock";
+    }
+    return "/tmp/process_manager-" + std::to_string(getuid()) + ".sock";
+}
+
+int runDaemonMode(const CliOptions& options)
+{
+    std::signal(SIGINT, handleDaemonSignal);
+    std::signal(SIGTERM, handleDaemonSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::string path = options.socketPath.empty() ? defaultSocketPath() : options.socketPath;
+    DaemonServer server;
+    std::string error;
+    if (!server.start(path, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    // One sampler for every client
+    sampleIntervalMs.store(options.intervalMs);
+    std::thread sampler(monitorCpu, beginMonitoring());
+    Logger::getInstance().info("Daemon listening on {}.", path);
+    std::cout << "Listening on " << path << std::endl;
+
+    server.serve(daemonStopRequested);
+
+    monitoringActive.store(false);
+    cv.notify_all(); // Wake the sampler from its interval wait
+    sampler.join();
+    server.stop();
+    Logger::getInstance().info("Daemon stopped.");
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file frame_buffer.cpp
+ * @brief Implements the reusable frame buffer.
+ *
+ * This source file contains the implementation of the FrameBuffer class. Numbers are converted
+ * directly into the buffer with `std::to_chars`, which is locale-independent and does not
+ * allocate; the storage only grows when a frame is larger than every previous one.
+ */
+
+#include "frame_buffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+FrameBuffer::FrameBuffer(size_t capacity) : m_data(std::max<size_t>(capacity, 64)), m_size(0) {}
+
+void FrameBuffer::clear()
+{
+    m_size = 0;
+}
+
+char* FrameBuffer::reserve(size_t length)
+{
+    if (m_size + length > m_data.size())
+    {
+        m_data.resize(std::max(m_data.size() * 2, m_size + length));
+    }
+    return m_data.data() + m_size;
+}
+
+void FrameBuffer::append(const char* data, size_t length)
+{
+    std::memcpy(reserve(length), data, length);
+    m_size += length;
+}
+
+void FrameBuffer::append(const std::string& text)
+{
+    append(text.data(), text.size());
+}
+
+void FrameBuffer::append(const char* text)
+{
+    append(text, std::strlen(text));
+}
+
+void FrameBuffer::append(size_t count, char ch)
+{
+    std::memset(reserve(count), ch, count);
+    m_size += count;
+}
+
+void FrameBuffer::appendPadded(const std::string& text, size_t width)
+{
+    append(text);
+    if (text.size() < width)
+    {
+        append(width - text.size(), ' ');
+    }
+}
+
+void FrameBuffer::appendInt(long long value, size_t width)
+{
+    char* begin = reserve(std::max<size_t>(width, 24));
+    char* end = std::to_chars(begin, begin + 24, value).ptr;
+    size_t length = end - begin;
+    m_size += length;
+    if (length < width)
+    {
+        append(width - length, ' ');
+    }
+}
+
+void FrameBuffer::appendFixed(double value, int precision, size_t width)
+{
+    // Large enough for any double in fixed notation (up to 309 integer digits) plus the precision
+    const size_t maxLength = 330 + static_cast<size_t>(std::max(precision, 0));
+    char* begin = reserve(maxLength);
+    auto result = std::to_chars(begin, begin + maxLength, value, std::chars_format::fixed, precision);
+    size_t length = result.ec == std::errc() ? static_cast<size_t>(result.ptr - begin) : 0;
+    m_size += length;
+    if (length < width)
+    {
+        append(width - length, ' ');
+    }
+}
+
+const char* FrameBuffer::data() const
+{
+    return m_data.data();
+}
+
+size_t FrameBuffer::size() const
+{
+    return m_size;
+}
+
+bool FrameBuffer::writeTo(int fd) const
+{
+    size_t written = 0;
+    while (written < m_size)
+    {
+        ssize_t result = write(fd, m_data.data() + written, m_size - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
@@ -16,6 +16,13 @@
  */
 std::atomic<bool> monitoringActive(false);
 
+/**
+ * @brief Number of the current monitoring session.
+ *
+ * Initialized to `0`. Advanced by `beginMonitoring()`.
+ */
+std::atomic<unsigned> monitoringGeneration(0);
+
 /**
  * @brief Mutex to synchronize access to standard output (std::cout).
  *
@@ -89,8 +96,134 @@ std::unordered_map<int, std::string> pidToUserCache;
 std::unordered_map<int, std::string> pidToCommandCache;
 
 /**
- * @brief Frequency (in seconds) for updating resource monitoring data.
+ * @brief Interval (in milliseconds) between two scans of the processes.
+ *
+ * Initialized to `5000`. Determines how often monitoring threads update CPU and memory usage information.
+ */
+std::atomic<int> sampleIntervalMs(5000);
+
+/**
+ * @brief Interval (in milliseconds) between two redraws of the process table.
+ *
+ * Initialized to `1000`.
+ */
+std::atomic<int> displayIntervalMs(1000);
+
+/**
+ * @brief Latest published snapshot of the processes.
+ *
+ * Empty until the first sampling epoch.
+ */
+SnapshotPublisher processSnapshots;
+
+/**
+ * @brief Shared-memory export of the sampling epochs.
+ *
+ * Closed until opened by `main()`.
+ */
+ShmSnapshotWriter shmExport;
+
+/**
+ * @brief Root directory of the proc filesystem.
+ *
+ * Initialized to `/proc`. Can be overridden with the `--proc-root` command-line option.
+ */
+std::string procRoot = "/proc";
+
+/**
+ * @brief Root directory of the cgroup v2 hierarchy.
+ *
+ * Initialized to `/sys/fs/cgroup`. Can be overridden with the `--cgroup-root` command-line option.
+ */
+std::string cgroupRoot = "/sys/fs/cgroup";
+
+/**
+ * @brief Atomic flag asking the display thread to redraw immediately.
+ *
+ * Initialized to `false`.
+ */
+std::atomic<bool> displayRefreshRequested(false);
+
+/**
+ * @brief Atomic flag asking the display thread for a full repaint.
+ *
+ * Initialized to `true` so the first frame clears the screen.
+ */
+std::atomic<bool> screenRepaintRequested(true);
+
+/**
+ * @brief Atomic flag signaling a terminal resize.
+ *
+ * Initialized to `true` so the first frame queries the terminal size.
+ */
+std::atomic<bool> terminalResized(true);
+
+/**
+ * @brief Row limit of the process display.
+ *
+ * Initialized to `0` (fit the terminal).
+ */
+std::atomic<int> displayRowLimit(0);
+
+/**
+ * @brief Recorder of sampling epochs.
+ *
+ * Closed until the user issues the `record` command.
+ */
+SessionRecorder sessionRecorder;
+
+/**
+ * @brief Number of pending single-step requests for the replay thread.
+ *
+ * Initialized to `0`.
+ */
+std::atomic<int> replayStepRequests(0);
+
+/**
+ * @brief Pending replay seek target in milliseconds from the start of the recording.
+ *
+ * Initialized to `-1` (no seek pending).
+ */
+std::atomic<long long> replaySeekOffsetMs(-1);
+
+/**
+ * @brief Atomic flag indicating whether a session is being replayed.
+ *
+ * Initialized to `false`.
+ */
+std::atomic<bool> replayActive(false);
+
+/**
+ * @brief Per-process history of recent samples.
+ *
+ * Initialized with the default budget (8 MiB) and window (120 samples).
+ */
+ProcessHistory processHistory;
+
+/**
+ * @brief Process tree with subtree sums.
+ *
+ * Empty until the first sampling epoch.
+ */
+ProcessTree processTree;
+
+/**
+ * @brief Atomic flag selecting the tree display mode.
+ *
+ * Initialized to `false` (flat table).
+ */
+std::atomic<bool> treeView(false);
+
+/**
+ * @brief Policy engine.
+ *
+ * Without rules until a policy file is loaded with `--policy` or the `policy load` command.
+ */
+PolicyEngine policyEngine;
+
+/**
+ * @brief Compressed long-retention history store.
  *
- * Initialized to `5`. Determines how often monitoring threads update CPU and memory usage information.
+ * Closed until a data directory is given with `--history-dir` or the `history_store` command.
  */
-std::atomic<int> updateFrequency(5);
+HistoryStore historyStore;
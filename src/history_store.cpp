@@ -0,0 +1,929 @@
+/**
+ * @file history_store.cpp
+ * @brief Implements the compressed long-retention history store.
+ *
+ * This source file contains the Gorilla-style bit encoding of process series described in
+ * `history_store.h` and the management of the memory-mapped segment files. Blocks of the open
+ * period are encoded incrementally as epochs arrive, so closing a period only copies finished
+ * bit streams into the segment.
+ */
+
+#include "history_store.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+const char kSegmentMagic[8] = {'P', 'M', 'H', 'S', 'E', 'G', '\0', '\1'};
+const size_t kSegmentHeaderSize = 8 + 8; // magic + period start
+const uint32_t kBlockMagic = 0x42484D50; // "PMHB" in little-endian order
+const size_t kBlockFixedSize = 4 + 4 + 4 + 4 + 8 + 8; // magic + length + pid + count + first + last seen
+const size_t kMinimumMapping = 1 << 20;
+
+void putFixed(uint8_t* out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        out[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t getFixed(const uint8_t* in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+uint64_t doubleBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Appends the `count` low bits of `value` to a bit stream, most significant bit first
+void writeBits(std::vector<uint8_t>& bits, uint64_t& bitCount, uint64_t value, int count)
+{
+    while (count > 0)
+    {
+        size_t byte = bitCount >> 3;
+        int used = static_cast<int>(bitCount & 7);
+        if (byte == bits.size())
+        {
+            bits.push_back(0);
+        }
+        int free = 8 - used;
+        int take = std::min(free, count);
+        uint8_t chunk = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+        bits[byte] |= static_cast<uint8_t>(chunk << (free - take));
+        bitCount += take;
+        count -= take;
+    }
+}
+
+// Writes the XOR of a value with the previous one, reusing the previous window of meaningful bits if it fits
+void writeXor(std::vector<uint8_t>& bits, uint64_t& bitCount, uint64_t value, uint64_t& previous, uint8_t& leading,
+              uint8_t& trailing)
+{
+    uint64_t x = value ^ previous;
+    previous = value;
+    if (x == 0)
+    {
+        writeBits(bits, bitCount, 0, 1);
+        return;
+    }
+
+    int lz = std::min(__builtin_clzll(x), 31); // Five bits are available to store it
+    int tz = __builtin_ctzll(x);
+    if (leading != 0xFF && lz >= leading && tz >= trailing)
+    {
+        writeBits(bits, bitCount, 0b10, 2);
+        writeBits(bits, bitCount, x >> trailing, 64 - leading - trailing);
+        return;
+    }
+
+    int meaningful = 64 - lz - tz;
+    writeBits(bits, bitCount, 0b11, 2);
+    writeBits(bits, bitCount, lz, 5);
+    writeBits(bits, bitCount, meaningful - 1, 6);
+    writeBits(bits, bitCount, x >> tz, meaningful);
+    leading = static_cast<uint8_t>(lz);
+    trailing = static_cast<uint8_t>(tz);
+}
+
+/**
+ * @brief Bounds-checked reader of a bit stream.
+ */
+class BitReader
+{
+  public:
+    BitReader(const uint8_t* data, uint64_t bitCount) : m_data(data), m_bitCount(bitCount), m_pos(0), m_ok(true) {}
+
+    uint64_t read(int count)
+    {
+        if (m_pos + count > m_bitCount)
+        {
+            m_ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        while (count > 0)
+        {
+            int used = static_cast<int>(m_pos & 7);
+            int free = 8 - used;
+            int take = std::min(free, count);
+            uint64_t chunk = (m_data[m_pos >> 3] >> (free - take)) & ((1u << take) - 1);
+            value = (value << take) | chunk;
+            m_pos += take;
+            count -= take;
+        }
+        return value;
+    }
+
+    // Reads one XOR-encoded value, mirroring writeXor()
+    uint64_t readXor(uint64_t& previous, uint8_t& leading, uint8_t& trailing)
+    {
+        if (read(1) == 0)
+        {
+            return previous;
+        }
+        if (read(1) == 1)
+        {
+            leading = static_cast<uint8_t>(read(5));
+            int meaningful = static_cast<int>(read(6)) + 1;
+            if (leading + meaningful > 64)
+            {
+                m_ok = false; // Only a corrupted stream can describe a window wider than 64 bits
+                return previous;
+            }
+            trailing = static_cast<uint8_t>(64 - leading - meaningful);
+        }
+        int meaningful = 64 - leading - trailing;
+        previous ^= read(meaningful) << trailing;
+        return previous;
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+  private:
+    const uint8_t* m_data;
+    uint64_t m_bitCount;
+    uint64_t m_pos;
+    bool m_ok;
+};
+
+/**
+ * @brief Decodes a block bit stream, calling `visit(timestamp, cpuCenti, memoryKb)` for every sample
+ *        until it returns `false`.
+ *
+ * @return `false` if the stream is corrupted.
+ */
+template <typename Visitor>
+bool decodeSamples(const uint8_t* data, uint64_t bitCount, uint32_t count, int64_t firstTs, Visitor visit)
+{
+    BitReader reader(data, bitCount);
+    int64_t timestamp = firstTs;
+    int64_t delta = 0;
+    uint64_t cpu = 0, memory = 0;
+    uint8_t cpuLeading = 0, cpuTrailing = 0, memoryLeading = 0, memoryTrailing = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (i == 0)
+        {
+            cpu = reader.read(64);
+            memory = reader.read(64);
+        }
+        else
+        {
+            // Delta-of-delta buckets: 0, 7, 9, 12 or 32 bits
+            int64_t dod;
+            if (reader.read(1) == 0)
+                dod = 0;
+            else if (reader.read(1) == 0)
+                dod = static_cast<int64_t>(reader.read(7)) - 63;
+            else if (reader.read(1) == 0)
+                dod = static_cast<int64_t>(reader.read(9)) - 255;
+            else if (reader.read(1) == 0)
+                dod = static_cast<int64_t>(reader.read(12)) - 2047;
+            else
+                dod = static_cast<int32_t>(static_cast<uint32_t>(reader.read(32)));
+            delta += dod;
+            timestamp += delta;
+            reader.readXor(cpu, cpuLeading, cpuTrailing);
+            reader.readXor(memory, memoryLeading, memoryTrailing);
+        }
+
+        if (!reader.ok())
+        {
+            return false;
+        }
+        if (!visit(timestamp, bitsDouble(cpu), bitsDouble(memory)))
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Header fields of a block stored in a segment.
+ */
+struct BlockView
+{
+    int pid;
+    uint32_t count;
+    int64_t firstTs;
+    int64_t lastSeenTs;
+    std::string user;
+    std::string command;
+    const uint8_t* bits;
+    uint64_t bitCount;
+};
+
+// Parses the block at `offset` of a segment; returns its length, or 0 if there is no complete block
+size_t parseBlock(const uint8_t* data, size_t size, size_t offset, BlockView& view)
+{
+    if (offset + kBlockFixedSize > size || getFixed(data + offset, 4) != kBlockMagic)
+    {
+        return 0;
+    }
+    size_t length = getFixed(data + offset + 4, 4);
+    if (length < kBlockFixedSize + 6 || offset + length > size)
+    {
+        return 0;
+    }
+
+    const uint8_t* p = data + offset;
+    const uint8_t* end = p + length;
+    view.pid = static_cast<int>(getFixed(p + 8, 4));
+    view.count = static_cast<uint32_t>(getFixed(p + 12, 4));
+    view.firstTs = static_cast<int64_t>(getFixed(p + 16, 8));
+    view.lastSeenTs = static_cast<int64_t>(getFixed(p + 24, 8));
+    p += kBlockFixedSize;
+
+    for (std::string* field : {&view.user, &view.command})
+    {
+        size_t fieldLength = *p++;
+        if (p + fieldLength + 1 > end)
+        {
+            return 0;
+        }
+        field->assign(reinterpret_cast<const char*>(p), fieldLength);
+        p += fieldLength;
+    }
+
+    if (p + 4 > end)
+    {
+        return 0;
+    }
+    view.bitCount = getFixed(p, 4);
+    view.bits = p + 4;
+    if ((view.bitCount + 7) / 8 > static_cast<size_t>(end - view.bits))
+    {
+        return 0;
+    }
+    return length;
+}
+
+// Encoded size of a block
+size_t blockLength(const std::string& user, const std::string& command, uint64_t bitCount)
+{
+    return kBlockFixedSize + 1 + user.size() + 1 + command.size() + 4 + (bitCount + 7) / 8;
+}
+
+// Writes a block of `length` bytes (see blockLength()) at `p`
+void putBlock(uint8_t* p, size_t length, int pid, uint32_t count, int64_t firstTs, int64_t lastSeenTs,
+              const std::string& user, const std::string& command, const std::vector<uint8_t>& bits,
+              uint64_t bitCount)
+{
+    putFixed(p, kBlockMagic, 4);
+    putFixed(p + 4, length, 4);
+    putFixed(p + 8, static_cast<uint32_t>(pid), 4);
+    putFixed(p + 12, count, 4);
+    putFixed(p + 16, static_cast<uint64_t>(firstTs), 8);
+    putFixed(p + 24, static_cast<uint64_t>(lastSeenTs), 8);
+    p += kBlockFixedSize;
+    for (const std::string* field : {&user, &command})
+    {
+        *p++ = static_cast<uint8_t>(field->size());
+        std::memcpy(p, field->data(), field->size());
+        p += field->size();
+    }
+    putFixed(p, bitCount, 4);
+    std::memcpy(p + 4, bits.data(), (bitCount + 7) / 8);
+}
+
+int64_t nowMs()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+} // namespace
+
+HistoryStore::HistoryStore()
+    : m_open(false), m_periodStartMs(-1), m_samplesSeen(0), m_samplesWritten(0), m_epochsSinceCheckpoint(0)
+{
+}
+
+HistoryStore::~HistoryStore()
+{
+    close();
+}
+
+bool HistoryStore::open(const HistoryStoreOptions& options)
+{
+    close();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (options.directory.empty() || options.periodSeconds <= 0)
+    {
+        return false;
+    }
+    if (mkdir(options.directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        return false;
+    }
+
+    DIR* dir = opendir(options.directory.c_str());
+    if (!dir)
+    {
+        return false;
+    }
+    m_options = options;
+
+    // Index every segment file; only block headers are read
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        long long startSeconds;
+        char suffix[8];
+        if (sscanf(entry->d_name, "seg-%lld.%7s", &startSeconds, suffix) != 2 || std::strcmp(suffix, "pmh") != 0)
+        {
+            continue;
+        }
+        auto segment = std::make_unique<Segment>();
+        segment->path = options.directory + "/" + entry->d_name;
+        segment->startMs = startSeconds * 1000;
+        if (indexSegment(*segment))
+        {
+            m_segments[segment->startMs] = std::move(segment);
+        }
+    }
+    closedir(dir);
+
+    m_open = true;
+    m_periodStartMs = -1;
+    m_samplesSeen = 0;
+    m_samplesWritten = 0;
+    m_epochsSinceCheckpoint = 0;
+    applyRetentionLocked(nowMs());
+    return true;
+}
+
+void HistoryStore::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+    {
+        return;
+    }
+    flushOpenBlocksLocked();
+    for (auto& pair : m_segments)
+    {
+        closeSegment(*pair.second);
+    }
+    m_segments.clear();
+    m_open = false;
+}
+
+bool HistoryStore::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+bool HistoryStore::append(int64_t timestampMs, const std::vector<Process>& snapshot)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    int64_t periodMs = static_cast<int64_t>(m_options.periodSeconds) * 1000;
+    int64_t periodStart = timestampMs - timestampMs % periodMs;
+    if (periodStart != m_periodStartMs)
+    {
+        // The previous period is over: move its blocks to its segment and drop expired segments
+        ok = flushOpenBlocksLocked();
+        m_periodStartMs = periodStart;
+        applyRetentionLocked(timestampMs);
+    }
+
+    bool checkpointCut = false;
+    int64_t heartbeatMs = static_cast<int64_t>(m_options.heartbeatSeconds) * 1000;
+    double cpuDeadbandCenti = m_options.cpuDeadband * 100.0;
+    for (const auto& process : snapshot)
+    {
+        m_samplesSeen++;
+        double cpuCenti = std::round(process.cpuUsage * 100.0);
+        double memoryKb = std::round(process.memoryUsage * 1024.0);
+
+        auto it = m_openBlocks.find(process.pid);
+        if (it != m_openBlocks.end() && it->second.command != process.command)
+        {
+            // The PID was reused by another program: close the block of the previous one
+            ok = writeBlock(process.pid, it->second) && ok;
+            m_openBlocks.erase(it);
+            it = m_openBlocks.end();
+            checkpointCut = true;
+        }
+        if (it == m_openBlocks.end())
+        {
+            it = m_openBlocks.emplace(process.pid, OpenBlock()).first;
+            it->second.user = process.user.substr(0, 255);
+            it->second.command = process.command.substr(0, 255);
+        }
+
+        OpenBlock& block = it->second;
+        double memoryDeadbandKb = std::max<double>(m_options.memoryDeadbandKb, 1.0);
+        bool write = block.count == 0 || timestampMs - block.lastTs >= heartbeatMs ||
+                     std::fabs(cpuCenti - bitsDouble(block.cpuBits)) >= std::max(cpuDeadbandCenti, 1.0) ||
+                     std::fabs(memoryKb - bitsDouble(block.memoryBits)) >= memoryDeadbandKb;
+        if (write)
+        {
+            encodeSample(block, timestampMs, cpuCenti, memoryKb);
+            m_samplesWritten++;
+        }
+        block.lastSeenTs = timestampMs;
+    }
+
+    // Bound what a crash can lose to the epochs since the last checkpoint. A block written above
+    // cut the previous checkpoint, which is replaced right away.
+    if (m_options.checkpointEpochs > 0 && (++m_epochsSinceCheckpoint >= m_options.checkpointEpochs || checkpointCut))
+    {
+        ok = checkpointLocked() && ok;
+        m_epochsSinceCheckpoint = 0;
+    }
+    return ok;
+}
+
+void HistoryStore::encodeSample(OpenBlock& block, int64_t timestampMs, double cpuCenti, double memoryKb)
+{
+    if (block.count == 0)
+    {
+        block.firstTs = timestampMs;
+        block.cpuBits = doubleBits(cpuCenti);
+        block.memoryBits = doubleBits(memoryKb);
+        writeBits(block.bits, block.bitCount, block.cpuBits, 64);
+        writeBits(block.bits, block.bitCount, block.memoryBits, 64);
+    }
+    else
+    {
+        int64_t delta = timestampMs - block.lastTs;
+        int64_t dod = delta - block.lastDelta;
+        block.lastDelta = delta;
+        if (dod == 0)
+        {
+            writeBits(block.bits, block.bitCount, 0, 1);
+        }
+        else if (dod >= -63 && dod <= 64)
+        {
+            writeBits(block.bits, block.bitCount, 0b10, 2);
+            writeBits(block.bits, block.bitCount, dod + 63, 7);
+        }
+        else if (dod >= -255 && dod <= 256)
+        {
+            writeBits(block.bits, block.bitCount, 0b110, 3);
+            writeBits(block.bits, block.bitCount, dod + 255, 9);
+        }
+        else if (dod >= -2047 && dod <= 2048)
+        {
+            writeBits(block.bits, block.bitCount, 0b1110, 4);
+            writeBits(block.bits, block.bitCount, dod + 2047, 12);
+        }
+        else
+        {
+            writeBits(block.bits, block.bitCount, 0b1111, 4);
+            writeBits(block.bits, block.bitCount, static_cast<uint32_t>(static_cast<int32_t>(dod)), 32);
+        }
+        writeXor(block.bits, block.bitCount, doubleBits(cpuCenti), block.cpuBits, block.cpuLeading, block.cpuTrailing);
+        writeXor(block.bits, block.bitCount, doubleBits(memoryKb), block.memoryBits, block.memoryLeading,
+                 block.memoryTrailing);
+    }
+    block.lastTs = timestampMs;
+    block.count++;
+}
+
+bool HistoryStore::processesAt(int64_t timestampMs, int64_t toleranceMs, std::vector<Process>& result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    result.clear();
+    if (!m_open)
+    {
+        return false;
+    }
+
+    // Latest sample at or before the requested time for every candidate process
+    struct Candidate
+    {
+        int64_t sampleTs;
+        Process process;
+    };
+    std::unordered_map<int, Candidate> found;
+    auto consider = [&](int pid, int64_t firstTs, int64_t lastSeenTs, const std::string& user,
+                        const std::string& command, const uint8_t* bits, uint64_t bitCount, uint32_t count) {
+        if (firstTs > timestampMs || lastSeenTs + toleranceMs < timestampMs)
+        {
+            return true; // Not running at that time
+        }
+        int64_t sampleTs = -1;
+        double cpuCenti = 0.0, memoryKb = 0.0;
+        bool ok = decodeSamples(bits, bitCount, count, firstTs, [&](int64_t ts, double cpu, double memory) {
+            if (ts > timestampMs)
+                return false;
+            sampleTs = ts;
+            cpuCenti = cpu;
+            memoryKb = memory;
+            return true;
+        });
+        auto it = found.find(pid);
+        if (sampleTs >= 0 && (it == found.end() || it->second.sampleTs < sampleTs))
+        {
+            found[pid] = Candidate{sampleTs, Process{pid, user, cpuCenti / 100.0, memoryKb / 1024.0, 0, command}};
+        }
+        return ok;
+    };
+
+    // A process that started before the period of the requested time may only have samples in the previous one
+    bool ok = true;
+    int64_t periodMs = static_cast<int64_t>(m_options.periodSeconds) * 1000;
+    int64_t periodStart = timestampMs - timestampMs % periodMs;
+    for (int64_t start : {periodStart - periodMs, periodStart})
+    {
+        auto it = m_segments.find(start);
+        if (it != m_segments.end())
+        {
+            const Segment& segment = *it->second;
+            BlockView view;
+            for (const auto& info : segment.blocks)
+            {
+                if (info.firstTs > timestampMs || info.lastSeenTs + toleranceMs < timestampMs)
+                    continue; // Skip blocks from the index alone, without touching their data
+                if (parseBlock(segment.data, segment.used, info.offset, view) == 0)
+                {
+                    ok = false;
+                    continue;
+                }
+                ok = consider(view.pid, view.firstTs, view.lastSeenTs, view.user, view.command, view.bits,
+                              view.bitCount, view.count) && ok;
+            }
+        }
+        if (start == m_periodStartMs)
+        {
+            for (const auto& pair : m_openBlocks)
+            {
+                const OpenBlock& block = pair.second;
+                ok = consider(pair.first, block.firstTs, block.lastSeenTs, block.user, block.command,
+                              block.bits.data(), block.bitCount, block.count) && ok;
+            }
+        }
+    }
+
+    result.reserve(found.size());
+    for (auto& pair : found)
+    {
+        result.push_back(std::move(pair.second.process));
+    }
+    return ok;
+}
+
+bool HistoryStore::series(int pid, int64_t fromMs, int64_t toMs, std::vector<HistoryPoint>& points)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    points.clear();
+    if (!m_open)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    auto collect = [&](const uint8_t* bits, uint64_t bitCount, uint32_t count, int64_t firstTs) {
+        return decodeSamples(bits, bitCount, count, firstTs, [&](int64_t ts, double cpuCenti, double memoryKb) {
+            if (ts > toMs)
+                return false;
+            if (ts >= fromMs)
+                points.push_back({ts, cpuCenti / 100.0, memoryKb / 1024.0});
+            return true;
+        });
+    };
+
+    int64_t periodMs = static_cast<int64_t>(m_options.periodSeconds) * 1000;
+    for (auto it = m_segments.lower_bound(fromMs - periodMs); it != m_segments.end() && it->first <= toMs; ++it)
+    {
+        const Segment& segment = *it->second;
+        BlockView view;
+        for (const auto& info : segment.blocks)
+        {
+            if (info.pid != pid || info.firstTs > toMs || info.lastSeenTs < fromMs)
+                continue;
+            if (parseBlock(segment.data, segment.used, info.offset, view) == 0)
+            {
+                ok = false;
+                continue;
+            }
+            ok = collect(view.bits, view.bitCount, view.count, view.firstTs) && ok;
+        }
+    }
+
+    auto it = m_openBlocks.find(pid);
+    if (it != m_openBlocks.end() && it->second.firstTs <= toMs)
+    {
+        ok = collect(it->second.bits.data(), it->second.bitCount, it->second.count, it->second.firstTs) && ok;
+    }
+
+    std::sort(points.begin(), points.end(),
+              [](const HistoryPoint& a, const HistoryPoint& b) { return a.timestampMs < b.timestampMs; });
+    return ok;
+}
+
+size_t HistoryStore::segmentCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_segments.size();
+}
+
+uint64_t HistoryStore::bytesUsed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t bytes = 0;
+    for (const auto& pair : m_segments)
+    {
+        bytes += pair.second->used;
+    }
+    for (const auto& pair : m_openBlocks)
+    {
+        bytes += kBlockFixedSize + 6 + pair.second.user.size() + pair.second.command.size() + pair.second.bits.size();
+    }
+    return bytes;
+}
+
+uint64_t HistoryStore::samplesSeen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_samplesSeen;
+}
+
+uint64_t HistoryStore::samplesWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_samplesWritten;
+}
+
+bool HistoryStore::indexSegment(Segment& segment)
+{
+    int fd = ::open(segment.path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kSegmentHeaderSize)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    segment.data = static_cast<uint8_t*>(data);
+    segment.mapped = size;
+    segment.writable = false;
+
+    if (std::memcmp(segment.data, kSegmentMagic, sizeof(kSegmentMagic)) != 0)
+    {
+        closeSegment(segment);
+        return false;
+    }
+
+    // Walk the block headers; a zeroed or truncated block ends the segment (e.g., after a crash)
+    size_t offset = kSegmentHeaderSize;
+    BlockView view;
+    size_t length;
+    while ((length = parseBlock(segment.data, size, offset, view)) > 0)
+    {
+        segment.blocks.push_back({view.pid, view.firstTs, view.lastSeenTs, static_cast<uint32_t>(offset)});
+        offset += length;
+    }
+    segment.used = offset;
+    return true;
+}
+
+bool HistoryStore::openWritableSegment(int64_t startMs)
+{
+    auto it = m_segments.find(startMs);
+    if (it != m_segments.end() && it->second->writable)
+    {
+        return true;
+    }
+
+    std::unique_ptr<Segment> segment;
+    if (it != m_segments.end())
+    {
+        // Reopen an existing segment of this period (after a restart) and append after its last block
+        segment = std::move(it->second);
+        m_segments.erase(it);
+        size_t used = segment->used;
+        std::vector<BlockInfo> blocks = std::move(segment->blocks);
+        closeSegment(*segment);
+        segment->fd = ::open(segment->path.c_str(), O_RDWR);
+        segment->used = used;
+        segment->blocks = std::move(blocks);
+    }
+    else
+    {
+        segment = std::make_unique<Segment>();
+        segment->path = m_options.directory + "/seg-" + std::to_string(startMs / 1000) + ".pmh";
+        segment->startMs = startMs;
+        segment->fd = ::open(segment->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        segment->used = 0;
+    }
+    if (segment->fd < 0)
+    {
+        return false;
+    }
+    segment->writable = true;
+    if (!ensureCapacity(*segment, kSegmentHeaderSize))
+    {
+        closeSegment(*segment);
+        return false;
+    }
+    if (segment->used == 0)
+    {
+        std::memcpy(segment->data, kSegmentMagic, sizeof(kSegmentMagic));
+        putFixed(segment->data + 8, static_cast<uint64_t>(startMs), 8);
+        segment->used = kSegmentHeaderSize;
+    }
+    m_segments[startMs] = std::move(segment);
+    return true;
+}
+
+bool HistoryStore::ensureCapacity(Segment& segment, size_t bytes)
+{
+    if (segment.data && segment.used + bytes <= segment.mapped)
+    {
+        return true;
+    }
+
+    // Grow the file geometrically and map it again
+    size_t size = std::max({segment.mapped * 2, segment.used + bytes, kMinimumMapping});
+    if (ftruncate(segment.fd, static_cast<off_t>(size)) != 0)
+    {
+        return false;
+    }
+    if (segment.data)
+    {
+        munmap(segment.data, segment.mapped);
+        segment.data = nullptr;
+        segment.mapped = 0;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, 0);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    segment.data = static_cast<uint8_t*>(data);
+    segment.mapped = size;
+    return true;
+}
+
+bool HistoryStore::writeBlock(int pid, const OpenBlock& block)
+{
+    if (block.count == 0)
+    {
+        return true;
+    }
+    if (!openWritableSegment(m_periodStartMs))
+    {
+        return false;
+    }
+
+    Segment& segment = *m_segments[m_periodStartMs];
+    size_t length = blockLength(block.user, block.command, block.bitCount);
+    if (!ensureCapacity(segment, length + 4))
+    {
+        return false;
+    }
+
+    putBlock(segment.data + segment.used, length, pid, block.count, block.firstTs, block.lastSeenTs, block.user,
+             block.command, block.bits, block.bitCount);
+    segment.blocks.push_back({pid, block.firstTs, block.lastSeenTs, static_cast<uint32_t>(segment.used)});
+    segment.used += length;
+
+    // End the segment here: what follows is a checkpoint that this block may have cut
+    putFixed(segment.data + segment.used, 0, 4);
+    return true;
+}
+
+bool HistoryStore::checkpointLocked()
+{
+    size_t total = 4;
+    for (const auto& pair : m_openBlocks)
+    {
+        if (pair.second.count > 0)
+            total += blockLength(pair.second.user, pair.second.command, pair.second.bitCount);
+    }
+    if (total == 4)
+    {
+        return true;
+    }
+    if (!openWritableSegment(m_periodStartMs))
+    {
+        return false;
+    }
+
+    // Copy the open blocks after the complete ones without counting them as used: they read as
+    // complete blocks after a crash, and the next checkpoint or the final blocks overwrite them
+    Segment& segment = *m_segments[m_periodStartMs];
+    if (!ensureCapacity(segment, total))
+    {
+        return false;
+    }
+    size_t offset = segment.used;
+    for (const auto& pair : m_openBlocks)
+    {
+        const OpenBlock& block = pair.second;
+        if (block.count == 0)
+            continue;
+        size_t length = blockLength(block.user, block.command, block.bitCount);
+        putBlock(segment.data + offset, length, pair.first, block.count, block.firstTs, block.lastSeenTs, block.user,
+                 block.command, block.bits, block.bitCount);
+        offset += length;
+    }
+    putFixed(segment.data + offset, 0, 4); // A longer previous checkpoint must not be read past this one
+    return true;
+}
+
+bool HistoryStore::flushOpenBlocksLocked()
+{
+    bool ok = true;
+    for (const auto& pair : m_openBlocks)
+    {
+        ok = writeBlock(pair.first, pair.second) && ok;
+    }
+    m_openBlocks.clear();
+
+    // The period is complete: trim the segment and keep it mapped read-only for queries
+    auto it = m_segments.find(m_periodStartMs);
+    if (it != m_segments.end() && it->second->writable)
+    {
+        Segment& segment = *it->second;
+        size_t used = segment.used;
+        closeSegment(segment);
+        ok = indexSegment(segment) && segment.used == used && ok;
+    }
+    return ok;
+}
+
+void HistoryStore::closeSegment(Segment& segment)
+{
+    if (segment.data)
+    {
+        munmap(segment.data, segment.mapped);
+    }
+    if (segment.fd >= 0)
+    {
+        if (segment.writable && ftruncate(segment.fd, static_cast<off_t>(segment.used)) != 0)
+        {
+            // The trailing zeroes are ignored by indexSegment() anyway
+        }
+        ::close(segment.fd);
+    }
+    segment.data = nullptr;
+    segment.mapped = 0;
+    segment.fd = -1;
+    segment.writable = false;
+    segment.blocks.clear();
+}
+
+void HistoryStore::applyRetentionLocked(int64_t nowMs)
+{
+    int64_t periodMs = static_cast<int64_t>(m_options.periodSeconds) * 1000;
+    int64_t cutoff = nowMs - static_cast<int64_t>(m_options.retentionHours) * 3600 * 1000;
+    for (auto it = m_segments.begin(); it != m_segments.end() && it->first + periodMs <= cutoff;)
+    {
+        closeSegment(*it->second);
+        unlink(it->second->path.c_str());
+        it = m_segments.erase(it);
+    }
+}
@@ -0,0 +1,479 @@
+/**
+ * @file log_record.cpp
+ * @brief Implements the formatting of log messages and the binary log format.
+ *
+ * This source file is built into the Process Manager, where the logger thread formats or encodes
+ * queued messages, and into `pm_logcat`, which decodes binary logs offline.
+ */
+
+#include "log_record.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+
+const char kStartRecord = 'S';
+const char kTemplateRecord = 'T';
+const char kMessageRecord = 'M';
+
+// Longest record a reader accepts; the Logger never writes one longer than a slot plus a template
+const uint64_t kMaxRecordBytes = 1 << 20;
+
+void appendVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void appendZigzag(std::string& out, int64_t value)
+{
+    appendVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+bool readVarint(const char*& p, const char* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        auto byte = static_cast<unsigned char>(*p++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool readZigzag(const char*& p, const char* end, int64_t& value)
+{
+    uint64_t raw;
+    if (!readVarint(p, end, raw))
+        return false;
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+// Reads the next argument packed by LogArgs and appends it to `out`; returns false when the
+// arguments are exhausted (or were cut), leaving `at` unchanged. Integers are also stored in `integer`.
+bool appendArgument(std::string& out, const char* args, size_t length, size_t& at, int64_t& integer)
+{
+    if (at >= length)
+        return false;
+    const char* value = args + at + 1;
+    size_t left = length - at - 1;
+    char digits[32];
+    std::to_chars_result result{digits, std::errc()};
+    switch (args[at])
+    {
+    case LogArgs::kSigned:
+    case LogArgs::kUnsigned:
+    case LogArgs::kDouble:
+    {
+        if (left < 8)
+            return false;
+        if (args[at] == LogArgs::kSigned)
+        {
+            std::memcpy(&integer, value, sizeof(integer));
+            result = std::to_chars(digits, digits + sizeof(digits), integer);
+        }
+        else if (args[at] == LogArgs::kUnsigned)
+        {
+            uint64_t number;
+            std::memcpy(&number, value, sizeof(number));
+            integer = static_cast<int64_t>(number);
+            result = std::to_chars(digits, digits + sizeof(digits), number);
+        }
+        else
+        {
+            double number;
+            std::memcpy(&number, value, sizeof(number));
+            result = std::to_chars(digits, digits + sizeof(digits), number);
+        }
+        out.append(digits, static_cast<size_t>(result.ptr - digits));
+        at += 1 + 8;
+        return true;
+    }
+    case LogArgs::kChar:
+    case LogArgs::kBool:
+        if (left < 1)
+            return false;
+        if (args[at] == LogArgs::kChar)
+            out += *value;
+        else
+            out += *value != 0 ? "true" : "false";
+        at += 1 + 1;
+        return true;
+    case LogArgs::kString:
+    {
+        uint16_t size;
+        if (left < sizeof(size))
+            return false;
+        std::memcpy(&size, value, sizeof(size));
+        size = static_cast<uint16_t>(std::min<size_t>(size, left - sizeof(size)));
+        out.append(value + sizeof(size), size);
+        at += 1 + sizeof(size) + size;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// Appends the arguments packed by LogArgs in the compact form of binary records
+bool compactArguments(std::string& out, const char* args, size_t length)
+{
+    size_t at = 0;
+    while (at < length)
+    {
+        char tag = args[at];
+        const char* value = args + at + 1;
+        size_t left = length - at - 1;
+        out += tag;
+        if (tag == LogArgs::kSigned || tag == LogArgs::kUnsigned || tag == LogArgs::kDouble)
+        {
+            if (left < 8)
+                return false;
+            uint64_t bits;
+            std::memcpy(&bits, value, sizeof(bits));
+            if (tag == LogArgs::kSigned)
+                appendZigzag(out, static_cast<int64_t>(bits));
+            else if (tag == LogArgs::kUnsigned)
+                appendVarint(out, bits);
+            else
+                out.append(value, 8);
+            at += 1 + 8;
+        }
+        else if (tag == LogArgs::kChar || tag == LogArgs::kBool)
+        {
+            if (left < 1)
+                return false;
+            out += *value;
+            at += 1 + 1;
+        }
+        else if (tag == LogArgs::kString)
+        {
+            uint16_t size;
+            if (left < sizeof(size))
+                return false;
+            std::memcpy(&size, value, sizeof(size));
+            size = static_cast<uint16_t>(std::min<size_t>(size, left - sizeof(size)));
+            appendVarint(out, size);
+            out.append(value + sizeof(size), size);
+            at += 1 + sizeof(size) + size;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Converts compact arguments back to the LogArgs layout
+bool expandArguments(std::string& out, const char* p, const char* end)
+{
+    while (p < end)
+    {
+        char tag = *p++;
+        out += tag;
+        if (tag == LogArgs::kSigned || tag == LogArgs::kUnsigned)
+        {
+            uint64_t bits;
+            if (!readVarint(p, end, bits))
+                return false;
+            if (tag == LogArgs::kSigned)
+                bits = (bits >> 1) ^ (~(bits & 1) + 1);
+            out.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+        else if (tag == LogArgs::kDouble)
+        {
+            if (end - p < 8)
+                return false;
+            out.append(p, 8);
+            p += 8;
+        }
+        else if (tag == LogArgs::kChar || tag == LogArgs::kBool)
+        {
+            if (p >= end)
+                return false;
+            out += *p++;
+        }
+        else if (tag == LogArgs::kString)
+        {
+            uint64_t size;
+            if (!readVarint(p, end, size) || size > static_cast<uint64_t>(end - p) || size > UINT16_MAX)
+                return false;
+            auto length = static_cast<uint16_t>(size);
+            out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.append(p, length);
+            p += length;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const char* logLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::INFO:
+        return "INFO";
+    case LogLevel::WARNING:
+        return "WARNING";
+    case LogLevel::ERROR:
+        return "ERROR";
+    case LogLevel::CRITICAL:
+        return "CRITICAL";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& level)
+{
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    for (LogLevel candidate : {LogLevel::INFO, LogLevel::WARNING, LogLevel::ERROR, LogLevel::CRITICAL})
+    {
+        if (upper == logLevelName(candidate))
+        {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void appendFormatted(std::string& out, const char* format, const char* args, size_t length, int64_t* pid)
+{
+    if (pid != nullptr)
+        *pid = -1;
+    size_t at = 0;
+    for (const char* p = format; *p != '\0';)
+    {
+        const char* open = std::strchr(p, '{');
+        if (open == nullptr)
+        {
+            out.append(p);
+            break;
+        }
+        size_t placeholder = 0;
+        if (open[1] == '}')
+            placeholder = 2;
+        else if (std::strncmp(open, "{pid}", 5) == 0)
+            placeholder = 5;
+        out.append(p, static_cast<size_t>(open - p) + (placeholder == 0 ? 1 : 0));
+        p = open + (placeholder == 0 ? 1 : placeholder);
+        if (placeholder == 0)
+            continue; // A brace that is not a placeholder
+
+        int64_t integer = -1;
+        size_t before = at;
+        if (!appendArgument(out, args, length, at, integer))
+            out.append(open, placeholder); // No argument left for this placeholder
+        else if (placeholder == 5 && pid != nullptr && *pid < 0 &&
+                 (args[before] == LogArgs::kSigned || args[before] == LogArgs::kUnsigned))
+            *pid = integer;
+    }
+}
+
+BinaryLogEncoder::BinaryLogEncoder() : m_lastTime(0)
+{
+}
+
+void BinaryLogEncoder::begin(std::string& out, int64_t time)
+{
+    m_templateIds.clear();
+    m_lastTime = time;
+    m_record.assign(1, kStartRecord);
+    m_record.append(reinterpret_cast<const char*>(&time), sizeof(time));
+    appendVarint(out, m_record.size());
+    out += m_record;
+}
+
+void BinaryLogEncoder::append(std::string& out, int64_t time, LogLevel level, const char* format, const char* text,
+                              size_t length)
+{
+    uint32_t id = 0;
+    if (format != nullptr)
+    {
+        auto inserted = m_templateIds.emplace(format, static_cast<uint32_t>(m_templateIds.size() + 1));
+        id = inserted.first->second;
+        if (inserted.second)
+        {
+            m_record.assign(1, kTemplateRecord);
+            appendVarint(m_record, id);
+            m_record.append(format);
+            appendVarint(out, m_record.size());
+            out += m_record;
+        }
+    }
+
+    m_record.assign(1, kMessageRecord);
+    m_record += static_cast<char>(level);
+    appendZigzag(m_record, time - m_lastTime);
+    m_lastTime = time;
+    appendVarint(m_record, id);
+    if (id == 0)
+        m_record.append(text, length);
+    else
+        compactArguments(m_record, text, length); // Arguments cut by LogArgs end the record early
+    appendVarint(out, m_record.size());
+    out += m_record;
+}
+
+BinaryLogReader::BinaryLogReader() : m_file(nullptr), m_lastTime(0), m_damaged(false)
+{
+}
+
+BinaryLogReader::~BinaryLogReader()
+{
+    if (m_file != nullptr)
+        gzclose(m_file);
+}
+
+bool BinaryLogReader::open(const std::string& path, std::string& error)
+{
+    if (m_file != nullptr)
+        gzclose(m_file);
+    m_file = gzopen(path.c_str(), "rb"); // Reads uncompressed files as they are
+    if (m_file == nullptr)
+    {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    gzbuffer(m_file, 128 * 1024);
+    char magic[kBinaryLogMagicBytes];
+    if (gzread(m_file, magic, sizeof(magic)) != static_cast<int>(sizeof(magic)) ||
+        std::memcmp(magic, kBinaryLogMagic, sizeof(magic)) != 0)
+    {
+        error = path + " is not a binary log";
+        gzclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+    m_templates.clear();
+    m_lastTime = 0;
+    m_damaged = false;
+    return true;
+}
+
+bool BinaryLogReader::next(LogEntry& entry)
+{
+    while (m_file != nullptr && !m_damaged)
+    {
+        // Length of the record, one varint byte at a time
+        uint64_t size = 0;
+        int shift = 0;
+        int byte = gzgetc(m_file);
+        if (byte < 0)
+            return false; // End of the log
+        for (;; byte = gzgetc(m_file), shift += 7)
+        {
+            if (byte < 0 || shift >= 64)
+            {
+                m_damaged = true;
+                return false;
+            }
+            size |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        if (size == 0 || size > kMaxRecordBytes)
+        {
+            m_damaged = true;
+            return false;
+        }
+        m_record.resize(size);
+        if (gzread(m_file, &m_record[0], static_cast<unsigned>(size)) != static_cast<int>(size))
+        {
+            m_damaged = true; // Cut short, e.g. by a crash while writing
+            return false;
+        }
+
+        const char* p = m_record.data() + 1;
+        const char* end = m_record.data() + m_record.size();
+        switch (m_record[0])
+        {
+        case kStartRecord:
+            if (end - p < 8)
+            {
+                m_damaged = true;
+                return false;
+            }
+            std::memcpy(&m_lastTime, p, sizeof(m_lastTime));
+            m_templates.clear();
+            break;
+        case kTemplateRecord:
+        {
+            uint64_t id;
+            if (!readVarint(p, end, id))
+            {
+                m_damaged = true;
+                return false;
+            }
+            m_templates[static_cast<uint32_t>(id)].assign(p, end);
+            break;
+        }
+        case kMessageRecord:
+            if (!decodeMessage(m_record, entry))
+            {
+                m_damaged = true;
+                return false;
+            }
+            return true;
+        default:
+            break; // Unknown record type, skipped
+        }
+    }
+    return false;
+}
+
+bool BinaryLogReader::decodeMessage(const std::string& record, LogEntry& entry)
+{
+    const char* p = record.data() + 1;
+    const char* end = record.data() + record.size();
+    if (p >= end)
+        return false;
+    entry.level = static_cast<LogLevel>(*p++);
+    int64_t delta;
+    uint64_t id;
+    if (!readZigzag(p, end, delta) || !readVarint(p, end, id))
+        return false;
+    m_lastTime += delta;
+    entry.time = m_lastTime;
+    entry.message.clear();
+    entry.pid = -1;
+    if (id == 0)
+    {
+        entry.message.assign(p, end);
+        return true;
+    }
+    auto format = m_templates.find(static_cast<uint32_t>(id));
+    if (format == m_templates.end())
+        return false;
+    m_args.clear();
+    if (!expandArguments(m_args, p, end))
+        return false;
+    appendFormatted(entry.message, format->second.c_str(), m_args.data(), m_args.size(), &entry.pid);
+    return true;
+}
+
+bool BinaryLogReader::damaged() const
+{
+    return m_damaged;
+}
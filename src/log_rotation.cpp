@@ -0,0 +1,229 @@
+/**
+ * @file log_rotation.cpp
+ * @brief Implements the archiving of rotated log files.
+ *
+ * Compression uses zlib's gzip streams, so rotated files can be read with `zcat` (text logs) or
+ * `pm_logcat` (binary logs) without being decompressed first.
+ */
+
+#include "log_rotation.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace
+{
+
+// Bytes read from the rotated file per gzwrite()
+const size_t kCompressChunkBytes = 64 * 1024;
+
+// Splits a path into its directory (or ".") and file name
+void splitPath(const std::string& path, std::string& directory, std::string& name)
+{
+    size_t slash = path.rfind('/');
+    directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    name = slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Parses "<YYYYmmdd-HHMMSS>[.<n>][.gz]", the part of a rotated name after "<log name>."
+bool parseRotatedSuffix(const char* suffix, std::string& stamp, long& sequence)
+{
+    if (std::strlen(suffix) < 15)
+        return false;
+    for (int i = 0; i < 15; ++i)
+    {
+        if (i == 8 ? suffix[i] != '-' : !std::isdigit(static_cast<unsigned char>(suffix[i])))
+            return false;
+    }
+    stamp.assign(suffix, 15);
+    const char* rest = suffix + 15;
+    sequence = 0;
+    if (*rest == '.' && std::isdigit(static_cast<unsigned char>(rest[1])))
+    {
+        char* end = nullptr;
+        sequence = std::strtol(rest + 1, &end, 10);
+        rest = end;
+    }
+    return *rest == '\0' || std::strcmp(rest, ".gz") == 0;
+}
+
+bool fileExists(const std::string& path)
+{
+    struct stat status;
+    return stat(path.c_str(), &status) == 0;
+}
+
+} // namespace
+
+std::string rotatedLogName(const std::string& path, std::time_t time)
+{
+    std::tm tm;
+    localtime_r(&time, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+    std::string base = path + "." + stamp;
+    std::string name = base;
+    for (int sequence = 1; fileExists(name) || fileExists(name + ".gz"); ++sequence)
+    {
+        name = base + "." + std::to_string(sequence);
+    }
+    return name;
+}
+
+std::vector<std::string> listRotatedLogs(const std::string& path)
+{
+    std::string directory, name;
+    splitPath(path, directory, name);
+    std::vector<std::tuple<std::string, long, std::string>> found; // Stamp, sequence, path
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+    {
+        return {};
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        std::string stamp;
+        long sequence;
+        if (std::strncmp(entry->d_name, name.c_str(), name.size()) == 0 && entry->d_name[name.size()] == '.' &&
+            parseRotatedSuffix(entry->d_name + name.size() + 1, stamp, sequence))
+        {
+            found.emplace_back(stamp, sequence, (directory == "." ? "" : directory + "/") + entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> paths;
+    paths.reserve(found.size());
+    for (auto& file : found)
+    {
+        paths.push_back(std::move(std::get<2>(file)));
+    }
+    return paths;
+}
+
+bool compressLogFile(const std::string& path, std::string& error)
+{
+    int input = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (input < 0)
+    {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::string target = path + ".gz";
+    std::string temporary = target + ".tmp";
+    gzFile output = gzopen(temporary.c_str(), "wb6");
+    if (output == nullptr)
+    {
+        error = "Cannot create " + temporary;
+        close(input);
+        return false;
+    }
+
+    std::vector<char> chunk(kCompressChunkBytes);
+    bool ok = true;
+    for (;;)
+    {
+        ssize_t bytes = read(input, chunk.data(), chunk.size());
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+        {
+            ok = bytes == 0;
+            break;
+        }
+        if (gzwrite(output, chunk.data(), static_cast<unsigned>(bytes)) != static_cast<int>(bytes))
+        {
+            ok = false;
+            break;
+        }
+    }
+    close(input);
+    ok = gzclose(output) == Z_OK && ok;
+    if (!ok || std::rename(temporary.c_str(), target.c_str()) != 0)
+    {
+        error = "Failed to compress " + path;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::remove(path.c_str());
+    return true;
+}
+
+void pruneRotatedLogs(const std::string& path, size_t keep)
+{
+    std::vector<std::string> rotated = listRotatedLogs(path);
+    for (size_t i = 0; i + keep < rotated.size(); ++i)
+    {
+        std::remove(rotated[i].c_str());
+    }
+}
+
+LogArchiver::LogArchiver() : m_stopping(false)
+{
+}
+
+LogArchiver::~LogArchiver()
+{
+    finish();
+}
+
+void LogArchiver::submit(const std::string& logPath, const std::string& rotatedPath, const LogRotationPolicy& policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{logPath, rotatedPath, policy});
+        m_stopping = false;
+    }
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&LogArchiver::run, this);
+    }
+    m_cv.notify_one();
+}
+
+void LogArchiver::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+// Archives queued files one at a time until finish() is called and the queue is empty.
+void LogArchiver::run()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return; // Stopping, and everything is archived
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        std::string error;
+        if (job.policy.compress && !compressLogFile(job.rotatedPath, error))
+        {
+            Logger::getInstance().error("Log rotation: {}", error);
+        }
+        pruneRotatedLogs(job.logPath, job.policy.keep);
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file log_site.cpp
+ * @brief Implements the rate limit and failure counters of logging call sites.
+ *
+ * The token bucket is kept as the generic cell rate algorithm: a single "theoretical arrival time"
+ * moved forward by one interval per message, so a message costs one clock read and one
+ * compare-and-swap, and refusing one costs no write to the bucket.
+ */
+
+#include "log_site.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+// Registered sites. Never destroyed, so that static sites can unregister at exit in any order
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<LogSite*> sites;
+};
+
+Registry& registry()
+{
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+int64_t steadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+LogSite::LogSite(const char* description, double ratePerSecond, int burst)
+    : m_description(description), m_intervalNs(static_cast<int64_t>(1e9 / std::max(ratePerSecond, 1e-3))),
+      m_burstNs(m_intervalNs * (std::max(burst, 1) - 1)), m_theoreticalTime(0), m_suppressed(0)
+{
+    for (auto& failures : m_failures)
+    {
+        failures.store(0, std::memory_order_relaxed);
+    }
+    Registry& sites = registry();
+    std::lock_guard<std::mutex> lock(sites.mutex);
+    sites.sites.push_back(this);
+}
+
+LogSite::~LogSite()
+{
+    Registry& sites = registry();
+    std::lock_guard<std::mutex> lock(sites.mutex);
+    sites.sites.erase(std::find(sites.sites.begin(), sites.sites.end(), this));
+}
+
+bool LogSite::allow()
+{
+    int64_t now = steadyNowNs();
+    int64_t theoretical = m_theoreticalTime.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        int64_t start = std::max(theoretical, now);
+        if (start - now > m_burstNs)
+        {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (m_theoreticalTime.compare_exchange_weak(theoretical, start + m_intervalNs, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+}
+
+void LogSite::count(int error)
+{
+    size_t index = kCounters - 1;
+    for (size_t i = 0; i + 1 < kCounters; ++i)
+    {
+        if (kTrackedErrors[i] == error)
+        {
+            index = i;
+            break;
+        }
+    }
+    m_failures[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* LogSite::description() const
+{
+    return m_description;
+}
+
+uint64_t LogSite::takeFailures(size_t index)
+{
+    return m_failures[index].exchange(0, std::memory_order_relaxed);
+}
+
+uint64_t LogSite::takeSuppressed()
+{
+    return m_suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+void LogSite::forEach(const std::function<void(LogSite&)>& visit)
+{
+    Registry& sites = registry();
+    std::lock_guard<std::mutex> lock(sites.mutex);
+    for (LogSite* site : sites.sites)
+    {
+        visit(*site);
+    }
+}
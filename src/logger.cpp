@@ -4,15 +4,76 @@
  *
  * This source file contains the implementation of the Logger class, which follows the singleton
  * design pattern to manage log messages with different severity levels. It supports asynchronous
- * logging to a specified file by utilizing a dedicated logging thread and a message queue.
- * The Logger ensures thread-safe operations, allowing multiple threads to enqueue log messages
- * without data races or inconsistencies.
+ * logging to a specified file by utilizing a dedicated logging thread and a lock-free message
+ * ring. The Logger ensures thread-safe operations, allowing multiple threads to enqueue log
+ * messages without data races, inconsistencies or a shared lock.
  */
 
 #include "logger.h"
+#include "log_record.h"
+#include "log_rotation.h"
+#include "log_site.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Collected bytes that are written whatever the policy, to bound the memory of the logging thread
+const size_t kMaxBatchBytes = 4 * 1024 * 1024;
+
+} // namespace
+
+// Creates the slots, each ready for the ticket of its index.
+LogRing::LogRing() : m_slots(new Slot[kCapacity]), m_enqueuePosition(0), m_dequeuePosition(0)
+{
+    for (size_t i = 0; i < kCapacity; ++i)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+// Claims the next ticket whose slot is free, copies the message into it and publishes it.
+bool LogRing::tryPush(LogLevel level, std::time_t time, const char* format, const char* text, size_t length,
+                      size_t& pending)
+{
+    uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;)
+    {
+        slot = &m_slots[position & (kCapacity - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t difference = static_cast<int64_t>(sequence - position);
+        if (difference == 0)
+        {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            return false; // The slot still holds the message of the previous lap
+        }
+        else
+        {
+            position = m_enqueuePosition.load(std::memory_order_relaxed); // Taken by another producer
+        }
+    }
+
+    slot->time = time;
+    slot->format = format;
+    slot->level = level;
+    slot->length = static_cast<uint32_t>(std::min(length, kTextBytes));
+    std::memcpy(slot->text, text, slot->length);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    pending = static_cast<size_t>(position + 1 - m_dequeuePosition.load(std::memory_order_relaxed));
+    return true;
+}
 
 // Retrieves the singleton instance of the Logger.
 // Ensures that only one instance of Logger exists throughout the application.
@@ -23,7 +84,12 @@ Logger& Logger::getInstance()
 }
 
 // Constructor initializes the Logger as inactive.
-Logger::Logger() : m_active(false)
+Logger::Logger()
+    : m_fd(-1), m_format(LogFormat::Text), m_fileBytes(0), m_emptyBytes(0), m_openedAt(0), m_rotationFailed(false),
+      m_archiver(new LogArchiver()), m_encoder(new BinaryLogEncoder()), m_active(false), m_wakeRequested(false),
+      m_wakeBatch(m_policy.maxMessages), m_flushOnCritical(m_policy.flushOnCritical), m_messagesWritten(0),
+      m_writeCalls(0), m_syncCalls(0), m_rotations(0), m_minLevel(LogLevel::INFO), m_cachedSecond(-1), m_cachedDate{},
+      m_cachedDateLength(0)
 {
 }
 
@@ -34,8 +100,9 @@ Logger::~Logger()
 }
 
 // Starts the Logger by opening the specified log file and launching the logging thread.
-// Returns false if the Logger is already active or if the log file cannot be opened.
-bool Logger::start(const std::string& filename)
+// Returns false if the Logger is already active, if the log file cannot be opened or if it holds
+// messages in the other format.
+bool Logger::start(const std::string& filename, LogFormat format)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_active.load())
@@ -43,12 +110,23 @@ bool Logger::start(const std::string& filename)
         return false; // Already active
     }
 
-    m_logFile.open(filename, std::ios::out | std::ios::app);
-    if (!m_logFile.is_open())
+    m_path = filename;
+    m_format = format;
+    m_rotationFailed = false;
+    if (!openFile())
     {
         return false;
     }
 
+    // Failures counted while nothing was logged do not belong to the first summary interval
+    LogSite::forEach([](LogSite& site) {
+        for (size_t i = 0; i < LogSite::kCounters; ++i)
+        {
+            site.takeFailures(i);
+        }
+        site.takeSuppressed();
+    });
+
     m_active.store(true);
     m_logThread = std::thread(&Logger::processQueue, this); // Launch logging thread
     return true;
@@ -63,28 +141,122 @@ void Logger::stop()
             return;
         m_active.store(false); // Signal logging thread to stop
     }
-    m_cv.notify_all(); // Wake up the logging thread if it's waiting
+    wakeLoggerThread(); // Wake up the logging thread if it's waiting
     if (m_logThread.joinable())
     {
         m_logThread.join(); // Wait for the logging thread to finish
     }
-    if (m_logFile.is_open())
+    if (m_fd >= 0)
+    {
+        close(m_fd); // Close the log file
+        m_fd = -1;
+    }
+    m_archiver->finish(); // Wait for the rotated files to be compressed
+}
+
+// Opens the log file for appending; a new binary log starts with its magic, and every binary
+// session with a start record.
+bool Logger::openFile()
+{
+    m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+    {
+        return false;
+    }
+    char magic[kBinaryLogMagicBytes];
+    ssize_t existing = pread(m_fd, magic, sizeof(magic), 0);
+    bool binaryFile = existing == static_cast<ssize_t>(sizeof(magic)) &&
+                      std::memcmp(magic, kBinaryLogMagic, sizeof(magic)) == 0;
+    if (existing > 0 && binaryFile != (m_format == LogFormat::Binary))
+    {
+        close(m_fd); // Appending would mix text lines and binary records
+        m_fd = -1;
+        return false;
+    }
+
+    struct stat status;
+    m_fileBytes = fstat(m_fd, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+    m_openedAt = std::time(nullptr);
+    if (m_format == LogFormat::Binary)
     {
-        m_logFile.close(); // Close the log file
+        std::string header = existing <= 0 ? std::string(kBinaryLogMagic, kBinaryLogMagicBytes) : std::string();
+        m_encoder->begin(header, static_cast<int64_t>(m_openedAt));
+        writeBatch(header);
+    }
+    m_emptyBytes = existing > 0 ? 0 : m_fileBytes; // A file with earlier messages can be rotated at once
+    return true;
+}
+
+// The file is rotated when it has messages and the next one would reach the size limit or
+// belongs to a later period.
+bool Logger::rotationDue(const LogRotationPolicy& rotation, size_t pendingBytes, std::time_t time) const
+{
+    uint64_t bytes = m_fileBytes + pendingBytes;
+    if (m_rotationFailed || bytes <= m_emptyBytes)
+    {
+        return false;
+    }
+    if (rotation.maxBytes > 0 && bytes >= rotation.maxBytes)
+    {
+        return true;
+    }
+    return rotation.intervalSeconds > 0 && time / rotation.intervalSeconds > m_openedAt / rotation.intervalSeconds;
+}
+
+// Moves the log file aside and continues in a new one; the archiver compresses the old one.
+void Logger::rotateFile(const LogRotationPolicy& rotation)
+{
+    std::string rotated = rotatedLogName(m_path, std::time(nullptr));
+    close(m_fd);
+    m_fd = -1;
+    if (std::rename(m_path.c_str(), rotated.c_str()) != 0)
+    {
+        m_rotationFailed = true; // Keep appending to the same file rather than retrying per message
+    }
+    if (!openFile())
+    {
+        return; // Nowhere to write: messages are lost until the Logger is restarted
+    }
+    if (!m_rotationFailed)
+    {
+        m_rotations++;
+        m_archiver->submit(m_path, rotated, rotation);
     }
 }
 
 // Enqueues a log message with the specified log level.
-// If logging is not active, the message is discarded.
+// If logging is not active or the level is filtered out, the message is discarded.
 void Logger::log(LogLevel level, const std::string& message)
 {
-    if (!m_active.load())
-        return; // Logging not active
+    if (!shouldLog(level))
+        return;
+    push(level, nullptr, message.data(), message.size());
+}
+
+// Queues a message with its raw timestamp; formatting is left to the logging thread.
+void Logger::push(LogLevel level, const char* format, const char* text, size_t length)
+{
+    std::time_t now = std::time(nullptr);
+    size_t pending = 0;
+    bool woken = false;
+    while (!m_ring.tryPush(level, now, format, text, length, pending))
     {
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-        m_queue.push(formatLogMessage(level, message)); // Add formatted message to the queue
+        // Full: let the logging thread free slots rather than losing the message
+        if (!m_active.load())
+            return;
+        if (!woken)
+        {
+            wakeLoggerThread();
+            woken = true;
+        }
+        std::this_thread::yield();
+    }
+    // Only the message completing a batch, or a critical one, wakes the logging thread
+    if (pending == m_wakeBatch.load(std::memory_order_relaxed) ||
+        (level == LogLevel::CRITICAL && m_flushOnCritical.load(std::memory_order_relaxed)))
+    {
+        wakeLoggerThread();
     }
-    m_cv.notify_all(); // Notify the logging thread that a new message is available
 }
 
 // Convenience method to log an informational message.
@@ -111,62 +283,259 @@ void Logger::critical(const std::string& message)
     log(LogLevel::CRITICAL, message);
 }
 
-// Dedicated thread function that processes log messages from the queue.
-// Continues running until the Logger is stopped and the queue is empty.
+// Sets the lowest severity that is queued.
+void Logger::setMinLevel(LogLevel level)
+{
+    m_minLevel.store(level);
+}
+
+// Returns the lowest severity that is queued.
+LogLevel Logger::minLevel() const
+{
+    return m_minLevel.load();
+}
+
+// Replaces the flush policy; the logging thread picks it up at its next wakeup.
+void Logger::setFlushPolicy(const LogFlushPolicy& policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_policy = policy;
+        m_policy.maxMessages = std::max<size_t>(policy.maxMessages, 1);
+        m_policy.maxDelayMs = std::max(policy.maxDelayMs, 1);
+        m_wakeBatch.store(m_policy.maxMessages);
+        m_flushOnCritical.store(m_policy.flushOnCritical);
+    }
+    wakeLoggerThread(); // Messages held back by the previous policy may now be due
+}
+
+// Replaces the rotation policy; the logging thread picks it up at its next wakeup.
+void Logger::setRotationPolicy(const LogRotationPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_rotation = policy;
+}
+
+// Returns a copy of the rotation policy.
+LogRotationPolicy Logger::rotationPolicy()
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    return m_rotation;
+}
+
+// Returns a copy of the flush policy.
+LogFlushPolicy Logger::flushPolicy()
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    return m_policy;
+}
+
+// Returns the counters maintained by the logging thread.
+LogStats Logger::stats() const
+{
+    LogStats stats;
+    stats.messages = m_messagesWritten.load();
+    stats.writeCalls = m_writeCalls.load();
+    stats.syncCalls = m_syncCalls.load();
+    stats.rotations = m_rotations.load();
+    return stats;
+}
+
+// Wakes the logging thread; called once per batch, for critical messages, when stopping, when the
+// policy changes or when the ring is full.
+void Logger::wakeLoggerThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_cv.notify_one();
+}
+
+// Dedicated thread function that processes log messages from the ring.
+// Collects formatted messages and writes them following the flush policy, until the Logger is
+// stopped and the ring is empty.
 void Logger::processQueue()
 {
-    while (true)
+    using Clock = std::chrono::steady_clock;
+    std::string batch;
+    batch.reserve(LogRing::kCapacity * 64);
+    size_t batchMessages = 0;
+    Clock::time_point oldest;     // When the first message of `batch` was collected
+    Clock::time_point lastSync = Clock::now();
+    bool unsynced = false;        // Messages were written since the last fdatasync()
+    Clock::time_point lastSummary = Clock::now();
+
+    // Writes the collected messages
+    auto writeCollected = [&]() {
+        writeBatch(batch);
+        m_messagesWritten += batchMessages;
+        batchMessages = 0;
+        unsynced = true;
+    };
+    // Makes the written messages durable
+    auto sync = [&](Clock::time_point now) {
+        fdatasync(m_fd);
+        m_syncCalls++;
+        lastSync = now;
+        unsynced = false;
+    };
+
+    for (;;)
     {
-        std::string logMsg;
+        LogFlushPolicy policy;
+        LogRotationPolicy rotation;
         {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            // Wait until there is a message to process or the Logger is stopped
-            m_cv.wait(lock, [this]() { return !m_active.load() || !m_queue.empty(); });
-            if (!m_active.load() && m_queue.empty())
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            // Sleep until woken, or until the collected messages or the sync are due
+            auto deadline = Clock::now() + std::chrono::milliseconds(m_policy.maxDelayMs);
+            if (batchMessages > 0)
+                deadline = std::min(deadline, oldest + std::chrono::milliseconds(m_policy.maxDelayMs));
+            if (unsynced && m_policy.syncIntervalMs > 0)
+                deadline = std::min(deadline, lastSync + std::chrono::milliseconds(m_policy.syncIntervalMs));
+            if (m_policy.summaryIntervalMs > 0)
+                deadline = std::min(deadline, lastSummary + std::chrono::milliseconds(m_policy.summaryIntervalMs));
+            m_cv.wait_until(lock, deadline, [this]() { return m_wakeRequested || !m_active.load(); });
+            m_wakeRequested = false;
+            policy = m_policy;
+            rotation = m_rotation;
+        }
+        bool stopping = !m_active.load();
+        bool rotates = rotation.maxBytes > 0 || rotation.intervalSeconds > 0;
+
+        // Collect everything queued, writing whenever the policy says so
+        bool critical = false;
+        auto collect = [&](const LogRing::Slot& slot) {
+            if (rotates && rotationDue(rotation, batch.size(), slot.time))
+            {
+                // Everything before this message goes to the old file, everything after to the new one
+                if (batchMessages > 0)
+                    writeCollected();
+                if (unsynced && policy.syncIntervalMs > 0)
+                    sync(Clock::now());
+                rotateFile(rotation);
+            }
+            if (batchMessages++ == 0)
+                oldest = Clock::now();
+            critical = critical || slot.level == LogLevel::CRITICAL;
+            if (m_format == LogFormat::Binary)
+                m_encoder->append(batch, slot.time, slot.level, slot.format, slot.text, slot.length);
+            else
+                formatLogMessage(batch, slot);
+        };
+        size_t consumed;
+        do
+        {
+            consumed = m_ring.drain(collect);
+            if (batchMessages >= policy.maxMessages || (critical && policy.flushOnCritical) ||
+                batch.size() >= kMaxBatchBytes)
             {
-                break; // Exit the loop if Logger is inactive and no messages are left
+                writeCollected();
+                critical = false;
             }
+        } while (consumed >= LogRing::kCapacity);
 
-            logMsg = m_queue.front(); // Retrieve the next message
-            m_queue.pop();            // Remove it from the queue
+        Clock::time_point now = Clock::now();
+        if (policy.summaryIntervalMs > 0 &&
+            (stopping || now - lastSummary >= std::chrono::milliseconds(policy.summaryIntervalMs)))
+        {
+            collectSiteSummaries(now - lastSummary, collect);
+            lastSummary = now;
+        }
+        if (batchMessages > 0 && (stopping || now - oldest >= std::chrono::milliseconds(policy.maxDelayMs)))
+        {
+            writeCollected();
+        }
+        if (unsynced && policy.syncIntervalMs > 0 &&
+            (stopping || now - lastSync >= std::chrono::milliseconds(policy.syncIntervalMs)))
+        {
+            sync(now);
         }
 
-        // Write the log message to the file
-        m_logFile << logMsg << "\n";
-        m_logFile.flush(); // Ensure the message is written to the file immediately
+        if (stopping)
+        {
+            break; // The ring was drained after the stop request
+        }
     }
 }
 
-// Formats a log message by adding a timestamp and converting the log level to a string.
-// The formatted message includes the date, time, log level, and the actual message.
-std::string Logger::formatLogMessage(LogLevel level, const std::string& message)
+// Hands one message per call site and counter that is not zero to `collect`, as if it had been
+// queued: the expected failures counted by the site, and the messages its rate limit refused.
+template <typename Collect>
+void Logger::collectSiteSummaries(std::chrono::steady_clock::duration elapsed, Collect& collect)
 {
-    auto now = std::time(nullptr);
-    std::tm tm_buf;
-    localtime_r(&now, &tm_buf); // Convert time to local time structure
+    auto seconds = std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::seconds>(elapsed).count());
+    LogRing::Slot summary;
+    summary.time = std::time(nullptr);
+    auto emit = [&](LogLevel level, const char* format, const LogArgs& args) {
+        summary.level = level;
+        summary.format = format;
+        summary.length = static_cast<uint32_t>(args.size());
+        std::memcpy(summary.text, args.data(), args.size());
+        collect(static_cast<const LogRing::Slot&>(summary));
+    };
+    LogSite::forEach([&](LogSite& site) {
+        for (size_t i = 0; i < LogSite::kCounters; ++i)
+        {
+            uint64_t failures = site.takeFailures(i);
+            if (failures == 0)
+                continue;
+            LogArgs args;
+            args.add(failures);
+            args.add(site.description());
+            args.add(LogSite::kCounterNames[i]);
+            args.add(seconds);
+            emit(LogLevel::INFO, "{} {} failed with {} in the last {} s", args);
+        }
+        uint64_t suppressed = site.takeSuppressed();
+        if (suppressed > 0)
+        {
+            LogArgs args;
+            args.add(suppressed);
+            args.add(site.description());
+            args.add(seconds);
+            emit(LogLevel::WARNING, "{} messages about {} suppressed in the last {} s", args);
+        }
+    });
+}
 
-    std::ostringstream oss;
-    oss << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S") // Format: YYYY-MM-DD HH:MM:SS
-        << " [" << logLevelToString(level) << "] "     // Add log level in brackets
-        << message;                                    // Append the actual log message
-    return oss.str();
+// Writes the collected messages with as few write() calls as the kernel allows.
+void Logger::writeBatch(std::string& buffer)
+{
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+        ssize_t result = write(m_fd, buffer.data() + written, buffer.size() - written);
+        m_writeCalls++;
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break; // Nowhere to report the failure: the messages are lost
+        }
+        written += static_cast<size_t>(result);
+    }
+    m_fileBytes += written;
+    buffer.clear();
 }
 
-// Converts a LogLevel enum value to its corresponding string representation.
-// This is used to prefix log messages with their severity level.
-std::string Logger::logLevelToString(LogLevel level)
+// Appends a log line: the date, time, log level, and the actual message.
+void Logger::formatLogMessage(std::string& out, const LogRing::Slot& slot)
 {
-    switch (level)
+    if (slot.time != m_cachedSecond)
     {
-    case LogLevel::INFO:
-        return "INFO";
-    case LogLevel::WARNING:
-        return "WARNING";
-    case LogLevel::ERROR:
-        return "ERROR";
-    case LogLevel::CRITICAL:
-        return "CRITICAL";
-    default:
-        return "UNKNOWN";
+        std::tm tm_buf;
+        localtime_r(&slot.time, &tm_buf); // Convert time to local time structure, once per second
+        m_cachedDateLength = std::strftime(m_cachedDate, sizeof(m_cachedDate), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        m_cachedSecond = slot.time;
     }
+    out.append(m_cachedDate, m_cachedDateLength); // YYYY-MM-DD HH:MM:SS
+    out += " [";
+    out += logLevelName(slot.level); // Add log level in brackets
+    out += "] ";
+    if (slot.format != nullptr)
+        appendFormatted(out, slot.format, slot.text, slot.length);
+    else
+        out.append(slot.text, slot.length); // Append the actual log message
+    out += '\n';
 }
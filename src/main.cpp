@@ -11,27 +11,103 @@
  * throughout its lifecycle.
  */
 
+#include "cli_options.h"
 #include "command_handler.h"
+#include "daemon_server.h"
+#include "globals.h"
 #include "logger.h"
+#include "metrics_server.h"
+#include "once_mode.h"
 #include "resource_monitor.h"
+#include "stream_output.h"
+#include "termination_manager.h"
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 /**
  * @brief The main function initializes the application and starts the command loop.
  *
  * The `main` function performs the following steps:
- * 1. Initializes and starts the Logger to record application events.
- * 2. Logs the startup event.
- * 3. Initializes resource monitoring threads for CPU and memory usage.
- * 4. Starts the command handling loop to process user inputs.
+ * 1. Parses command-line options (`--proc-root <dir>` reads processes from an alternative procfs tree,
+ *    `--cgroup-root <dir>` reads cgroups from an alternative hierarchy,
+ *    `--history-dir <dir>` keeps a compressed history of every process in a data directory,
+ *    `--policy <file>` evaluates rules against every epoch and acts on the matching processes,
+ *    `--stream <jsonl|csv>` selects the headless stream mode; see cli_options.h).
+ *    With `--once`, prints the processes once and returns without starting the Logger.
+ *    `--daemon` serves process snapshots to local clients over a Unix socket (see daemon_server.h).
+ *    `--shm-export <name>` publishes every epoch into shared memory (see shm_snapshot_reader.h), and
+ *    `--metrics <address>` serves Prometheus metrics over HTTP (see metrics_server.h).
+ * 2. Initializes and starts the Logger to record application events.
+ * 3. Logs the startup event.
+ * 4. Starts the command handling loop to process user inputs, streams process records to
+ *    standard output in stream mode, or serves clients in daemon mode.
  * 5. Upon termination, logs the shutdown event and stops the Logger.
  *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
  * @return Returns 0 upon successful execution.
  */
-int main()
+int main(int argc, char* argv[])
 {
-    // Initialize and start the Logger to record events to "process_manager.log"
-    if (!Logger::getInstance().start("process_manager.log"))
+    // Parse command-line options
+    CliOptions cli;
+    std::string error;
+    if (!parseCommandLine(argc, argv, cli, error))
+    {
+        std::cerr << error << std::endl;
+        std::cerr << usageText(argv[0]);
+        return 1;
+    }
+    if (!cli.procRoot.empty())
+    {
+        procRoot = cli.procRoot; // Read processes from an alternative procfs tree
+    }
+    if (!cli.cgroupRoot.empty())
+    {
+        cgroupRoot = cli.cgroupRoot; // Read cgroups from an alternative hierarchy
+    }
+    if (cli.once)
+    {
+        // One-shot mode: no command loop, monitoring threads or logger thread to start
+        return runOnceMode(cli);
+    }
+    if (!cli.historyDir.empty())
+    {
+        HistoryStoreOptions options;
+        options.directory = cli.historyDir;
+        if (!historyStore.open(options))
+        {
+            std::cerr << "Failed to open history directory: " << options.directory << std::endl;
+            return 1;
+        }
+    }
+
+    if (!cli.policyFile.empty())
+    {
+        std::vector<PolicyRule> rules;
+        if (!loadPolicyFile(cli.policyFile, rules, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        policyEngine.setRules(std::move(rules));
+    }
+
+    if (!cli.shmExport.empty())
+    {
+        if (!shmExport.open(cli.shmExport, ShmSnapshotWriter::kDefaultCapacity, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    // Initialize and start the Logger to record events to "process_manager.log", or to
+    // "process_manager.binlog" in binary (decoded with pm_logcat), rotated as the options say
+    const char* logFile = cli.logFormat == LogFormat::Binary ? "process_manager.binlog" : "process_manager.log";
+    Logger::getInstance().setRotationPolicy(cli.logRotation);
+    if (!Logger::getInstance().start(logFile, cli.logFormat))
     {
         std::cerr << "Failed to start logger!" << std::endl;
         return 1; // Exit with an error code if the logger fails to start
@@ -39,16 +115,65 @@ int main()
 
     // Log that the Process Manager has started successfully
     Logger::getInstance().info("Process Manager started.");
+    if (policyEngine.ruleCount() > 0)
+    {
+        Logger::getInstance().info("Loaded {} policy rule(s) from {}.", policyEngine.ruleCount(), cli.policyFile);
+    }
 
-    // Start the command handling loop to process user commands
-    // This function blocks until the user decides to exit the application
-    startCommandLoop();
+    MetricsServer metricsServer(cli.metricsTop);
+    std::atomic<bool> metricsStopRequested(false);
+    std::thread metricsThread;
+    if (!cli.metricsAddress.empty())
+    {
+        if (!metricsServer.start(cli.metricsAddress, error))
+        {
+            std::cerr << error << std::endl;
+            Logger::getInstance().stop();
+            return 1;
+        }
+        // Scrapes are served next to whichever mode runs, from the snapshots it publishes
+        metricsThread = std::thread([&]() { metricsServer.serve(metricsStopRequested); });
+    }
+
+    int status = 0;
+    if (cli.streamFormat != StreamFormat::None)
+    {
+        // Headless mode: records go to standard output until interrupted
+        status = runStreamMode(cli);
+    }
+    else if (cli.daemon)
+    {
+        // Daemon mode: one sampler serves every client until interrupted
+        status = runDaemonMode(cli);
+    }
+    else
+    {
+        // Start the command handling loop to process user commands
+        // This function blocks until the user decides to exit the application
+        startCommandLoop();
+    }
+
+    if (metricsThread.joinable())
+    {
+        metricsStopRequested.store(true);
+        metricsThread.join();
+        metricsServer.stop();
+    }
 
     // Log that the Process Manager is shutting down
     Logger::getInstance().info("Shutting down Process Manager.");
 
+    // Let graceful terminations still pending kill what outlives its grace period
+    TerminationManager::getInstance().stop();
+
+    // Write the blocks of the current period to the history store
+    historyStore.close();
+
+    // Remove the shared-memory export, so that its readers see no stale epochs
+    shmExport.close();
+
     // Stop the Logger to ensure all logs are flushed and resources are released
     Logger::getInstance().stop();
 
-    return 0; // Indicate successful execution
+    return status; // 0 indicates successful execution
 }
@@ -0,0 +1,362 @@
+/**
+ * @file metrics_server.cpp
+ * @brief Implements the Prometheus exposition endpoint.
+ *
+ * This source file contains the metrics renderer and the MetricsServer class. The server runs the
+ * poll() loop of PollServer, like the daemon server, and answers every scrape of an epoch with the
+ * metrics rendered at the first scrape of that epoch.
+ */
+
+#include "metrics_server.h"
+#include "cli_options.h"
+#include "globals.h"
+#include "logger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Bytes per megabyte, the unit of Process::memoryUsage
+const double kBytesPerMb = 1024.0 * 1024.0;
+
+// Appends a label value, escaped as the text format requires
+void appendLabelValue(FrameBuffer& out, const std::string& value)
+{
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        const char* escaped = nullptr;
+        if (value[i] == '\\')
+            escaped = "\\\\";
+        else if (value[i] == '"')
+            escaped = "\\\"";
+        else if (value[i] == '\n')
+            escaped = "\\n";
+        if (escaped != nullptr)
+        {
+            out.append(value.data() + start, i - start);
+            out.append(escaped);
+            start = i + 1;
+        }
+    }
+    out.append(value.data() + start, value.size() - start);
+}
+
+// Appends the HELP and TYPE lines of a gauge
+void appendGaugeHeader(FrameBuffer& out, const char* name, const char* help)
+{
+    out.append("# HELP ");
+    out.append(name);
+    out.append(1, ' ');
+    out.append(help);
+    out.append("\n# TYPE ");
+    out.append(name);
+    out.append(" gauge\n");
+}
+
+// Appends a sample of a per-process gauge
+void appendProcessSample(FrameBuffer& out, const char* name, const std::string& pid, const std::string& user,
+                         const std::string& command, double value, bool bytes)
+{
+    out.append(name);
+    out.append("{pid=\"");
+    out.append(pid);
+    out.append("\",user=\"");
+    appendLabelValue(out, user);
+    out.append("\",command=\"");
+    appendLabelValue(out, command);
+    out.append("\"} ");
+    if (bytes)
+        out.appendInt(std::llround(value * kBytesPerMb));
+    else
+        out.appendFixed(value, 2);
+    out.append(1, '\n');
+}
+
+// Sums of the processes of a user, or of the processes left out of the top lists
+struct UsageTotals
+{
+    double cpu = 0.0;
+    double memory = 0.0;
+    long long processes = 0;
+};
+
+} // namespace
+
+void renderMetrics(FrameBuffer& out, const ProcessSnapshot& snapshot, size_t top, int64_t timestampMs)
+{
+    const std::vector<Process>& processes = snapshot.processes;
+
+    // Export the `top` processes of each ranking; everything else goes into the "other" series
+    std::vector<const Process*> ranked(processes.size());
+    std::transform(processes.begin(), processes.end(), ranked.begin(), [](const Process& p) { return &p; });
+    std::vector<char> exported(processes.size(), 0);
+    size_t limit = std::min(top, ranked.size());
+    auto markTop = [&](auto higher) {
+        std::nth_element(ranked.begin(), ranked.begin() + limit, ranked.end(), higher);
+        for (size_t i = 0; i < limit; ++i)
+        {
+            exported[static_cast<size_t>(ranked[i] - processes.data())] = 1;
+        }
+    };
+    if (limit > 0 && limit < ranked.size())
+    {
+        markTop([](const Process* a, const Process* b) { return a->cpuUsage > b->cpuUsage; });
+        markTop([](const Process* a, const Process* b) { return a->memoryUsage > b->memoryUsage; });
+    }
+    else if (limit > 0)
+    {
+        std::fill(exported.begin(), exported.end(), 1);
+    }
+
+    UsageTotals other;
+    std::map<std::string, UsageTotals> users;
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        UsageTotals& user = users[processes[i].user];
+        user.cpu += processes[i].cpuUsage;
+        user.memory += processes[i].memoryUsage;
+        user.processes++;
+        if (!exported[i])
+        {
+            other.cpu += processes[i].cpuUsage;
+            other.memory += processes[i].memoryUsage;
+            other.processes++;
+        }
+    }
+
+    appendGaugeHeader(out, "process_manager_processes", "Processes in the latest snapshot.");
+    out.append("process_manager_processes ");
+    out.appendInt(static_cast<long long>(processes.size()));
+    out.append(1, '\n');
+    appendGaugeHeader(out, "process_manager_snapshot_timestamp_seconds",
+                      "Time of the latest snapshot, in seconds since the Unix epoch.");
+    out.append("process_manager_snapshot_timestamp_seconds ");
+    out.appendFixed(static_cast<double>(timestampMs) / 1000.0, 3);
+    out.append(1, '\n');
+
+    // Per-process gauges, in PID order (the snapshot is sorted by PID)
+    const char* gauges[2] = {"process_manager_process_cpu_percent", "process_manager_process_resident_bytes"};
+    const char* helps[2] = {"CPU usage of a process, in percent of one core.", "Resident memory of a process."};
+    for (int gauge = 0; gauge < 2; ++gauge)
+    {
+        bool bytes = gauge == 1;
+        appendGaugeHeader(out, gauges[gauge], helps[gauge]);
+        for (size_t i = 0; i < processes.size(); ++i)
+        {
+            if (exported[i])
+            {
+                const Process& process = processes[i];
+                appendProcessSample(out, gauges[gauge], std::to_string(process.pid), process.user, process.command,
+                                    bytes ? process.memoryUsage : process.cpuUsage, bytes);
+            }
+        }
+        if (other.processes > 0)
+        {
+            appendProcessSample(out, gauges[gauge], "other", "", "", bytes ? other.memory : other.cpu, bytes);
+        }
+    }
+    appendGaugeHeader(out, "process_manager_other_processes", "Processes summed into the pid=\"other\" series.");
+    out.append("process_manager_other_processes ");
+    out.appendInt(other.processes);
+    out.append(1, '\n');
+
+    // Per-user gauges
+    appendGaugeHeader(out, "process_manager_user_cpu_percent", "CPU usage of the processes of a user.");
+    for (const auto& user : users)
+    {
+        out.append("process_manager_user_cpu_percent{user=\"");
+        appendLabelValue(out, user.first);
+        out.append("\"} ");
+        out.appendFixed(user.second.cpu, 2);
+        out.append(1, '\n');
+    }
+    appendGaugeHeader(out, "process_manager_user_resident_bytes", "Resident memory of the processes of a user.");
+    for (const auto& user : users)
+    {
+        out.append("process_manager_user_resident_bytes{user=\"");
+        appendLabelValue(out, user.first);
+        out.append("\"} ");
+        out.appendInt(std::llround(user.second.memory * kBytesPerMb));
+        out.append(1, '\n');
+    }
+    appendGaugeHeader(out, "process_manager_user_processes", "Processes of a user.");
+    for (const auto& user : users)
+    {
+        out.append("process_manager_user_processes{user=\"");
+        appendLabelValue(out, user.first);
+        out.append("\"} ");
+        out.appendInt(user.second.processes);
+        out.append(1, '\n');
+    }
+}
+
+MetricsServer::MetricsServer(size_t top)
+    : PollServer("Metrics", kMaxClients, 4 * kMaxRequestBytes), m_top(top), m_port(0), m_scratch(256 * 1024),
+      m_renderCount(0)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(const std::string& address, std::string& error)
+{
+    std::string host;
+    int port = 0;
+    if (!parseListenAddress(address, host, port))
+    {
+        error = "Invalid metrics address: " + address;
+        return false;
+    }
+    sockaddr_in socketAddress{};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, host.c_str(), &socketAddress.sin_addr);
+
+    m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0)
+    {
+        error = std::string("Failed to create socket: ") + std::strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    socklen_t length = sizeof(socketAddress);
+    if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0 ||
+        listen(m_listenFd, SOMAXCONN) != 0 ||
+        getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&socketAddress), &length) != 0)
+    {
+        error = "Failed to listen on " + address + ": " + std::strerror(errno);
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    m_port = ntohs(socketAddress.sin_port);
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    closeSockets();
+    m_port = 0;
+    m_cachedSnapshot.reset();
+}
+
+int MetricsServer::port() const
+{
+    return m_port;
+}
+
+uint64_t MetricsServer::renderCount() const
+{
+    return m_renderCount.load();
+}
+
+void MetricsServer::handleRequests(Client& client)
+{
+    // One response at a time: pipelined requests wait until the previous response is written
+    size_t end = client.input.find("\r\n\r\n");
+    size_t separator = 4;
+    if (end == std::string::npos)
+    {
+        end = client.input.find("\n\n");
+        separator = 2;
+    }
+    if (end != std::string::npos && end <= kMaxRequestBytes)
+    {
+        std::string head = client.input.substr(0, end);
+        client.input.erase(0, end + separator);
+        handleRequest(client, head);
+    }
+    else if (client.input.size() > kMaxRequestBytes)
+    {
+        appendResponse(client, "431 Request Header Fields Too Large", "Request too large\n", false);
+    }
+}
+
+void MetricsServer::handleRequest(Client& client, const std::string& head)
+{
+    // Request line: method, target and version
+    size_t lineEnd = head.find_first_of("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = firstSpace == std::string::npos ? std::string::npos : requestLine.find(' ', firstSpace + 1);
+    if (secondSpace == std::string::npos)
+    {
+        appendResponse(client, "400 Bad Request", "Bad request\n", false);
+        return;
+    }
+    std::string method = requestLine.substr(0, firstSpace);
+    std::string target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string version = requestLine.substr(secondSpace + 1);
+
+    // HTTP/1.1 connections persist unless the client asks otherwise, HTTP/1.0 ones only on request
+    std::string lowerHead = head;
+    std::transform(lowerHead.begin(), lowerHead.end(), lowerHead.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    bool keepAlive = version == "HTTP/1.1" ? lowerHead.find("\nconnection: close") == std::string::npos
+                                           : lowerHead.find("\nconnection: keep-alive") != std::string::npos;
+
+    if (method != "GET")
+    {
+        appendResponse(client, "405 Method Not Allowed", "Only GET is supported\n", false);
+        return;
+    }
+    if (target != "/metrics" && target.rfind("/metrics?", 0) != 0)
+    {
+        appendResponse(client, "404 Not Found", "Metrics are served at /metrics\n", keepAlive);
+        return;
+    }
+    const std::string* body = metricsBody();
+    if (body == nullptr)
+    {
+        appendResponse(client, "503 Service Unavailable", "No snapshot yet\n", keepAlive);
+        return;
+    }
+    appendResponse(client, "200 OK", *body, keepAlive);
+}
+
+void MetricsServer::appendResponse(Client& client, const char* status, const std::string& body, bool keepAlive)
+{
+    client.output += "HTTP/1.1 ";
+    client.output += status;
+    client.output += "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: ";
+    client.output += std::to_string(body.size());
+    client.output += keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    client.output += body;
+    client.closing = client.closing || !keepAlive;
+}
+
+const std::string* MetricsServer::metricsBody()
+{
+    auto snapshot = processSnapshots.latest();
+    if (!snapshot)
+    {
+        return nullptr;
+    }
+    if (snapshot != m_cachedSnapshot)
+    {
+        // Snapshots are stamped on the steady clock; the exported timestamp is wall-clock time
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count() -
+                              (steadyNowMs() - snapshot->timestampMs);
+        m_scratch.clear();
+        renderMetrics(m_scratch, *snapshot, m_top, timestampMs);
+        m_cachedBody.assign(m_scratch.data(), m_scratch.size());
+        m_cachedSnapshot = snapshot;
+        m_renderCount++;
+    }
+    return &m_cachedBody;
+}
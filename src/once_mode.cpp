@@ -0,0 +1,67 @@
+/**
+ * @file once_mode.cpp
+ * @brief Implements the one-shot mode.
+ *
+ * This source file contains the implementation of `runOnceMode()`. It reuses the building blocks
+ * of the other modes: `sampleEpoch()` for the measuring scan, `filterProcesses()` and
+ * `sortProcesses()` for the selection, and the table formatter or the StreamWriter for the output.
+ */
+
+#include "once_mode.h"
+#include "process_display.h"
+#include "resource_monitor.h"
+#include "screen_renderer.h"
+#include "stream_output.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+int runOnceMode(const CliOptions& options, int fd)
+{
+    std::signal(SIGPIPE, SIG_IGN); // A closed pipe is reported as EPIPE by write()
+
+    // The first scan only establishes the CPU times the usage is measured against, so it skips the
+    // user, memory and command files that sampleEpoch() reads
+    long previousTotalCpuTime = getTotalCpuTime();
+    primeProcessTimes();
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.windowMs));
+    auto snapshot = sampleEpoch(previousTotalCpuTime);
+
+    std::vector<Process> selected = filterProcesses(snapshot->processes, options.filter);
+    bool written = false;
+    if (options.streamFormat != StreamFormat::None)
+    {
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        std::vector<const Process*> rows;
+        selectStreamRows(selected, options.top, options.sortBy, rows);
+        StreamWriter writer(fd, options.streamFormat);
+        written = writer.writeEpoch(std::chrono::duration_cast<std::chrono::milliseconds>(now).count(), rows);
+    }
+    else
+    {
+        size_t rows = options.top == 0 ? selected.size() : options.top;
+        sortProcesses(selected, options.sortBy, rows);
+
+        // Fit the command column to the terminal; files and pipes get the default width, without colors
+        int terminalRows = 0;
+        int width = kDefaultTableWidth;
+        bool terminal = isatty(fd);
+        if (terminal)
+        {
+            queryTerminalSize(fd, terminalRows, width);
+        }
+        FrameBuffer frame(4096);
+        formatProcessTable(selected, frame, rows, width, terminal);
+        written = frame.writeTo(fd);
+    }
+
+    // The reader going away (e.g., `| head`) is not an error
+    if (!written && errno != EPIPE)
+    {
+        std::cerr << "Failed to write process list." << std::endl;
+        return 1;
+    }
+    return 0;
+}
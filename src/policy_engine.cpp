@@ -0,0 +1,706 @@
+/**
+ * @file policy_engine.cpp
+ * @brief Implements the policy engine: the rule compiler, the per-epoch evaluation and the actions.
+ *
+ * The processes of an epoch are read once, into columns of doubles; user and command names are
+ * looked up once per process, not once per rule. A rule then starts from the processes passing its
+ * first test: the list of those with its string value, or a branchless scan of a column that
+ * rules with stricter thresholds on the same column continue from, and that is skipped when the
+ * threshold lies outside the range of the column (a `cpu > 95` rule on an idle host costs
+ * nothing). The remaining conditions only see the processes that passed. The state of a rule is
+ * merged with the matches of the epoch, both sorted by PID, in one linear pass without hashing.
+ */
+
+#include "policy_engine.h"
+#include "cli_options.h"
+#include "logger.h"
+#include "process_control.h"
+#include "process_info.h"
+#include "termination_manager.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sys/resource.h>
+#include <tuple>
+
+namespace
+{
+
+// Characters of the comparison operators
+const char kOperatorCharacters[] = "<>=!";
+
+// The arrow separating conditions from actions, also accepted as the Unicode arrow
+const char kUnicodeArrow[] = "\xE2\x86\x92";
+
+// Splits a rule into words, operators, commas and arrows; "cpu>95" is three tokens
+std::vector<std::string> tokenize(const std::string& text)
+{
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            ++i;
+        }
+        else if (text.compare(i, 2, "->") == 0 || text.compare(i, 3, kUnicodeArrow) == 0)
+        {
+            tokens.push_back("->");
+            i += c == '-' ? 2 : 3;
+        }
+        else if (c == ',')
+        {
+            tokens.push_back(",");
+            ++i;
+        }
+        else if (std::strchr(kOperatorCharacters, c) != nullptr)
+        {
+            size_t length = i + 1 < text.size() && text[i + 1] == '=' ? 2 : 1;
+            tokens.push_back(text.substr(i, length));
+            i += length;
+        }
+        else
+        {
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) && text[i] != ',' &&
+                   std::strchr(kOperatorCharacters, text[i]) == nullptr && text.compare(i, 2, "->") != 0 &&
+                   text.compare(i, 3, kUnicodeArrow) != 0)
+            {
+                ++i;
+            }
+            tokens.push_back(text.substr(start, i - start));
+        }
+    }
+    return tokens;
+}
+
+bool parseField(const std::string& name, PolicyField& field)
+{
+    if (name == "cpu")
+        field = PolicyField::Cpu;
+    else if (name == "memory")
+        field = PolicyField::Memory;
+    else if (name == "pid")
+        field = PolicyField::Pid;
+    else if (name == "user")
+        field = PolicyField::User;
+    else if (name == "command")
+        field = PolicyField::Command;
+    else
+        return false;
+    return true;
+}
+
+bool parseOperator(const std::string& name, PolicyOperator& op)
+{
+    if (name == ">")
+        op = PolicyOperator::Greater;
+    else if (name == ">=")
+        op = PolicyOperator::GreaterEqual;
+    else if (name == "<")
+        op = PolicyOperator::Less;
+    else if (name == "<=")
+        op = PolicyOperator::LessEqual;
+    else if (name == "==" || name == "=")
+        op = PolicyOperator::Equal;
+    else if (name == "!=")
+        op = PolicyOperator::NotEqual;
+    else
+        return false;
+    return true;
+}
+
+bool isNumeric(PolicyField field)
+{
+    return field == PolicyField::Cpu || field == PolicyField::Memory || field == PolicyField::Pid;
+}
+
+bool parseNumber(const std::string& text, double& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && errno == 0;
+}
+
+// Selects the rows whose value in `column` satisfies `predicate`, among all `count` rows if `rows` is
+// null or among the `count` rows it lists. Writes them to `out`, which may be `rows`, in the same
+// order and returns their number.
+template <typename Predicate>
+size_t selectRows(const double* column, const uint32_t* rows, size_t count, uint32_t* out, Predicate predicate)
+{
+    size_t matches = 0;
+    if (rows == nullptr)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[matches] = static_cast<uint32_t>(i);
+            matches += predicate(column[i]) ? 1 : 0;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t row = rows[i];
+            out[matches] = row;
+            matches += predicate(column[row]) ? 1 : 0;
+        }
+    }
+    return matches;
+}
+
+size_t selectRows(const double* column, const uint32_t* rows, size_t count, PolicyOperator op, double value,
+                  uint32_t* out)
+{
+    switch (op)
+    {
+    case PolicyOperator::Greater:
+        return selectRows(column, rows, count, out, [value](double x) { return x > value; });
+    case PolicyOperator::GreaterEqual:
+        return selectRows(column, rows, count, out, [value](double x) { return x >= value; });
+    case PolicyOperator::Less:
+        return selectRows(column, rows, count, out, [value](double x) { return x < value; });
+    case PolicyOperator::LessEqual:
+        return selectRows(column, rows, count, out, [value](double x) { return x <= value; });
+    case PolicyOperator::Equal:
+        return selectRows(column, rows, count, out, [value](double x) { return x == value; });
+    case PolicyOperator::NotEqual:
+        return selectRows(column, rows, count, out, [value](double x) { return x != value; });
+    }
+    return 0;
+}
+
+// `>` and `>=` rise, `<` and `<=` fall: a rule with a stricter threshold matches a subset of the
+// processes matching a rule with a looser one on the same column
+bool isRising(PolicyOperator op)
+{
+    return op == PolicyOperator::Greater || op == PolicyOperator::GreaterEqual;
+}
+
+bool isThreshold(PolicyOperator op)
+{
+    return op != PolicyOperator::Equal && op != PolicyOperator::NotEqual;
+}
+
+// Usage rounded for messages
+double tenths(double value)
+{
+    return std::round(value * 10) / 10;
+}
+
+// Returns true if no value within [minimum, maximum] can satisfy the condition
+bool outOfRange(PolicyOperator op, double value, double minimum, double maximum)
+{
+    switch (op)
+    {
+    case PolicyOperator::Greater:
+        return maximum <= value;
+    case PolicyOperator::GreaterEqual:
+        return maximum < value;
+    case PolicyOperator::Less:
+        return minimum >= value;
+    case PolicyOperator::LessEqual:
+        return minimum > value;
+    case PolicyOperator::Equal:
+        return value < minimum || value > maximum;
+    case PolicyOperator::NotEqual:
+        return false;
+    }
+    return false;
+}
+
+} // namespace
+
+bool parsePolicyRule(const std::string& text, PolicyRule& rule, std::string& error)
+{
+    rule = PolicyRule();
+    size_t start = text.find_first_not_of(" \t");
+    rule.text = start == std::string::npos ? "" : text.substr(start, text.find_last_not_of(" \t\r") + 1 - start);
+
+    std::vector<std::string> tokens = tokenize(text);
+    size_t pos = 0;
+    auto next = [&]() { return pos < tokens.size() ? tokens[pos++] : std::string(); };
+    bool hasDuration = false;
+
+    // Conditions, up to the arrow; `for <duration>` may follow any of them, once
+    while (true)
+    {
+        PolicyCondition condition;
+        std::string field = next(), op = next(), value = next();
+        if (!parseField(field, condition.field))
+        {
+            error = "unknown field '" + field + "' (use cpu, memory, pid, user or command)";
+            return false;
+        }
+        if (!parseOperator(op, condition.op))
+        {
+            error = "expected a comparison after '" + field + "'";
+            return false;
+        }
+        if (value.empty() || value == "->")
+        {
+            error = "missing value after '" + field + " " + op + "'";
+            return false;
+        }
+        if (isNumeric(condition.field))
+        {
+            if (!parseNumber(value, condition.number))
+            {
+                error = "invalid number '" + value + "' for " + field;
+                return false;
+            }
+        }
+        else if (condition.op != PolicyOperator::Equal && condition.op != PolicyOperator::NotEqual)
+        {
+            error = field + " can only be compared with == or !=";
+            return false;
+        }
+        condition.text = value;
+        rule.conditions.push_back(condition);
+
+        std::string keyword = next();
+        if (keyword == "and")
+            continue;
+        if (keyword == "for")
+        {
+            if (hasDuration)
+            {
+                error = "only one 'for' is allowed per rule";
+                return false;
+            }
+            std::string duration = next();
+            int milliseconds = 0;
+            if (!parseDuration(duration, milliseconds))
+            {
+                error = "invalid duration '" + duration + "' (e.g., 30s or 5m)";
+                return false;
+            }
+            rule.holdMs = milliseconds;
+            hasDuration = true;
+            keyword = next();
+            if (keyword == "and")
+                continue;
+        }
+        if (keyword == "->")
+            break;
+        error = keyword.empty() ? "missing '->' and actions" : "unexpected '" + keyword + "'";
+        return false;
+    }
+
+    // Actions, in order
+    while (true)
+    {
+        PolicyAction action;
+        std::string name = next();
+        if (name == "term")
+        {
+            action.type = PolicyActionType::Terminate;
+            if (pos < tokens.size() && tokens[pos] != "," && tokens[pos] != "then")
+            {
+                std::string grace = next();
+                if (!parseDuration(grace, action.graceMs))
+                {
+                    error = "invalid grace period '" + grace + "' for term";
+                    return false;
+                }
+            }
+        }
+        else if (name == "kill")
+        {
+            action.type = PolicyActionType::Kill;
+        }
+        else if (name == "renice")
+        {
+            std::string value = next();
+            double nice = 0;
+            if (!parseNumber(value, nice) || nice != static_cast<int>(nice) || nice < -20 || nice > 19)
+            {
+                error = "renice needs a nice value from -20 to 19";
+                return false;
+            }
+            action.type = PolicyActionType::Renice;
+            action.nice = static_cast<int>(nice);
+        }
+        else if (name == "alert")
+        {
+            action.type = PolicyActionType::Alert;
+        }
+        else
+        {
+            error = name.empty() ? "missing action" : "unknown action '" + name + "' (use term, kill, renice or alert)";
+            return false;
+        }
+        rule.actions.push_back(action);
+
+        std::string separator = next();
+        if (separator.empty())
+            break;
+        if (separator == "," && pos < tokens.size() && tokens[pos] == "then")
+            pos++;
+        else if (separator != "," && separator != "then")
+        {
+            error = "unexpected '" + separator + "' after an action";
+            return false;
+        }
+    }
+
+    // The first numeric condition is scanned over the columns; the others only check its matches
+    std::stable_partition(rule.conditions.begin(), rule.conditions.end(),
+                          [](const PolicyCondition& condition) { return isNumeric(condition.field); });
+    return true;
+}
+
+bool loadPolicyFile(const std::string& path, std::vector<PolicyRule>& rules, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "Cannot open policy file " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    rules.clear();
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number)
+    {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        PolicyRule rule;
+        std::string reason;
+        if (!parsePolicyRule(line, rule, reason))
+        {
+            error = path + ":" + std::to_string(number) + ": " + reason;
+            return false;
+        }
+        rule.line = number;
+        rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+void PolicyEngine::setRules(std::vector<PolicyRule> rules)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rules = std::move(rules);
+    m_states.assign(m_rules.size(), RuleState());
+
+    // Every condition becomes a comparison of a column; strings are numbered per field
+    m_tests.assign(m_rules.size(), {});
+    for (size_t column = 0; column < kColumns; ++column)
+    {
+        m_literals[column].clear();
+        m_usesColumn[column] = false;
+    }
+    for (size_t r = 0; r < m_rules.size(); ++r)
+    {
+        std::vector<Test>& tests = m_tests[r];
+        for (const PolicyCondition& condition : m_rules[r].conditions)
+        {
+            size_t column = static_cast<size_t>(condition.field);
+            double value = condition.number;
+            if (!isNumeric(condition.field))
+            {
+                value = m_literals[column].emplace(condition.text, m_literals[column].size()).first->second;
+            }
+            m_usesColumn[column] = true;
+            tests.push_back({static_cast<uint8_t>(column), condition.op, value});
+        }
+
+        // The first test selects the processes checked against the others: preferably the list of
+        // those with a string value, else a threshold that can continue from a looser one
+        auto first = std::find_if(tests.begin(), tests.end(), [](const Test& test) {
+            return !isNumeric(static_cast<PolicyField>(test.column)) && test.op == PolicyOperator::Equal;
+        });
+        if (first == tests.end())
+            first = std::find_if(tests.begin(), tests.end(), [](const Test& test) { return isThreshold(test.op); });
+        if (first != tests.end())
+            std::iter_swap(tests.begin(), first);
+    }
+
+    // Thresholds on the same column and in the same direction are evaluated from the loosest to
+    // the strictest, each scanning only the processes that passed the one before
+    m_steps.clear();
+    for (size_t r = 0; r < m_rules.size(); ++r)
+    {
+        const std::vector<Test>& tests = m_tests[r];
+        Source source = Source::Scan;
+        if (tests.empty())
+            source = Source::All;
+        else if (!isNumeric(static_cast<PolicyField>(tests[0].column)) && tests[0].op == PolicyOperator::Equal)
+            source = Source::Postings;
+        m_steps.push_back({static_cast<uint32_t>(r), source});
+    }
+    auto key = [this](const Step& step) {
+        const Test& test = m_tests[step.rule][0];
+        bool rising = isRising(test.op);
+        bool strict = test.op == PolicyOperator::Greater || test.op == PolicyOperator::Less;
+        return std::make_tuple(test.column, rising, rising ? test.value : -test.value, strict);
+    };
+    auto chained = std::stable_partition(m_steps.begin(), m_steps.end(), [this](const Step& step) {
+        return step.source != Source::Scan || !isThreshold(m_tests[step.rule][0].op);
+    });
+    std::stable_sort(chained, m_steps.end(), [&key](const Step& a, const Step& b) { return key(a) < key(b); });
+    for (auto step = chained; step != m_steps.end(); ++step)
+    {
+        if (step == chained)
+            continue;
+        const Test& looser = m_tests[step[-1].rule][0];
+        const Test& test = m_tests[step->rule][0];
+        if (looser.column == test.column && isRising(looser.op) == isRising(test.op))
+            step->source = Source::Chain;
+    }
+}
+
+void PolicyEngine::clear()
+{
+    setRules({});
+}
+
+size_t PolicyEngine::ruleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rules.size();
+}
+
+std::vector<PolicyRuleStatus> PolicyEngine::status() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<PolicyRuleStatus> rules;
+    for (size_t i = 0; i < m_rules.size(); ++i)
+    {
+        rules.push_back({m_rules[i].text, m_states[i].matches.size(), m_states[i].firings});
+    }
+    return rules;
+}
+
+void PolicyEngine::evaluate(const ProcessSnapshot& snapshot, int64_t nowMs, std::vector<PolicyFiring>& firings)
+{
+    firings.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_rules.empty())
+        return;
+
+    // The fields the rules test, in columns filled in one pass over the processes. A string is
+    // replaced by the index of the rule literal it equals, or -1, once per process rather than per
+    // rule, and the processes with each literal are listed.
+    const std::vector<Process>& processes = snapshot.processes;
+    size_t count = processes.size();
+    double* columns[kColumns] = {};
+    for (size_t column = 0; column < kColumns; ++column)
+    {
+        if (!m_usesColumn[column])
+            continue;
+        m_columns[column].resize(count);
+        columns[column] = m_columns[column].data();
+        m_postings[column].resize(m_literals[column].size());
+        for (std::vector<uint32_t>& rows : m_postings[column])
+        {
+            rows.clear();
+        }
+    }
+    m_pids.resize(count);
+    m_startTimes.resize(count);
+    const size_t user = static_cast<size_t>(PolicyField::User), command = static_cast<size_t>(PolicyField::Command);
+    double* cpu = columns[static_cast<size_t>(PolicyField::Cpu)];
+    double* memory = columns[static_cast<size_t>(PolicyField::Memory)];
+    double* pids = columns[static_cast<size_t>(PolicyField::Pid)];
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Process& process = processes[i];
+        m_pids[i] = process.pid;
+        m_startTimes[i] = process.startTime;
+        if (cpu)
+            cpu[i] = process.cpuUsage;
+        if (memory)
+            memory[i] = process.memoryUsage;
+        if (pids)
+            pids[i] = process.pid;
+        if (columns[user])
+            columns[user][i] = internLiteral(user, process.user, static_cast<uint32_t>(i));
+        if (columns[command])
+            columns[command][i] = internLiteral(command, process.command, static_cast<uint32_t>(i));
+    }
+
+    // The range of each numeric column, to skip the thresholds nothing passes
+    double minimum[kColumns] = {}, maximum[kColumns] = {};
+    for (size_t column = 0; column < kColumns; ++column)
+    {
+        if (columns[column] && count > 0 && isNumeric(static_cast<PolicyField>(column)))
+        {
+            auto range = std::minmax_element(columns[column], columns[column] + count);
+            minimum[column] = *range.first;
+            maximum[column] = *range.second;
+        }
+    }
+    m_passed.resize(count);
+    m_candidates.resize(count);
+
+    size_t chained = 0; // Processes passing the looser threshold of the previous step
+    for (const Step& step : m_steps)
+    {
+        const std::vector<Test>& tests = m_tests[step.rule];
+        RuleState& state = m_states[step.rule];
+
+        // Processes passing the first test
+        const uint32_t* rows = m_passed.data();
+        size_t passed = 0;
+        if (step.source == Source::All)
+        {
+            std::iota(m_passed.begin(), m_passed.end(), 0u);
+            passed = count;
+        }
+        else if (step.source == Source::Postings)
+        {
+            const std::vector<uint32_t>& postings = m_postings[tests[0].column][static_cast<size_t>(tests[0].value)];
+            rows = postings.data();
+            passed = postings.size();
+        }
+        else
+        {
+            const Test& test = tests[0];
+            const double* column = m_columns[test.column].data();
+            if (step.source == Source::Chain)
+                passed = selectRows(column, m_passed.data(), chained, test.op, test.value, m_passed.data());
+            else if (!outOfRange(test.op, test.value, minimum[test.column], maximum[test.column]))
+                passed = selectRows(column, nullptr, count, test.op, test.value, m_passed.data());
+            chained = passed;
+        }
+
+        // Then the others
+        size_t matches = passed;
+        for (size_t t = 1; t < tests.size() && matches > 0; ++t)
+        {
+            const Test& test = tests[t];
+            const double* column = m_columns[test.column].data();
+            matches = selectRows(column, rows, matches, test.op, test.value, m_candidates.data());
+            rows = m_candidates.data();
+        }
+
+        // Merge with the processes that matched before: both are sorted by PID
+        if (matches == 0 && state.matches.empty())
+            continue;
+        const PolicyRule& rule = m_rules[step.rule];
+        m_scratch.resize(matches);
+        const Match* previous = state.matches.data();
+        const Match* end = previous + state.matches.size();
+        for (size_t i = 0; i < matches; ++i)
+        {
+            uint32_t row = rows[i];
+            Match& match = m_scratch[i];
+            match = {m_pids[row], 0, m_startTimes[row], nowMs};
+            while (previous != end && previous->pid < match.pid)
+                ++previous;
+            if (previous != end && previous->pid == match.pid && previous->startTime == match.startTime)
+            {
+                match.fired = previous->fired;
+                match.sinceMs = previous->sinceMs;
+            }
+            if (match.fired == 0 && nowMs - match.sinceMs >= rule.holdMs)
+            {
+                match.fired = 1;
+                state.firings++;
+                firings.push_back({step.rule, rule.text, rule.actions, processes[row]});
+            }
+        }
+        std::swap(state.matches, m_scratch);
+    }
+
+    // Steps are grouped by source; firings are reported in the order of the rules
+    std::stable_sort(firings.begin(), firings.end(),
+                     [](const PolicyFiring& a, const PolicyFiring& b) { return a.rule < b.rule; });
+}
+
+double PolicyEngine::internLiteral(size_t column, const std::string& text, uint32_t row)
+{
+    auto it = m_literals[column].find(text);
+    if (it == m_literals[column].end())
+        return -1;
+    m_postings[column][it->second].push_back(row);
+    return it->second;
+}
+
+void PolicyEngine::execute(const std::vector<PolicyFiring>& firings)
+{
+    Logger& logger = Logger::getInstance();
+    for (const PolicyFiring& firing : firings)
+    {
+        const Process& process = firing.process;
+        const std::string& rule = firing.text;
+        logger.info("Policy rule `{}` fired for PID {pid} ({}, user {}): CPU {}%, memory {} MB.", rule, process.pid,
+                    process.command, process.user, tenths(process.cpuUsage), tenths(process.memoryUsage));
+
+        KillTarget target{process.pid, process.startTime};
+        for (const PolicyAction& action : firing.actions)
+        {
+            switch (action.type)
+            {
+            case PolicyActionType::Terminate:
+            case PolicyActionType::Kill:
+            {
+                if (action.type == PolicyActionType::Terminate && action.graceMs > 0)
+                {
+                    logger.info("Policy: sending SIGTERM to PID {pid} with a {} ms grace period.", process.pid,
+                                action.graceMs);
+                    TerminationManager::getInstance().terminate({target}, action.graceMs, [](const KillReport& report) {
+                        const KillResult& result = report.results.front();
+                        Logger::getInstance().info("Policy: termination of PID {pid}: {}.", result.pid,
+                                                   killOutcomeName(result.outcome));
+                    });
+                    break;
+                }
+                int signal = action.type == PolicyActionType::Kill ? SIGKILL : SIGTERM;
+                const char* name = signal == SIGKILL ? "SIGKILL" : "SIGTERM";
+                KillResult result = signalProcesses({target}, signal, 1).results.front();
+                if (result.outcome == KillOutcome::Killed)
+                    logger.info("Policy: sent {} to PID {pid}.", name, process.pid);
+                else
+                    logger.error("Policy: failed to send {} to PID {pid}: {}.", name, process.pid,
+                                 killOutcomeName(result.outcome));
+                break;
+            }
+            case PolicyActionType::Renice:
+            {
+                // setpriority() has no pidfd variant: check the start time right before instead
+                unsigned long long startTime = 0;
+                if (!readProcessStartTime(process.pid, startTime) ||
+                    (process.startTime != 0 && startTime != process.startTime))
+                {
+                    logger.error("Policy: failed to renice PID {pid}: {}.", process.pid,
+                                 killOutcomeName(startTime == 0 ? KillOutcome::NotFound : KillOutcome::Recycled));
+                }
+                else if (setpriority(PRIO_PROCESS, static_cast<id_t>(process.pid), action.nice) != 0)
+                {
+                    logger.error("Policy: failed to renice PID {pid} to {}: {}.", process.pid, action.nice,
+                                 std::strerror(errno));
+                }
+                else
+                {
+                    logger.info("Policy: reniced PID {pid} to {}.", process.pid, action.nice);
+                }
+                break;
+            }
+            case PolicyActionType::Alert:
+                logger.critical("Policy alert: rule `{}` matched PID {pid} ({}, user {}): CPU {}%, memory {} MB.",
+                                rule, process.pid, process.command, process.user, tenths(process.cpuUsage),
+                                tenths(process.memoryUsage));
+                break;
+            }
+        }
+    }
+}
+
+void PolicyEngine::run(const ProcessSnapshot& snapshot, int64_t nowMs)
+{
+    evaluate(snapshot, nowMs, m_firings);
+    if (!m_firings.empty())
+        execute(m_firings);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file poll_server.cpp
+ * @brief Implements the poll()-based client loop shared by the daemon and metrics servers.
+ */
+
+#include "poll_server.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Longest time the server waits in poll() before checking for a stop request
+const int kPollTimeoutMs = 100;
+
+} // namespace
+
+PollServer::PollServer(const char* name, size_t maxClients, size_t maxBufferedInput)
+    : m_listenFd(-1), m_name(name), m_maxClients(maxClients), m_maxBufferedInput(maxBufferedInput)
+{
+}
+
+PollServer::~PollServer()
+{
+    closeSockets();
+}
+
+void PollServer::serve(const std::atomic<bool>& stopRequested)
+{
+    std::vector<pollfd> fds;
+    while (!stopRequested.load() && m_listenFd >= 0)
+    {
+        // A client with an unsent answer is only watched for writability
+        fds.clear();
+        fds.push_back({m_listenFd, POLLIN, 0});
+        for (const auto& client : m_clients)
+        {
+            short events = client->written < client->output.size() ? POLLOUT : POLLIN;
+            fds.push_back({client->fd, events, 0});
+        }
+
+        int ready = poll(fds.data(), fds.size(), kPollTimeoutMs);
+        if (ready < 0 && errno != EINTR)
+        {
+            Logger::getInstance().error("{} poll failed: {}", m_name, std::strerror(errno));
+            break;
+        }
+        if (ready <= 0)
+            continue;
+
+        for (size_t i = 0; i < m_clients.size(); ++i)
+        {
+            Client& client = *m_clients[i];
+            short revents = fds[i + 1].revents;
+            if (revents == 0)
+                continue;
+            bool keep = (revents & POLLOUT) ? writeOutput(client) : readRequests(client);
+            if (!keep)
+            {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                       [](const std::unique_ptr<Client>& client) { return client->fd < 0; }),
+                        m_clients.end());
+
+        if (fds[0].revents & POLLIN)
+        {
+            acceptClients();
+        }
+    }
+}
+
+size_t PollServer::clientCount() const
+{
+    return m_clients.size();
+}
+
+std::unique_ptr<PollServer::Client> PollServer::newClient()
+{
+    return std::make_unique<Client>();
+}
+
+void PollServer::closeSockets()
+{
+    for (const auto& client : m_clients)
+    {
+        close(client->fd);
+    }
+    m_clients.clear();
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+        m_listenFd = -1;
+    }
+}
+
+void PollServer::acceptClients()
+{
+    for (;;)
+    {
+        int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break; // No more pending connections (or out of descriptors: retried on the next poll)
+        }
+        if (m_clients.size() >= m_maxClients)
+        {
+            close(fd);
+            continue;
+        }
+        std::unique_ptr<Client> client = newClient();
+        client->fd = fd;
+        m_clients.push_back(std::move(client));
+    }
+}
+
+bool PollServer::readRequests(Client& client)
+{
+    char chunk[4096];
+    for (;;)
+    {
+        ssize_t received = recv(client.fd, chunk, sizeof(chunk), 0);
+        if (received > 0)
+        {
+            client.input.append(chunk, static_cast<size_t>(received));
+            // Bounded per call; the rest is read once the received requests are answered
+            if (static_cast<size_t>(received) < sizeof(chunk) || client.input.size() >= m_maxBufferedInput)
+                break;
+            continue;
+        }
+        if (received == 0)
+        {
+            client.inputClosed = true; // Answer what was asked, then close
+            break;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        return false;
+    }
+    return writeOutput(client);
+}
+
+bool PollServer::writeOutput(Client& client)
+{
+    for (;;)
+    {
+        while (client.written < client.output.size())
+        {
+            ssize_t sent = send(client.fd, client.output.data() + client.written, client.output.size() - client.written,
+                                MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                client.written += static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return true; // The rest is written when the socket becomes writable
+            return false;
+        }
+        client.output.clear();
+        client.written = 0;
+        if (client.closing)
+            return false;
+
+        // Answer the requests that were waiting for the previous answers to be written
+        handleRequests(client);
+        if (client.output.empty())
+            return !client.closing && !client.inputClosed;
+    }
+}
@@ -7,16 +7,213 @@
  * or user ownership. It ensures safe termination by handling various error scenarios such as
  * invalid PIDs, insufficient permissions, and attempts to kill critical processes like the
  * current process. Thread safety is maintained through the use of mutexes when accessing
- * the shared processes map.
+ * the shared processes map, which is only held while the targets are selected.
+ *
+ * Processes are signalled through pidfds: the descriptor pins the process, and comparing the start
+ * time read afterwards with the sampled one proves that it is the process that was sampled and not
+ * a newer one that reused the PID.
  */
 
 #include "process_control.h"
 #include "globals.h"
+#include "process_info.h" // For readProcessStartTime()
+#include "process_tree.h" // For scanProcessTree()
+#include <algorithm>
+#include <atomic>
 #include <errno.h>  // For errno
 #include <iostream> // For std::cerr and std::cout
 #include <signal.h> // For kill()
+#include <sstream>
+#include <sys/syscall.h>
+#include <thread>
 #include <unistd.h> // For getpid()
 
+namespace
+{
+
+// Targets signalled by one thread at a time; smaller sets are signalled by the calling thread alone
+const size_t kSignalBatch = 256;
+
+// Most threads signalling at once
+const size_t kMaxSignalThreads = 8;
+
+// Set once pidfd_open() reports ENOSYS, to fall back to kill() without asking again
+std::atomic<bool> g_noPidfd{false};
+
+KillResult failure(int pid, int error)
+{
+    switch (error)
+    {
+    case ESRCH:
+        return {pid, KillOutcome::NotFound, error};
+    case EPERM:
+        return {pid, KillOutcome::PermissionDenied, error};
+    default:
+        return {pid, KillOutcome::Failed, error};
+    }
+}
+
+// Signals one target: resolves it to a pidfd, checks its start time, then signals the pidfd
+KillResult signalTarget(const KillTarget& target, int signal, pid_t self)
+{
+    int pidfd;
+    KillResult result;
+    if (!openProcessHandle(target, self, pidfd, result))
+    {
+        return result;
+    }
+    result = signalProcessHandle(target, pidfd, signal);
+    if (pidfd >= 0)
+        close(pidfd);
+    return result;
+}
+
+// Prints the result of one target of a group kill; `detail` describes why it was selected
+void printKillResult(const KillResult& result, const std::string& detail)
+{
+    if (result.outcome == KillOutcome::Killed)
+    {
+        std::cout << "Killed process " << result.pid << " (" << detail << ")\n";
+    }
+    else
+    {
+        std::cerr << "Failed to kill process " << result.pid << ": " << killOutcomeName(result.outcome) << ".\n";
+    }
+}
+
+} // namespace
+
+KillTarget currentKillTarget(int pid)
+{
+    KillTarget target{pid};
+    if (pid > 0 && !readProcessStartTime(pid, target.startTime))
+        target.startTime = 0;
+    return target;
+}
+
+bool openProcessHandle(const KillTarget& target, pid_t self, int& pidfd, KillResult& result)
+{
+    pidfd = -1;
+    if (target.pid <= 0 || target.pid == self)
+    {
+        result = {target.pid, KillOutcome::Refused, 0};
+        return false;
+    }
+
+    if (!g_noPidfd.load(std::memory_order_relaxed))
+    {
+        pidfd = static_cast<int>(syscall(SYS_pidfd_open, target.pid, 0));
+        if (pidfd < 0)
+        {
+            if (errno == ENOSYS)
+                g_noPidfd.store(true, std::memory_order_relaxed);
+            else if (errno != EMFILE && errno != ENFILE)
+            {
+                result = failure(target.pid, errno);
+                return false;
+            }
+            // Without a descriptor, the start time checks below are all that protects a reused PID
+        }
+    }
+
+    unsigned long long startTime = 0;
+    KillOutcome mismatch = KillOutcome::Killed;
+    if (!readProcessStartTime(target.pid, startTime))
+        mismatch = KillOutcome::NotFound; // Exited since it was resolved
+    else if (target.startTime == 0)
+        mismatch = KillOutcome::Refused; // Unknown identity (e.g., a replayed process): fail closed
+    else if (startTime != target.startTime)
+        mismatch = KillOutcome::Recycled;
+    if (mismatch != KillOutcome::Killed)
+    {
+        if (pidfd >= 0)
+            close(pidfd);
+        pidfd = -1;
+        result = {target.pid, mismatch, mismatch == KillOutcome::NotFound ? ESRCH : 0};
+        return false;
+    }
+    return true;
+}
+
+KillResult signalProcessHandle(const KillTarget& target, int pidfd, int signal)
+{
+    int result;
+    if (pidfd >= 0)
+    {
+        result = static_cast<int>(syscall(SYS_pidfd_send_signal, pidfd, signal, nullptr, 0));
+    }
+    else
+    {
+        result = kill(target.pid, signal); // No pidfd: the start time was checked just before
+    }
+    return result == 0 ? KillResult{target.pid, KillOutcome::Killed, 0} : failure(target.pid, errno);
+}
+
+const char* killOutcomeName(KillOutcome outcome)
+{
+    switch (outcome)
+    {
+    case KillOutcome::Killed:
+        return "killed";
+    case KillOutcome::Terminated:
+        return "exited after SIGTERM";
+    case KillOutcome::NotFound:
+        return "process does not exist";
+    case KillOutcome::Recycled:
+        return "PID reused by another process";
+    case KillOutcome::PermissionDenied:
+        return "insufficient permissions";
+    case KillOutcome::Refused:
+        return "refused";
+    case KillOutcome::Failed:
+        break;
+    }
+    return "failed";
+}
+
+size_t KillReport::count(KillOutcome outcome) const
+{
+    auto matches = [outcome](const KillResult& result) { return result.outcome == outcome; };
+    return static_cast<size_t>(std::count_if(results.begin(), results.end(), matches));
+}
+
+KillReport signalProcesses(const std::vector<KillTarget>& targets, int signal, size_t threads)
+{
+    KillReport report;
+    report.results.resize(targets.size());
+    size_t batches = (targets.size() + kSignalBatch - 1) / kSignalBatch;
+    if (threads == 0)
+    {
+        threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), kMaxSignalThreads);
+    }
+    threads = std::max<size_t>(1, std::min(threads, batches));
+
+    // Each thread takes the next batch until none is left; results land at the index of their target
+    pid_t self = getpid();
+    std::atomic<size_t> nextBatch{0};
+    auto work = [&]() {
+        for (size_t batch; (batch = nextBatch.fetch_add(1)) < batches;)
+        {
+            size_t end = std::min(targets.size(), (batch + 1) * kSignalBatch);
+            for (size_t i = batch * kSignalBatch; i < end; ++i)
+            {
+                report.results[i] = signalTarget(targets[i], signal, self);
+            }
+        }
+    };
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threads; ++i)
+    {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto& helper : helpers)
+    {
+        helper.join();
+    }
+    return report;
+}
+
 bool killProcess(int pid)
 {
     // Validate PID
@@ -33,135 +230,124 @@ bool killProcess(int pid)
         return false;
     }
 
-    // Attempt to send SIGKILL to the process
-    if (kill(pid, SIGKILL) == 0)
+    // Attempt to send SIGKILL to the process, through a pidfd when the kernel has them
+    KillResult result = signalTarget(currentKillTarget(pid), SIGKILL, getpid());
+    switch (result.outcome)
     {
+    case KillOutcome::Killed:
         std::cout << "Process " << pid << " terminated successfully.\n";
         return true;
+    case KillOutcome::NotFound:
+        std::cerr << "Error: Process " << pid << " does not exist.\n";
+        break;
+    case KillOutcome::PermissionDenied:
+        std::cerr << "Error: Insufficient permissions to kill process " << pid << ".\n";
+        break;
+    default:
+        errno = result.error;
+        perror("Error killing process");
+        break;
     }
-    else
+    return false;
+}
+
+std::vector<KillTarget> selectKillTargets(const std::function<bool(const Process&)>& selected)
+{
+    // Only select under the lock: the sampler must not wait for thousands of signals
+    std::vector<KillTarget> targets;
+    std::lock_guard<std::mutex> lock(processMutex);
+    for (const auto& [pid, process] : processes)
     {
-        // Handle specific errors based on errno
-        switch (errno)
+        if (selected(process))
         {
-        case ESRCH:
-            std::cerr << "Error: Process " << pid << " does not exist.\n";
-            break;
-        case EPERM:
-            std::cerr << "Error: Insufficient permissions to kill process " << pid << ".\n";
-            break;
-        default:
-            perror("Error killing process");
-            break;
+            targets.push_back(KillTarget{pid, process.startTime});
         }
-        return false;
     }
+    return targets;
 }
 
-bool killProcessesByCpu(double threshold)
+KillReport killProcessesByCpu(double threshold)
 {
-    bool anyKilled = false;
-    int successCount = 0;
-    int failureCount = 0;
+    std::vector<double> cpuUsages;
+    std::vector<KillTarget> targets = selectKillTargets([&](const Process& process) {
+        if (process.cpuUsage <= threshold)
+            return false;
+        cpuUsages.push_back(process.cpuUsage);
+        return true;
+    });
 
+    KillReport report = signalProcesses(targets);
+    for (size_t i = 0; i < report.results.size(); ++i)
     {
-        // Lock the processes map to ensure thread-safe access
-        std::lock_guard<std::mutex> lock(processMutex);
-        for (const auto& [pid, process] : processes)
-        {
-            if (process.cpuUsage > threshold)
-            {
-                // Attempt to kill the process
-                if (kill(pid, SIGKILL) == 0)
-                {
-                    std::cout << "Killed process " << pid << " (CPU: " << process.cpuUsage << "%)\n";
-                    anyKilled = true;
-                    successCount++;
-                }
-                else
-                {
-                    std::cerr << "Failed to kill process " << pid << ": ";
-                    switch (errno)
-                    {
-                    case ESRCH:
-                        std::cerr << "Process does not exist.\n";
-                        break;
-                    case EPERM:
-                        std::cerr << "Insufficient permissions.\n";
-                        break;
-                    default:
-                        perror("Error");
-                        break;
-                    }
-                    failureCount++;
-                }
-            }
-        }
+        std::ostringstream detail;
+        detail << "CPU: " << cpuUsages[i] << "%";
+        printKillResult(report.results[i], detail.str());
     }
 
     // Provide a summary of the termination attempts
-    if (!anyKilled)
+    if (report.killed() == 0)
     {
         std::cout << "No processes found exceeding the CPU usage threshold.\n";
     }
     else
     {
-        std::cout << "Summary: " << successCount << " processes killed, " << failureCount << " failed.\n";
+        std::cout << "Summary: " << report.killed() << " processes killed, " << report.failed() << " failed.\n";
     }
-
-    return anyKilled;
+    return report;
 }
 
-bool killProcessesByUser(const std::string& username)
+KillReport killProcessesByUser(const std::string& username)
 {
-    bool anyKilled = false;
-    int successCount = 0;
-    int failureCount = 0;
+    std::vector<KillTarget> targets =
+        selectKillTargets([&](const Process& process) { return process.user == username; });
 
+    KillReport report = signalProcesses(targets);
+    for (const KillResult& result : report.results)
     {
-        // Lock the processes map to ensure thread-safe access
-        std::lock_guard<std::mutex> lock(processMutex);
-        for (const auto& [pid, process] : processes)
-        {
-            if (process.user == username)
-            {
-                // Attempt to kill the process
-                if (kill(pid, SIGKILL) == 0)
-                {
-                    std::cout << "Killed process " << pid << " (User: " << username << ")\n";
-                    anyKilled = true;
-                    successCount++;
-                }
-                else
-                {
-                    std::cerr << "Failed to kill process " << pid << ": ";
-                    switch (errno)
-                    {
-                    case ESRCH:
-                        std::cerr << "Process does not exist.\n";
-                        break;
-                    case EPERM:
-                        std::cerr << "Insufficient permissions.\n";
-                        break;
-                    default:
-                        perror("Error");
-                        break;
-                    }
-                    failureCount++;
-                }
-            }
-        }
+        printKillResult(result, "User: " + username);
     }
 
     // Provide a summary of the termination attempts
-    if (!anyKilled)
+    if (report.killed() == 0)
     {
         std::cout << "No processes found for user: " << username << "\n";
     }
     else
     {
-        std::cout << "Summary: " << successCount << " processes killed, " << failureCount << " failed.\n";
+        std::cout << "Summary: " << report.killed() << " processes killed, " << report.failed() << " failed.\n";
+    }
+    return report;
+}
+
+std::vector<KillTarget> selectProcessTree(int pid)
+{
+    ProcessTree tree;
+    scanProcessTree(tree);
+
+    std::vector<KillTarget> targets;
+    for (const Process& process : tree.subtree(pid))
+    {
+        targets.push_back(KillTarget{process.pid, process.startTime});
+    }
+    return targets;
+}
+
+KillReport killProcessTree(int pid)
+{
+    KillReport report = signalProcesses(selectProcessTree(pid));
+    for (const KillResult& result : report.results)
+    {
+        printKillResult(result, "Tree of PID: " + std::to_string(pid));
     }
 
-    return anyKilled;
+    // Provide a summary of the termination attempts
+    if (report.results.empty())
+    {
+        std::cout << "No process found with PID: " << pid << "\n";
+    }
+    else
+    {
+        std::cout << "Summary: " << report.killed() << " processes killed, " << report.failed() << " failed.\n";
+    }
+    return report;
 }
@@ -7,12 +7,17 @@
  * color-coding based on CPU usage to enhance readability and highlights critical information
  * about each process, such as PID, user, CPU usage, memory usage, and the associated command.
  * The function ensures that the output remains organized and does not overwhelm the user by
- * limiting the display to a maximum of 30 processes at a time.
+ * limiting the display to the rows that fit on the terminal (30 when printing to the console).
+ * Tables are composed into a FrameBuffer with `std::to_chars` and written with a single system call.
  */
 
 #include "process_display.h"
-#include <iomanip>
+#include "globals.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <mutex>
+#include <unistd.h>
 
 /**
  * @def RESET
@@ -38,53 +43,223 @@
  */
 #define GREEN "\033[32m"
 
+namespace
+{
+
+// Column at which the command starts (PID, user, CPU and memory fields with their separators)
+const int kCommandColumn = 59;
+
+// Column at which the path starts in the cgroup table (PIDs, CPU and memory fields with their separators)
+const int kCgroupPathColumn = 42;
+
+// Narrowest command column, used when the table is wider than the terminal anyway
+const int kMinCommandWidth = 8;
+
+// Rows above the first process row (header and separator)
+const int kHeaderRows = 2;
+
+// Returns the width of the command column of a table `width` columns wide
+size_t commandWidth(int width)
+{
+    return static_cast<size_t>(std::max(width - kCommandColumn, kMinCommandWidth));
+}
+
+// Returns the number of leading bytes of `command` to show before "..." in `width` columns, or
+// `command.size()` if it fits
+size_t visibleCommandLength(const std::string& command, size_t width)
+{
+    return command.size() > width ? width - 3 : command.size();
+}
+
+// Returns the color escape sequence for a CPU usage: red (high), yellow (moderate) or green (low)
+const char* cpuColor(double cpuUsage)
+{
+    if (cpuUsage > 20.0)
+        return RED;
+    if (cpuUsage > 10.0)
+        return YELLOW;
+    return GREEN;
+}
+
+// Formats `value` with two decimals into `buffer`, left-aligned in `width` characters ("%-*.2f")
+size_t formatFixed(char* buffer, size_t size, double value, size_t width)
+{
+    auto result = std::to_chars(buffer, buffer + size, value, std::chars_format::fixed, 2);
+    size_t length = result.ec == std::errc() ? static_cast<size_t>(result.ptr - buffer) : 0;
+    while (length < width && length < size)
+    {
+        buffer[length++] = ' ';
+    }
+    return length;
+}
+
+// Writes text at `column` and returns the column following a field of at least `width` cells
+int putField(ScreenRenderer& screen, int row, int column, const char* text, size_t length, size_t width,
+             ScreenColor color = ScreenColor::FG_DEFAULT)
+{
+    int end = screen.put(row, column, text, length, color);
+    return std::max(end, column + static_cast<int>(width));
+}
+
+} // namespace
+
 void printProcesses(const std::vector<Process>& processes)
 {
-    // Print the table header with column names
-    std::cout << std::setw(8) << "PID"
-              << " | " << std::left << std::setw(14) << "User"
-              << " | " << std::setw(9) << "CPU (%)"
-              << " | " << std::setw(16) << "Memory (MB)"
-              << " | "
-              << "Command" << std::endl;
-
-    // Print a separator line to distinguish the header from the process entries
-    std::cout << std::string(100, '=') << std::endl;
-
-    int count = 0; // Counter to limit the number of displayed processes
+    // One buffer and one write per table, so the rows are not interleaved with other output
+    int rows = 0, width = kDefaultTableWidth;
+    queryTerminalSize(STDOUT_FILENO, rows, width);
+
+    std::lock_guard<std::mutex> lock(coutMutex);
+    static FrameBuffer frame;
+    frame.clear();
+    formatProcessTable(processes, frame, kDefaultTableRows, width);
+    std::cout.flush(); // Anything already streamed to std::cout comes first
+    frame.writeTo(STDOUT_FILENO);
+}
+
+void printProcesses(const std::vector<Process>& processes, std::ostream& out)
+{
+    FrameBuffer frame(4096); // A full table is about 2.5 kB
+    formatProcessTable(processes, frame);
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+}
+
+void formatProcessTable(const std::vector<Process>& processes, FrameBuffer& out, size_t maxRows, int width,
+                        bool color)
+{
+    // Print the table header with column names and a separator line
+    out.append("PID      | User           | CPU (%)   | Memory (MB)      | Command\n");
+    out.append(static_cast<size_t>(std::max(width, 1)), '=');
+    out.append(1, '\n');
+
+    const size_t maxCommand = commandWidth(width);
+    size_t count = 0; // Counter to limit the number of displayed processes
     for (const auto& process : processes)
     {
-        if (count >= 30)
-            break; // Limit the display to the first 30 processes
+        if (count >= maxRows)
+            break; // Limit the display to the rows that fit
+
+        out.appendInt(process.pid, 8);
+        out.append(" | ");
+        out.appendPadded(process.user, 14);
+        out.append(" | ");
+        if (color)
+            out.append(cpuColor(process.cpuUsage));
+        out.appendFixed(process.cpuUsage, 2, 8);
+        out.append(color ? "%" RESET " | " : "% | ");
+        out.appendFixed(process.memoryUsage, 2, 13);
+        out.append(" MB | ");
+
+        // Truncate the command string if it exceeds the command column to maintain table alignment
+        size_t visible = visibleCommandLength(process.command, maxCommand);
+        out.append(process.command.data(), visible);
+        if (visible < process.command.size())
+        {
+            out.append("...");
+        }
+        out.append(1, '\n');
+
+        count++; // Increment the counter after displaying a process
+    }
+}
+
+void composeProcessTable(const std::vector<Process>& processes, ScreenRenderer& screen)
+{
+    char buffer[64];
+
+    // Header and separator, laid out like printProcesses()
+    screen.put(0, 0, "PID      | User           | CPU (%)   | Memory (MB)      | Command");
+    screen.put(1, 0, std::string(screen.columns(), '='));
+
+    const size_t maxCommand = commandWidth(screen.columns());
+    int row = kHeaderRows;
+    for (const auto& process : processes)
+    {
+        if (row >= screen.rows())
+            break; // Limit the display to the rows that fit
 
         // Determine the color based on CPU usage
-        std::string color;
+        ScreenColor color = ScreenColor::FG_GREEN;
         if (process.cpuUsage > 20.0)
         {
-            color = RED; // High CPU usage
+            color = ScreenColor::FG_RED; // High CPU usage
         }
         else if (process.cpuUsage > 10.0)
         {
-            color = YELLOW; // Moderate CPU usage
-        }
-        else
-        {
-            color = GREEN; // Low CPU usage
+            color = ScreenColor::FG_YELLOW; // Moderate CPU usage
         }
 
-        // Truncate the command string if it exceeds 35 characters to maintain table alignment
-        std::string command = process.command;
-        if (command.length() > 35)
+        char* end = std::to_chars(buffer, buffer + sizeof(buffer), process.pid).ptr;
+        int column = putField(screen, row, 0, buffer, end - buffer, 8);
+        column = screen.put(row, column, " | ", 3);
+        column = putField(screen, row, column, process.user.data(), process.user.size(), 14);
+        column = screen.put(row, column, " | ", 3);
+        size_t length = formatFixed(buffer, sizeof(buffer) - 1, process.cpuUsage, 8);
+        buffer[length++] = '%';
+        column = screen.put(row, column, buffer, length, color);
+        column = screen.put(row, column, " | ", 3);
+        length = formatFixed(buffer, sizeof(buffer), process.memoryUsage, 13);
+        column = screen.put(row, column, buffer, length);
+        column = screen.put(row, column, " MB | ", 6);
+
+        // Truncate the command string if it exceeds the command column to maintain table alignment
+        size_t visible = visibleCommandLength(process.command, maxCommand);
+        column = screen.put(row, column, process.command.data(), visible);
+        if (visible < process.command.size())
         {
-            command = command.substr(0, 32) + "...";
+            column = screen.put(row, column, "...", 3);
         }
+        row++;
+    }
+}
+
+size_t tableRowsFor(const ScreenRenderer& screen)
+{
+    return static_cast<size_t>(std::max(screen.rows() - kHeaderRows, 0));
+}
 
-        // Print the process information row with appropriate formatting and color-coding
-        std::cout << std::setw(8) << process.pid << " | " << std::left << std::setw(14) << process.user << " | "
-                  << color << std::setw(8) << std::fixed << std::setprecision(2) << process.cpuUsage << "%" << RESET
-                  << " | " << std::setw(13) << std::fixed << std::setprecision(2) << process.memoryUsage << " MB | "
-                  << command << std::endl;
+void printCgroups(const std::vector<CgroupUsage>& cgroups, size_t maxRows)
+{
+    int rows = 0, width = kDefaultTableWidth;
+    queryTerminalSize(STDOUT_FILENO, rows, width);
 
-        count++; // Increment the counter after displaying a process
+    std::lock_guard<std::mutex> lock(coutMutex);
+    FrameBuffer frame(4096);
+    formatCgroupTable(cgroups, frame, maxRows, width);
+    std::cout.flush(); // Anything already streamed to std::cout comes first
+    frame.writeTo(STDOUT_FILENO);
+}
+
+void formatCgroupTable(const std::vector<CgroupUsage>& cgroups, FrameBuffer& out, size_t maxRows, int width,
+                       bool color)
+{
+    // The path takes the place of the command, and the number of processes that of the user
+    out.append("PIDs     | CPU (%)   | Memory (MB)      | Cgroup\n");
+    out.append(static_cast<size_t>(std::max(width, 1)), '=');
+    out.append(1, '\n');
+
+    const size_t maxPath = commandWidth(width + kCommandColumn - kCgroupPathColumn);
+    size_t count = 0;
+    for (const auto& cgroup : cgroups)
+    {
+        if (count++ >= maxRows)
+            break;
+
+        out.appendInt(static_cast<long long>(cgroup.pids), 8);
+        out.append(" | ");
+        if (color)
+            out.append(cpuColor(cgroup.cpuUsage));
+        out.appendFixed(cgroup.cpuUsage, 2, 8);
+        out.append(color ? "%" RESET " | " : "% | ");
+        out.appendFixed(cgroup.memoryUsage, 2, 13);
+        out.append(" MB | ");
+
+        size_t visible = visibleCommandLength(cgroup.path, maxPath);
+        out.append(cgroup.path.data(), visible);
+        if (visible < cgroup.path.size())
+        {
+            out.append("...");
+        }
+        out.append(1, '\n');
     }
 }
@@ -0,0 +1,290 @@
+/**
+ * @file process_history.cpp
+ * @brief Implements the fixed-budget per-process history.
+ *
+ * This source file contains the implementation of the ProcessHistory class. The slab and every
+ * per-ring array are sized once from the memory budget; recording an epoch only writes samples and
+ * relinks rings in an intrusive LRU list (index-based, so no allocation happens while sampling
+ * apart from the PID lookup table). Rings are moved to the front of the list when their process
+ * shows activity, so exited and idle processes naturally drift to the back where they are evicted.
+ */
+
+#include "process_history.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// Bookkeeping per ring besides its samples: six 32-bit arrays plus an estimate of a hash map node
+const size_t kPerSlotOverhead = 6 * sizeof(uint32_t) + 32;
+
+// Number of rings inspected from the back of the LRU list when looking for an exited process
+const int kEvictionScan = 16;
+
+// A process is active if it used some CPU or its memory changed since the previous sample
+bool isActive(const HistorySample& previous, const HistorySample& current)
+{
+    return current.cpuUsage > 0.05f || std::fabs(current.memoryUsage - previous.memoryUsage) > 0.01f;
+}
+
+} // namespace
+
+ProcessHistory::ProcessHistory(size_t budgetBytes, size_t window)
+{
+    configure(budgetBytes, window);
+}
+
+void ProcessHistory::configure(size_t budgetBytes, size_t window)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = budgetBytes;
+    m_window = std::max<size_t>(window, 1);
+    m_slots = budgetBytes / (m_window * sizeof(HistorySample) + kPerSlotOverhead);
+
+    // Preallocate everything once; shrink_to_fit releases the previous configuration's memory
+    m_slab.assign(m_slots * m_window, HistorySample{0.0f, 0.0f});
+    m_slab.shrink_to_fit();
+    m_slotPid.assign(m_slots, 0);
+    m_head.assign(m_slots, 0);
+    m_count.assign(m_slots, 0);
+    m_lastEpoch.assign(m_slots, 0);
+    m_prev.assign(m_slots, kNone);
+    m_next.assign(m_slots, kNone);
+    m_pidToSlot.clear();
+    m_pidToSlot.reserve(m_slots);
+    m_evictions = 0;
+    resetLocked();
+}
+
+void ProcessHistory::resetLocked()
+{
+    m_lruHead = kNone;
+    m_lruTail = kNone;
+    m_used = 0;
+    m_epoch = 0;
+}
+
+void ProcessHistory::recordEpoch(const std::vector<HistoryUpdate>& updates)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_slots == 0)
+    {
+        return; // Budget too small for a single ring
+    }
+    m_epoch++;
+
+    // Mark every known process as alive first, so eviction below only picks processes not in this epoch
+    for (const auto& update : updates)
+    {
+        auto it = m_pidToSlot.find(update.pid);
+        if (it != m_pidToSlot.end())
+        {
+            m_lastEpoch[it->second] = m_epoch;
+        }
+    }
+
+    for (const auto& update : updates)
+    {
+        HistorySample sample{static_cast<float>(update.cpuUsage), static_cast<float>(update.memoryUsage)};
+
+        uint32_t slot;
+        bool active;
+        auto it = m_pidToSlot.find(update.pid);
+        if (it != m_pidToSlot.end())
+        {
+            slot = it->second;
+            uint32_t last = (m_head[slot] + m_window - 1) % m_window;
+            active = isActive(m_slab[slot * m_window + last], sample);
+        }
+        else
+        {
+            slot = acquireSlotLocked();
+            m_slotPid[slot] = update.pid;
+            m_head[slot] = 0;
+            m_count[slot] = 0;
+            m_lastEpoch[slot] = m_epoch;
+            m_pidToSlot[update.pid] = slot;
+            active = true; // New processes start at the front of the LRU list
+        }
+
+        m_slab[slot * m_window + m_head[slot]] = sample;
+        m_head[slot] = (m_head[slot] + 1) % m_window;
+        m_count[slot] = std::min<uint32_t>(m_count[slot] + 1, static_cast<uint32_t>(m_window));
+
+        if (active && m_lruHead != slot)
+        {
+            unlinkLocked(slot);
+            pushFrontLocked(slot);
+        }
+    }
+}
+
+uint32_t ProcessHistory::acquireSlotLocked()
+{
+    if (m_used < m_slots)
+    {
+        uint32_t slot = m_used++;
+        m_prev[slot] = kNone;
+        m_next[slot] = kNone;
+        pushFrontLocked(slot); // Link it so unlinkLocked() can be used uniformly
+        return slot;
+    }
+
+    // Prefer the least recently active ring whose process was not seen in this epoch (it exited)
+    uint32_t victim = m_lruTail;
+    uint32_t candidate = m_lruTail;
+    for (int i = 0; i < kEvictionScan && candidate != kNone; ++i)
+    {
+        if (m_lastEpoch[candidate] != m_epoch)
+        {
+            victim = candidate;
+            break;
+        }
+        candidate = m_prev[candidate];
+    }
+
+    m_pidToSlot.erase(m_slotPid[victim]);
+    m_evictions++;
+    return victim;
+}
+
+void ProcessHistory::unlinkLocked(uint32_t slot)
+{
+    if (m_prev[slot] != kNone)
+        m_next[m_prev[slot]] = m_next[slot];
+    else if (m_lruHead == slot)
+        m_lruHead = m_next[slot];
+
+    if (m_next[slot] != kNone)
+        m_prev[m_next[slot]] = m_prev[slot];
+    else if (m_lruTail == slot)
+        m_lruTail = m_prev[slot];
+
+    m_prev[slot] = kNone;
+    m_next[slot] = kNone;
+}
+
+void ProcessHistory::pushFrontLocked(uint32_t slot)
+{
+    m_prev[slot] = kNone;
+    m_next[slot] = m_lruHead;
+    if (m_lruHead != kNone)
+        m_prev[m_lruHead] = slot;
+    m_lruHead = slot;
+    if (m_lruTail == kNone)
+        m_lruTail = slot;
+}
+
+bool ProcessHistory::samples(int pid, std::vector<HistorySample>& out) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.clear();
+    auto it = m_pidToSlot.find(pid);
+    if (it == m_pidToSlot.end())
+    {
+        return false;
+    }
+
+    uint32_t slot = it->second;
+    uint32_t count = m_count[slot];
+    uint32_t first = (m_head[slot] + m_window - count) % m_window;
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        out.push_back(m_slab[slot * m_window + (first + i) % m_window]);
+    }
+    return true;
+}
+
+size_t ProcessHistory::trackedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pidToSlot.size();
+}
+
+size_t ProcessHistory::capacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_slots;
+}
+
+size_t ProcessHistory::window() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_window;
+}
+
+size_t ProcessHistory::budgetBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budgetBytes;
+}
+
+uint64_t ProcessHistory::evictions() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evictions;
+}
+
+HistoryStats ProcessHistory::computeStats(const std::vector<double>& values)
+{
+    HistoryStats stats;
+    if (values.empty())
+    {
+        return stats;
+    }
+
+    stats.count = values.size();
+    stats.min = *std::min_element(values.begin(), values.end());
+    stats.max = *std::max_element(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    stats.avg = sum / values.size();
+
+    // Nearest-rank percentile: the smallest value with at least 95% of the samples at or below it
+    std::vector<double> sorted(values);
+    size_t rank = static_cast<size_t>(std::ceil(0.95 * sorted.size()));
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    stats.p95 = sorted[index];
+    return stats;
+}
+
+std::string ProcessHistory::sparkline(const std::vector<double>& values, size_t width)
+{
+    static const char* const levels[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    if (values.empty() || width == 0)
+    {
+        return std::string();
+    }
+
+    // Average consecutive samples into at most `width` buckets
+    size_t buckets = std::min(width, values.size());
+    std::vector<double> points(buckets, 0.0);
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        size_t begin = b * values.size() / buckets;
+        size_t end = (b + 1) * values.size() / buckets;
+        double sum = 0.0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            sum += values[i];
+        }
+        points[b] = sum / (end - begin);
+    }
+
+    double low = *std::min_element(points.begin(), points.end());
+    double high = *std::max_element(points.begin(), points.end());
+    std::string line;
+    line.reserve(buckets * 3);
+    for (double point : points)
+    {
+        int level = high > low ? static_cast<int>((point - low) / (high - low) * 7.0 + 0.5) : 0;
+        line += levels[std::clamp(level, 0, 7)];
+    }
+    return line;
+}
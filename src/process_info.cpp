@@ -6,11 +6,12 @@
  * about active processes on the system. It includes methods to retrieve the user
  * owning a process, the command associated with a process, and the memory usage of
  * a process. Additionally, it provides functionality to list all active processes
- * by scanning the `/proc` filesystem. Thread safety is maintained through the use
- * of mutexes when accessing shared data structures.
+ * by scanning the `/proc` filesystem, or the directory configured in `procRoot`. Thread
+ * safety is maintained through the use of mutexes when accessing shared data structures.
  */
 
 #include "process_info.h"
+#include "globals.h"
 #include "utils.h"
 #include <cctype>
 #include <dirent.h>
@@ -25,7 +26,7 @@
 std::string getProcessUser(int pid)
 {
     // Open the /proc/[pid]/status file to read process information
-    std::ifstream statusFile("/proc/" + std::to_string(pid) + "/status");
+    std::ifstream statusFile(procFilePath(pid, "status"));
     if (!statusFile.is_open())
     {
         return "Unknown"; // Return "Unknown" if the file cannot be opened
@@ -50,7 +51,7 @@ std::string getProcessUser(int pid)
 std::string getProcessCommand(int pid)
 {
     // Open the /proc/[pid]/comm file to read the command name
-    std::ifstream commFile("/proc/" + std::to_string(pid) + "/comm");
+    std::ifstream commFile(procFilePath(pid, "comm"));
     if (!commFile.is_open())
     {
         return "Unknown"; // Return "Unknown" if the file cannot be opened
@@ -64,7 +65,7 @@ std::string getProcessCommand(int pid)
 double getProcessMemoryUsage(int pid)
 {
     // Open the /proc/[pid]/status file to read memory information
-    std::ifstream statusFile("/proc/" + std::to_string(pid) + "/status");
+    std::ifstream statusFile(procFilePath(pid, "status"));
     if (!statusFile.is_open())
     {
         return 0.0; // Return 0.0 if the file cannot be opened
@@ -85,16 +86,38 @@ double getProcessMemoryUsage(int pid)
     return 0.0; // Return 0.0 if VmRSS is not found
 }
 
+// Reads field 22 of /proc/[pid]/stat, counting from the end of the command name, which may hold
+// spaces and parentheses
+bool readProcessStartTime(int pid, unsigned long long& startTime)
+{
+    std::ifstream statFile(procFilePath(pid, "stat"));
+    std::string line;
+    if (!std::getline(statFile, line))
+    {
+        return false;
+    }
+    size_t end = line.rfind(')');
+    if (end == std::string::npos)
+    {
+        return false;
+    }
+    std::istringstream ss(line.substr(end + 1));
+    std::string ignored;
+    for (int field = 3; field < 22; ++field) // State (3) to itrealvalue (21)
+        ss >> ignored;
+    return static_cast<bool>(ss >> startTime);
+}
+
 // Function to retrieve a list of all active processes
 std::vector<Process> getActiveProcesses()
 {
     std::vector<Process> processes; // Vector to store active processes
 
-    // Open the /proc directory to scan for process directories
-    DIR* dir = opendir("/proc");
+    // Open the /proc directory (or the configured proc root) to scan for process directories
+    DIR* dir = opendir(procRoot.c_str());
     if (dir == nullptr)
     {
-        std::cerr << "Cannot open /proc directory" << std::endl;
+        std::cerr << "Cannot open " << procRoot << " directory" << std::endl;
         return processes; // Return empty vector if /proc cannot be opened
     }
 
@@ -120,3 +143,26 @@ std::vector<Process> getActiveProcesses()
     closedir(dir);    // Close the /proc directory
     return processes; // Return the list of active processes
 }
+
+std::vector<int> getProcessIds()
+{
+    std::vector<int> pids;
+    DIR* dir = opendir(procRoot.c_str());
+    if (dir == nullptr)
+    {
+        std::cerr << "Cannot open " << procRoot << " directory" << std::endl;
+        return pids;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (isdigit(entry->d_name[0]))
+        {
+            pids.push_back(std::stoi(entry->d_name));
+        }
+    }
+
+    closedir(dir);
+    return pids;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file process_snapshot.cpp
+ * @brief Implements snapshot publication and interpolation.
+ *
+ * This source file contains the implementation of the SnapshotPublisher class and of the helpers
+ * building and interpolating snapshots. Both snapshots are sorted by PID, so interpolation is a
+ * single merge pass.
+ */
+
+#include "process_snapshot.h"
+#include <algorithm>
+#include <chrono>
+
+void SnapshotPublisher::publish(std::shared_ptr<const ProcessSnapshot> snapshot)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_latest.swap(snapshot); // The previous snapshot is released outside the lock
+}
+
+std::shared_ptr<const ProcessSnapshot> SnapshotPublisher::latest() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latest;
+}
+
+void SnapshotPublisher::reset()
+{
+    publish(nullptr);
+}
+
+std::shared_ptr<const ProcessSnapshot> makeSnapshot(std::vector<Process> processes, int64_t timestampMs,
+                                                    bool continuous)
+{
+    std::sort(processes.begin(), processes.end(), [](const Process& a, const Process& b) { return a.pid < b.pid; });
+    auto snapshot = std::make_shared<ProcessSnapshot>();
+    snapshot->timestampMs = timestampMs;
+    snapshot->continuous = continuous;
+    snapshot->processes = std::move(processes);
+    return snapshot;
+}
+
+void interpolateSnapshots(const ProcessSnapshot& previous, const ProcessSnapshot& latest, double fraction,
+                          std::vector<Process>& out)
+{
+    fraction = std::clamp(fraction, 0.0, 1.0);
+    out = latest.processes;
+
+    auto before = previous.processes.begin();
+    for (auto& process : out)
+    {
+        while (before != previous.processes.end() && before->pid < process.pid)
+        {
+            ++before; // Exited process
+        }
+        // A reused PID runs another program, whose values are not interpolated
+        if (before != previous.processes.end() && before->pid == process.pid && before->command == process.command)
+        {
+            process.cpuUsage = before->cpuUsage + (process.cpuUsage - before->cpuUsage) * fraction;
+            process.memoryUsage = before->memoryUsage + (process.memoryUsage - before->memoryUsage) * fraction;
+        }
+    }
+}
+
+int64_t steadyNowMs()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
@@ -0,0 +1,329 @@
+/**
+ * @file process_tree.cpp
+ * @brief Implements the incrementally maintained process tree.
+ *
+ * Children are kept in intrusive doubly-linked lists (first child, previous and next sibling), so
+ * moving a process under another parent is O(1) besides updating the sums of the ancestors. The
+ * roots form a list of their own through the same sibling fields. Trees are walked with explicit
+ * stacks: a chain of thousands of forked processes must not overflow the thread's stack.
+ */
+
+#include "process_tree.h"
+#include "resource_monitor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+
+// Indentation of one level of the tree in the command column
+const char kIndent[] = "  ";
+
+// Marker written before the command of a child, as in `ps f`
+const char kChildMarker[] = "\\_ ";
+
+// Fixed-point values of a sample: hundredths of a percent and kB
+int64_t cpuUnits(double cpuUsage)
+{
+    return std::llround(cpuUsage * 100.0);
+}
+
+int64_t memoryUnits(double memoryUsage)
+{
+    return std::llround(memoryUsage * 1024.0);
+}
+
+} // namespace
+
+ProcessTree::ProcessTree() : m_firstRoot(0), m_epoch(0)
+{
+}
+
+void ProcessTree::update(const std::vector<Process>& epoch)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_epoch;
+
+    // Refresh the processes that are known and add the new ones as roots. Those that appeared,
+    // changed parent or wait for a parent that was missing are linked once all are present.
+    std::vector<int> relink;
+    size_t seen = 0;
+    for (const Process& process : epoch)
+    {
+        auto it = m_nodes.find(process.pid);
+        if (it != m_nodes.end() && it->second.seen == m_epoch)
+        {
+            continue; // Listed twice
+        }
+        if (it != m_nodes.end() && process.startTime != 0 && it->second.process.startTime != 0 &&
+            process.startTime != it->second.process.startTime)
+        {
+            remove(process.pid); // The PID was reused by a new process
+            it = m_nodes.end();
+        }
+
+        int64_t cpu = cpuUnits(process.cpuUsage);
+        int64_t memory = memoryUnits(process.memoryUsage);
+        if (it == m_nodes.end())
+        {
+            Node& node = m_nodes[process.pid];
+            node.process = process;
+            node.cpu = node.subtreeCpu = cpu;
+            node.memory = node.subtreeMemory = memory;
+            node.seen = m_epoch;
+            link(process.pid, 0);
+            relink.push_back(process.pid);
+            ++seen;
+            continue;
+        }
+
+        Node& node = it->second;
+        if (cpu != node.cpu || memory != node.memory)
+        {
+            addToAncestors(process.pid, cpu - node.cpu, memory - node.memory, 0);
+            node.cpu = cpu;
+            node.memory = memory;
+        }
+        if (process.ppid != node.process.ppid || (node.parent == 0 && process.ppid != 0))
+        {
+            relink.push_back(process.pid);
+        }
+        node.process = process;
+        node.seen = m_epoch;
+        ++seen;
+    }
+
+    // Processes missing from the epoch have exited; nothing to look for if every known one was seen
+    if (m_nodes.size() > seen)
+    {
+        std::vector<int> exited;
+        for (const auto& entry : m_nodes)
+        {
+            if (entry.second.seen != m_epoch)
+                exited.push_back(entry.first);
+        }
+        for (int pid : exited)
+        {
+            remove(pid);
+        }
+    }
+
+    for (int pid : relink)
+    {
+        auto it = m_nodes.find(pid);
+        if (it == m_nodes.end())
+            continue;
+        int ppid = it->second.process.ppid;
+        int parent = ppid != pid && m_nodes.count(ppid) != 0 && !isAncestor(pid, ppid) ? ppid : 0;
+        if (parent != it->second.parent)
+        {
+            unlink(pid);
+            link(pid, parent);
+        }
+    }
+}
+
+void ProcessTree::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.clear();
+    m_firstRoot = 0;
+}
+
+size_t ProcessTree::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nodes.size();
+}
+
+bool ProcessTree::subtreeUsage(int pid, double& cpuUsage, double& memoryUsage, size_t& count) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_nodes.find(pid);
+    if (it == m_nodes.end())
+    {
+        return false;
+    }
+    cpuUsage = it->second.subtreeCpu / 100.0;
+    memoryUsage = it->second.subtreeMemory / 1024.0;
+    count = static_cast<size_t>(it->second.subtreeCount);
+    return true;
+}
+
+std::vector<Process> ProcessTree::subtree(int pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Process> out;
+    if (m_nodes.count(pid) != 0)
+    {
+        appendSubtree(pid, out);
+    }
+    return out;
+}
+
+void ProcessTree::layout(const std::string& criterion, const std::pair<std::string, std::string>& filter,
+                         size_t limit, std::vector<Process>& rows) const
+{
+    rows.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    bool byCpu = criterion == "cpu";
+    bool byMemory = criterion == "memory";
+    auto ranksHigher = [&](const Node* a, const Node* b) {
+        if (byCpu && a->subtreeCpu != b->subtreeCpu)
+            return a->subtreeCpu > b->subtreeCpu;
+        if (byMemory && a->subtreeMemory != b->subtreeMemory)
+            return a->subtreeMemory > b->subtreeMemory;
+        return a->process.pid < b->process.pid;
+    };
+
+    // Subtrees at or below a numeric threshold are pruned, like the processes of the flat view
+    int64_t cpuThreshold = INT64_MIN, memoryThreshold = INT64_MIN;
+    if (filter.first == "cpu")
+        cpuThreshold = cpuUnits(std::atof(filter.second.c_str()));
+    else if (filter.first == "memory")
+        memoryThreshold = memoryUnits(std::atof(filter.second.c_str()));
+    bool byUser = filter.first == "user";
+
+    // Siblings of each level, sorted, consumed from the back
+    std::vector<std::pair<const Node*, int>> stack; // Node, depth
+    std::vector<const Node*> siblings;
+    auto pushSorted = [&](int first, int depth) {
+        siblings.clear();
+        for (int pid = first; pid != 0; pid = m_nodes.at(pid).nextSibling)
+        {
+            const Node& node = m_nodes.at(pid);
+            if (node.subtreeCpu > cpuThreshold && node.subtreeMemory > memoryThreshold)
+                siblings.push_back(&node);
+        }
+        std::sort(siblings.begin(), siblings.end(), ranksHigher);
+        for (auto it = siblings.rbegin(); it != siblings.rend(); ++it)
+            stack.emplace_back(*it, depth);
+    };
+
+    pushSorted(m_firstRoot, 0);
+    while (!stack.empty() && rows.size() < limit)
+    {
+        const Node* node = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
+        if (!byUser || node->process.user == filter.second)
+        {
+            Process row = node->process;
+            row.cpuUsage = node->subtreeCpu / 100.0;
+            row.memoryUsage = node->subtreeMemory / 1024.0;
+            if (depth > 0)
+            {
+                std::string command;
+                command.reserve(2 * depth + 3 + row.command.size());
+                for (int level = 1; level < depth; ++level)
+                    command += kIndent;
+                command += kChildMarker;
+                command += row.command;
+                row.command = std::move(command);
+            }
+            rows.push_back(std::move(row));
+        }
+        pushSorted(node->firstChild, depth + 1);
+    }
+}
+
+void ProcessTree::addToAncestors(int pid, int64_t cpu, int64_t memory, int64_t count)
+{
+    for (int current = pid; current != 0;)
+    {
+        Node& node = m_nodes.at(current);
+        node.subtreeCpu += cpu;
+        node.subtreeMemory += memory;
+        node.subtreeCount += count;
+        current = node.parent;
+    }
+}
+
+// Links a node that is in no list at the head of the children of `parent` (or of the roots)
+void ProcessTree::link(int pid, int parent)
+{
+    Node& node = m_nodes.at(pid);
+    int& head = parent == 0 ? m_firstRoot : m_nodes.at(parent).firstChild;
+    node.parent = parent;
+    node.previousSibling = 0;
+    node.nextSibling = head;
+    if (head != 0)
+        m_nodes.at(head).previousSibling = pid;
+    head = pid;
+    if (parent != 0)
+        addToAncestors(parent, node.subtreeCpu, node.subtreeMemory, node.subtreeCount);
+}
+
+// Takes a node and its subtree out of the children of its parent (or of the roots)
+void ProcessTree::unlink(int pid)
+{
+    Node& node = m_nodes.at(pid);
+    if (node.parent != 0)
+        addToAncestors(node.parent, -node.subtreeCpu, -node.subtreeMemory, -node.subtreeCount);
+    if (node.previousSibling != 0)
+        m_nodes.at(node.previousSibling).nextSibling = node.nextSibling;
+    else if (node.parent != 0)
+        m_nodes.at(node.parent).firstChild = node.nextSibling;
+    else
+        m_firstRoot = node.nextSibling;
+    if (node.nextSibling != 0)
+        m_nodes.at(node.nextSibling).previousSibling = node.previousSibling;
+    node.parent = node.previousSibling = node.nextSibling = 0;
+}
+
+// Removes a process; its children become roots
+void ProcessTree::remove(int pid)
+{
+    Node& node = m_nodes.at(pid);
+    while (node.firstChild != 0)
+    {
+        int child = node.firstChild;
+        unlink(child);
+        link(child, 0);
+    }
+    unlink(pid);
+    m_nodes.erase(pid);
+}
+
+// Returns true if `ancestor` is `pid` or one of the processes above it
+bool ProcessTree::isAncestor(int ancestor, int pid) const
+{
+    for (int current = pid; current != 0; current = m_nodes.at(current).parent)
+    {
+        if (current == ancestor)
+            return true;
+    }
+    return false;
+}
+
+void ProcessTree::appendSubtree(int pid, std::vector<Process>& out) const
+{
+    std::vector<int> stack = {pid};
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes.at(stack.back());
+        stack.pop_back();
+        out.push_back(node.process);
+        for (int child = node.firstChild; child != 0; child = m_nodes.at(child).nextSibling)
+            stack.push_back(child);
+    }
+}
+
+void scanProcessTree(ProcessTree& tree)
+{
+    std::vector<Process> processes;
+    for (int pid : getProcessIds())
+    {
+        Process process = {};
+        process.pid = pid;
+        getProcessTotalTime(pid, &process.startTime, &process.ppid);
+        if (process.startTime != 0 || process.ppid != 0)
+        {
+            processes.push_back(process); // Otherwise it exited since it was listed
+        }
+    }
+    tree.update(processes);
+}
@@ -11,12 +11,16 @@
 
 #include "resource_monitor.h"
 #include "globals.h"
+#include "log_site.h"
 #include "logger.h" // Include the Logger header
 #include "process_display.h"
 #include "process_info.h" // For getActiveProcesses()
+#include "utils.h"        // For procFilePath()
 #include <algorithm>
 #include <cctype> // For isdigit()
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <fstream>  // For std::ifstream
 #include <iostream> // For std::cout, std::cerr
 #include <sstream>  // For std::stringstream
@@ -28,11 +32,17 @@
 
 long getTotalCpuTime()
 {
-    std::ifstream statFile("/proc/stat");
+    std::string statPath = procRoot + "/stat";
+    static LogSite site("system stat reads");
+    std::ifstream statFile(statPath);
     if (!statFile.is_open())
     {
-        std::cerr << "Failed to open /proc/stat" << std::endl;
-        Logger::getInstance().error("Failed to open /proc/stat file.");
+        // Fails the same way every epoch: report it at a bounded rate
+        if (site.allow())
+        {
+            std::cerr << "Failed to open " << statPath << std::endl;
+            Logger::getInstance().error("Failed to open {} file.", statPath);
+        }
         return 0; // Return a default value
     }
 
@@ -48,27 +58,53 @@ long getTotalCpuTime()
     return user + nice + system + idle + iowait + irq + softirq + steal;
 }
 
-long getProcessTotalTime(int pid)
+long getProcessTotalTime(int pid, unsigned long long* startTime, int* ppid)
 {
-    std::ifstream statFile("/proc/" + std::to_string(pid) + "/stat");
+    static LogSite site("stat reads");
+    if (startTime != nullptr)
+        *startTime = 0;
+    if (ppid != nullptr)
+        *ppid = 0;
+    std::string statPath = procFilePath(pid, "stat");
+    errno = 0;
+    std::ifstream statFile(statPath);
     if (!statFile.is_open())
     {
-        std::string errMsg = "Failed to open /proc/" + std::to_string(pid) + "/stat";
-        std::cerr << errMsg << std::endl;
-        Logger::getInstance().error(errMsg);
+        // A process that exited since it was listed is expected: it is only counted, and the logger
+        // thread writes one summary per interval. Other failures are logged at a bounded rate.
+        int error = errno;
+        site.count(error);
+        if (error != ENOENT && error != ESRCH && site.allow())
+        {
+            Logger::getInstance().error("Failed to open {} of PID {pid}: {}", statPath, pid, std::strerror(error));
+        }
         return 0;
     }
 
     std::string line;
     std::getline(statFile, line); // Read the stat line
-    std::stringstream ss(line);
+
+    // Count fields from the end of the command name, which may hold spaces and parentheses
+    size_t end = line.rfind(')');
+    std::stringstream ss(end == std::string::npos ? line : line.substr(end + 1));
     std::string ignored;
-    long utime, stime, cutime, cstime;
+    int parent = 0;
+    long utime = 0, stime = 0, cutime = 0, cstime = 0;
 
-    // Skip the first 13 fields to reach utime, stime, cutime, cstime
-    for (int i = 0; i < 13; ++i)
+    // Read ppid (4), then skip the fields up to minflt (12) to reach utime, stime, cutime, cstime
+    ss >> ignored >> parent;
+    for (int i = 5; i < 14; ++i)
         ss >> ignored;
     ss >> utime >> stime >> cutime >> cstime;
+    if (ppid != nullptr)
+        *ppid = parent;
+    if (startTime != nullptr)
+    {
+        // Skip priority, nice, num_threads and itrealvalue to reach starttime
+        for (int i = 0; i < 4; ++i)
+            ss >> ignored;
+        ss >> *startTime;
+    }
 
     long totalProcessTime = utime + stime + cutime + cstime;
     return totalProcessTime;
@@ -76,9 +112,12 @@ long getProcessTotalTime(int pid)
 
 double calculateCpuUsage(long processTimeDelta, long totalCpuTimeDelta, long numCores)
 {
+    static LogSite site("CPU usage calculations");
     if (totalCpuTimeDelta == 0)
     {
-        Logger::getInstance().warning("Total CPU time delta is zero, cannot calculate CPU usage.");
+        // Happens for every process of an epoch at once
+        if (site.allow())
+            Logger::getInstance().warning("Total CPU time delta is zero, cannot calculate CPU usage.");
         return 0.0;
     }
 
@@ -86,66 +125,275 @@ double calculateCpuUsage(long processTimeDelta, long totalCpuTimeDelta, long num
     return cpuUsage;
 }
 
-void monitorCpu()
+namespace
 {
-    Logger::getInstance().info("CPU monitoring thread started.");
-    long previousTotalCpuTime = getTotalCpuTime();
 
-    while (monitoringActive.load())
+// Copies the processes of a range of `Process` (or of map pairs, through `get`) that pass the filter
+template <typename Range, typename Get>
+std::vector<Process> filterRange(const Range& range, const std::pair<std::string, std::string>& filter, Get get)
+{
+    std::vector<Process> result;
+    result.reserve(range.size());
+
+    // Parse numeric thresholds once instead of once per process
+    double threshold = 0.0;
+    if (filter.first == "cpu" || filter.first == "memory")
     {
-        // Pause monitoring if the flag is set
-        while (monitoringPaused.load() && monitoringActive.load())
+        threshold = std::stod(filter.second);
+    }
+
+    for (const auto& item : range)
+    {
+        const Process& process = get(item);
+
+        // Apply user-defined filters
+        if (filter.first == "user" && process.user != filter.second)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        if (filter.first == "cpu" && process.cpuUsage <= threshold)
+        {
+            continue;
+        }
+        if (filter.first == "memory" && process.memoryUsage <= threshold)
+        {
+            continue;
         }
 
-        if (!monitoringActive.load())
-            break; // Exit if monitoring is no longer active
+        result.push_back(process);
+    }
+    return result;
+}
 
-        // Sleep for the specified update frequency before the next check
-        std::this_thread::sleep_for(std::chrono::seconds(updateFrequency.load()));
+} // namespace
 
-        long totalCpuTime = getTotalCpuTime();
-        long totalCpuTimeDelta = totalCpuTime - previousTotalCpuTime;
-        previousTotalCpuTime = totalCpuTime;
+std::vector<Process> filterProcesses(const std::unordered_map<int, Process>& processMap,
+                                     const std::pair<std::string, std::string>& filter)
+{
+    return filterRange(processMap, filter, [](const std::pair<const int, Process>& pair) -> const Process& {
+        return pair.second;
+    });
+}
 
-        auto activeProcesses = getActiveProcesses();
+std::vector<Process> filterProcesses(const std::vector<Process>& processList,
+                                     const std::pair<std::string, std::string>& filter)
+{
+    return filterRange(processList, filter, [](const Process& process) -> const Process& { return process; });
+}
+
+void sortProcesses(std::vector<Process>& processList, const std::string& criterion)
+{
+    if (criterion == "cpu")
+    {
+        std::sort(processList.begin(), processList.end(),
+                  [](const Process& a, const Process& b) { return a.cpuUsage > b.cpuUsage; });
+    }
+    else if (criterion == "memory")
+    {
+        std::sort(processList.begin(), processList.end(),
+                  [](const Process& a, const Process& b) { return a.memoryUsage > b.memoryUsage; });
+    }
+}
+
+void sortProcesses(std::vector<Process>& processList, const std::string& criterion, size_t limit)
+{
+    if (limit >= processList.size())
+    {
+        sortProcesses(processList, criterion);
+        return;
+    }
+
+    auto selectTop = [&](auto ranksHigher) {
+        std::nth_element(processList.begin(), processList.begin() + limit, processList.end(), ranksHigher);
+        processList.erase(processList.begin() + limit, processList.end());
+        std::sort(processList.begin(), processList.end(), ranksHigher);
+    };
+    if (criterion == "cpu")
+    {
+        selectTop([](const Process& a, const Process& b) { return a.cpuUsage > b.cpuUsage; });
+    }
+    else if (criterion == "memory")
+    {
+        selectTop([](const Process& a, const Process& b) { return a.memoryUsage > b.memoryUsage; });
+    }
+    else
+    {
+        processList.erase(processList.begin() + limit, processList.end());
+    }
+}
+
+std::shared_ptr<const ProcessSnapshot> sampleEpoch(long& previousTotalCpuTime)
+{
+    long totalCpuTime = getTotalCpuTime();
+    long totalCpuTimeDelta = totalCpuTime - previousTotalCpuTime;
+    previousTotalCpuTime = totalCpuTime;
 
+    auto activeProcesses = getActiveProcesses();
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN); // Reads /sys, so once per epoch rather than per process
+
+    // Copy of this epoch's processes for the display, the session recorder and the history store
+    std::vector<Process> epochSnapshot;
+    epochSnapshot.reserve(activeProcesses.size());
+    std::unordered_set<int> activePids;
+    activePids.reserve(activeProcesses.size());
+
+    {
+        // Lock the processes map to ensure thread-safe updates
+        std::lock_guard<std::mutex> lock(processMutex);
+        for (auto& process : activeProcesses)
         {
-            // Lock the processes map to ensure thread-safe updates
-            std::lock_guard<std::mutex> lock(processMutex);
-            for (auto& process : activeProcesses)
-            {
-                long totalProcessTime = getProcessTotalTime(process.pid);
-                long processTimeDelta = totalProcessTime - processes[process.pid].prevTotalTime;
+            long totalProcessTime = getProcessTotalTime(process.pid, &process.startTime, &process.ppid);
+            long processTimeDelta = totalProcessTime - processes[process.pid].prevTotalTime;
 
-                processes[process.pid] = process; // Update the entire Process struct
-                processes[process.pid].prevTotalTime = totalProcessTime;
-                processes[process.pid].cpuUsage =
-                    calculateCpuUsage(processTimeDelta, totalCpuTimeDelta, sysconf(_SC_NPROCESSORS_ONLN));
-            }
+            processes[process.pid] = process; // Update the entire Process struct
+            processes[process.pid].prevTotalTime = totalProcessTime;
+            processes[process.pid].cpuUsage = calculateCpuUsage(processTimeDelta, totalCpuTimeDelta, cpuCount);
+
+            activePids.insert(process.pid);
+            epochSnapshot.push_back(processes[process.pid]);
+        }
+
+        // Drop processes that exited since the previous epoch so the map does not grow forever
+        for (auto it = processes.begin(); it != processes.end();)
+        {
+            if (activePids.count(it->first) == 0)
+                it = processes.erase(it);
+            else
+                ++it;
         }
     }
 
-    Logger::getInstance().info("CPU monitoring thread stopped.");
+    // Hand the epoch to the display thread, which renders it at its own rate
+    auto snapshot = makeSnapshot(std::move(epochSnapshot), steadyNowMs(), true);
+    processSnapshots.publish(snapshot);
+
+    // Local consumers of the shared-memory export read the same epoch without any system call
+    if (shmExport.isOpen())
+    {
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        shmExport.publish(snapshot->processes, std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    }
+    return snapshot;
 }
 
-void monitorMemory()
+namespace
 {
-    Logger::getInstance().info("Memory monitoring thread started.");
-    while (monitoringActive.load())
+
+// Longest time a waiting monitoring thread goes without checking whether its session still runs,
+// in case the notification of a stop arrived before it started waiting
+const std::chrono::milliseconds kStopPollInterval(200);
+
+// True while the session a monitoring thread was started for runs
+bool sessionCurrent(unsigned generation)
+{
+    return monitoringActive.load() && monitoringGeneration.load() == generation;
+}
+
+// Waits for `intervalMs` milliseconds, or less if the session stops meanwhile. Returns whether it
+// still runs.
+bool waitWhileCurrent(unsigned generation, int intervalMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs);
+    std::unique_lock<std::mutex> lock(cvMutex);
+    while (sessionCurrent(generation) && std::chrono::steady_clock::now() < deadline)
+    {
+        cv.wait_until(lock, std::min(deadline, std::chrono::steady_clock::now() + kStopPollInterval));
+    }
+    return sessionCurrent(generation);
+}
+
+// Waits while monitoring is paused. Returns whether the session still runs.
+bool waitWhilePaused(unsigned generation)
+{
+    while (monitoringPaused.load() && sessionCurrent(generation))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return sessionCurrent(generation);
+}
+
+} // namespace
+
+unsigned beginMonitoring()
+{
+    std::lock_guard<std::mutex> lock(cvMutex);
+    monitoringActive.store(true);
+    return monitoringGeneration.fetch_add(1) + 1;
+}
+
+void primeProcessTimes()
+{
+    std::vector<int> pids = getProcessIds();
+    std::lock_guard<std::mutex> lock(processMutex);
+    for (int pid : pids)
+    {
+        processes[pid].prevTotalTime = getProcessTotalTime(pid, &processes[pid].startTime, &processes[pid].ppid);
+    }
+}
+
+void monitorCpu(unsigned generation)
+{
+    Logger::getInstance().info("CPU monitoring thread started.");
+    long previousTotalCpuTime = getTotalCpuTime();
+    primeProcessTimes(); // The first epoch reports usage over one interval, not since each process started
+
+    while (sessionCurrent(generation))
     {
         // Pause monitoring if the flag is set
-        while (monitoringPaused.load() && monitoringActive.load())
+        if (!waitWhilePaused(generation))
+            break; // Exit if monitoring is no longer active
+
+        // Wait for the sampling interval before the next check; a stop or restart meanwhile ends this thread
+        if (!waitWhileCurrent(generation, sampleIntervalMs.load()))
+            break;
+
+        bool recording = sessionRecorder.isOpen();
+        bool storing = historyStore.isOpen();
+        auto snapshot = sampleEpoch(previousTotalCpuTime);
+
+        // Samples of this epoch for the per-process history
+        std::vector<HistoryUpdate> historyUpdates;
+        historyUpdates.reserve(snapshot->processes.size());
+        for (const auto& process : snapshot->processes)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            historyUpdates.push_back({process.pid, process.cpuUsage, process.memoryUsage});
         }
+        processHistory.recordEpoch(historyUpdates);
+        processTree.update(snapshot->processes);
+
+        // Policies act on processes: never for an epoch sampled after the session was stopped
+        if (!sessionCurrent(generation))
+            break;
+        policyEngine.run(*snapshot, snapshot->timestampMs);
+
+        // Append the epoch to the session file and the history store outside the lock so the display is not delayed
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+        if (recording && !sessionRecorder.append(nowMs, snapshot->processes))
+        {
+            Logger::getInstance().error("Failed to append epoch to session file.");
+        }
+        if (storing && !historyStore.append(nowMs, snapshot->processes))
+        {
+            Logger::getInstance().error("Failed to append epoch to history store.");
+        }
+    }
 
-        if (!monitoringActive.load())
+    Logger::getInstance().info("CPU monitoring thread stopped.");
+}
+
+void monitorMemory(unsigned generation)
+{
+    Logger::getInstance().info("Memory monitoring thread started.");
+    while (sessionCurrent(generation))
+    {
+        // Pause monitoring if the flag is set
+        if (!waitWhilePaused(generation))
             break; // Exit if monitoring is no longer active
 
-        // Sleep for the specified update frequency before the next update
-        std::this_thread::sleep_for(std::chrono::seconds(updateFrequency.load()));
+        // Wait for the sampling interval before the next update; a stop or restart meanwhile ends this thread
+        if (!waitWhileCurrent(generation, sampleIntervalMs.load()))
+            break;
 
         auto activeProcesses = getActiveProcesses();
 
@@ -163,65 +411,221 @@ void monitorMemory()
     Logger::getInstance().info("Memory monitoring thread stopped.");
 }
 
-void monitorProcesses()
+namespace
+{
+
+// Interval at which the display thread checks for terminal resizes while waiting for new data
+const std::chrono::milliseconds kResizePollInterval(200);
+
+// Sizes the display area to the terminal, keeping its last line for the cursor and capping the
+// process rows at `rowLimit` (0 for no limit). Without a terminal the default table size is used.
+void fitScreenToTerminal(ScreenRenderer& screen, int rowLimit)
+{
+    const int headerRows = 2;
+    int rows = 0, columns = kDefaultTableWidth;
+    int areaRows = static_cast<int>(kDefaultTableRows) + headerRows;
+    if (queryTerminalSize(STDOUT_FILENO, rows, columns))
+    {
+        areaRows = rows - 1;
+        if (rowLimit > 0)
+        {
+            areaRows = std::min(areaRows, rowLimit + headerRows);
+        }
+    }
+    else if (rowLimit > 0)
+    {
+        areaRows = rowLimit + headerRows;
+    }
+    screen.resize(std::max(areaRows, headerRows + 1), columns);
+}
+
+} // namespace
+
+void displayProcessTable()
+{
+    // Follow the terminal size and the row limit; resizing the area forces a full repaint
+    static ScreenRenderer screen(static_cast<int>(kDefaultTableRows) + 2, kDefaultTableWidth);
+    static int appliedRowLimit = -1;
+    int rowLimit = displayRowLimit.load();
+    if (terminalResized.exchange(false) || rowLimit != appliedRowLimit)
+    {
+        fitScreenToTerminal(screen, rowLimit);
+        appliedRowLimit = rowLimit;
+    }
+
+    // Render from the latest published snapshot. Between two live epochs the values move from the
+    // previous snapshot to the latest one over the time that separated them.
+    static std::shared_ptr<const ProcessSnapshot> previous, current;
+    auto latest = processSnapshots.latest();
+    if (latest != current)
+    {
+        previous = latest && latest->continuous ? current : nullptr;
+        current = latest;
+    }
+
+    std::vector<Process> processesVector;
+    if (treeView.load())
+    {
+        // Subtree sums change with the epochs only, so the tree is shown without interpolation
+        processTree.layout(sortingCriterion, filterCriterion, tableRowsFor(screen), processesVector);
+    }
+    else if (current && previous)
+    {
+        int64_t span = current->timestampMs - previous->timestampMs;
+        double fraction = span > 0 ? static_cast<double>(steadyNowMs() - current->timestampMs) / span : 1.0;
+        std::vector<Process> shown;
+        interpolateSnapshots(*previous, *current, fraction, shown);
+        processesVector = filterProcesses(shown, filterCriterion);
+    }
+    else if (current)
+    {
+        processesVector = filterProcesses(current->processes, filterCriterion);
+    }
+
+    // Select and sort only the processes that fit on the screen (the tree comes laid out)
+    if (!treeView.load())
+        sortProcesses(processesVector, sortingCriterion, tableRowsFor(screen));
+
+    // Repaint only the cells that changed since the previous frame (everything after other output)
+    if (screenRepaintRequested.exchange(false))
+    {
+        screen.invalidate();
+    }
+    static FrameBuffer frame;
+    frame.clear();
+    screen.beginFrame();
+    composeProcessTable(processesVector, screen);
+    if (screen.render(frame) > 0)
+    {
+        // The whole frame goes out in one write, never interleaved with other console output
+        std::lock_guard<std::mutex> lock(coutMutex);
+        std::cout.flush();
+        frame.writeTo(STDOUT_FILENO);
+    }
+}
+
+void monitorProcesses(unsigned generation)
 {
     Logger::getInstance().info("Process display thread started.");
-    while (monitoringActive.load())
+    while (sessionCurrent(generation))
     {
         // Pause monitoring if the flag is set
-        while (monitoringPaused.load() && monitoringActive.load())
+        if (!waitWhilePaused(generation))
+            break; // Exit if monitoring is no longer active
+
+        // Wait for the display interval, or until new data or a new sort/filter asks for an immediate
+        // redraw. A resize is flagged by the SIGWINCH handler, which cannot notify `cv`, so it is polled.
+        // The deadline follows `displayIntervalMs`, so a new interval applies to the wait in progress.
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = [start]() { return start + std::chrono::milliseconds(displayIntervalMs.load()); };
+            auto wake = [generation]() {
+                return !sessionCurrent(generation) || displayRefreshRequested.load() || terminalResized.load();
+            };
+            std::unique_lock<std::mutex> lock(cvMutex);
+            while (!wake() && std::chrono::steady_clock::now() < deadline())
+            {
+                cv.wait_until(lock, std::min(deadline(), std::chrono::steady_clock::now() + kResizePollInterval));
+            }
         }
+        displayRefreshRequested.store(false);
 
-        if (!monitoringActive.load())
-            break; // Exit if monitoring is no longer active
+        if (!sessionCurrent(generation))
+            break; // Exit if monitoring was stopped while waiting
+
+        displayProcessTable();
+    }
+    Logger::getInstance().info("Process display thread stopped.");
+}
 
-        // Sleep for the specified update frequency before the next update
-        std::this_thread::sleep_for(std::chrono::seconds(updateFrequency.load()));
+void replaySession(std::shared_ptr<SessionReader> reader, double speed, bool stepMode, unsigned generation)
+{
+    Logger::getInstance().info("Replay thread started.");
+    SessionFrame frame;
+    size_t index = 0;
 
-        std::vector<Process> processesVector;
+    while (sessionCurrent(generation) && index < reader->frameCount())
+    {
+        // Pause replay if the flag is set
+        if (!waitWhilePaused(generation))
+            break;
 
+        // Jump to the requested position of the recording
+        long long seekOffset = replaySeekOffsetMs.exchange(-1);
+        if (seekOffset >= 0)
         {
-            // Lock the processes map to ensure thread-safe access
-            std::lock_guard<std::mutex> lock(processMutex);
-            for (const auto& pair : processes)
+            index = reader->findFrame(reader->frameTimestamp(0) + seekOffset);
+        }
+        else if (stepMode)
+        {
+            // Wait until the user asks for the next frame (or seeks)
+            while (sessionCurrent(generation) && replayStepRequests.load() <= 0 && replaySeekOffsetMs.load() < 0)
             {
-                const auto& process = pair.second;
-
-                // Apply user-defined filters
-                if (filterCriterion.first == "user" && process.user != filterCriterion.second)
-                {
-                    continue;
-                }
-                if (filterCriterion.first == "cpu" && process.cpuUsage <= std::stod(filterCriterion.second))
-                {
-                    continue;
-                }
-                if (filterCriterion.first == "memory" && process.memoryUsage <= std::stod(filterCriterion.second))
-                {
-                    continue;
-                }
-
-                processesVector.push_back(process);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
             }
+            if (replaySeekOffsetMs.load() >= 0)
+                continue;
+            replayStepRequests.fetch_sub(1);
         }
+        else if (index > 0)
+        {
+            // Reproduce the original spacing between epochs, scaled by the replay speed
+            auto delay = std::chrono::milliseconds(static_cast<long long>(
+                (reader->frameTimestamp(index) - reader->frameTimestamp(index - 1)) / speed));
+            auto deadline = std::chrono::steady_clock::now() + delay;
+            while (sessionCurrent(generation) && replaySeekOffsetMs.load() < 0 &&
+                   std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    deadline - std::chrono::steady_clock::now(), std::chrono::milliseconds(20)));
+            }
+            if (replaySeekOffsetMs.load() >= 0)
+                continue;
+        }
+
+        if (!sessionCurrent(generation))
+            break; // Exit if monitoring is no longer active
 
-        // Sort the processes based on the selected sorting criterion
-        if (sortingCriterion == "cpu")
+        if (!reader->readFrame(index, frame))
         {
-            std::sort(processesVector.begin(), processesVector.end(),
-                      [](const Process& a, const Process& b) { return a.cpuUsage > b.cpuUsage; });
+            Logger::getInstance().error("Failed to decode frame {} of session file.", index);
+            break;
         }
-        else if (sortingCriterion == "memory")
+
         {
-            std::sort(processesVector.begin(), processesVector.end(),
-                      [](const Process& a, const Process& b) { return a.memoryUsage > b.memoryUsage; });
+            // Replace the processes map with the recorded snapshot
+            std::lock_guard<std::mutex> lock(processMutex);
+            processes.clear();
+            for (const auto& process : frame.processes)
+            {
+                processes[process.pid] = process;
+            }
         }
+        // Recorded frames are shown as they are, without interpolation (steps and seeks jump)
+        processSnapshots.publish(makeSnapshot(frame.processes, steadyNowMs(), false));
+        processTree.update(frame.processes);
+
+        // Ask the display thread to show the new frame immediately
+        displayRefreshRequested.store(true);
+        cv.notify_all();
+        ++index;
+    }
 
-        // Clear the terminal screen and display the updated list of processes
-        std::cout << "\033[2J\033[H"; // ANSI escape code to clear the screen
-        printProcesses(processesVector);
+    {
+        // The session ends with the recording or a stop; a session started since then is left alone.
+        // The recorded PIDs must not stay in the map, where kill commands would find them.
+        std::lock_guard<std::mutex> lock(cvMutex);
+        if (monitoringGeneration.load() == generation)
+        {
+            monitoringActive.store(false);
+            {
+                std::lock_guard<std::mutex> processLock(processMutex);
+                processes.clear();
+            }
+            processTree.clear();
+            replayActive.store(false);
+        }
     }
-    Logger::getInstance().info("Process display thread stopped.");
+    cv.notify_all();
+    Logger::getInstance().info("Replay thread stopped after {} frames.", index);
 }
@@ -0,0 +1,220 @@
+/**
+ * @file screen_renderer.cpp
+ * @brief Implements the diff-based screen model.
+ *
+ * This source file contains the implementation of the ScreenRenderer class. Frames are compared
+ * row by row; every maximal group of changed cells becomes one cursor movement followed by the new
+ * cells, and color changes are only emitted when the color actually differs from the previous cell
+ * written.
+ */
+
+#include "screen_renderer.h"
+#include <algorithm>
+#include <charconv>
+#include <sys/ioctl.h>
+
+namespace
+{
+
+// Unchanged cells between two changed runs that are rewritten rather than skipped with a cursor
+// movement (`\033[RR;CCH` costs 6 to 8 bytes)
+const int kMergeGap = 6;
+
+const char* colorSequence(ScreenColor color)
+{
+    switch (color)
+    {
+    case ScreenColor::FG_RED:
+        return "\033[31m";
+    case ScreenColor::FG_YELLOW:
+        return "\033[33m";
+    case ScreenColor::FG_GREEN:
+        return "\033[32m";
+    default:
+        return "\033[0m";
+    }
+}
+
+} // namespace
+
+ScreenRenderer::ScreenRenderer(int rows, int columns)
+    : m_rows(0), m_columns(0), m_fullRepaint(true), m_cursorRow(-1), m_cursorColumn(0),
+      m_color(ScreenColor::FG_DEFAULT)
+{
+    resize(rows, columns);
+}
+
+void ScreenRenderer::resize(int rows, int columns)
+{
+    m_rows = std::max(rows, 1);
+    m_columns = std::max(columns, 1);
+    m_shown.assign(static_cast<size_t>(m_rows) * m_columns, Cell{' ', ScreenColor::FG_DEFAULT});
+    m_next = m_shown;
+    m_fullRepaint = true;
+}
+
+void ScreenRenderer::invalidate()
+{
+    m_fullRepaint = true;
+}
+
+void ScreenRenderer::beginFrame()
+{
+    std::fill(m_next.begin(), m_next.end(), Cell{' ', ScreenColor::FG_DEFAULT});
+}
+
+int ScreenRenderer::put(int row, int column, const char* text, size_t length, ScreenColor color)
+{
+    if (row < 0 || row >= m_rows || column < 0)
+    {
+        return column;
+    }
+    Cell* cells = &m_next[static_cast<size_t>(row) * m_columns];
+    for (size_t i = 0; i < length && column < m_columns; ++i, ++column)
+    {
+        unsigned char ch = static_cast<unsigned char>(text[i]);
+        cells[column] = Cell{ch >= 0x20 && ch < 0x7F ? static_cast<char>(ch) : '?', color};
+    }
+    return column;
+}
+
+int ScreenRenderer::put(int row, int column, const std::string& text, ScreenColor color)
+{
+    return put(row, column, text.data(), text.size(), color);
+}
+
+size_t ScreenRenderer::render(FrameBuffer& out)
+{
+    size_t start = out.size();
+    m_cursorRow = -1;
+    m_color = ScreenColor::FG_DEFAULT; // Every render ends with the default color
+
+    if (m_fullRepaint)
+    {
+        out.append("\033[H\033[2J");
+        m_cursorRow = 0;
+        m_cursorColumn = 0;
+        // Compare against a blank screen so only non-blank cells are written
+        std::fill(m_shown.begin(), m_shown.end(), Cell{' ', ScreenColor::FG_DEFAULT});
+    }
+
+    const Cell blank{' ', ScreenColor::FG_DEFAULT};
+    for (int row = 0; row < m_rows; ++row)
+    {
+        const Cell* next = &m_next[static_cast<size_t>(row) * m_columns];
+        const Cell* shown = &m_shown[static_cast<size_t>(row) * m_columns];
+
+        // Cells from `end` on are blank in the new frame and can be erased in one sequence
+        int end = m_columns;
+        while (end > 0 && next[end - 1] == blank)
+        {
+            end--;
+        }
+
+        int column = 0;
+        while (column < m_columns)
+        {
+            if (next[column] == shown[column])
+            {
+                column++;
+                continue;
+            }
+            if (column >= end)
+            {
+                moveCursor(out, row, column);
+                setColor(out, ScreenColor::FG_DEFAULT);
+                out.append("\033[K"); // Erase to the end of the line
+                break;
+            }
+
+            // Extend the run over changed cells, bridging short gaps of unchanged ones
+            int lastChanged = column;
+            for (int probe = column + 1; probe < end && probe - lastChanged <= kMergeGap; ++probe)
+            {
+                if (next[probe] != shown[probe])
+                {
+                    lastChanged = probe;
+                }
+            }
+
+            moveCursor(out, row, column);
+            for (; column <= lastChanged; ++column)
+            {
+                setColor(out, next[column].color);
+                out.append(1, next[column].ch);
+            }
+            m_cursorColumn = column;
+        }
+    }
+
+    size_t emitted = out.size() - start;
+    if (emitted > 0)
+    {
+        setColor(out, ScreenColor::FG_DEFAULT);
+        moveCursor(out, lastUsedRow(m_next) + 1, 0); // Leave the cursor below the table
+    }
+
+    m_shown.swap(m_next);
+    m_fullRepaint = false;
+    return out.size() - start;
+}
+
+int ScreenRenderer::rows() const
+{
+    return m_rows;
+}
+
+int ScreenRenderer::columns() const
+{
+    return m_columns;
+}
+
+void ScreenRenderer::moveCursor(FrameBuffer& out, int row, int column)
+{
+    if (row == m_cursorRow && column == m_cursorColumn)
+    {
+        return;
+    }
+    out.append("\033[");
+    out.appendInt(row + 1);
+    out.append(1, ';');
+    out.appendInt(column + 1);
+    out.append(1, 'H');
+    m_cursorRow = row;
+    m_cursorColumn = column;
+}
+
+void ScreenRenderer::setColor(FrameBuffer& out, ScreenColor color)
+{
+    if (color != m_color)
+    {
+        out.append(colorSequence(color));
+        m_color = color;
+    }
+}
+
+int ScreenRenderer::lastUsedRow(const std::vector<Cell>& grid) const
+{
+    const Cell blank{' ', ScreenColor::FG_DEFAULT};
+    for (int row = m_rows - 1; row >= 0; --row)
+    {
+        const Cell* cells = &grid[static_cast<size_t>(row) * m_columns];
+        if (std::any_of(cells, cells + m_columns, [&](const Cell& cell) { return cell != blank; }))
+        {
+            return row;
+        }
+    }
+    return -1;
+}
+
+bool queryTerminalSize(int fd, int& rows, int& columns)
+{
+    struct winsize size;
+    if (ioctl(fd, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 || size.ws_col == 0)
+    {
+        return false;
+    }
+    rows = size.ws_row;
+    columns = size.ws_col;
+    return true;
+}
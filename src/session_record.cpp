@@ -0,0 +1,624 @@
+/**
+ * @file session_record.cpp
+ * @brief Implements the recorder and reader of sampling session files.
+ *
+ * This source file contains the binary encoding of session frames described in
+ * `session_record.h`. Integers in frame payloads are LEB128 varints, and signed deltas are
+ * zigzag-encoded first, so that the common case of a process whose CPU and memory usage barely
+ * changed between two epochs costs a handful of bytes, and an unchanged process costs nothing.
+ */
+
+#include "session_record.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdio_ext.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+const char kMagic[8] = {'P', 'M', 'R', 'E', 'C', '\0', '\0', '\1'};
+const uint8_t kKeyFrame = 0;
+const uint8_t kDeltaFrame = 1;
+const size_t kFrameHeaderSize = 4 + 1 + 8; // length + type + timestamp
+
+// Field flags of an entry in a delta frame
+const uint8_t kHasStrings = 1;
+const uint8_t kHasCpu = 2;
+const uint8_t kHasMemory = 4;
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putSigned(std::string& out, int64_t value)
+{
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); // Zigzag
+}
+
+void putString(std::string& out, const std::string& value)
+{
+    putVarint(out, value.size());
+    out.append(value);
+}
+
+void putFixed(char* out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t getFixed(const unsigned char* in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Returns the offset just past the last complete frame of a session file, reading the frame
+ *        headers only, as SessionReader::open() does.
+ */
+long completeFramesEnd(FILE* file)
+{
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    long offset = sizeof(kMagic);
+    unsigned char frameHeader[kFrameHeaderSize];
+    while (offset + static_cast<long>(kFrameHeaderSize) <= fileSize)
+    {
+        fseek(file, offset, SEEK_SET);
+        if (fread(frameHeader, 1, kFrameHeaderSize, file) != kFrameHeaderSize)
+        {
+            break;
+        }
+        uint32_t length = static_cast<uint32_t>(getFixed(frameHeader, 4));
+        if (length < kFrameHeaderSize - 4 || offset + 4 + static_cast<long>(length) > fileSize)
+        {
+            break; // Truncated frame
+        }
+        offset += 4 + length;
+    }
+    return std::min(offset, fileSize);
+}
+
+/**
+ * @brief Bounds-checked cursor over a frame payload.
+ */
+struct Cursor
+{
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= size)
+            {
+                ok = false;
+                return 0;
+            }
+            unsigned char byte = data[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint()
+    {
+        uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    uint8_t byte()
+    {
+        if (pos >= size)
+        {
+            ok = false;
+            return 0;
+        }
+        return data[pos++];
+    }
+
+    std::string string()
+    {
+        uint64_t length = varint();
+        if (!ok || length > size - pos)
+        {
+            ok = false;
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return value;
+    }
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------
+// SessionRecorder
+// ---------------------------------------------------------------------------------------------
+
+SessionRecorder::SessionRecorder()
+    : m_file(nullptr), m_framesSinceKey(kKeyFrameInterval), m_framesWritten(0), m_bytesWritten(0)
+{
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+bool SessionRecorder::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file != nullptr)
+    {
+        return false; // Already recording
+    }
+
+    FILE* file = fopen(path.c_str(), "a+b");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // An existing file must start with the session header; an empty file gets one
+    char header[sizeof(kMagic)];
+    fseek(file, 0, SEEK_SET);
+    size_t headerBytes = fread(header, 1, sizeof(header), file);
+    if (headerBytes == 0)
+    {
+        fwrite(kMagic, 1, sizeof(kMagic), file);
+    }
+    else if (headerBytes != sizeof(kMagic) || std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    {
+        fclose(file);
+        return false;
+    }
+    else
+    {
+        // A recording that crashed mid-frame left a partial frame, whose length would swallow the
+        // frames appended after it: cut the file back to its last complete frame
+        if (ftruncate(fileno(file), completeFramesEnd(file)) != 0)
+        {
+            fclose(file);
+            return false;
+        }
+        fseek(file, 0, SEEK_END); // Switching from reading to appending
+    }
+
+    setvbuf(file, nullptr, _IOFBF, 1 << 20); // Large buffer: one write syscall per several frames
+    m_file = file;
+    m_path = path;
+    m_previous.clear();
+    m_framesSinceKey = kKeyFrameInterval; // The first frame of every recording is a key frame
+    m_framesWritten = 0;
+    m_bytesWritten = 0;
+    return true;
+}
+
+void SessionRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_path.clear();
+    m_previous.clear();
+}
+
+bool SessionRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file != nullptr;
+}
+
+std::string SessionRecorder::path() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_path;
+}
+
+uint64_t SessionRecorder::framesWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_framesWritten;
+}
+
+uint64_t SessionRecorder::bytesWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytesWritten;
+}
+
+bool SessionRecorder::append(int64_t timestampMs, const std::vector<Process>& snapshot)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file == nullptr)
+    {
+        return false;
+    }
+
+    // Convert the snapshot to its stored form, sorted by PID so frames can be merged linearly
+    m_current.resize(snapshot.size());
+    for (size_t i = 0; i < snapshot.size(); ++i)
+    {
+        Entry& entry = m_current[i];
+        entry.pid = snapshot[i].pid;
+        entry.cpuCenti = std::llround(snapshot[i].cpuUsage * 100.0);
+        entry.rssKb = std::llround(snapshot[i].memoryUsage * 1024.0);
+        entry.user = snapshot[i].user;
+        entry.command = snapshot[i].command;
+    }
+    std::sort(m_current.begin(), m_current.end(), [](const Entry& a, const Entry& b) { return a.pid < b.pid; });
+
+    // Reserve room for the frame header, filled in once the payload length is known
+    m_payload.assign(kFrameHeaderSize, '\0');
+    uint8_t type;
+    if (m_framesSinceKey >= kKeyFrameInterval)
+    {
+        type = kKeyFrame;
+        encodeKeyFrame();
+        m_framesSinceKey = 0;
+    }
+    else
+    {
+        type = kDeltaFrame;
+        encodeDeltaFrame();
+    }
+    m_framesSinceKey++;
+
+    putFixed(&m_payload[0], m_payload.size() - 4, 4);
+    m_payload[4] = static_cast<char>(type);
+    putFixed(&m_payload[5], static_cast<uint64_t>(timestampMs), 8);
+
+    long offset = ftell(m_file);
+    if (fwrite(m_payload.data(), 1, m_payload.size(), m_file) != m_payload.size())
+    {
+        discardPartialFrame(offset);
+        m_framesSinceKey = kKeyFrameInterval;
+        return false;
+    }
+    m_previous.swap(m_current);
+    m_framesWritten++;
+    m_bytesWritten += m_payload.size();
+    return true;
+}
+
+// Drops the bytes of a frame that could not be written completely, so the file ends with the
+// previous frame; the next frame must then be a key frame, since this one never reached the file
+void SessionRecorder::discardPartialFrame(long offset)
+{
+    clearerr(m_file);
+    fflush(m_file); // Earlier frames still buffered, if the disk takes them now
+    __fpurge(m_file);
+    struct stat status;
+    if (fstat(fileno(m_file), &status) == 0 && status.st_size >= offset && offset >= 0)
+    {
+        if (ftruncate(fileno(m_file), offset) == 0)
+            return;
+    }
+    // Some earlier frames were lost with the buffer: keep the complete ones
+    if (ftruncate(fileno(m_file), completeFramesEnd(m_file)) != 0)
+    {
+        clearerr(m_file);
+    }
+}
+
+// Key frame payload: count, then (pid delta, cpu, memory, user, command) for every process
+void SessionRecorder::encodeKeyFrame()
+{
+    putVarint(m_payload, m_current.size());
+    int lastPid = 0;
+    for (const Entry& entry : m_current)
+    {
+        putVarint(m_payload, static_cast<uint64_t>(entry.pid - lastPid));
+        putSigned(m_payload, entry.cpuCenti);
+        putSigned(m_payload, entry.rssKb);
+        putString(m_payload, entry.user);
+        putString(m_payload, entry.command);
+        lastPid = entry.pid;
+    }
+}
+
+// Delta frame payload: removed PIDs, then (pid delta, flags, changed fields) for new or changed processes
+void SessionRecorder::encodeDeltaFrame()
+{
+    // Removed PIDs: present in the previous frame but not in the current one
+    std::vector<int> removed;
+    {
+        size_t j = 0;
+        for (const Entry& old : m_previous)
+        {
+            while (j < m_current.size() && m_current[j].pid < old.pid)
+                ++j;
+            if (j == m_current.size() || m_current[j].pid != old.pid)
+                removed.push_back(old.pid);
+        }
+    }
+    putVarint(m_payload, removed.size());
+    int lastPid = 0;
+    for (int pid : removed)
+    {
+        putVarint(m_payload, static_cast<uint64_t>(pid - lastPid));
+        lastPid = pid;
+    }
+
+    // New and changed entries. The count is unknown until the merge is done, so encode them separately
+    std::string& changes = m_changes;
+    changes.clear();
+    size_t changedCount = 0;
+    lastPid = 0;
+    size_t i = 0;
+    for (const Entry& entry : m_current)
+    {
+        while (i < m_previous.size() && m_previous[i].pid < entry.pid)
+            ++i;
+        const Entry* old = (i < m_previous.size() && m_previous[i].pid == entry.pid) ? &m_previous[i] : nullptr;
+
+        uint8_t flags = 0;
+        if (old == nullptr || old->user != entry.user || old->command != entry.command)
+            flags |= kHasStrings;
+        if (old == nullptr || old->cpuCenti != entry.cpuCenti)
+            flags |= kHasCpu;
+        if (old == nullptr || old->rssKb != entry.rssKb)
+            flags |= kHasMemory;
+        if (flags == 0)
+            continue; // Unchanged processes cost nothing
+
+        putVarint(changes, static_cast<uint64_t>(entry.pid - lastPid));
+        changes.push_back(static_cast<char>(flags));
+        if (flags & kHasCpu)
+            putSigned(changes, entry.cpuCenti - (old ? old->cpuCenti : 0));
+        if (flags & kHasMemory)
+            putSigned(changes, entry.rssKb - (old ? old->rssKb : 0));
+        if (flags & kHasStrings)
+        {
+            putString(changes, entry.user);
+            putString(changes, entry.command);
+        }
+        lastPid = entry.pid;
+        changedCount++;
+    }
+    putVarint(m_payload, changedCount);
+    m_payload.append(changes);
+}
+
+// ---------------------------------------------------------------------------------------------
+// SessionReader
+// ---------------------------------------------------------------------------------------------
+
+SessionReader::SessionReader() : m_file(nullptr), m_nextFrame(0)
+{
+}
+
+SessionReader::~SessionReader()
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+}
+
+bool SessionReader::open(const std::string& path)
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_frames.clear();
+    m_state.clear();
+    m_nextFrame = 0;
+
+    m_file = fopen(path.c_str(), "rb");
+    if (m_file == nullptr)
+    {
+        return false;
+    }
+
+    char header[sizeof(kMagic)];
+    if (fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+        std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+
+    fseek(m_file, 0, SEEK_END);
+    long fileSize = ftell(m_file);
+    long offset = sizeof(kMagic);
+
+    // Index the frames by reading their headers only
+    unsigned char frameHeader[kFrameHeaderSize];
+    while (offset + static_cast<long>(kFrameHeaderSize) <= fileSize)
+    {
+        fseek(m_file, offset, SEEK_SET);
+        if (fread(frameHeader, 1, kFrameHeaderSize, m_file) != kFrameHeaderSize)
+        {
+            break;
+        }
+        uint32_t length = static_cast<uint32_t>(getFixed(frameHeader, 4));
+        if (length < kFrameHeaderSize - 4 || offset + 4 + static_cast<long>(length) > fileSize)
+        {
+            break; // Truncated frame
+        }
+
+        FrameInfo info;
+        info.keyFrame = frameHeader[4] == kKeyFrame;
+        info.timestampMs = static_cast<int64_t>(getFixed(frameHeader + 5, 8));
+        info.offset = offset + kFrameHeaderSize;
+        info.length = length - (kFrameHeaderSize - 4);
+        m_frames.push_back(info);
+        offset += 4 + length;
+    }
+
+    // A file whose first frame is not a key frame cannot be decoded
+    return !m_frames.empty() ? m_frames.front().keyFrame : true;
+}
+
+size_t SessionReader::frameCount() const
+{
+    return m_frames.size();
+}
+
+int64_t SessionReader::frameTimestamp(size_t index) const
+{
+    return m_frames[index].timestampMs;
+}
+
+size_t SessionReader::findFrame(int64_t timestampMs) const
+{
+    auto it = std::upper_bound(m_frames.begin(), m_frames.end(), timestampMs,
+                               [](int64_t value, const FrameInfo& info) { return value < info.timestampMs; });
+    return it == m_frames.begin() ? 0 : static_cast<size_t>(it - m_frames.begin()) - 1;
+}
+
+bool SessionReader::readFrame(size_t index, SessionFrame& frame)
+{
+    if (m_file == nullptr || index >= m_frames.size())
+    {
+        return false;
+    }
+
+    // Continue from the current state when possible, otherwise restart from the closest key frame
+    size_t first = m_nextFrame;
+    if (index < m_nextFrame || m_frames[index].keyFrame)
+    {
+        first = index;
+        while (!m_frames[first].keyFrame)
+        {
+            --first;
+        }
+    }
+    else
+    {
+        for (size_t i = index; i > m_nextFrame; --i)
+        {
+            if (m_frames[i].keyFrame)
+            {
+                first = i; // Skip the deltas that precede a later key frame
+                break;
+            }
+        }
+    }
+
+    for (size_t i = first; i <= index; ++i)
+    {
+        if (!applyFrame(i))
+        {
+            m_state.clear();
+            m_nextFrame = 0;
+            return false;
+        }
+    }
+
+    frame.timestampMs = m_frames[index].timestampMs;
+    frame.processes.clear();
+    frame.processes.reserve(m_state.size());
+    for (const auto& [pid, entry] : m_state)
+    {
+        Process process;
+        process.pid = pid;
+        process.user = entry.user;
+        process.cpuUsage = entry.cpuCenti / 100.0;
+        process.memoryUsage = entry.rssKb / 1024.0;
+        process.prevTotalTime = 0;
+        process.command = entry.command;
+        frame.processes.push_back(std::move(process));
+    }
+    std::sort(frame.processes.begin(), frame.processes.end(),
+              [](const Process& a, const Process& b) { return a.pid < b.pid; });
+    return true;
+}
+
+bool SessionReader::applyFrame(size_t index)
+{
+    const FrameInfo& info = m_frames[index];
+    m_payload.resize(info.length);
+    fseek(m_file, info.offset, SEEK_SET);
+    if (fread(&m_payload[0], 1, info.length, m_file) != info.length)
+    {
+        return false;
+    }
+
+    Cursor in{reinterpret_cast<const unsigned char*>(m_payload.data()), m_payload.size()};
+    if (info.keyFrame)
+    {
+        m_state.clear();
+        uint64_t count = in.varint();
+        int pid = 0;
+        for (uint64_t i = 0; i < count && in.ok; ++i)
+        {
+            pid += static_cast<int>(in.varint());
+            Entry& entry = m_state[pid];
+            entry.cpuCenti = in.signedVarint();
+            entry.rssKb = in.signedVarint();
+            entry.user = in.string();
+            entry.command = in.string();
+        }
+    }
+    else
+    {
+        uint64_t removedCount = in.varint();
+        int pid = 0;
+        for (uint64_t i = 0; i < removedCount && in.ok; ++i)
+        {
+            pid += static_cast<int>(in.varint());
+            m_state.erase(pid);
+        }
+
+        uint64_t changedCount = in.varint();
+        pid = 0;
+        for (uint64_t i = 0; i < changedCount && in.ok; ++i)
+        {
+            pid += static_cast<int>(in.varint());
+            uint8_t flags = in.byte();
+            auto it = m_state.find(pid);
+            if (it == m_state.end())
+            {
+                it = m_state.emplace(pid, Entry{0, 0, std::string(), std::string()}).first;
+            }
+            Entry& entry = it->second;
+            if (flags & kHasCpu)
+                entry.cpuCenti += in.signedVarint();
+            if (flags & kHasMemory)
+                entry.rssKb += in.signedVarint();
+            if (flags & kHasStrings)
+            {
+                entry.user = in.string();
+                entry.command = in.string();
+            }
+        }
+    }
+
+    m_nextFrame = index + 1;
+    return in.ok;
+}
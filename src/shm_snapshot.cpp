@@ -0,0 +1,208 @@
+/**
+ * @file shm_snapshot.cpp
+ * @brief Implements the writer of the shared-memory snapshot export.
+ *
+ * This source file contains the implementation of the ShmSnapshotWriter class. Each epoch is
+ * written into the buffer that readers are not using, between two increments of that buffer's
+ * sequence counter, before the buffer is made the active one.
+ */
+
+#include "shm_snapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace
+{
+
+// Largest accepted capacity, which keeps every offset of the region within 32 bits
+const uint32_t kMaxCapacity = 1u << 22;
+
+// Buffers start on their own pages
+uint64_t alignToPage(uint64_t bytes)
+{
+    return (bytes + 4095) & ~uint64_t(4095);
+}
+
+} // namespace
+
+ShmSnapshotWriter::ShmSnapshotWriter() : m_region(nullptr), m_regionBytes(0), m_header(nullptr), m_columnOffsets{}
+{
+}
+
+ShmSnapshotWriter::~ShmSnapshotWriter()
+{
+    close();
+}
+
+bool ShmSnapshotWriter::open(const std::string& name, uint32_t capacity, std::string& error)
+{
+    close();
+    if (capacity == 0 || capacity > kMaxCapacity)
+    {
+        error = "Invalid capacity: " + std::to_string(capacity);
+        return false;
+    }
+    std::string objectName = (!name.empty() && name[0] == '/') ? name : "/" + name;
+
+    // Readers of a previous object keep their mapping; new readers get the new object
+    shm_unlink(objectName.c_str());
+    int fd = shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        error = "Cannot create shared memory " + objectName + ": " + std::strerror(errno);
+        return false;
+    }
+
+    uint32_t stringCapacity = capacity * kStringBytesPerProcess;
+    uint64_t offsets[6];
+    uint64_t bufferBytes = shmBufferLayout(capacity, stringCapacity, offsets);
+    uint64_t firstBuffer = alignToPage(sizeof(ShmSnapshotHeader));
+    uint64_t secondBuffer = firstBuffer + alignToPage(bufferBytes);
+    uint64_t regionBytes = secondBuffer + bufferBytes;
+
+    void* region = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(regionBytes)) == 0)
+    {
+        region = mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int savedErrno = errno;
+    ::close(fd);
+    if (region == MAP_FAILED)
+    {
+        error = "Cannot size or map " + objectName + ": " + std::strerror(savedErrno);
+        shm_unlink(objectName.c_str());
+        return false;
+    }
+
+    // The region is zero-filled: no epoch yet, both sequence counters even
+    m_header = new (region) ShmSnapshotHeader();
+    m_header->version = kShmSnapshotVersion;
+    m_header->capacity = capacity;
+    m_header->stringCapacity = stringCapacity;
+    m_header->regionBytes = regionBytes;
+    m_header->bufferOffset[0] = firstBuffer;
+    m_header->bufferOffset[1] = secondBuffer;
+    m_header->writerPid = static_cast<int32_t>(getpid());
+    m_header->active.store(0);
+    m_header->epoch.store(0);
+    m_header->sequence[0].store(0);
+    m_header->sequence[1].store(0);
+    m_header->magic = kShmSnapshotMagic;
+
+    m_region = static_cast<char*>(region);
+    m_regionBytes = regionBytes;
+    std::copy(offsets, offsets + 6, m_columnOffsets);
+    m_name = objectName;
+    return true;
+}
+
+void ShmSnapshotWriter::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_region != nullptr)
+    {
+        munmap(m_region, m_regionBytes);
+        shm_unlink(m_name.c_str());
+        m_region = nullptr;
+        m_header = nullptr;
+        m_regionBytes = 0;
+    }
+}
+
+bool ShmSnapshotWriter::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_region != nullptr;
+}
+
+void ShmSnapshotWriter::publish(const std::vector<Process>& processes, int64_t timestampMs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_region == nullptr)
+    {
+        return;
+    }
+
+    // Write the buffer readers are not using
+    uint64_t epoch = m_header->epoch.load(std::memory_order_relaxed) + 1;
+    uint32_t buffer = epoch == 1 ? 0 : 1 - m_header->active.load(std::memory_order_relaxed);
+    uint64_t sequence = m_header->sequence[buffer].load(std::memory_order_relaxed);
+    m_header->sequence[buffer].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char* base = m_region + m_header->bufferOffset[buffer];
+    auto* pids = reinterpret_cast<int32_t*>(base + m_columnOffsets[0]);
+    auto* cpu = reinterpret_cast<float*>(base + m_columnOffsets[1]);
+    auto* memory = reinterpret_cast<float*>(base + m_columnOffsets[2]);
+    auto* users = reinterpret_cast<uint32_t*>(base + m_columnOffsets[3]);
+    auto* commands = reinterpret_cast<uint32_t*>(base + m_columnOffsets[4]);
+    char* strings = base + m_columnOffsets[5];
+
+    const uint32_t capacity = m_header->capacity;
+    const uint32_t pool = m_header->stringCapacity;
+    bool truncated = processes.size() > capacity;
+    uint32_t used = 1;
+    strings[0] = '\0'; // Offset 0 is the empty string, used when the pool is full
+
+    // Copies a string into the pool (cut to the space left) and returns its offset
+    auto addString = [&](const std::string& text) -> uint32_t {
+        if (used + 1 >= pool)
+        {
+            truncated = truncated || !text.empty();
+            return 0;
+        }
+        size_t length = std::min<size_t>(text.size(), pool - used - 1);
+        truncated = truncated || length < text.size();
+        uint32_t offset = used;
+        std::memcpy(strings + used, text.data(), length);
+        strings[used + length] = '\0';
+        used += static_cast<uint32_t>(length + 1);
+        return offset;
+    };
+
+    // Few distinct users own most processes, so their names are stored once per epoch
+    std::pair<const std::string*, uint32_t> recentUsers[8] = {};
+    size_t nextRecent = 0;
+
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(processes.size(), capacity));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Process& process = processes[i];
+        pids[i] = process.pid;
+        cpu[i] = static_cast<float>(process.cpuUsage);
+        memory[i] = static_cast<float>(process.memoryUsage);
+
+        const auto* recent = std::find_if(std::begin(recentUsers), std::end(recentUsers), [&](const auto& entry) {
+            return entry.first != nullptr && *entry.first == process.user;
+        });
+        if (recent != std::end(recentUsers))
+        {
+            users[i] = recent->second;
+        }
+        else
+        {
+            users[i] = addString(process.user);
+            recentUsers[nextRecent] = {&process.user, users[i]};
+            nextRecent = (nextRecent + 1) % 8;
+        }
+        commands[i] = addString(process.command);
+    }
+
+    auto* header = reinterpret_cast<ShmBufferHeader*>(base);
+    header->epoch = epoch;
+    header->timestampMs = timestampMs;
+    header->count = count;
+    header->stringBytes = used;
+    header->truncated = truncated ? 1 : 0;
+
+    // Close the seqlock, then make the buffer the active one
+    m_header->sequence[buffer].store(sequence + 2, std::memory_order_release);
+    m_header->active.store(buffer, std::memory_order_release);
+    m_header->epoch.store(epoch, std::memory_order_release);
+}
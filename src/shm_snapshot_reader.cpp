@@ -0,0 +1,202 @@
+/**
+ * @file shm_snapshot_reader.cpp
+ * @brief Implements the reader library of the shared-memory snapshot export.
+ *
+ * This source file is built into the `pm_shm_reader` library for other programs, and into the
+ * Process Manager itself for its tests and benchmarks. It only depends on the C++ standard
+ * library and POSIX.
+ */
+
+#include "shm_snapshot_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Attempts of read() before it gives up on an epoch that keeps being rewritten
+const int kReadAttempts = 8;
+
+uint64_t alignTo64(uint64_t bytes)
+{
+    return (bytes + 63) & ~uint64_t(63);
+}
+
+} // namespace
+
+uint64_t shmBufferLayout(uint32_t capacity, uint32_t stringCapacity, uint64_t columnOffsets[6])
+{
+    static const uint64_t columnBytes[5] = {sizeof(int32_t), sizeof(float), sizeof(float), sizeof(uint32_t),
+                                            sizeof(uint32_t)};
+    uint64_t offset = alignTo64(sizeof(ShmBufferHeader));
+    for (int column = 0; column < 5; ++column)
+    {
+        columnOffsets[column] = offset;
+        offset = alignTo64(offset + columnBytes[column] * capacity);
+    }
+    columnOffsets[5] = offset; // String pool
+    return alignTo64(offset + stringCapacity);
+}
+
+ShmSnapshotReader::ShmSnapshotReader() : m_region(nullptr), m_regionBytes(0), m_header(nullptr), m_columnOffsets{}
+{
+}
+
+ShmSnapshotReader::~ShmSnapshotReader()
+{
+    close();
+}
+
+bool ShmSnapshotReader::open(const std::string& name, std::string& error)
+{
+    close();
+    std::string objectName = (!name.empty() && name[0] == '/') ? name : "/" + name;
+    int fd = shm_open(objectName.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        error = "Cannot open shared memory " + objectName + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(ShmSnapshotHeader))
+    {
+        error = objectName + " is not a snapshot region";
+        ::close(fd);
+        return false;
+    }
+    size_t bytes = static_cast<size_t>(status.st_size);
+    void* region = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping stays valid
+    if (region == MAP_FAILED)
+    {
+        error = "Cannot map " + objectName + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Check that the layout described by the header is the one this library computes
+    const auto* header = static_cast<const ShmSnapshotHeader*>(region);
+    uint64_t offsets[6];
+    uint64_t bufferBytes = shmBufferLayout(header->capacity, header->stringCapacity, offsets);
+    bool valid = header->magic == kShmSnapshotMagic && header->version == kShmSnapshotVersion &&
+                 header->regionBytes == bytes && header->bufferOffset[0] + bufferBytes <= bytes &&
+                 header->bufferOffset[1] + bufferBytes <= bytes;
+    if (!valid)
+    {
+        error = objectName + " is not a snapshot region of version " + std::to_string(kShmSnapshotVersion);
+        munmap(region, bytes);
+        return false;
+    }
+
+    m_region = static_cast<const char*>(region);
+    m_regionBytes = bytes;
+    m_header = header;
+    std::copy(offsets, offsets + 6, m_columnOffsets);
+    return true;
+}
+
+void ShmSnapshotReader::close()
+{
+    if (m_region != nullptr)
+    {
+        munmap(const_cast<char*>(m_region), m_regionBytes);
+        m_region = nullptr;
+        m_header = nullptr;
+        m_regionBytes = 0;
+    }
+}
+
+bool ShmSnapshotReader::isOpen() const
+{
+    return m_region != nullptr;
+}
+
+uint64_t ShmSnapshotReader::epoch() const
+{
+    return m_header != nullptr ? m_header->epoch.load(std::memory_order_acquire) : 0;
+}
+
+bool ShmSnapshotReader::beginRead(ShmSnapshotView& view, uint32_t& buffer, uint64_t& sequence) const
+{
+    if (m_header == nullptr || m_header->epoch.load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+    buffer = m_header->active.load(std::memory_order_acquire) & 1;
+    sequence = m_header->sequence[buffer].load(std::memory_order_acquire);
+    if (sequence & 1)
+    {
+        return false; // Being rewritten: this reader is more than one epoch behind
+    }
+
+    // Sizes are clamped to the capacity, so even a torn header cannot lead outside the region
+    const char* base = m_region + m_header->bufferOffset[buffer];
+    const auto* bufferHeader = reinterpret_cast<const ShmBufferHeader*>(base);
+    view.epoch = bufferHeader->epoch;
+    view.timestampMs = bufferHeader->timestampMs;
+    view.count = std::min(bufferHeader->count, m_header->capacity);
+    view.truncated = bufferHeader->truncated != 0;
+    view.pid = reinterpret_cast<const int32_t*>(base + m_columnOffsets[0]);
+    view.cpu = reinterpret_cast<const float*>(base + m_columnOffsets[1]);
+    view.memory = reinterpret_cast<const float*>(base + m_columnOffsets[2]);
+    view.userOffset = reinterpret_cast<const uint32_t*>(base + m_columnOffsets[3]);
+    view.commandOffset = reinterpret_cast<const uint32_t*>(base + m_columnOffsets[4]);
+    view.strings = base + m_columnOffsets[5];
+    return true;
+}
+
+bool ShmSnapshotReader::endRead(uint32_t buffer, uint64_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_header->sequence[buffer].load(std::memory_order_relaxed) == sequence;
+}
+
+bool ShmSnapshotReader::read(ShmSnapshotCopy& out) const
+{
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt)
+    {
+        ShmSnapshotView shared;
+        uint32_t buffer = 0;
+        uint64_t sequence = 0;
+        if (!beginRead(shared, buffer, sequence))
+        {
+            if (epoch() == 0)
+                return false;
+            continue;
+        }
+        const auto* bufferHeader =
+            reinterpret_cast<const ShmBufferHeader*>(m_region + m_header->bufferOffset[buffer]);
+        size_t stringBytes = std::min(bufferHeader->stringBytes, m_header->stringCapacity);
+
+        // Columns are copied back to back: pid, cpu, memory, user, command, strings
+        size_t n = shared.count;
+        size_t columnBytes = n * sizeof(uint32_t);
+        out.storage.resize(5 * columnBytes + stringBytes + 1);
+        char* target = out.storage.data();
+        std::memcpy(target, shared.pid, columnBytes);
+        std::memcpy(target + columnBytes, shared.cpu, columnBytes);
+        std::memcpy(target + 2 * columnBytes, shared.memory, columnBytes);
+        std::memcpy(target + 3 * columnBytes, shared.userOffset, columnBytes);
+        std::memcpy(target + 4 * columnBytes, shared.commandOffset, columnBytes);
+        std::memcpy(target + 5 * columnBytes, shared.strings, stringBytes);
+        target[5 * columnBytes + stringBytes] = '\0';
+
+        if (!endRead(buffer, sequence))
+        {
+            continue; // Rewritten during the copy
+        }
+        out.view = shared;
+        out.view.pid = reinterpret_cast<const int32_t*>(target);
+        out.view.cpu = reinterpret_cast<const float*>(target + columnBytes);
+        out.view.memory = reinterpret_cast<const float*>(target + 2 * columnBytes);
+        out.view.userOffset = reinterpret_cast<const uint32_t*>(target + 3 * columnBytes);
+        out.view.commandOffset = reinterpret_cast<const uint32_t*>(target + 4 * columnBytes);
+        out.view.strings = target + 5 * columnBytes;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file stream_output.cpp
+ * @brief Implements the headless stream mode.
+ *
+ * This source file contains the implementation of the StreamWriter class and of the stream mode
+ * loop. The loop reuses the sampling step of the interactive monitor (`sampleEpoch()`), keeps the
+ * epochs on a fixed schedule, and hands each one to the writer, which serializes every record
+ * straight into its buffer: strings are escaped run by run and numbers go through `std::to_chars`.
+ */
+
+#include "stream_output.h"
+#include "globals.h"
+#include "logger.h"
+#include "resource_monitor.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+// Set by SIGINT and SIGTERM; the loop stops after the current epoch
+std::atomic<bool> streamStopRequested(false);
+
+// Interval at which a sleeping stream loop checks for a stop request
+const std::chrono::milliseconds kStopPollInterval(100);
+
+void handleStreamSignal(int sig)
+{
+    (void)sig;
+    streamStopRequested.store(true);
+}
+
+// Appends `text` as a JSON string, escaping quotes, backslashes and control characters
+void appendJsonString(FrameBuffer& out, const std::string& text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out.append(1, '"');
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        unsigned char ch = static_cast<unsigned char>(text[i]);
+        if (ch >= 0x20 && ch != '"' && ch != '\\')
+        {
+            continue; // Part of the current run of plain characters
+        }
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (ch)
+        {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+        {
+            char escape[] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF]};
+            out.append(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+    out.append(1, '"');
+}
+
+// Appends `text` as a CSV field, quoted if it contains a separator, a quote or a line break
+void appendCsvField(FrameBuffer& out, const std::string& text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        out.append(text);
+        return;
+    }
+    // Quoted field: embedded quotes are doubled
+    out.append(1, '"');
+    size_t runStart = 0;
+    for (size_t quote = text.find('"'); quote != std::string::npos; quote = text.find('"', quote + 1))
+    {
+        out.append(text.data() + runStart, quote + 1 - runStart);
+        out.append(1, '"');
+        runStart = quote + 1;
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+    out.append(1, '"');
+}
+
+} // namespace
+
+StreamWriter::StreamWriter(int fd, StreamFormat format)
+    : m_fd(fd), m_format(format), m_buffer(kFlushThreshold + 4096), m_headerWritten(false), m_records(0)
+{
+}
+
+bool StreamWriter::writeEpoch(int64_t timestampMs, const std::vector<const Process*>& rows)
+{
+    if (m_format == StreamFormat::Csv && !m_headerWritten)
+    {
+        m_buffer.append("ts,pid,user,cpu,mem_mb,command\n");
+        m_headerWritten = true;
+    }
+    for (const Process* process : rows)
+    {
+        appendStreamRecord(m_buffer, m_format, timestampMs, *process);
+        if (m_buffer.size() >= kFlushThreshold && !flush())
+        {
+            return false;
+        }
+    }
+    m_records += rows.size();
+    return flush(); // Readers see every epoch as soon as it is sampled
+}
+
+size_t StreamWriter::recordsWritten() const
+{
+    return m_records;
+}
+
+void appendStreamRecord(FrameBuffer& out, StreamFormat format, int64_t timestampMs, const Process& process)
+{
+    // Non-finite values have no JSON representation; they are written as 0
+    double cpu = std::isfinite(process.cpuUsage) ? process.cpuUsage : 0.0;
+    double memory = std::isfinite(process.memoryUsage) ? process.memoryUsage : 0.0;
+
+    if (format == StreamFormat::JsonLines)
+    {
+        out.append("{\"ts\":");
+        out.appendInt(timestampMs);
+        out.append(",\"pid\":");
+        out.appendInt(process.pid);
+        out.append(",\"user\":");
+        appendJsonString(out, process.user);
+        out.append(",\"cpu\":");
+        out.appendFixed(cpu, 2);
+        out.append(",\"mem_mb\":");
+        out.appendFixed(memory, 2);
+        out.append(",\"command\":");
+        appendJsonString(out, process.command);
+        out.append("}\n");
+    }
+    else
+    {
+        out.appendInt(timestampMs);
+        out.append(1, ',');
+        out.appendInt(process.pid);
+        out.append(1, ',');
+        appendCsvField(out, process.user);
+        out.append(1, ',');
+        out.appendFixed(cpu, 2);
+        out.append(1, ',');
+        out.appendFixed(memory, 2);
+        out.append(1, ',');
+        appendCsvField(out, process.command);
+        out.append(1, '\n');
+    }
+}
+
+bool StreamWriter::flush()
+{
+    bool written = m_buffer.writeTo(m_fd);
+    m_buffer.clear();
+    return written;
+}
+
+void selectStreamRows(const std::vector<Process>& processes, size_t top, const std::string& sortBy,
+                      std::vector<const Process*>& rows)
+{
+    rows.clear();
+    for (const auto& process : processes)
+    {
+        rows.push_back(&process);
+    }
+    if (top == 0)
+    {
+        return;
+    }
+
+    auto ranksHigher = [&sortBy](const Process* a, const Process* b) {
+        return sortBy == "memory" ? a->memoryUsage > b->memoryUsage : a->cpuUsage > b->cpuUsage;
+    };
+    if (top < rows.size())
+    {
+        std::nth_element(rows.begin(), rows.begin() + top, rows.end(), ranksHigher);
+        rows.resize(top);
+    }
+    std::sort(rows.begin(), rows.end(), ranksHigher);
+}
+
+int runStreamMode(const CliOptions& options)
+{
+    std::signal(SIGINT, handleStreamSignal);
+    std::signal(SIGTERM, handleStreamSignal);
+    std::signal(SIGPIPE, SIG_IGN); // A closed pipe is reported as EPIPE by write()
+    Logger::getInstance().info("Stream mode started with an interval of {} ms.", options.intervalMs);
+
+    StreamWriter writer(STDOUT_FILENO, options.streamFormat);
+    std::vector<const Process*> rows;
+    const auto interval = std::chrono::milliseconds(options.intervalMs);
+
+    // The first scan only establishes the CPU times the usage of the next epoch is measured against
+    long previousTotalCpuTime = getTotalCpuTime();
+    sampleEpoch(previousTotalCpuTime);
+
+    int status = 0;
+    long epochs = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (!streamStopRequested.load() && (options.count == 0 || epochs < options.count))
+    {
+        // Keep epochs on a fixed schedule; after a slow epoch, sample again right away
+        next = std::max(next + interval, std::chrono::steady_clock::now());
+        while (!streamStopRequested.load() && std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                next - std::chrono::steady_clock::now(), kStopPollInterval));
+        }
+        if (streamStopRequested.load())
+            break;
+
+        auto snapshot = sampleEpoch(previousTotalCpuTime);
+        policyEngine.run(*snapshot, snapshot->timestampMs);
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+        if (historyStore.isOpen() && !historyStore.append(nowMs, snapshot->processes))
+        {
+            Logger::getInstance().error("Failed to append epoch to history store.");
+        }
+
+        selectStreamRows(snapshot->processes, options.top, options.sortBy, rows);
+        if (!writer.writeEpoch(nowMs, rows))
+        {
+            // The reader going away (e.g., `| head`) is a normal way to end the stream
+            if (errno != EPIPE)
+            {
+                std::cerr << "Failed to write stream output." << std::endl;
+                status = 1;
+            }
+            break;
+        }
+        ++epochs;
+    }
+
+    Logger::getInstance().info("Stream mode stopped after {} epochs and {} records.", epochs,
+                               writer.recordsWritten());
+    return status;
+}
@@ -0,0 +1,416 @@
+/**
+ * @file synthetic_proc.cpp
+ * @brief Implements the generator for fake procfs trees.
+ *
+ * This source file contains the implementation of the SyntheticProcTree class. Every per-process
+ * parameter is derived from a hash of the seed and the PID, and every value written to disk is a
+ * closed-form function of those parameters and the tick, which keeps the generator deterministic
+ * and lets it write any tick directly. Files are written with plain `open`/`write` calls because
+ * trees with a million PIDs contain millions of files, each to a temporary file renamed over the
+ * target so that a sampler reading the tree meanwhile never sees an empty or partial file.
+ */
+
+#include "synthetic_proc.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// Command names used for generated processes (no spaces, at most 15 characters like the kernel's comm)
+const char* const kCommands[] = {"systemd", "postgres", "nginx",   "bash",    "cc1plus", "java",
+                                 "python3", "sshd",     "redis",   "node",    "make",    "kworker",
+                                 "dockerd", "chrome",   "rsyslogd", "containerd"};
+const int kCommandCount = sizeof(kCommands) / sizeof(kCommands[0]);
+
+// UIDs of generated processes: root, regular users, www-data, postgres-like service account, nobody
+const int kUids[] = {0, 0, 1000, 1001, 33, 999, 65534};
+const int kUidCount = sizeof(kUids) / sizeof(kUids[0]);
+
+// Aggregate CPU time of the host before the first tick
+const long kBaseTotalTime = 1000000;
+
+// Microseconds per clock tick (USER_HZ is 100 on Linux), to turn process times into cgroup times
+const unsigned long long kUsecPerJiffy = 10000;
+
+// Cgroup holding the generated containers, below the cgroup root
+const char kCgroupSlice[] = "system.slice";
+
+// SplitMix64 finalizer, used as a fast and well-distributed hash of (seed, pid, salt)
+uint64_t mix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Replaces a whole file atomically: readers see either the previous contents or the new ones
+bool writeFile(const std::string& path, const char* data, size_t length)
+{
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool ok = write(fd, data, length) == static_cast<ssize_t>(length);
+    close(fd);
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SyntheticProcTree::SyntheticProcTree(std::string root, SyntheticProcOptions options)
+    : m_root(std::move(root)), m_options(options), m_tick(-1)
+{
+    if (m_options.cpuCount <= 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        m_options.cpuCount = online > 0 ? static_cast<int>(online) : 1;
+    }
+}
+
+bool SyntheticProcTree::writeTick(long tick)
+{
+    bool createFiles = m_tick < 0;
+    if (createFiles)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(m_root, ec);
+        if (ec)
+        {
+            return false;
+        }
+    }
+
+    bool ok = writeAggregateStat(tick);
+    for (int i = 0; i < m_options.pidCount && ok; ++i)
+    {
+        ok = writeProcess(m_options.firstPid + i, tick, createFiles);
+    }
+    if (ok && m_options.cgroupCount > 0)
+    {
+        ok = writeCgroups(tick, createFiles);
+    }
+    m_tick = tick;
+    return ok;
+}
+
+bool SyntheticProcTree::advance()
+{
+    return writeTick(m_tick + 1);
+}
+
+void SyntheticProcTree::remove()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(m_root, ec);
+    if (m_options.cgroupCount > 0)
+    {
+        std::filesystem::remove_all(m_options.cgroupRoot, ec);
+    }
+    m_tick = -1;
+}
+
+const std::string& SyntheticProcTree::root() const
+{
+    return m_root;
+}
+
+long SyntheticProcTree::currentTick() const
+{
+    return m_tick;
+}
+
+int SyntheticProcTree::cpuCount() const
+{
+    return m_options.cpuCount;
+}
+
+SyntheticProfile SyntheticProcTree::profileOf(int pid) const
+{
+    return paramsOf(pid).profile;
+}
+
+long SyntheticProcTree::processTimeAt(int pid, long tick) const
+{
+    Params params = paramsOf(pid);
+    return params.baseTime +
+           static_cast<long>(params.rate) * m_options.jiffiesPerTick * busyTicksUntil(params, tick) / 100;
+}
+
+long SyntheticProcTree::totalTimeAt(long tick) const
+{
+    return kBaseTotalTime + tick * m_options.jiffiesPerTick * m_options.cpuCount;
+}
+
+long SyntheticProcTree::rssKbAt(int pid, long tick) const
+{
+    Params params = paramsOf(pid);
+    switch (params.profile)
+    {
+    case SyntheticProfile::BURSTY:
+        // Memory is allocated while busy and released at the end of every cycle
+        return params.baseRssKb + params.growthKb * std::min<long>(tick % params.period, params.busyTicks);
+    case SyntheticProfile::LEAKING:
+        return params.baseRssKb + params.growthKb * tick;
+    default:
+        return params.baseRssKb;
+    }
+}
+
+int SyntheticProcTree::uidOf(int pid) const
+{
+    return paramsOf(pid).uid;
+}
+
+std::string SyntheticProcTree::commandOf(int pid) const
+{
+    return kCommands[paramsOf(pid).command];
+}
+
+int SyntheticProcTree::parentOf(int pid) const
+{
+    if (pid <= m_options.firstPid)
+    {
+        return 0; // The first process plays the role of init
+    }
+    uint64_t hash = mix(m_options.seed ^ (static_cast<uint64_t>(pid) << 20) ^ 0x5050);
+    if (hash % 10 < 6)
+    {
+        return m_options.firstPid; // Most processes are children of init
+    }
+    // Otherwise pick an earlier PID so the parent/child graph is always a tree
+    return m_options.firstPid + static_cast<int>((hash >> 8) % static_cast<uint64_t>(pid - m_options.firstPid));
+}
+
+std::string SyntheticProcTree::cgroupOf(int pid) const
+{
+    if (m_options.cgroupCount <= 0)
+    {
+        return "";
+    }
+    int container = (pid - m_options.firstPid) % m_options.cgroupCount;
+    return std::string(kCgroupSlice) + "/container-" + std::to_string(container) + ".scope";
+}
+
+SyntheticProcTree::Params SyntheticProcTree::paramsOf(int pid) const
+{
+    uint64_t hash = mix(m_options.seed ^ (static_cast<uint64_t>(pid) << 20));
+    uint64_t second = mix(hash);
+
+    Params params;
+    int bucket = static_cast<int>(hash % 100);
+    if (bucket < 70)
+    {
+        params.profile = SyntheticProfile::IDLE;
+        params.rate = 0;
+    }
+    else if (bucket < 90)
+    {
+        params.profile = SyntheticProfile::STEADY;
+        params.rate = 1 + static_cast<int>((hash >> 8) % 30);
+    }
+    else if (bucket < 98)
+    {
+        params.profile = SyntheticProfile::BURSTY;
+        params.rate = 20 + static_cast<int>((hash >> 8) % 76);
+    }
+    else
+    {
+        params.profile = SyntheticProfile::LEAKING;
+        params.rate = 2 + static_cast<int>((hash >> 8) % 9);
+    }
+
+    params.period = 4 + static_cast<int>((hash >> 16) % 12);
+    params.busyTicks = 1 + static_cast<int>((hash >> 24) % params.period);
+    params.baseTime = static_cast<long>((second >> 4) % 500000);
+    params.baseRssKb = (1024L << ((second >> 24) % 11)) + static_cast<long>((second >> 32) % 1024);
+    params.growthKb = params.profile == SyntheticProfile::LEAKING ? 512 + static_cast<long>((second >> 40) % 4096)
+                                                                  : 64 + static_cast<long>((second >> 40) % 1024);
+    params.uid = kUids[(second >> 48) % kUidCount];
+    params.command = static_cast<int>((second >> 52) % kCommandCount);
+    params.startTime = 100 + static_cast<long>(pid - m_options.firstPid) * 3;
+    return params;
+}
+
+long SyntheticProcTree::busyTicksUntil(const Params& params, long tick) const
+{
+    switch (params.profile)
+    {
+    case SyntheticProfile::IDLE:
+        return 0;
+    case SyntheticProfile::BURSTY:
+        return (tick / params.period) * params.busyTicks + std::min<long>(tick % params.period, params.busyTicks);
+    default:
+        return tick;
+    }
+}
+
+bool SyntheticProcTree::writeProcess(int pid, long tick, bool createFiles)
+{
+    Params params = paramsOf(pid);
+    std::string dir = m_root + "/" + std::to_string(pid);
+    char buffer[512];
+
+    if (createFiles)
+    {
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            return false;
+        }
+        int length = snprintf(buffer, sizeof(buffer), "%s\n", kCommands[params.command]);
+        if (!writeFile(dir + "/comm", buffer, length))
+        {
+            return false;
+        }
+        if (m_options.cgroupCount > 0)
+        {
+            length = snprintf(buffer, sizeof(buffer), "0::/%s\n", cgroupOf(pid).c_str());
+            if (!writeFile(dir + "/cgroup", buffer, length))
+            {
+                return false;
+            }
+        }
+    }
+    else if (params.profile == SyntheticProfile::IDLE)
+    {
+        return true; // Idle processes never change after the first write
+    }
+
+    long busyNow = busyTicksUntil(params, tick + 1) - busyTicksUntil(params, tick);
+    char state = busyNow > 0 ? 'R' : 'S';
+    long cpuTime = processTimeAt(pid, tick);
+    long utime = cpuTime * 3 / 4;
+    long stime = cpuTime - utime;
+    long rssKb = rssKbAt(pid, tick);
+    int ppid = parentOf(pid);
+
+    int length = snprintf(buffer, sizeof(buffer),
+                          "%d (%s) %c %d %d %d 0 -1 4194560 %ld 0 %ld 0 %ld %ld 0 0 20 0 1 0 %ld %ld %ld "
+                          "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                          pid, kCommands[params.command], state, ppid, pid, pid, cpuTime / 10, cpuTime / 1000, utime,
+                          stime, params.startTime, (rssKb + 4096) * 1024, rssKb / 4);
+    if (!writeFile(dir + "/stat", buffer, length))
+    {
+        return false;
+    }
+
+    length = snprintf(buffer, sizeof(buffer),
+                      "Name:\t%s\nUmask:\t0022\nState:\t%c\nTgid:\t%d\nPid:\t%d\nPPid:\t%d\n"
+                      "Uid:\t%d\t%d\t%d\t%d\nGid:\t%d\t%d\t%d\t%d\n"
+                      "VmSize:\t%8ld kB\nVmRSS:\t%8ld kB\nThreads:\t1\n",
+                      kCommands[params.command], state, pid, pid, ppid, params.uid, params.uid, params.uid, params.uid,
+                      params.uid, params.uid, params.uid, params.uid, rssKb + 4096, rssKb);
+    return writeFile(dir + "/status", buffer, length);
+}
+
+bool SyntheticProcTree::writeAggregateStat(long tick)
+{
+    long total = totalTimeAt(tick);
+    long user = total / 4;
+    long system = total / 8;
+    long idle = total - user - system;
+
+    std::string contents;
+    char buffer[160];
+    int length = snprintf(buffer, sizeof(buffer), "cpu  %ld 0 %ld %ld 0 0 0 0 0 0\n", user, system, idle);
+    contents.append(buffer, length);
+    for (int cpu = 0; cpu < m_options.cpuCount; ++cpu)
+    {
+        length = snprintf(buffer, sizeof(buffer), "cpu%d %ld 0 %ld %ld 0 0 0 0 0 0\n", cpu, user / m_options.cpuCount,
+                          system / m_options.cpuCount, idle / m_options.cpuCount);
+        contents.append(buffer, length);
+    }
+    length = snprintf(buffer, sizeof(buffer), "btime 1700000000\nprocesses %d\nprocs_running 1\nprocs_blocked 0\n",
+                      m_options.pidCount);
+    contents.append(buffer, length);
+    return writeFile(m_root + "/stat", contents.data(), contents.size());
+}
+
+// Writes the counters of every container, summed over its processes, and of the slice holding them
+bool SyntheticProcTree::writeCgroups(long tick, bool createFiles)
+{
+    struct Totals
+    {
+        unsigned long long time = 0; // Jiffies
+        unsigned long long rssKb = 0;
+        unsigned long long pids = 0;
+        std::string procs;
+    };
+    std::vector<Totals> containers(m_options.cgroupCount);
+    Totals slice;
+    for (int i = 0; i < m_options.pidCount; ++i)
+    {
+        int pid = m_options.firstPid + i;
+        Totals& totals = containers[i % m_options.cgroupCount];
+        totals.time += processTimeAt(pid, tick);
+        totals.rssKb += rssKbAt(pid, tick);
+        totals.pids++;
+        if (createFiles)
+        {
+            totals.procs += std::to_string(pid) + "\n";
+        }
+    }
+    for (const Totals& totals : containers)
+    {
+        slice.time += totals.time;
+        slice.rssKb += totals.rssKb;
+        slice.pids += totals.pids;
+    }
+
+    auto writeCgroup = [&](const std::string& dir, const Totals& totals) {
+        char buffer[256];
+        if (createFiles)
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+            if (ec || !writeFile(dir + "/cgroup.procs", totals.procs.data(), totals.procs.size()) ||
+                !writeFile(dir + "/cgroup.kill", "", 0) || !writeFile(dir + "/cpu.max", "max 100000\n", 11))
+            {
+                return false;
+            }
+        }
+        unsigned long long usage = totals.time * kUsecPerJiffy;
+        int length = snprintf(buffer, sizeof(buffer),
+                              "usage_usec %llu\nuser_usec %llu\nsystem_usec %llu\nnr_periods 0\nnr_throttled 0\n"
+                              "throttled_usec 0\n",
+                              usage, usage * 3 / 4, usage - usage * 3 / 4);
+        if (!writeFile(dir + "/cpu.stat", buffer, length))
+        {
+            return false;
+        }
+        length = snprintf(buffer, sizeof(buffer), "%llu\n", totals.rssKb * 1024);
+        if (!writeFile(dir + "/memory.current", buffer, length))
+        {
+            return false;
+        }
+        length = snprintf(buffer, sizeof(buffer), "%llu\n", totals.pids);
+        return writeFile(dir + "/pids.current", buffer, length);
+    };
+
+    std::string sliceDir = m_options.cgroupRoot + "/" + kCgroupSlice;
+    bool ok = writeCgroup(sliceDir, slice);
+    if (ok && createFiles)
+    {
+        ok = writeFile(m_options.cgroupRoot + "/cgroup.controllers", "cpu memory pids\n", 16);
+    }
+    for (int container = 0; container < m_options.cgroupCount && ok; ++container)
+    {
+        ok = writeCgroup(sliceDir + "/container-" + std::to_string(container) + ".scope", containers[container]);
+    }
+    return ok;
+}
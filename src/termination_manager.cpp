@@ -0,0 +1,321 @@
+/**
+ * @file termination_manager.cpp
+ * @brief Implements the graceful termination of processes on one epoll-driven thread.
+ *
+ * Processes for which the kernel gives no pidfd (no pidfd support, or no descriptor left) are not
+ * watched for their exit: at the end of their grace period, their start time tells whether they
+ * are still running, and they get SIGKILL if so.
+ *
+ * If the thread cannot be started (no epoll instance or eventfd) or epoll fails under it, nothing
+ * can wait for a grace period: the processes get SIGKILL at once, and the request still completes.
+ */
+
+#include "termination_manager.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Events handled per epoll_wait()
+const int kEventBatch = 256;
+
+// Key of the eventfd in the epoll set
+const uint64_t kWakeupKey = 0;
+
+} // namespace
+
+TerminationManager& TerminationManager::getInstance()
+{
+    static TerminationManager instance;
+    return instance;
+}
+
+TerminationManager::TerminationManager()
+    : m_stopping(false), m_running(false), m_epoll(-1), m_wakeup(-1), m_pending(0), m_nextKey(kWakeupKey + 1)
+{
+}
+
+TerminationManager::~TerminationManager()
+{
+    stop();
+}
+
+void TerminationManager::terminate(std::vector<KillTarget> targets, int graceMs, Completion done)
+{
+    auto job = std::make_shared<Job>();
+    job->targets = std::move(targets);
+    job->graceMs = std::max(graceMs, 0);
+    job->done = std::move(done);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_thread.joinable() && !m_running)
+        {
+            m_thread.join(); // It gave up after epoll failed: try a new one
+            closeDescriptors();
+        }
+        if (m_thread.joinable() || startThread())
+        {
+            m_requests.push_back(std::move(job));
+            uint64_t one = 1;
+            (void)!write(m_wakeup, &one, sizeof(one));
+            return;
+        }
+    }
+    killNow(*job);
+}
+
+// Starts the manager thread with its epoll set; called with `m_mutex` held.
+bool TerminationManager::startThread()
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeupKey;
+    if (m_epoll < 0 || m_wakeup < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event) != 0)
+    {
+        closeDescriptors();
+        return false;
+    }
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&TerminationManager::run, this);
+    return true;
+}
+
+void TerminationManager::closeDescriptors()
+{
+    if (m_epoll >= 0)
+        close(m_epoll);
+    if (m_wakeup >= 0)
+        close(m_wakeup);
+    m_epoll = m_wakeup = -1;
+}
+
+// Completes a request that cannot wait for its grace period: SIGKILL for every target at once.
+void TerminationManager::killNow(Job& job)
+{
+    job.report = signalProcesses(job.targets, SIGKILL, 1);
+    if (job.done)
+        job.done(job.report);
+}
+
+size_t TerminationManager::pending() const
+{
+    return m_pending.load();
+}
+
+void TerminationManager::stop()
+{
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable())
+            return;
+        m_stopping = true;
+        uint64_t one = 1;
+        (void)!write(m_wakeup, &one, sizeof(one));
+        thread = std::move(m_thread);
+    }
+    thread.join();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closeDescriptors();
+}
+
+// Waits for exits and grace periods until stopped with nothing left to wait for.
+void TerminationManager::run()
+{
+    epoll_event events[kEventBatch];
+    for (;;)
+    {
+        int timeoutMs = -1;
+        if (!m_deadlines.empty())
+        {
+            auto left = m_deadlines.top().first - Clock::now();
+            // Round up, so that the deadline has passed when epoll_wait() times out
+            timeoutMs = static_cast<int>(
+                std::max<int64_t>(0, std::chrono::ceil<std::chrono::milliseconds>(left).count()));
+        }
+        int ready = epoll_wait(m_epoll, events, kEventBatch, timeoutMs);
+        if (ready < 0 && errno != EINTR)
+        {
+            abandon();
+            return;
+        }
+
+        for (int i = 0; i < ready; ++i)
+        {
+            uint64_t key = events[i].data.u64;
+            if (key != kWakeupKey)
+            {
+                // The process exited: SIGTERM was enough
+                auto watch = m_watches.find(key);
+                if (watch != m_watches.end())
+                    finish(key, KillResult{watch->second.job->targets[watch->second.index].pid,
+                                           KillOutcome::Terminated, 0});
+                continue;
+            }
+            uint64_t count;
+            (void)!read(m_wakeup, &count, sizeof(count));
+        }
+
+        // Start the new requests
+        bool stopping;
+        std::deque<std::shared_ptr<Job>> requests;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            requests.swap(m_requests);
+            stopping = m_stopping;
+        }
+        for (const auto& job : requests)
+        {
+            startJob(job);
+        }
+
+        // Kill what outlived its grace period
+        Clock::time_point now = Clock::now();
+        while (!m_deadlines.empty() && m_deadlines.top().first <= now)
+        {
+            uint64_t key = m_deadlines.top().second;
+            m_deadlines.pop();
+            if (m_watches.count(key) != 0)
+                escalate(key);
+        }
+
+        if (stopping && m_watches.empty())
+            break;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+}
+
+// epoll failed: kills every watched process and every queued request now, and ends the thread,
+// which the next request replaces.
+void TerminationManager::abandon()
+{
+    while (!m_watches.empty())
+    {
+        escalate(m_watches.begin()->first);
+    }
+    m_deadlines = {};
+
+    std::deque<std::shared_ptr<Job>> requests;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        requests.swap(m_requests);
+        m_running = false;
+    }
+    for (const auto& job : requests)
+    {
+        killNow(*job);
+    }
+}
+
+// Sends SIGTERM to every target of a request that is still the sampled process, and watches them.
+void TerminationManager::startJob(const std::shared_ptr<Job>& job)
+{
+    job->report.results.resize(job->targets.size());
+    job->remaining = job->targets.size();
+    if (job->remaining == 0)
+    {
+        if (job->done)
+            job->done(job->report);
+        return;
+    }
+
+    pid_t self = getpid();
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(job->graceMs);
+    for (size_t i = 0; i < job->targets.size(); ++i)
+    {
+        const KillTarget& target = job->targets[i];
+        int pidfd;
+        KillResult result;
+        if (!openProcessHandle(target, self, pidfd, result))
+        {
+            complete(*job, i, result);
+            continue;
+        }
+        result = signalProcessHandle(target, pidfd, SIGTERM);
+        if (result.outcome != KillOutcome::Killed)
+        {
+            if (pidfd >= 0)
+                close(pidfd);
+            complete(*job, i, result);
+            continue;
+        }
+
+        uint64_t key = m_nextKey++;
+        if (pidfd >= 0)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = key;
+            if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, pidfd, &event) != 0)
+            {
+                // Not watched: checked by its start time at the deadline instead
+                close(pidfd);
+                pidfd = -1;
+            }
+        }
+        m_watches.emplace(key, Watch{job, i, pidfd});
+        m_deadlines.emplace(deadline, key);
+        m_pending++;
+    }
+}
+
+// The grace period of a watched process is over: SIGKILL it, unless it is gone.
+void TerminationManager::escalate(uint64_t key)
+{
+    Watch& watch = m_watches[key];
+    const KillTarget& target = watch.job->targets[watch.index];
+    KillResult result;
+    if (watch.pidfd >= 0)
+    {
+        result = signalProcessHandle(target, watch.pidfd, SIGKILL);
+    }
+    else
+    {
+        // Not watched: the start time tells whether it is still the same process
+        int pidfd;
+        if (openProcessHandle(target, getpid(), pidfd, result))
+            result = signalProcessHandle(target, pidfd, SIGKILL);
+        else if (result.outcome == KillOutcome::NotFound || result.outcome == KillOutcome::Recycled)
+            result = KillResult{target.pid, KillOutcome::Terminated, 0};
+    }
+    if (result.outcome == KillOutcome::NotFound)
+    {
+        result = KillResult{target.pid, KillOutcome::Terminated, 0}; // Exited just before the deadline
+    }
+    finish(key, result);
+}
+
+// Stops watching a process and records its outcome.
+void TerminationManager::finish(uint64_t key, const KillResult& result)
+{
+    auto watch = m_watches.find(key);
+    if (watch->second.pidfd >= 0)
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, watch->second.pidfd, nullptr);
+        close(watch->second.pidfd);
+    }
+    std::shared_ptr<Job> job = std::move(watch->second.job);
+    size_t index = watch->second.index;
+    m_watches.erase(watch);
+    m_pending--;
+    complete(*job, index, result);
+}
+
+// Records the outcome of one target, and reports the request once it has them all.
+void TerminationManager::complete(Job& job, size_t index, const KillResult& result)
+{
+    job.report.results[index] = result;
+    if (--job.remaining == 0 && job.done)
+    {
+        job.done(job.report);
+    }
+}
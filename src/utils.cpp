@@ -4,10 +4,12 @@
  * This source file contains helper functions that perform common tasks required
  * across different modules of the application. Specifically, it includes functions
  * to convert User IDs (UIDs) to their corresponding usernames by interfacing with
- * the system's user database.
+ * the system's user database, and to build paths inside the configured proc root.
  */
 
 #include "utils.h"
+#include "globals.h"
+#include "log_site.h"
 #include "logger.h"
 #include <pwd.h>
 
@@ -15,12 +17,28 @@
 std::string getUserNameFromUid(int uid)
 {
     // Retrieve password structure based on UID
+    static LogSite site("user name lookups");
     struct passwd* pw = getpwuid(uid);
     if (pw)
     {
-        Logger::getInstance().warning("Unable to find username for UID: " + std::to_string(uid));
+        // Called for every process listed: keep the warning from flooding the log
+        if (site.allow())
+            Logger::getInstance().warning("Unable to find username for UID: {}", uid);
         return "Unknown";
     }
     // Return "Unknown" if the username cannot be determined
     return "Unknown";
 }
+
+// Utility function to build /proc/[pid]/[name] relative to the configured proc root
+std::string procFilePath(int pid, const char* name)
+{
+    std::string path;
+    path.reserve(procRoot.size() + 24);
+    path += procRoot;
+    path += '/';
+    path += std::to_string(pid);
+    path += '/';
+    path += name;
+    return path;
+}
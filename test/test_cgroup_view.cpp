@@ -0,0 +1,180 @@
+/**
+ * @file test_cgroup_view.cpp
+ *
+ * This test suite verifies the cgroup view against a synthetic host whose processes are spread
+ * over containers: the counters read per cgroup must match the sums scripted for their processes,
+ * the CPU usage must follow the scripted rates, and the actions must write the interface files.
+ */
+
+#include "cgroup_view.h"
+#include "globals.h"
+#include "synthetic_proc.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+/**
+ * @brief Fixture that writes a synthetic host with 4 containers and points `cgroupRoot` at its cgroups.
+ */
+class CgroupViewTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_fakecgroup_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+
+        SyntheticProcOptions options;
+        options.pidCount = 40;
+        options.firstPid = 100;
+        options.cpuCount = 4;
+        options.cgroupCount = 4;
+        options.cgroupRoot = std::string(dirTemplate) + "/cgroup";
+        tree = new SyntheticProcTree(std::string(dirTemplate) + "/proc", options);
+        ASSERT_TRUE(tree->writeTick(0));
+
+        directory = dirTemplate;
+        savedRoot = cgroupRoot;
+        cgroupRoot = options.cgroupRoot;
+    }
+
+    void TearDown() override
+    {
+        cgroupRoot = savedRoot;
+        tree->remove();
+        delete tree;
+        rmdir(directory.c_str());
+    }
+
+    static std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::string contents;
+        std::getline(file, contents);
+        return contents;
+    }
+
+    SyntheticProcTree* tree = nullptr;
+    std::string directory;
+    std::string savedRoot;
+};
+
+// Every container is listed below its slice, and its counters are the sums of its processes
+TEST_F(CgroupViewTest, ReadsContainerTotals)
+{
+    EXPECT_TRUE(cgroupHierarchyAvailable());
+    std::vector<std::string> paths = listCgroups();
+    ASSERT_EQ(paths.size(), 5u);
+    EXPECT_EQ(paths[0], "system.slice");
+
+    for (int container = 0; container < 4; ++container)
+    {
+        std::string path = "system.slice/container-" + std::to_string(container) + ".scope";
+        uint64_t usageUsec = 0, memoryBytes = 0, pids = 0;
+        for (int pid = 100; pid < 140; ++pid)
+        {
+            if (tree->cgroupOf(pid) == path)
+            {
+                usageUsec += tree->processTimeAt(pid, 0) * 10000ULL;
+                memoryBytes += tree->rssKbAt(pid, 0) * 1024ULL;
+                pids++;
+            }
+        }
+
+        CgroupStats stats;
+        ASSERT_TRUE(readCgroupStats(path, stats));
+        EXPECT_EQ(stats.pids, 10u);
+        EXPECT_EQ(stats.pids, pids);
+        EXPECT_EQ(stats.usageUsec, usageUsec);
+        EXPECT_EQ(stats.memoryBytes, memoryBytes);
+    }
+
+    CgroupStats stats;
+    EXPECT_FALSE(readCgroupStats("system.slice/missing.scope", stats));
+}
+
+// The CPU usage of a container is the CPU time it used between two samples over the elapsed time
+TEST_F(CgroupViewTest, CpuUsageFollowsScript)
+{
+    CgroupSampler sampler;
+    auto start = CgroupSampler::Clock::now();
+    std::vector<CgroupUsage> first = sampler.sample(start);
+    ASSERT_EQ(first.size(), 5u);
+    for (const CgroupUsage& cgroup : first)
+    {
+        EXPECT_EQ(cgroup.cpuUsage, 0.0) << cgroup.path;
+    }
+
+    // One tick is 100 jiffies per core, i.e. one second of wall time
+    ASSERT_TRUE(tree->advance());
+    std::vector<CgroupUsage> second = sampler.sample(start + std::chrono::seconds(1));
+    ASSERT_EQ(second.size(), 5u);
+    double total = 0.0;
+    for (const CgroupUsage& cgroup : second)
+    {
+        if (cgroup.path == "system.slice")
+            continue;
+        double expected = 0.0;
+        for (int pid = 100; pid < 140; ++pid)
+        {
+            if (tree->cgroupOf(pid) == cgroup.path)
+                expected += tree->processTimeAt(pid, 1) - tree->processTimeAt(pid, 0); // Jiffies, i.e. percent
+        }
+        EXPECT_NEAR(cgroup.cpuUsage, expected, 1e-6) << cgroup.path;
+        total += cgroup.cpuUsage;
+    }
+    EXPECT_NEAR(second[0].cpuUsage, total, 1e-6);
+}
+
+// Filters and sorting follow the process view
+TEST_F(CgroupViewTest, FilterAndSort)
+{
+    std::vector<CgroupUsage> cgroups = {
+        {"a.slice/web.scope", 12.5, 300.0, 4}, {"a.slice/db.scope", 80.0, 2048.0, 9}, {"b.slice", 1.0, 50.0, 1}};
+
+    std::vector<CgroupUsage> busy = cgroups;
+    filterCgroups(busy, {"cpu", "10"});
+    ASSERT_EQ(busy.size(), 2u);
+    sortCgroups(busy, "cpu");
+    EXPECT_EQ(busy[0].path, "a.slice/db.scope");
+
+    std::vector<CgroupUsage> named = cgroups;
+    filterCgroups(named, {"cgroup", "web"});
+    ASSERT_EQ(named.size(), 1u);
+    EXPECT_EQ(named[0].path, "a.slice/web.scope");
+
+    std::vector<CgroupUsage> all = cgroups;
+    filterCgroups(all, {"user", "root"}); // Does not apply to cgroups
+    EXPECT_EQ(all.size(), 3u);
+    sortCgroups(all, "memory");
+    EXPECT_EQ(all[2].path, "b.slice");
+    sortCgroups(all, "path");
+    EXPECT_EQ(all[0].path, "a.slice/db.scope");
+}
+
+// cgroup.kill and cpu.max receive what the kernel expects; paths outside the hierarchy are refused
+TEST_F(CgroupViewTest, KillAndThrottle)
+{
+    std::string path = "system.slice/container-1.scope";
+    std::string error;
+    ASSERT_TRUE(killCgroup(path, error)) << error;
+    EXPECT_EQ(readFile(cgroupRoot + "/" + path + "/cgroup.kill"), "1");
+
+    ASSERT_TRUE(setCgroupCpuMax("/" + path + "/", 50, error)) << error;
+    EXPECT_EQ(readFile(cgroupRoot + "/" + path + "/cpu.max"), "50000 100000");
+    ASSERT_TRUE(setCgroupCpuMax(path, 0.1, error)) << error;
+    EXPECT_EQ(readFile(cgroupRoot + "/" + path + "/cpu.max"), "1000 100000");
+    ASSERT_TRUE(setCgroupCpuMax(path, 0, error)) << error;
+    EXPECT_EQ(readFile(cgroupRoot + "/" + path + "/cpu.max"), "max 100000");
+
+    EXPECT_FALSE(killCgroup("/", error));
+    EXPECT_FALSE(killCgroup("system.slice/../..", error));
+    EXPECT_FALSE(killCgroup("system.slice/missing.scope", error));
+    EXPECT_FALSE(setCgroupCpuMax(path, -5, error));
+    EXPECT_FALSE(setCgroupCpuMax(path, 1e30, error));
+    EXPECT_FALSE(setCgroupCpuMax(path, std::nan(""), error));
+    EXPECT_FALSE(setCgroupCpuMax(path, HUGE_VAL, error));
+    EXPECT_EQ(readFile(cgroupRoot + "/" + path + "/cpu.max"), "max 100000");
+}
@@ -10,6 +10,7 @@
 #include "command_handler.h"
 #include "globals.h"
 #include "logger.h"
+#include <cmath>
 #include <gtest/gtest.h>
 #include <string>
 #include <sstream>
@@ -29,16 +30,27 @@ static std::string runCommand(const std::string& input) {
     std::ostringstream output;
 
     if (command == "set_update_freq") {
-        int newFreq;
-        if (iss >> newFreq) {
-            if (newFreq <= 0) {
-                output << "Invalid frequency. Please provide a positive integer value.\n";
-            } else {
-                updateFrequency.store(newFreq);
-                output << "Update frequency set to " << newFreq << " seconds.\n";
-            }
+        std::string target = "sample";
+        std::string argument;
+        double seconds = 0.0;
+        if (iss >> argument && (argument == "sample" || argument == "display")) {
+            target = argument;
+            argument.clear();
+            iss >> argument;
+        }
+        std::istringstream number(argument);
+        bool parsed = !argument.empty() && (number >> seconds) && number.eof();
+        if (!parsed) {
+            output << "Usage: set_update_freq <seconds>\n"
+                   << "       set_update_freq <sample|display> <seconds>\n";
+        } else if (!std::isfinite(seconds) || seconds * 1000 < 50 || seconds * 1000 > 86400000) {
+            output << "Invalid frequency. Please provide a value between 0.05 and 86400 seconds.\n";
+        } else if (target == "sample") {
+            sampleIntervalMs.store(static_cast<int>(seconds * 1000 + 0.5));
+            output << "Update frequency set to " << seconds << " seconds.\n";
         } else {
-            output << "Usage: set_update_freq <seconds>\n";
+            displayIntervalMs.store(static_cast<int>(seconds * 1000 + 0.5));
+            output << "Display frequency set to " << seconds << " seconds.\n";
         }
     }
     else if (command == "filter") {
@@ -121,22 +133,49 @@ static std::string runCommand(const std::string& input) {
 // Test case to verify setting a valid update frequency
 TEST(CommandHandlerTest, SetUpdateFreqValid) {
     // Assume default is 5 seconds
-    updateFrequency.store(5);
+    sampleIntervalMs.store(5000);
     std::string output = runCommand("set_update_freq 10");
-    EXPECT_EQ(updateFrequency.load(), 10);
+    EXPECT_EQ(sampleIntervalMs.load(), 10000);
     EXPECT_NE(output.find("Update frequency set to 10 seconds."), std::string::npos);
+
+    output = runCommand("set_update_freq sample 2");
+    EXPECT_EQ(sampleIntervalMs.load(), 2000);
+}
+
+// Test case to verify that the display interval is set independently of the sampling interval
+TEST(CommandHandlerTest, SetDisplayFreqValid) {
+    sampleIntervalMs.store(5000);
+    displayIntervalMs.store(1000);
+    std::string output = runCommand("set_update_freq display 0.25");
+    EXPECT_EQ(displayIntervalMs.load(), 250);
+    EXPECT_EQ(sampleIntervalMs.load(), 5000);
+    EXPECT_NE(output.find("Display frequency set to 0.25 seconds."), std::string::npos);
 }
 
 // Test case to verify setting an invalid update frequency
 TEST(CommandHandlerTest, SetUpdateFreqInvalid) {
-    updateFrequency.store(5);
+    sampleIntervalMs.store(5000);
     std::string output = runCommand("set_update_freq -5");
     // Frequency should remain unchanged
-    EXPECT_EQ(updateFrequency.load(), 5);
+    EXPECT_EQ(sampleIntervalMs.load(), 5000);
+    EXPECT_NE(output.find("Invalid frequency."), std::string::npos);
+
+    // Too long to fit the interval in milliseconds
+    output = runCommand("set_update_freq 3e6");
+    EXPECT_EQ(sampleIntervalMs.load(), 5000);
     EXPECT_NE(output.find("Invalid frequency."), std::string::npos);
 
     output = runCommand("set_update_freq");
     EXPECT_NE(output.find("Usage: set_update_freq <seconds>"), std::string::npos);
+
+    // Trailing junk after the interval is rejected in both forms
+    displayIntervalMs.store(1000);
+    output = runCommand("set_update_freq display 2x");
+    EXPECT_EQ(displayIntervalMs.load(), 1000);
+    EXPECT_NE(output.find("Usage: set_update_freq <seconds>"), std::string::npos);
+    output = runCommand("set_update_freq 2x");
+    EXPECT_EQ(sampleIntervalMs.load(), 5000);
+    EXPECT_NE(output.find("Usage: set_update_freq <seconds>"), std::string::npos);
 }
 
 // Test case to verify applying a valid user filter
@@ -0,0 +1,291 @@
+/**
+ * @file test_daemon_server.cpp
+ *
+ * This test suite verifies the daemon server: the line-based protocol (listing with per-connection
+ * filter and sort, history, kill, errors and pipelined requests), the handling of the socket file,
+ * and 100 clients querying the server concurrently.
+ */
+
+#include "daemon_server.h"
+#include "globals.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief Blocking client of the daemon protocol.
+ */
+class TestClient
+{
+  public:
+    explicit TestClient(const std::string& path)
+    {
+        m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        connected = connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    ~TestClient()
+    {
+        close(m_fd);
+    }
+
+    void send(const std::string& text)
+    {
+        ASSERT_EQ(::send(m_fd, text.data(), text.size(), 0), static_cast<ssize_t>(text.size()));
+    }
+
+    // Reads one line without its newline; returns false at the end of the connection
+    bool readLine(std::string& line)
+    {
+        for (;;)
+        {
+            size_t end = m_buffer.find('\n');
+            if (end != std::string::npos)
+            {
+                line = m_buffer.substr(0, end);
+                m_buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[4096];
+            ssize_t received = recv(m_fd, chunk, sizeof(chunk), 0);
+            if (received <= 0)
+                return false;
+            m_buffer.append(chunk, static_cast<size_t>(received));
+        }
+    }
+
+    // Reads one answer: the status line and, for "OK <count>", the lines that follow it
+    std::string readAnswer(std::vector<std::string>& lines)
+    {
+        lines.clear();
+        std::string status;
+        if (!readLine(status))
+            return "";
+        if (status.rfind("OK ", 0) == 0)
+        {
+            int count = std::atoi(status.c_str() + 3);
+            std::string line;
+            for (int i = 0; i < count && readLine(line); ++i)
+            {
+                lines.push_back(line);
+            }
+        }
+        return status;
+    }
+
+    std::string request(const std::string& line, std::vector<std::string>& lines)
+    {
+        send(line + "\n");
+        return readAnswer(lines);
+    }
+
+    bool connected = false;
+
+  private:
+    int m_fd;
+    std::string m_buffer;
+};
+
+} // namespace
+
+// Daemon options are parsed, and the daemon does not combine with the other modes
+TEST(DaemonOptionsTest, CommandLine)
+{
+    const char* args[] = {"pm", "--daemon", "--socket", "/tmp/pm.sock", "--interval", "2s"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(6, args, options, error)) << error;
+    EXPECT_TRUE(options.daemon);
+    EXPECT_EQ(options.socketPath, "/tmp/pm.sock");
+    EXPECT_EQ(options.intervalMs, 2000);
+
+    const char* conflicting[] = {"pm", "--daemon", "--once"};
+    CliOptions other;
+    EXPECT_FALSE(parseCommandLine(3, conflicting, other, error));
+}
+
+/**
+ * @brief Fixture that publishes a snapshot and serves it on a temporary socket.
+ */
+class DaemonServerTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_daemon_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+        directory = dirTemplate;
+        path = directory + "/pm.sock";
+
+        processSnapshots.publish(makeSnapshot({{1, "root", 5.0, 100.0, 0, "init"},
+                                               {2, "alice", 50.0, 10.0, 0, "busy"},
+                                               {3, "alice", 20.0, 300.0, 0, "big"},
+                                               {4, "bob", 0.5, 1.0, 0, "idle \"quoted\""}},
+                                              steadyNowMs(), true));
+
+        std::string error;
+        ASSERT_TRUE(server.start(path, error)) << error;
+        serverThread = std::thread([this]() { server.serve(stopRequested); });
+    }
+
+    void TearDown() override
+    {
+        stopRequested.store(true);
+        serverThread.join();
+        server.stop();
+        processSnapshots.reset();
+        rmdir(directory.c_str());
+    }
+
+    std::string directory;
+    std::string path;
+    DaemonServer server;
+    std::atomic<bool> stopRequested{false};
+    std::thread serverThread;
+};
+
+// Listing follows the filter and sort settings of the connection
+TEST_F(DaemonServerTest, ListFilterSort)
+{
+    TestClient client(path);
+    ASSERT_TRUE(client.connected);
+    std::vector<std::string> lines;
+
+    EXPECT_EQ(client.request("LIST", lines), "OK 4");
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_NE(lines[0].find("\"pid\":2,\"user\":\"alice\",\"cpu\":50.00,\"mem_mb\":10.00,\"command\":\"busy\"}"),
+              std::string::npos);
+    EXPECT_NE(lines[3].find("\"command\":\"idle \\\"quoted\\\"\""), std::string::npos);
+
+    EXPECT_EQ(client.request("sort memory", lines), "OK 0");
+    EXPECT_EQ(client.request("LIST 2", lines), "OK 2");
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_NE(lines[0].find("\"pid\":3,"), std::string::npos);
+    EXPECT_NE(lines[1].find("\"pid\":1,"), std::string::npos);
+
+    EXPECT_EQ(client.request("FILTER user=alice", lines), "OK 0");
+    EXPECT_EQ(client.request("LIST", lines), "OK 2");
+    EXPECT_EQ(client.request("FILTER cpu>10", lines), "OK 0");
+    EXPECT_EQ(client.request("LIST 0", lines), "OK 2");
+    EXPECT_EQ(client.request("FILTER none", lines), "OK 0");
+    EXPECT_EQ(client.request("LIST", lines), "OK 4");
+
+    // Settings belong to the connection
+    TestClient other(path);
+    EXPECT_EQ(other.request("LIST 1", lines), "OK 1");
+    EXPECT_NE(lines[0].find("\"pid\":2,"), std::string::npos);
+}
+
+// Invalid requests get an error line and leave the connection usable
+TEST_F(DaemonServerTest, Errors)
+{
+    TestClient client(path);
+    std::vector<std::string> lines;
+    EXPECT_EQ(client.request("LIST -1", lines), "ERR Usage: LIST [N]");
+    EXPECT_EQ(client.request("SORT pid", lines), "ERR Usage: SORT cpu|memory");
+    EXPECT_EQ(client.request("FILTER cpu>lots", lines).rfind("ERR Usage: FILTER", 0), 0u);
+    EXPECT_EQ(client.request("HISTORY 999999", lines), "ERR No history recorded for process 999999");
+    EXPECT_EQ(client.request("KILL abc", lines), "ERR Usage: KILL <pid>");
+    EXPECT_EQ(client.request("KILL " + std::to_string(getpid()), lines),
+              "ERR Failed to kill process " + std::to_string(getpid()));
+    EXPECT_EQ(client.request("REBOOT", lines), "ERR Unknown command: REBOOT");
+    EXPECT_EQ(client.request("LIST 1", lines), "OK 1");
+
+    client.send(std::string(DaemonServer::kMaxRequestBytes + 10, 'x'));
+    std::string line;
+    ASSERT_TRUE(client.readLine(line));
+    EXPECT_EQ(line, "ERR Request too long");
+    EXPECT_FALSE(client.readLine(line)); // Closed by the server
+}
+
+// Pipelined requests are answered in order, and QUIT closes the connection
+TEST_F(DaemonServerTest, PipelinedRequests)
+{
+    processHistory.recordEpoch({{2, 10.0, 1.0}});
+    processHistory.recordEpoch({{2, 30.0, 2.0}});
+
+    TestClient client(path);
+    client.send("SORT memory\nLIST 1\r\nHISTORY 2\nQUIT\nLIST\n");
+    std::vector<std::string> lines;
+    EXPECT_EQ(client.readAnswer(lines), "OK 0");
+    EXPECT_EQ(client.readAnswer(lines), "OK 1");
+    EXPECT_NE(lines[0].find("\"pid\":3,"), std::string::npos);
+    EXPECT_EQ(client.readAnswer(lines), "OK 2");
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "{\"cpu\":10.00,\"mem_mb\":1.00}");
+    EXPECT_EQ(lines[1], "{\"cpu\":30.00,\"mem_mb\":2.00}");
+    EXPECT_EQ(client.readAnswer(lines), "OK 0");
+    EXPECT_EQ(client.readAnswer(lines), ""); // Nothing after QUIT
+}
+
+// The socket is private, a stale socket file is replaced and a live one is not
+TEST_F(DaemonServerTest, SocketFile)
+{
+    struct stat status;
+    ASSERT_EQ(stat(path.c_str(), &status), 0);
+    EXPECT_EQ(status.st_mode & 0777, 0600u);
+
+    DaemonServer second;
+    std::string error;
+    EXPECT_FALSE(second.start(path, error));
+    EXPECT_EQ(error, "Another daemon is listening on " + path);
+
+    // A socket file nobody listens on, as left by a killed daemon
+    std::string stalePath = directory + "/stale.sock";
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, stalePath.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    close(fd);
+    EXPECT_TRUE(second.start(stalePath, error)) << error;
+    second.stop();
+    EXPECT_NE(access(stalePath.c_str(), F_OK), 0); // Removed on stop
+}
+
+// 100 clients querying at the same time all get complete answers
+TEST_F(DaemonServerTest, HundredConcurrentClients)
+{
+    const int clients = 100;
+    const int requests = 20;
+    std::atomic<int> answered(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            TestClient client(path);
+            if (!client.connected)
+                return;
+            std::vector<std::string> lines;
+            if (i % 2 == 1 && client.request("SORT memory", lines) != "OK 0")
+                return;
+            const char* expected = i % 2 == 1 ? "\"pid\":3," : "\"pid\":2,";
+            for (int r = 0; r < requests; ++r)
+            {
+                if (client.request("LIST 3", lines) != "OK 3" || lines.size() != 3 ||
+                    lines[0].find(expected) == std::string::npos)
+                    return;
+                answered++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(answered.load(), clients * requests);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_frame_buffer.cpp
+ *
+ * This test suite verifies the frame buffer and the process table formatted with it. Numbers and
+ * padding are compared with the equivalent `printf` conversions, the buffer is grown past its
+ * initial capacity, and a frame is written to a pipe in one piece.
+ */
+
+#include "frame_buffer.h"
+#include "process_display.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+std::string contents(const FrameBuffer& buffer)
+{
+    return std::string(buffer.data(), buffer.size());
+}
+
+std::string printfString(const char* format, double value)
+{
+    char buffer[512];
+    int length = snprintf(buffer, sizeof(buffer), format, value);
+    return std::string(buffer, length);
+}
+
+} // namespace
+
+// Integers and fixed-point numbers match "%-*d" and "%-*.*f", including rounding
+TEST(FrameBufferTest, NumbersMatchPrintf)
+{
+    FrameBuffer buffer(16);
+    buffer.appendInt(42, 8);
+    buffer.appendInt(-7);
+    buffer.appendInt(123456789012LL, 4);
+    EXPECT_EQ(contents(buffer), "42      -7123456789012");
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> dist(0.0, 5000.0);
+    for (int i = 0; i < 10000; ++i)
+    {
+        double value = i < 8 ? (0.005 + i * 0.01) : dist(rng); // Halfway cases first
+        buffer.clear();
+        buffer.appendFixed(value, 2, 8);
+        ASSERT_EQ(contents(buffer), printfString("%-8.2f", value)) << value;
+    }
+
+    buffer.clear();
+    buffer.appendFixed(1e300, 2);
+    EXPECT_EQ(contents(buffer), printfString("%.2f", 1e300));
+}
+
+// Strings are padded but never truncated, and the buffer grows as needed
+TEST(FrameBufferTest, PaddingAndGrowth)
+{
+    FrameBuffer buffer(64);
+    buffer.appendPadded("root", 6);
+    buffer.append("|");
+    buffer.appendPadded("a-very-long-user-name", 6);
+    EXPECT_EQ(contents(buffer), "root  |a-very-long-user-name");
+
+    std::string expected = contents(buffer);
+    for (int i = 0; i < 5000; ++i)
+    {
+        buffer.append(3, 'x');
+        buffer.appendInt(i);
+        expected += "xxx" + std::to_string(i);
+    }
+    EXPECT_EQ(contents(buffer), expected);
+
+    buffer.clear();
+    EXPECT_EQ(buffer.size(), 0u);
+}
+
+// The process table keeps the layout of the former iostream output
+TEST(FrameBufferTest, ProcessTableLayout)
+{
+    std::vector<Process> processes(40);
+    for (size_t i = 0; i < processes.size(); ++i)
+    {
+        processes[i].pid = static_cast<int>(100 + i);
+        processes[i].user = i == 1 ? "a-user-name-longer-than-14" : "root";
+        processes[i].cpuUsage = i * 1.5;
+        processes[i].memoryUsage = 1000.0 / (i + 1);
+        processes[i].command = i == 2 ? std::string(50, 'c') : "cmd";
+    }
+
+    FrameBuffer buffer;
+    formatProcessTable(processes, buffer);
+    std::string table = contents(buffer);
+
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t end; (end = table.find('\n', start)) != std::string::npos; start = end + 1)
+    {
+        lines.push_back(table.substr(start, end - start));
+    }
+    ASSERT_EQ(start, table.size()); // Every line is terminated
+    ASSERT_EQ(lines.size(), 32u);   // Header, separator and 30 rows
+    EXPECT_EQ(lines[0], "PID      | User           | CPU (%)   | Memory (MB)      | Command");
+    EXPECT_EQ(lines[1], std::string(100, '='));
+    EXPECT_EQ(lines[2], "100      | root           | \033[32m0.00    %\033[0m | 1000.00       MB | cmd");
+    EXPECT_EQ(lines[3], "101      | a-user-name-longer-than-14 | \033[32m1.50    %\033[0m | 500.00        MB | cmd");
+    EXPECT_EQ(lines[4], "102      | root           | \033[32m3.00    %\033[0m | 333.33        MB | " +
+                            std::string(38, 'c') + "..."); // 41 columns left of 100
+    EXPECT_EQ(lines[10].substr(28, 5), "\033[33m"); // 12% is moderate
+    EXPECT_EQ(lines[20].substr(28, 5), "\033[31m"); // 27% is high
+}
+
+// A frame larger than the pipe's atomic size still arrives complete
+TEST(FrameBufferTest, WriteToDescriptor)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    FrameBuffer buffer(128);
+    for (int i = 0; i < 2000; ++i)
+    {
+        buffer.appendInt(i, 6);
+    }
+    ASSERT_TRUE(buffer.writeTo(fds[1]));
+    close(fds[1]);
+
+    std::string received;
+    char chunk[4096];
+    for (ssize_t n; (n = read(fds[0], chunk, sizeof(chunk))) > 0;)
+    {
+        received.append(chunk, n);
+    }
+    close(fds[0]);
+    EXPECT_EQ(received, contents(buffer));
+
+    // Writing to a closed descriptor is reported
+    EXPECT_FALSE(buffer.writeTo(fds[1]));
+}
@@ -0,0 +1,276 @@
+/**
+ * @file test_history_store.cpp
+ *
+ * This test suite verifies the compressed history store. Epochs with irregular timestamps and
+ * values are appended across several periods, then read back through point-in-time and series
+ * queries, both from the blocks of the open period and from segment files after reopening. Dead-band
+ * filtering, PID reuse, retention, truncated segments and checkpoints of the open period are
+ * covered as well.
+ */
+
+#include "history_store.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+const int64_t kPeriodMs = 60 * 1000;
+
+// Usage of process `pid` at epoch `epoch`, quantized like the store (hundredths of a percent, kB)
+Process makeProcess(int pid, int epoch)
+{
+    Process process;
+    process.pid = pid;
+    process.user = pid % 2 ? "root" : "postgres";
+    process.cpuUsage = ((pid * 37 + epoch * epoch * 11) % 9000) / 100.0;
+    process.memoryUsage = (pid * 4096 + (pid % 3 == 0 ? epoch * 640 : 0)) / 1024.0;
+    process.prevTotalTime = 0;
+    process.command = "cmd" + std::to_string(pid);
+    return process;
+}
+
+} // namespace
+
+/**
+ * @brief Fixture providing a temporary data directory and a time base close to the wall clock
+ *        (so retention applied when opening the store keeps the test data).
+ */
+class HistoryStoreTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_history_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+        options.directory = dirTemplate;
+        options.periodSeconds = 60;
+        options.heartbeatSeconds = 30;
+        options.cpuDeadband = 0.0; // Lossless: every change is written
+        options.memoryDeadbandKb = 0;
+
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+        base = nowMs - 3 * 3600 * 1000;
+        base -= base % kPeriodMs;
+    }
+
+    void TearDown() override
+    {
+        store.close();
+        std::filesystem::remove_all(options.directory);
+    }
+
+    // Appends `epochs` epochs of processes 1..count with jittered timestamps, returning the timestamps
+    std::vector<int64_t> appendEpochs(int epochs, int count)
+    {
+        std::vector<int64_t> timestamps;
+        int64_t timestamp = base;
+        for (int epoch = 0; epoch < epochs; ++epoch)
+        {
+            timestamp += 1000 + (epoch * 7919) % 23 - 11 + (epoch % 50 == 49 ? 9000 : 0);
+            std::vector<Process> snapshot;
+            for (int pid = 1; pid <= count; ++pid)
+            {
+                snapshot.push_back(makeProcess(pid, epoch));
+            }
+            EXPECT_TRUE(store.append(timestamp, snapshot));
+            timestamps.push_back(timestamp);
+        }
+        return timestamps;
+    }
+
+    HistoryStoreOptions options;
+    HistoryStore store;
+    int64_t base = 0;
+};
+
+// Every sample decodes exactly, from open blocks and from segments, across several periods
+TEST_F(HistoryStoreTest, SeriesRoundTrip)
+{
+    ASSERT_TRUE(store.open(options));
+    std::vector<int64_t> timestamps = appendEpochs(300, 20);
+    EXPECT_GE(store.segmentCount(), 4u);
+    EXPECT_EQ(store.samplesSeen(), 300u * 20u);
+
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int pid : {1, 6, 17})
+        {
+            std::vector<HistoryPoint> points;
+            ASSERT_TRUE(store.series(pid, base, timestamps.back(), points));
+            ASSERT_EQ(points.size(), timestamps.size());
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                Process expected = makeProcess(pid, static_cast<int>(i));
+                EXPECT_EQ(points[i].timestampMs, timestamps[i]);
+                EXPECT_NEAR(points[i].cpuUsage, expected.cpuUsage, 1e-9);
+                EXPECT_NEAR(points[i].memoryUsage, expected.memoryUsage, 1e-9);
+            }
+        }
+
+        // Everything is read back from the segment files the second time
+        store.close();
+        ASSERT_TRUE(store.open(options));
+    }
+}
+
+// A point-in-time query returns the value of the last sample at or before the requested time
+TEST_F(HistoryStoreTest, ProcessesAt)
+{
+    ASSERT_TRUE(store.open(options));
+    std::vector<int64_t> timestamps = appendEpochs(200, 10);
+
+    for (size_t epoch : {0u, 59u, 60u, 123u, 199u})
+    {
+        std::vector<Process> result;
+        ASSERT_TRUE(store.processesAt(timestamps[epoch] + 500, 2000, result));
+        ASSERT_EQ(result.size(), 10u);
+        for (const auto& process : result)
+        {
+            Process expected = makeProcess(process.pid, static_cast<int>(epoch));
+            EXPECT_EQ(process.command, expected.command);
+            EXPECT_EQ(process.user, expected.user);
+            EXPECT_NEAR(process.cpuUsage, expected.cpuUsage, 1e-9);
+        }
+    }
+
+    // Before the first epoch and long after the last one nothing was running
+    std::vector<Process> result;
+    ASSERT_TRUE(store.processesAt(base, 2000, result));
+    EXPECT_TRUE(result.empty());
+    ASSERT_TRUE(store.processesAt(timestamps.back() + 60000, 2000, result));
+    EXPECT_TRUE(result.empty());
+}
+
+// Small changes are absorbed by the dead band, but a sample is still written at every heartbeat
+TEST_F(HistoryStoreTest, DeadbandAndHeartbeat)
+{
+    options.cpuDeadband = 0.5;
+    options.memoryDeadbandKb = 256;
+    ASSERT_TRUE(store.open(options));
+
+    for (int epoch = 0; epoch < 120; ++epoch)
+    {
+        Process process = makeProcess(1, 0);
+        process.cpuUsage = 10.0 + (epoch % 2) * 0.25; // Jitter inside the dead band
+        process.memoryUsage = epoch < 60 ? 100.0 : 200.0;
+        store.append(base + epoch * 1000, {process});
+    }
+
+    // First sample, heartbeats at 30/60/90 s, and the memory jump at 60 s (same sample)
+    EXPECT_EQ(store.samplesWritten(), 4u);
+
+    std::vector<Process> result;
+    ASSERT_TRUE(store.processesAt(base + 75 * 1000, 1000, result));
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_NEAR(result[0].cpuUsage, 10.0, 0.5);
+    EXPECT_DOUBLE_EQ(result[0].memoryUsage, 200.0);
+}
+
+// A reused PID starts a new block, and queries return the program running at the requested time
+TEST_F(HistoryStoreTest, PidReuse)
+{
+    ASSERT_TRUE(store.open(options));
+    Process first = makeProcess(42, 0);
+    Process second = makeProcess(42, 1);
+    second.command = "other";
+    for (int epoch = 0; epoch < 10; ++epoch)
+    {
+        store.append(base + epoch * 1000, {epoch < 5 ? first : second});
+    }
+
+    std::vector<Process> result;
+    ASSERT_TRUE(store.processesAt(base + 2000, 1000, result));
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0].command, first.command);
+    ASSERT_TRUE(store.processesAt(base + 8000, 1000, result));
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0].command, "other");
+}
+
+// Segments older than the retention are deleted as time advances
+TEST_F(HistoryStoreTest, Retention)
+{
+    options.retentionHours = 1;
+    ASSERT_TRUE(store.open(options));
+    for (int minute = 0; minute < 70; minute += 10)
+    {
+        store.append(base + minute * kPeriodMs, {makeProcess(1, minute)});
+    }
+    EXPECT_EQ(store.segmentCount(), 6u); // The period of minute 60 is still open
+
+    // At minute 90, only the periods of the last hour remain
+    store.append(base + 90 * kPeriodMs, {makeProcess(1, 90)});
+    EXPECT_EQ(store.segmentCount(), 4u); // Minutes 30, 40, 50 and 60
+    std::vector<HistoryPoint> points;
+    ASSERT_TRUE(store.series(1, base, base + 100 * kPeriodMs, points));
+    ASSERT_EQ(points.size(), 5u);
+    EXPECT_EQ(points[0].timestampMs, base + 30 * kPeriodMs);
+}
+
+// A segment cut in the middle of a block (e.g., a crash while writing) keeps its complete blocks
+TEST_F(HistoryStoreTest, TruncatedSegment)
+{
+    ASSERT_TRUE(store.open(options));
+    std::vector<int64_t> timestamps = appendEpochs(30, 5);
+    store.close();
+
+    std::string path;
+    for (const auto& entry : std::filesystem::directory_iterator(options.directory))
+    {
+        path = entry.path();
+    }
+    ASSERT_FALSE(path.empty());
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 3);
+
+    ASSERT_TRUE(store.open(options));
+    std::vector<Process> result;
+    ASSERT_TRUE(store.processesAt(timestamps[10], 2000, result));
+    EXPECT_EQ(result.size(), 4u); // The last block of the segment was lost
+}
+
+// The open period is checkpointed to its segment, so a store that is never closed (e.g., killed)
+// loses only the epochs since the last checkpoint
+TEST_F(HistoryStoreTest, CheckpointWithoutClose)
+{
+    options.checkpointEpochs = 5;
+    ASSERT_TRUE(store.open(options));
+    std::vector<int64_t> timestamps = appendEpochs(23, 5);
+
+    // Read the directory from another store while the first one is still open, as after a crash
+    HistoryStore recovered;
+    ASSERT_TRUE(recovered.open(options));
+    std::vector<HistoryPoint> points;
+    ASSERT_TRUE(recovered.series(3, base, timestamps.back(), points));
+    ASSERT_EQ(points.size(), 20u); // Up to the checkpoint of epoch 20
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        EXPECT_EQ(points[i].timestampMs, timestamps[i]);
+        EXPECT_NEAR(points[i].cpuUsage, makeProcess(3, static_cast<int>(i)).cpuUsage, 1e-9);
+    }
+    std::vector<Process> result;
+    ASSERT_TRUE(recovered.processesAt(timestamps[19], 2000, result));
+    EXPECT_EQ(result.size(), 5u);
+    recovered.close();
+
+    // A block closed by PID reuse cuts the checkpoint, which is taken again in the same epoch
+    Process reused = makeProcess(1, 23);
+    reused.command = "other";
+    ASSERT_TRUE(store.append(timestamps.back() + 1000, {reused}));
+    ASSERT_TRUE(recovered.open(options));
+    ASSERT_TRUE(recovered.series(3, base, timestamps.back(), points));
+    EXPECT_EQ(points.size(), 23u);
+    ASSERT_TRUE(recovered.series(1, base, timestamps.back() + 1000, points));
+    EXPECT_EQ(points.size(), 24u); // The closed block of the first program and the new one
+    ASSERT_TRUE(recovered.processesAt(timestamps.back() + 1000, 500, result));
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0].command, "other");
+}
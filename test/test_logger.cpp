@@ -0,0 +1,485 @@
+/**
+ * @file test_logger.cpp
+ *
+ * This test suite verifies the Logger and its lock-free message ring: messages from concurrent
+ * threads are all written, in order per thread, even when they outnumber the slots of the ring;
+ * long messages are cut to a slot; the flush policy decides when messages reach the file and
+ * when it is synced; formatted messages are formatted by the logger thread; and messages below
+ * the minimum level are discarded.
+ */
+
+#include "cli_options.h"
+#include "log_record.h"
+#include "log_rotation.h"
+#include "log_site.h"
+#include "logger.h"
+#include "resource_monitor.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <regex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <vector>
+#include <zlib.h>
+
+namespace
+{
+
+// Log file private to this test process
+std::string testLogPath()
+{
+    return "/tmp/pm_test_logger_" + std::to_string(getpid()) + ".log";
+}
+
+std::vector<std::string> readLines(const std::string& path)
+{
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Lines of a log file, gzipped or not
+std::vector<std::string> readLogLines(const std::string& path)
+{
+    std::vector<std::string> lines;
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return lines;
+    char line[1024];
+    while (gzgets(file, line, sizeof(line)) != nullptr)
+    {
+        lines.emplace_back(line, std::strlen(line) - 1); // Without the newline
+    }
+    gzclose(file);
+    return lines;
+}
+
+// Empty directory private to this test process, for rotated logs
+std::string makeRotationDirectory()
+{
+    std::string directory = "/tmp/pm_test_rotation_" + std::to_string(getpid());
+    std::string command = "rm -rf " + directory;
+    std::system(command.c_str());
+    mkdir(directory.c_str(), 0755);
+    return directory;
+}
+
+} // namespace
+
+// Every message of every thread is written once, in the order each thread logged them
+TEST(LoggerTest, ConcurrentProducersLoseNothing)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    ASSERT_TRUE(logger.start(testLogPath()));
+
+    const int threadCount = 8;
+    const int messages = 2 * static_cast<int>(LogRing::kCapacity); // Each thread alone could fill the ring
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&logger, t, messages]() {
+            for (int i = 0; i < messages; ++i)
+            {
+                logger.info("thread " + std::to_string(t) + " message " + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    logger.stop();
+
+    std::vector<std::string> lines = readLines(testLogPath());
+    ASSERT_EQ(lines.size(), static_cast<size_t>(threadCount * messages));
+    std::vector<int> next(threadCount, 0);
+    for (const auto& line : lines)
+    {
+        int thread = -1;
+        int message = -1;
+        size_t at = line.find("[INFO] thread ");
+        ASSERT_NE(at, std::string::npos) << line;
+        ASSERT_EQ(std::sscanf(line.c_str() + at, "[INFO] thread %d message %d", &thread, &message), 2) << line;
+        ASSERT_EQ(message, next[thread]) << line;
+        next[thread]++;
+    }
+    std::remove(testLogPath().c_str());
+}
+
+// Messages longer than a slot are cut; a lone message is written without waiting for a batch
+TEST(LoggerTest, LongMessageAndFlushInterval)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    ASSERT_TRUE(logger.start(testLogPath()));
+
+    logger.error(std::string(1000, 'x'));
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * LogFlushPolicy().maxDelayMs));
+    std::vector<std::string> lines = readLines(testLogPath()); // Before stop()
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find(" [ERROR] " + std::string(LogRing::kTextBytes, 'x')), std::string::npos);
+    EXPECT_EQ(lines[0].find(std::string(LogRing::kTextBytes + 1, 'x')), std::string::npos);
+
+    logger.stop();
+    logger.info("discarded while stopped");
+    EXPECT_EQ(readLines(testLogPath()).size(), 1u);
+    std::remove(testLogPath().c_str());
+}
+
+// Messages wait for the policy's batch or delay, except that a critical message flushes at once
+TEST(LoggerTest, FlushPolicy)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    LogFlushPolicy policy;
+    policy.maxMessages = 1000;
+    policy.maxDelayMs = 60000;
+    policy.syncIntervalMs = 1;
+    logger.setFlushPolicy(policy);
+    ASSERT_TRUE(logger.start(testLogPath()));
+    LogStats before = logger.stats();
+
+    logger.info("held back");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(readLines(testLogPath()).size(), 0u);
+
+    logger.critical("urgent");
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100 && lines.size() < 2; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        lines = readLines(testLogPath());
+    }
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_NE(lines[1].find("[CRITICAL] urgent"), std::string::npos);
+
+    for (int i = 0; i < 998; ++i)
+    {
+        logger.warning("batched");
+    }
+    logger.stop();
+    logger.setFlushPolicy(LogFlushPolicy());
+
+    // One write for the critical message, one for the batch; synced at least once
+    LogStats after = logger.stats();
+    EXPECT_EQ(after.messages - before.messages, 1000u);
+    EXPECT_EQ(after.writeCalls - before.writeCalls, 2u);
+    EXPECT_GE(after.syncCalls - before.syncCalls, 1u);
+    EXPECT_EQ(readLines(testLogPath()).size(), 1000u);
+    std::remove(testLogPath().c_str());
+}
+
+// Arguments are queued raw and formatted by the logger thread into their placeholders
+TEST(LoggerTest, FormattedMessages)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    ASSERT_TRUE(logger.start(testLogPath()));
+
+    std::string user = "alice";
+    logger.info("PID {} of {} uses {}% ({})", 42, user, 12.5, 'R');
+    logger.warning("{} {} {} {}", -7, uint64_t(18446744073709551615ull), true, "literal");
+    logger.error("only {} of {} arguments", 1);
+    logger.info("no arguments {}");
+    logger.critical("cut: {} {}", std::string(1000, 'y'), 3);
+    logger.stop();
+
+    std::vector<std::string> lines = readLines(testLogPath());
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_TRUE(std::regex_match(lines[0], std::regex(R"(\d{4}-\d\d-\d\d \d\d:\d\d:\d\d \[INFO\] .*)"))) << lines[0];
+    EXPECT_NE(lines[0].find(" [INFO] PID 42 of alice uses 12.5% (R)"), std::string::npos) << lines[0];
+    EXPECT_NE(lines[1].find(" [WARNING] -7 18446744073709551615 true literal"), std::string::npos) << lines[1];
+    EXPECT_NE(lines[2].find(" [ERROR] only 1 of {} arguments"), std::string::npos) << lines[2];
+    EXPECT_NE(lines[3].find(" [INFO] no arguments {}"), std::string::npos) << lines[3];
+
+    // The string fills the slot; the argument after it is dropped
+    size_t at = lines[4].find(" [CRITICAL] cut: ");
+    ASSERT_NE(at, std::string::npos) << lines[4];
+    std::string rest = lines[4].substr(at + 17);
+    EXPECT_EQ(rest, std::string(LogRing::kTextBytes - 3, 'y') + " {}");
+    std::remove(testLogPath().c_str());
+}
+
+// Messages below the minimum level are discarded, formatted or not
+TEST(LoggerTest, MinLevel)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    ASSERT_TRUE(logger.start(testLogPath()));
+    logger.setMinLevel(LogLevel::WARNING);
+    EXPECT_FALSE(logger.shouldLog(LogLevel::INFO));
+    EXPECT_TRUE(logger.shouldLog(LogLevel::ERROR));
+
+    logger.info("dropped {}", 1);
+    logger.info(std::string("dropped too"));
+    logger.warning("kept {}", 2);
+    logger.error(std::string("kept too"));
+    logger.setMinLevel(LogLevel::INFO);
+    logger.info("kept {}", 3);
+    logger.stop();
+    EXPECT_FALSE(logger.shouldLog(LogLevel::CRITICAL)); // Not active
+
+    std::vector<std::string> lines = readLines(testLogPath());
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_NE(lines[0].find("[WARNING] kept 2"), std::string::npos);
+    EXPECT_NE(lines[1].find("[ERROR] kept too"), std::string::npos);
+    EXPECT_NE(lines[2].find("[INFO] kept 3"), std::string::npos);
+    std::remove(testLogPath().c_str());
+}
+
+// Binary records decode to the text messages, across restarts of the logger appending to the file
+TEST(LoggerTest, BinaryLogRoundTrip)
+{
+    const std::string path = testLogPath() + ".bin";
+    std::remove(path.c_str());
+    Logger& logger = Logger::getInstance();
+    int64_t before = static_cast<int64_t>(std::time(nullptr));
+    ASSERT_TRUE(logger.start(path, LogFormat::Binary));
+    logger.info("Killed process {pid} of {}", 4242, std::string("alice"));
+    logger.warning(std::string("plain message"));
+    logger.info("Killed process {pid} of {}", -1, "bob");
+    logger.critical("{} {} {} {{x}", 2.5, true, 'c');
+    logger.stop();
+
+    // Appending restarts template ids; a text logger refuses the file
+    ASSERT_TRUE(logger.start(path, LogFormat::Binary));
+    logger.error("second run {pid}", 7u);
+    logger.stop();
+    EXPECT_FALSE(logger.start(path, LogFormat::Text));
+
+    BinaryLogReader reader;
+    std::string error;
+    ASSERT_TRUE(reader.open(path, error)) << error;
+    std::vector<LogEntry> entries;
+    LogEntry entry;
+    while (reader.next(entry))
+    {
+        entries.push_back(entry);
+    }
+    EXPECT_FALSE(reader.damaged());
+    ASSERT_EQ(entries.size(), 5u);
+    EXPECT_EQ(entries[0].message, "Killed process 4242 of alice");
+    EXPECT_EQ(entries[0].pid, 4242);
+    EXPECT_EQ(entries[0].level, LogLevel::INFO);
+    EXPECT_GE(entries[0].time, before);
+    EXPECT_LE(entries[0].time, static_cast<int64_t>(std::time(nullptr)));
+    EXPECT_EQ(entries[1].message, "plain message");
+    EXPECT_EQ(entries[1].level, LogLevel::WARNING);
+    EXPECT_EQ(entries[1].pid, -1);
+    EXPECT_EQ(entries[2].message, "Killed process -1 of bob");
+    EXPECT_EQ(entries[3].message, "2.5 true c {{x}");
+    EXPECT_EQ(entries[3].level, LogLevel::CRITICAL);
+    EXPECT_EQ(entries[4].message, "second run 7");
+    EXPECT_EQ(entries[4].pid, 7);
+
+    // A record cut by a crash ends the decoding, and is reported
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() - 2);
+    BinaryLogReader cut;
+    ASSERT_TRUE(cut.open(path, error));
+    size_t decoded = 0;
+    while (cut.next(entry))
+    {
+        decoded++;
+    }
+    EXPECT_EQ(decoded, 4u);
+    EXPECT_TRUE(cut.damaged());
+    std::remove(path.c_str());
+}
+
+// Rotation options are parsed into the policy
+TEST(LogRotationTest, CommandLine)
+{
+    const char* args[] = {"pm", "--log-max-size", "100M", "--log-rotate", "1h", "--log-keep", "3", "--log-format",
+                          "binary"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(9, args, options, error)) << error;
+    EXPECT_EQ(options.logRotation.maxBytes, 100u * 1024 * 1024);
+    EXPECT_EQ(options.logRotation.intervalSeconds, 3600);
+    EXPECT_EQ(options.logRotation.keep, 3u);
+    EXPECT_EQ(options.logFormat, LogFormat::Binary);
+
+    uint64_t bytes = 0;
+    EXPECT_TRUE(parseByteSize("512K", bytes));
+    EXPECT_EQ(bytes, 512u * 1024);
+    EXPECT_TRUE(parseByteSize("4096", bytes));
+    EXPECT_EQ(bytes, 4096u);
+    EXPECT_FALSE(parseByteSize("0", bytes));
+    EXPECT_FALSE(parseByteSize("10 parsecs", bytes));
+    const char* fractional[] = {"pm", "--log-rotate", "1500ms"};
+    EXPECT_FALSE(parseCommandLine(3, fractional, options, error));
+}
+
+// Size rotation splits the messages over files without losing or duplicating any; rotated files
+// are gzipped and, in binary, each one decodes on its own
+TEST(LogRotationTest, SizeRotationLosesNothing)
+{
+    for (LogFormat format : {LogFormat::Text, LogFormat::Binary})
+    {
+        std::string directory = makeRotationDirectory();
+        std::string path = directory + "/pm.log";
+        Logger& logger = Logger::getInstance();
+        LogRotationPolicy policy;
+        policy.maxBytes = 16 * 1024;
+        policy.keep = 100;
+        logger.setRotationPolicy(policy);
+        LogStats before = logger.stats();
+        ASSERT_TRUE(logger.start(path, format));
+
+        const int messages = 5000;
+        const std::string padding(40, '-'); // An argument, so that binary records are as long
+        for (int i = 0; i < messages; ++i)
+        {
+            logger.info("message {} {}", i, padding);
+        }
+        logger.stop();
+        logger.setRotationPolicy(LogRotationPolicy());
+
+        std::vector<std::string> files = listRotatedLogs(path);
+        EXPECT_GE(files.size(), 3u);
+        EXPECT_EQ(logger.stats().rotations - before.rotations, files.size());
+        files.push_back(path);
+
+        int next = 0;
+        for (size_t f = 0; f < files.size(); ++f)
+        {
+            EXPECT_EQ(f + 1 < files.size(), files[f].size() > 3 && files[f].substr(files[f].size() - 3) == ".gz")
+                << files[f];
+            std::vector<std::string> lines;
+            if (format == LogFormat::Binary)
+            {
+                BinaryLogReader reader;
+                std::string error;
+                ASSERT_TRUE(reader.open(files[f], error)) << error;
+                LogEntry entry;
+                while (reader.next(entry))
+                {
+                    lines.push_back(" [INFO] " + entry.message);
+                }
+                EXPECT_FALSE(reader.damaged());
+            }
+            else
+            {
+                lines = readLogLines(files[f]);
+            }
+            EXPECT_FALSE(lines.empty()) << files[f];
+            for (const auto& line : lines)
+            {
+                int number = -1;
+                size_t at = line.find("[INFO] message ");
+                ASSERT_NE(at, std::string::npos) << line;
+                ASSERT_EQ(std::sscanf(line.c_str() + at, "[INFO] message %d", &number), 1) << line;
+                ASSERT_EQ(number, next) << files[f];
+                next++;
+            }
+        }
+        EXPECT_EQ(next, messages);
+        std::system(("rm -rf " + directory).c_str());
+    }
+}
+
+// Period rotation happens at the first message of a new period; only the newest files are kept
+TEST(LogRotationTest, PeriodRotationAndRetention)
+{
+    std::string directory = makeRotationDirectory();
+    std::string path = directory + "/pm.log";
+    Logger& logger = Logger::getInstance();
+    LogRotationPolicy policy;
+    policy.intervalSeconds = 1;
+    policy.keep = 1;
+    policy.compress = false;
+    logger.setRotationPolicy(policy);
+    LogStats before = logger.stats();
+    ASSERT_TRUE(logger.start(path));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        logger.info("period {}", i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    }
+    logger.stop();
+    logger.setRotationPolicy(LogRotationPolicy());
+
+    EXPECT_EQ(logger.stats().rotations - before.rotations, 2u);
+    std::vector<std::string> files = listRotatedLogs(path);
+    ASSERT_EQ(files.size(), 1u); // The oldest was deleted
+    std::vector<std::string> rotated = readLogLines(files[0]);
+    ASSERT_EQ(rotated.size(), 1u);
+    EXPECT_NE(rotated[0].find("period 1"), std::string::npos);
+    std::vector<std::string> current = readLogLines(path);
+    ASSERT_EQ(current.size(), 1u);
+    EXPECT_NE(current[0].find("period 2"), std::string::npos);
+    std::system(("rm -rf " + directory).c_str());
+}
+
+// The token bucket lets a burst through, then one message per interval
+TEST(LogSiteTest, RateLimit)
+{
+    LogSite slow("slow test messages", 1.0, 3);
+    EXPECT_TRUE(slow.allow());
+    EXPECT_TRUE(slow.allow());
+    EXPECT_TRUE(slow.allow());
+    EXPECT_FALSE(slow.allow());
+    EXPECT_FALSE(slow.allow());
+    EXPECT_EQ(slow.takeSuppressed(), 2u);
+    EXPECT_EQ(slow.takeSuppressed(), 0u);
+
+    LogSite fast("fast test messages", 100.0, 1);
+    EXPECT_TRUE(fast.allow());
+    EXPECT_FALSE(fast.allow());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(fast.allow());
+}
+
+// Stat reads of vanished processes are only counted, and summarized with the suppressed messages
+TEST(LogSiteTest, Summaries)
+{
+    std::remove(testLogPath().c_str());
+    Logger& logger = Logger::getInstance();
+    LogFlushPolicy policy;
+    policy.summaryIntervalMs = 100;
+    logger.setFlushPolicy(policy);
+    ASSERT_TRUE(logger.start(testLogPath()));
+
+    for (int i = 0; i < 412; ++i)
+    {
+        EXPECT_EQ(getProcessTotalTime(999999999), 0); // No such process
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(400)); // A summary interval and a write
+    std::vector<std::string> lines = readLines(testLogPath());
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("[INFO] 412 stat reads failed with ENOENT in the last 1 s"), std::string::npos)
+        << lines[0];
+
+    LogSite site("limited test messages", 1.0, 2);
+    for (int i = 0; i < 10; ++i)
+    {
+        if (site.allow())
+            logger.info("limited {}", i);
+    }
+    logger.stop(); // Summarizes what was counted since the last summary
+    logger.setFlushPolicy(LogFlushPolicy());
+
+    lines = readLines(testLogPath());
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_NE(lines[1].find("[INFO] limited 0"), std::string::npos) << lines[1];
+    EXPECT_NE(lines[2].find("[INFO] limited 1"), std::string::npos) << lines[2];
+    EXPECT_NE(lines[3].find("[WARNING] 8 messages about limited test messages suppressed in the last"),
+              std::string::npos)
+        << lines[3];
+    std::remove(testLogPath().c_str());
+}
@@ -0,0 +1,211 @@
+/**
+ * @file test_metrics_server.cpp
+ *
+ * This test suite verifies the Prometheus endpoint: the metrics rendered from a snapshot (top
+ * processes, the "other" series, per-user sums and label escaping), and the HTTP server, which
+ * renders once per epoch however often it is scraped.
+ */
+
+#include "cli_options.h"
+#include "globals.h"
+#include "metrics_server.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+// Processes of the rendering and server tests
+std::shared_ptr<const ProcessSnapshot> makeTestSnapshot()
+{
+    return makeSnapshot({{1, "root", 5.0, 100.0, 0, "init"},
+                         {2, "alice", 50.0, 10.0, 0, "busy"},
+                         {3, "alice", 20.0, 300.0, 0, "big"},
+                         {4, "bob", 0.5, 1.0, 0, "idle \"quoted\""},
+                         {5, "bob", 1.5, 2.0, 0, "small"}},
+                        steadyNowMs(), true);
+}
+
+std::string render(const ProcessSnapshot& snapshot, size_t top)
+{
+    FrameBuffer buffer;
+    renderMetrics(buffer, snapshot, top, 1700000000123);
+    return std::string(buffer.data(), buffer.size());
+}
+
+// Connects to the server and returns the socket
+int connectTo(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends a request and reads one response (head and Content-Length bytes of body)
+std::string exchange(int fd, const std::string& request)
+{
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    std::string response;
+    char chunk[4096];
+    for (;;)
+    {
+        size_t headEnd = response.find("\r\n\r\n");
+        if (headEnd != std::string::npos)
+        {
+            size_t lengthAt = response.find("Content-Length: ");
+            size_t length = std::stoul(response.substr(lengthAt + 16));
+            if (response.size() >= headEnd + 4 + length)
+                return response;
+        }
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return response;
+        response.append(chunk, static_cast<size_t>(received));
+    }
+}
+
+} // namespace
+
+// Metrics options are parsed and validated
+TEST(MetricsOptionsTest, CommandLine)
+{
+    const char* args[] = {"pm", "--metrics", "127.0.0.1:9256", "--metrics-top", "20"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(5, args, options, error)) << error;
+    EXPECT_EQ(options.metricsAddress, "127.0.0.1:9256");
+    EXPECT_EQ(options.metricsTop, 20u);
+
+    std::string host;
+    int port = 0;
+    EXPECT_TRUE(parseListenAddress("9256", host, port));
+    EXPECT_EQ(host, "127.0.0.1");
+    EXPECT_EQ(port, 9256);
+    EXPECT_FALSE(parseListenAddress("localhost:9256", host, port));
+    EXPECT_FALSE(parseListenAddress("127.0.0.1:99999", host, port));
+
+    const char* invalid[] = {"pm", "--metrics", "port"};
+    EXPECT_FALSE(parseCommandLine(3, invalid, options, error));
+}
+
+// Top processes per ranking are exported; the others are summed into pid="other"
+TEST(MetricsRenderTest, TopAndOther)
+{
+    auto snapshot = makeTestSnapshot();
+    std::string text = render(*snapshot, 1);
+
+    EXPECT_NE(text.find("# TYPE process_manager_processes gauge\nprocess_manager_processes 5\n"), std::string::npos);
+    EXPECT_NE(text.find("process_manager_snapshot_timestamp_seconds 1700000000.123\n"), std::string::npos);
+
+    // PID 2 has the most CPU, PID 3 the most memory
+    EXPECT_NE(text.find("process_manager_process_cpu_percent{pid=\"2\",user=\"alice\",command=\"busy\"} 50.00\n"),
+              std::string::npos);
+    EXPECT_NE(
+        text.find("process_manager_process_resident_bytes{pid=\"3\",user=\"alice\",command=\"big\"} 314572800\n"),
+        std::string::npos);
+    EXPECT_EQ(text.find("{pid=\"1\""), std::string::npos);
+    EXPECT_NE(text.find("process_manager_process_cpu_percent{pid=\"other\",user=\"\",command=\"\"} 7.00\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("process_manager_other_processes 3\n"), std::string::npos);
+
+    // Per-user sums cover every process
+    EXPECT_NE(text.find("process_manager_user_cpu_percent{user=\"alice\"} 70.00\n"), std::string::npos);
+    EXPECT_NE(text.find("process_manager_user_processes{user=\"bob\"} 2\n"), std::string::npos);
+
+    // Everything is exported when the cap is not reached, with label values escaped
+    std::string all = render(*snapshot, 10);
+    EXPECT_NE(all.find("{pid=\"4\",user=\"bob\",command=\"idle \\\"quoted\\\"\"}"), std::string::npos);
+    EXPECT_EQ(all.find("{pid=\"other\""), std::string::npos);
+    EXPECT_NE(all.find("process_manager_other_processes 0\n"), std::string::npos);
+}
+
+/**
+ * @brief Fixture that serves the metrics on a free local port.
+ */
+class MetricsServerTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        std::string error;
+        ASSERT_TRUE(server.start("127.0.0.1:0", error)) << error;
+        serverThread = std::thread([this]() { server.serve(stopRequested); });
+    }
+
+    void TearDown() override
+    {
+        stopRequested.store(true);
+        serverThread.join();
+        server.stop();
+        processSnapshots.reset();
+    }
+
+    MetricsServer server{2};
+    std::atomic<bool> stopRequested{false};
+    std::thread serverThread;
+};
+
+// Scrapes of the same epoch share one rendering, on a persistent connection
+TEST_F(MetricsServerTest, RendersOncePerEpoch)
+{
+    int fd = connectTo(server.port());
+    ASSERT_GE(fd, 0);
+    const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    std::string response = exchange(fd, request);
+    EXPECT_EQ(response.rfind("HTTP/1.1 503 Service Unavailable\r\n", 0), 0u); // No snapshot yet
+
+    processSnapshots.publish(makeTestSnapshot());
+    for (int i = 0; i < 5; ++i)
+    {
+        response = exchange(fd, request);
+        ASSERT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+        EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+        EXPECT_NE(response.find("process_manager_processes 5\n"), std::string::npos);
+    }
+    EXPECT_EQ(server.renderCount(), 1u);
+
+    processSnapshots.publish(makeSnapshot({{9, "carol", 1.0, 1.0, 0, "new"}}, steadyNowMs(), true));
+    response = exchange(fd, request);
+    EXPECT_NE(response.find("process_manager_processes 1\n"), std::string::npos);
+    EXPECT_EQ(server.renderCount(), 2u);
+    close(fd);
+}
+
+// Other paths and methods get errors; HTTP/1.0 and "Connection: close" end the connection
+TEST_F(MetricsServerTest, ErrorsAndConnectionClose)
+{
+    processSnapshots.publish(makeTestSnapshot());
+    int fd = connectTo(server.port());
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(exchange(fd, "GET / HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 404 Not Found\r\n", 0), 0u);
+    std::string response = exchange(fd, "GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    char byte;
+    EXPECT_EQ(recv(fd, &byte, 1, 0), 0); // Closed by the server
+    close(fd);
+
+    fd = connectTo(server.port());
+    EXPECT_EQ(exchange(fd, "POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0), 0u);
+    close(fd);
+
+    fd = connectTo(server.port());
+    EXPECT_EQ(exchange(fd, "GET /metrics HTTP/1.0\r\n\r\n").rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(recv(fd, &byte, 1, 0), 0);
+    close(fd);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_once_mode.cpp
+ *
+ * This test suite verifies the one-shot mode: parsing of its options and filters, and the table
+ * and records it writes for a small synthetic procfs tree, with top-N selection and filtering.
+ */
+
+#include "globals.h"
+#include "once_mode.h"
+#include "process_info.h"
+#include "synthetic_proc.h"
+#include <algorithm>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Fixture that writes a fake procfs tree and points `procRoot` at it for the test duration.
+ */
+class OnceModeTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_once_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+
+        SyntheticProcOptions options;
+        options.pidCount = 50;
+        options.cpuCount = 4;
+        tree = new SyntheticProcTree(dirTemplate, options);
+        ASSERT_TRUE(tree->writeTick(0));
+
+        savedRoot = procRoot;
+        procRoot = tree->root();
+    }
+
+    void TearDown() override
+    {
+        procRoot = savedRoot;
+        tree->remove();
+        delete tree;
+    }
+
+    // Runs the one-shot mode with its output sent through a pipe, and returns the output lines
+    std::vector<std::string> runOnce(const CliOptions& options)
+    {
+        int fds[2];
+        EXPECT_EQ(pipe(fds), 0);
+        EXPECT_EQ(runOnceMode(options, fds[1]), 0);
+        close(fds[1]);
+
+        std::string output;
+        char chunk[4096];
+        for (ssize_t n; (n = read(fds[0], chunk, sizeof(chunk))) > 0;)
+        {
+            output.append(chunk, n);
+        }
+        close(fds[0]);
+
+        std::vector<std::string> lines;
+        std::istringstream stream(output);
+        for (std::string line; std::getline(stream, line);)
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    SyntheticProcTree* tree = nullptr;
+    std::string savedRoot;
+};
+
+// One-shot options and filters are parsed and validated up front
+TEST(OnceModeOptionsTest, CommandLine)
+{
+    const char* args[] = {"pm", "--once", "--top", "20", "--sort", "memory", "--filter", "user=postgres"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(8, args, options, error)) << error;
+    EXPECT_TRUE(options.once);
+    EXPECT_EQ(options.top, 20u);
+    EXPECT_EQ(options.filter, std::make_pair(std::string("user"), std::string("postgres")));
+    EXPECT_EQ(options.windowMs, 200);
+
+    std::pair<std::string, std::string> filter;
+    EXPECT_TRUE(parseFilter("cpu>12.5", filter));
+    EXPECT_EQ(filter, std::make_pair(std::string("cpu"), std::string("12.5")));
+    EXPECT_TRUE(parseFilter("memory=100", filter));
+    EXPECT_EQ(filter.first, "memory");
+    EXPECT_FALSE(parseFilter("cpu>lots", filter));
+    EXPECT_FALSE(parseFilter("user>root", filter));
+    EXPECT_FALSE(parseFilter("pid=1", filter));
+    EXPECT_FALSE(parseFilter("user=", filter));
+
+    const char* badWindow[] = {"pm", "--once", "--window", "soon"};
+    EXPECT_FALSE(parseCommandLine(4, badWindow, options, error));
+}
+
+// The table lists the top processes by memory, without colors when not written to a terminal
+TEST_F(OnceModeTest, TopByMemory)
+{
+    CliOptions options;
+    options.once = true;
+    options.windowMs = 1;
+    options.top = 5;
+    options.sortBy = "memory";
+    std::vector<std::string> lines = runOnce(options);
+    ASSERT_EQ(lines.size(), 7u); // Header, separator and five rows
+    EXPECT_EQ(lines[0].rfind("PID", 0), 0u);
+
+    std::vector<double> memory;
+    for (const auto& process : getActiveProcesses())
+    {
+        memory.push_back(getProcessMemoryUsage(process.pid));
+    }
+    std::sort(memory.rbegin(), memory.rend());
+    for (size_t row = 0; row < 5; ++row)
+    {
+        const std::string& line = lines[row + 2];
+        EXPECT_EQ(line.find('\033'), std::string::npos);
+        double shown = std::stod(line.substr(line.find('|', line.find('|', line.find('|') + 1) + 1) + 1));
+        EXPECT_NEAR(shown, memory[row], 0.01);
+    }
+}
+
+// Filters apply before top-N selection, and records can be written instead of the table
+TEST_F(OnceModeTest, FilterAndRecords)
+{
+    std::vector<double> memory;
+    for (const auto& process : getActiveProcesses())
+    {
+        memory.push_back(getProcessMemoryUsage(process.pid));
+    }
+    std::sort(memory.begin(), memory.end());
+    double median = memory[memory.size() / 2];
+
+    CliOptions options;
+    options.once = true;
+    options.windowMs = 1;
+    options.streamFormat = StreamFormat::JsonLines;
+    std::ostringstream threshold;
+    threshold.precision(17); // Round-trips the exact value
+    threshold << median;
+    options.filter = {"memory", threshold.str()};
+    std::vector<std::string> lines = runOnce(options);
+    size_t above = std::count_if(memory.begin(), memory.end(), [&](double value) { return value > median; });
+    EXPECT_EQ(lines.size(), above);
+    EXPECT_EQ(lines.front().rfind("{\"ts\":", 0), 0u);
+
+    options.streamFormat = StreamFormat::None;
+    options.filter = {"user", "nobody-at-all"};
+    EXPECT_EQ(runOnce(options).size(), 2u); // Header and separator only
+}
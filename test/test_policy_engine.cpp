@@ -0,0 +1,385 @@
+/**
+ * @file test_policy_engine.cpp
+ *
+ * This test suite verifies the policy engine. It checks the rule compiler on valid and invalid
+ * rules and files, that a rule fires only once a process matched it for the whole hold time and
+ * again only after it stopped matching, that a reused PID starts over, that rules evaluated from
+ * each other's candidates still match exactly the processes satisfying them, and that the actions
+ * reach a real process in the order they are written.
+ */
+
+#include "policy_engine.h"
+#include "process_info.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+Process makeProcess(int pid, double cpuUsage, double memoryUsage, const std::string& user = "alice",
+                    unsigned long long startTime = 1)
+{
+    Process process = {};
+    process.pid = pid;
+    process.user = user;
+    process.cpuUsage = cpuUsage;
+    process.memoryUsage = memoryUsage;
+    process.command = "stress";
+    process.startTime = startTime;
+    return process;
+}
+
+ProcessSnapshot makeEpoch(std::vector<Process> processes)
+{
+    ProcessSnapshot snapshot;
+    snapshot.timestampMs = 0;
+    snapshot.continuous = true;
+    snapshot.processes = std::move(processes);
+    return snapshot;
+}
+
+PolicyRule compile(const std::string& text)
+{
+    PolicyRule rule;
+    std::string error;
+    EXPECT_TRUE(parsePolicyRule(text, rule, error)) << text << ": " << error;
+    return rule;
+}
+
+std::vector<int> firedPids(const std::vector<PolicyFiring>& firings)
+{
+    std::vector<int> pids;
+    for (const PolicyFiring& firing : firings)
+    {
+        pids.push_back(firing.process.pid);
+    }
+    return pids;
+}
+
+} // namespace
+
+// The example rule compiles with its numeric conditions first and its actions in order
+TEST(PolicyEngineTest, ParsesRules)
+{
+    PolicyRule rule = compile("  user != root and cpu > 95 for 30s -> term 10s, then renice 10, alert  ");
+    EXPECT_EQ(rule.text, "user != root and cpu > 95 for 30s -> term 10s, then renice 10, alert");
+    ASSERT_EQ(rule.conditions.size(), 2u);
+    EXPECT_EQ(rule.conditions[0].field, PolicyField::Cpu);
+    EXPECT_EQ(rule.conditions[0].op, PolicyOperator::Greater);
+    EXPECT_EQ(rule.conditions[0].number, 95.0);
+    EXPECT_EQ(rule.conditions[1].field, PolicyField::User);
+    EXPECT_EQ(rule.conditions[1].op, PolicyOperator::NotEqual);
+    EXPECT_EQ(rule.conditions[1].text, "root");
+    EXPECT_EQ(rule.holdMs, 30000);
+    ASSERT_EQ(rule.actions.size(), 3u);
+    EXPECT_EQ(rule.actions[0].type, PolicyActionType::Terminate);
+    EXPECT_EQ(rule.actions[0].graceMs, 10000);
+    EXPECT_EQ(rule.actions[1].type, PolicyActionType::Renice);
+    EXPECT_EQ(rule.actions[1].nice, 10);
+    EXPECT_EQ(rule.actions[2].type, PolicyActionType::Alert);
+
+    // The duration may also come before further conditions, as in the documented example
+    rule = compile("cpu > 95 for 30s and user != root -> term 10s, then renice 10, alert");
+    ASSERT_EQ(rule.conditions.size(), 2u);
+    EXPECT_EQ(rule.conditions[0].field, PolicyField::Cpu);
+    EXPECT_EQ(rule.conditions[1].field, PolicyField::User);
+    EXPECT_EQ(rule.conditions[1].text, "root");
+    EXPECT_EQ(rule.holdMs, 30000);
+    ASSERT_EQ(rule.actions.size(), 3u);
+    EXPECT_EQ(rule.actions[0].graceMs, 10000);
+
+    // Operators need no spaces, the Unicode arrow works, and actions may be chained with "then"
+    rule = compile("memory>=2048 \xE2\x86\x92 alert then kill");
+    ASSERT_EQ(rule.conditions.size(), 1u);
+    EXPECT_EQ(rule.conditions[0].op, PolicyOperator::GreaterEqual);
+    EXPECT_EQ(rule.holdMs, 0);
+    ASSERT_EQ(rule.actions.size(), 2u);
+    EXPECT_EQ(rule.actions[1].type, PolicyActionType::Kill);
+
+    rule = compile("command = java and pid<5000 -> renice -5, term");
+    EXPECT_EQ(rule.conditions[0].field, PolicyField::Pid);
+    EXPECT_EQ(rule.conditions[1].op, PolicyOperator::Equal);
+    EXPECT_EQ(rule.actions[0].nice, -5);
+    EXPECT_EQ(rule.actions[1].graceMs, 0);
+}
+
+// Invalid rules are rejected with the reason
+TEST(PolicyEngineTest, RejectsInvalidRules)
+{
+    const std::pair<const char*, const char*> cases[] = {
+        {"load > 5 -> alert", "unknown field"},
+        {"cpu 95 -> alert", "expected a comparison"},
+        {"cpu > -> alert", "missing value"},
+        {"cpu > high -> alert", "invalid number"},
+        {"user > root -> alert", "only be compared"},
+        {"cpu > 95 for ever -> alert", "invalid duration"},
+        {"cpu > 95 or memory > 10 -> alert", "unexpected 'or'"},
+        {"cpu > 95 for 30s and memory > 10 for 1m -> alert", "only one 'for'"},
+        {"cpu > 95", "missing '->'"},
+        {"cpu > 95 ->", "missing action"},
+        {"cpu > 95 -> reboot", "unknown action"},
+        {"cpu > 95 -> renice 40", "renice needs"},
+        {"cpu > 95 -> term soon", "invalid grace period"},
+        {"cpu > 95 -> alert kill", "unexpected 'kill'"},
+    };
+    for (const auto& entry : cases)
+    {
+        PolicyRule rule;
+        std::string error;
+        EXPECT_FALSE(parsePolicyRule(entry.first, rule, error)) << entry.first;
+        EXPECT_NE(error.find(entry.second), std::string::npos) << entry.first << ": " << error;
+    }
+}
+
+// Files skip comments and blank lines; an error names its line
+TEST(PolicyEngineTest, LoadsFiles)
+{
+    char path[] = "/tmp/pm_policy_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    {
+        std::ofstream file(path);
+        file << "# Runaway jobs\n\ncpu > 95 for 30s -> term # then escalate\nmemory > 8192 -> alert\n";
+    }
+    std::vector<PolicyRule> rules;
+    std::string error;
+    ASSERT_TRUE(loadPolicyFile(path, rules, error)) << error;
+    ASSERT_EQ(rules.size(), 2u);
+    EXPECT_EQ(rules[0].line, 3);
+    EXPECT_EQ(rules[0].text, "cpu > 95 for 30s -> term");
+    EXPECT_EQ(rules[1].line, 4);
+
+    {
+        std::ofstream file(path);
+        file << "cpu > 95 -> alert\n\ncpu > 95 -> nothing\n";
+    }
+    EXPECT_FALSE(loadPolicyFile(path, rules, error));
+    EXPECT_NE(error.find(std::string(path) + ":3: unknown action"), std::string::npos) << error;
+
+    std::remove(path);
+    EXPECT_FALSE(loadPolicyFile(path, rules, error));
+}
+
+// A rule fires once the process matched for the hold time, once, and again after it stopped matching
+TEST(PolicyEngineTest, HoldTimeAndRearm)
+{
+    PolicyEngine engine;
+    engine.setRules({compile("cpu > 50 for 10s -> alert")});
+    std::vector<PolicyFiring> firings;
+
+    ProcessSnapshot busy = makeEpoch({makeProcess(10, 80.0, 1.0), makeProcess(11, 10.0, 1.0)});
+    ProcessSnapshot idle = makeEpoch({makeProcess(10, 20.0, 1.0), makeProcess(11, 10.0, 1.0)});
+
+    engine.evaluate(busy, 0, firings);
+    EXPECT_TRUE(firings.empty());
+    engine.evaluate(busy, 5000, firings);
+    EXPECT_TRUE(firings.empty());
+    engine.evaluate(busy, 10000, firings);
+    EXPECT_EQ(firedPids(firings), std::vector<int>{10});
+    EXPECT_EQ(firings[0].rule, 0u);
+    engine.evaluate(busy, 15000, firings);
+    EXPECT_TRUE(firings.empty());
+
+    // One epoch below the threshold starts the hold time over
+    engine.evaluate(idle, 20000, firings);
+    EXPECT_TRUE(firings.empty());
+    EXPECT_EQ(engine.status()[0].matching, 0u);
+    engine.evaluate(busy, 25000, firings);
+    engine.evaluate(busy, 34999, firings);
+    EXPECT_TRUE(firings.empty());
+    engine.evaluate(busy, 35000, firings);
+    EXPECT_EQ(firedPids(firings), std::vector<int>{10});
+
+    std::vector<PolicyRuleStatus> status = engine.status();
+    ASSERT_EQ(status.size(), 1u);
+    EXPECT_EQ(status[0].matching, 1u);
+    EXPECT_EQ(status[0].firings, 2u);
+
+    // New rules start without state
+    engine.setRules({compile("cpu > 50 -> alert")});
+    engine.evaluate(busy, 40000, firings);
+    EXPECT_EQ(firedPids(firings), std::vector<int>{10});
+    engine.clear();
+    engine.evaluate(busy, 45000, firings);
+    EXPECT_TRUE(firings.empty());
+    EXPECT_EQ(engine.ruleCount(), 0u);
+}
+
+// A process that got the PID of one that exited starts matching from scratch
+TEST(PolicyEngineTest, ReusedPidStartsOver)
+{
+    PolicyEngine engine;
+    engine.setRules({compile("cpu > 50 for 10s -> alert")});
+    std::vector<PolicyFiring> firings;
+
+    engine.evaluate(makeEpoch({makeProcess(10, 80.0, 1.0, "alice", 100)}), 0, firings);
+    engine.evaluate(makeEpoch({makeProcess(10, 80.0, 1.0, "alice", 200)}), 10000, firings);
+    EXPECT_TRUE(firings.empty());
+    engine.evaluate(makeEpoch({makeProcess(10, 80.0, 1.0, "alice", 200)}), 20000, firings);
+    EXPECT_EQ(firedPids(firings), std::vector<int>{10});
+}
+
+// Every condition must hold; rules fire independently, by rule then by PID
+TEST(PolicyEngineTest, CombinesConditionsAndRules)
+{
+    PolicyEngine engine;
+    engine.setRules({compile("user != root and cpu > 10 and memory >= 100 -> alert"), compile("memory < 50 -> alert"),
+                     compile("command == stress and cpu > 1000 -> alert"), compile("pid = 4 -> alert")});
+    std::vector<PolicyFiring> firings;
+
+    engine.evaluate(makeEpoch({makeProcess(1, 90.0, 500.0, "root"), makeProcess(2, 90.0, 500.0),
+                               makeProcess(3, 90.0, 99.0), makeProcess(4, 5.0, 100.0), makeProcess(5, 20.0, 20.0),
+                               makeProcess(6, 11.0, 100.0)}),
+                    0, firings);
+    ASSERT_EQ(firings.size(), 4u);
+    EXPECT_EQ(firings[0].rule, 0u);
+    EXPECT_EQ(firings[0].process.pid, 2);
+    EXPECT_EQ(firings[1].rule, 0u);
+    EXPECT_EQ(firings[1].process.pid, 6);
+    EXPECT_EQ(firings[2].rule, 1u);
+    EXPECT_EQ(firings[2].process.pid, 5);
+    EXPECT_EQ(firings[3].rule, 3u);
+    EXPECT_EQ(firings[3].process.pid, 4);
+    EXPECT_EQ(firings[0].actions.size(), 1u);
+
+    // No process at all
+    engine.evaluate(makeEpoch({}), 1000, firings);
+    EXPECT_TRUE(firings.empty());
+}
+
+// Rules sharing a column are evaluated from the loosest threshold on; each still fires for exactly
+// the processes that satisfy all of its conditions
+TEST(PolicyEngineTest, MatchesEveryRuleExactly)
+{
+    const char* ruleTexts[] = {
+        "cpu > 50 -> alert",
+        "cpu >= 50 -> alert",
+        "cpu > 20 and user != root -> alert",
+        "cpu <= 30 -> alert",
+        "cpu < 30 -> alert",
+        "cpu < 70 and memory > 40 -> alert",
+        "memory >= 90 -> alert",
+        "user == bob -> alert",
+        "user == bob and cpu >= 50 -> alert",
+        "command == java -> alert",
+        "pid != 7 and cpu > 90 -> alert",
+        "user == carol -> alert",
+        "cpu > 1000 -> alert",
+        "cpu >= 0 and memory < 10 -> alert",
+    };
+    std::vector<PolicyRule> rules;
+    for (const char* text : ruleTexts)
+    {
+        rules.push_back(compile(text));
+    }
+    PolicyEngine engine;
+    engine.setRules(rules);
+
+    auto satisfies = [](const Process& process, const PolicyCondition& condition) {
+        double value = condition.field == PolicyField::Cpu      ? process.cpuUsage
+                       : condition.field == PolicyField::Memory ? process.memoryUsage
+                                                                : process.pid;
+        switch (condition.op)
+        {
+        case PolicyOperator::Greater:
+            return value > condition.number;
+        case PolicyOperator::GreaterEqual:
+            return value >= condition.number;
+        case PolicyOperator::Less:
+            return value < condition.number;
+        case PolicyOperator::LessEqual:
+            return value <= condition.number;
+        case PolicyOperator::Equal:
+        case PolicyOperator::NotEqual:
+            break;
+        }
+        bool equal = condition.field == PolicyField::User      ? process.user == condition.text
+                     : condition.field == PolicyField::Command ? process.command == condition.text
+                                                               : value == condition.number;
+        return equal == (condition.op == PolicyOperator::Equal);
+    };
+
+    static const char* users[] = {"root", "alice", "bob"};
+    static const char* commands[] = {"java", "bash"};
+    srandom(11);
+    for (int epoch = 0; epoch < 20; ++epoch)
+    {
+        // Values on a coarse grid, so many fall on the thresholds
+        std::vector<Process> processes;
+        for (int pid = 1; pid <= 200; ++pid)
+        {
+            Process process = makeProcess(pid, (random() % 21) * 5.0, (random() % 11) * 10.0, users[random() % 3],
+                                          static_cast<unsigned long long>(epoch + 1));
+            process.command = commands[random() % 2];
+            processes.push_back(process);
+        }
+
+        std::vector<std::pair<size_t, int>> expected;
+        for (size_t r = 0; r < rules.size(); ++r)
+        {
+            for (const Process& process : processes)
+            {
+                bool matches = true;
+                for (const PolicyCondition& condition : rules[r].conditions)
+                {
+                    matches = matches && satisfies(process, condition);
+                }
+                if (matches)
+                    expected.push_back({r, process.pid});
+            }
+        }
+
+        // A new start time every epoch, so every rule fires again for every match
+        std::vector<PolicyFiring> firings;
+        engine.evaluate(makeEpoch(processes), epoch * 1000, firings);
+        std::vector<std::pair<size_t, int>> actual;
+        for (const PolicyFiring& firing : firings)
+        {
+            actual.push_back({firing.rule, firing.process.pid});
+        }
+        ASSERT_EQ(actual, expected) << "epoch " << epoch;
+    }
+}
+
+// Actions reach the process in the order of the rule: renice, then SIGTERM
+TEST(PolicyEngineTest, ExecutesActions)
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        pause();
+        _exit(0);
+    }
+    ASSERT_GT(child, 0);
+    Process process = makeProcess(child, 99.0, 1.0);
+    ASSERT_TRUE(readProcessStartTime(child, process.startTime));
+
+    PolicyEngine engine;
+    std::string pid = std::to_string(child);
+    engine.setRules({compile("pid == " + pid + " -> alert, renice 7")});
+    engine.run(makeEpoch({process}), 0);
+    EXPECT_EQ(getpriority(PRIO_PROCESS, static_cast<id_t>(child)), 7);
+
+    engine.setRules({compile("pid == " + pid + " -> renice 9, term")});
+    engine.run(makeEpoch({process}), 0);
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGTERM);
+    EXPECT_EQ(engine.status()[0].firings, 1u);
+
+    // The PID is gone: a new firing is reported as failed, not sent elsewhere
+    engine.setRules({compile("pid == " + pid + " -> renice 7, kill")});
+    engine.run(makeEpoch({process}), 0);
+    EXPECT_EQ(engine.status()[0].firings, 1u);
+}
@@ -8,13 +8,17 @@
  * ability to terminate processes under different conditions.
  */
 
+#include "globals.h"
 #include "process_control.h"
+#include "process_info.h"
+#include <climits>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <cerrno>
+#include <vector>
 
 /**
  * @brief Mock function to simulate the behavior of the `kill` system call.
@@ -136,3 +140,116 @@ TEST(RealProcessControlTest, KillProcessRealChild) {
 TEST(RealProcessControlTest, KillProcessNonExistent) {
     EXPECT_FALSE(killProcess(99999)) << "Non-existent process should not be killed";
 }
+
+/**
+ * @brief Forks a child that waits for a signal, and returns its PID and start time.
+ */
+static KillTarget spawnSleeper() {
+    pid_t pid = fork();
+    if (pid == 0) {
+        pause();
+        _exit(0);
+    }
+    KillTarget target{pid};
+    EXPECT_TRUE(readProcessStartTime(pid, target.startTime));
+    return target;
+}
+
+/**
+ * @brief Reaps a child and returns whether SIGKILL terminated it.
+ */
+static bool reapKilled(pid_t pid) {
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL;
+}
+
+/**
+ * @brief Tests that `signalProcesses` reports each target and spares a PID whose start time changed.
+ *
+ * A target with a different start time stands for a process that exited and whose PID was given to a
+ * newer one: it must not be signalled. Neither must a target whose start time is unknown, unless it
+ * is resolved from the PID first.
+ */
+TEST(RealProcessControlTest, SignalProcessesReport) {
+    KillTarget verified = spawnSleeper();
+    KillTarget recycled = spawnSleeper();
+    KillTarget unchecked = spawnSleeper();
+    unchecked.startTime = 0;
+    KillTarget stale = recycled;
+    stale.startTime += 1;
+
+    KillReport report = signalProcesses({verified, stale, unchecked, KillTarget{INT_MAX}, KillTarget{getpid()}});
+    ASSERT_EQ(report.results.size(), 5u);
+    EXPECT_EQ(report.results[0].outcome, KillOutcome::Killed);
+    EXPECT_EQ(report.results[1].outcome, KillOutcome::Recycled);
+    EXPECT_EQ(report.results[2].outcome, KillOutcome::Refused);
+    EXPECT_EQ(report.results[3].outcome, KillOutcome::NotFound);
+    EXPECT_EQ(report.results[4].outcome, KillOutcome::Refused);
+    EXPECT_EQ(report.results[1].pid, recycled.pid);
+    EXPECT_EQ(report.killed(), 1u);
+    EXPECT_EQ(report.failed(), 4u);
+
+    EXPECT_TRUE(reapKilled(verified.pid));
+    EXPECT_EQ(kill(recycled.pid, 0), 0) << "A process with another start time was signalled";
+    EXPECT_EQ(kill(unchecked.pid, 0), 0) << "A process with an unknown start time was signalled";
+
+    // Resolved from its PID, the process holding it now is signalled
+    KillTarget current = currentKillTarget(unchecked.pid);
+    EXPECT_NE(current.startTime, 0u);
+    report = signalProcesses({current, currentKillTarget(INT_MAX)});
+    ASSERT_EQ(report.results.size(), 2u);
+    EXPECT_EQ(report.results[0].outcome, KillOutcome::Killed);
+    EXPECT_EQ(report.results[1].outcome, KillOutcome::NotFound);
+    EXPECT_TRUE(reapKilled(unchecked.pid));
+
+    kill(recycled.pid, SIGKILL);
+    EXPECT_TRUE(reapKilled(recycled.pid));
+}
+
+/**
+ * @brief Tests that a set of several batches is signalled completely by several threads, in order.
+ */
+TEST(RealProcessControlTest, SignalProcessesParallelBatches) {
+    std::vector<KillTarget> targets;
+    for (int i = 0; i < 600; ++i) {
+        targets.push_back(spawnSleeper());
+    }
+    KillReport report = signalProcesses(targets, SIGKILL, 3);
+    ASSERT_EQ(report.results.size(), targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        EXPECT_EQ(report.results[i].pid, targets[i].pid);
+        EXPECT_EQ(report.results[i].outcome, KillOutcome::Killed);
+        EXPECT_TRUE(reapKilled(targets[i].pid));
+    }
+}
+
+/**
+ * @brief Tests that `killProcessesByCpu` kills the sampled processes above the threshold only.
+ */
+TEST(RealProcessControlTest, KillProcessesByCpu) {
+    KillTarget busy = spawnSleeper();
+    KillTarget idle = spawnSleeper();
+    KillTarget recycled = spawnSleeper();
+    {
+        std::lock_guard<std::mutex> lock(processMutex);
+        processes.clear();
+        processes[busy.pid] = Process{busy.pid, "test", 95.0, 1.0, 0, "busy", busy.startTime};
+        processes[idle.pid] = Process{idle.pid, "test", 1.0, 1.0, 0, "idle", idle.startTime};
+        processes[recycled.pid] = Process{recycled.pid, "test", 95.0, 1.0, 0, "old", recycled.startTime + 1};
+    }
+
+    KillReport report = killProcessesByCpu(50.0);
+    EXPECT_EQ(report.results.size(), 2u);
+    EXPECT_EQ(report.killed(), 1u);
+    EXPECT_EQ(report.count(KillOutcome::Recycled), 1u);
+    EXPECT_TRUE(reapKilled(busy.pid));
+
+    {
+        std::lock_guard<std::mutex> lock(processMutex);
+        processes.clear();
+    }
+    for (pid_t pid : {idle.pid, recycled.pid}) {
+        EXPECT_EQ(kill(pid, SIGKILL), 0);
+        EXPECT_TRUE(reapKilled(pid));
+    }
+}
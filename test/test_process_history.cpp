@@ -0,0 +1,149 @@
+/**
+ * @file test_process_history.cpp
+ *
+ * This test suite verifies the per-process history. It checks that rings keep the most recent
+ * window of samples in order, that the history never tracks more processes than its budget allows,
+ * that exited processes are evicted before idle or active ones, and the statistics and sparkline
+ * helpers used by the `history` command.
+ */
+
+#include "process_history.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Budget that fits exactly `slots` rings of `window` samples (see kPerSlotOverhead in process_history.cpp)
+size_t budgetFor(size_t slots, size_t window)
+{
+    return slots * (window * sizeof(HistorySample) + 6 * sizeof(uint32_t) + 32);
+}
+
+// Number of code points in a UTF-8 string
+size_t codePoints(const std::string& text)
+{
+    size_t count = 0;
+    for (unsigned char c : text)
+    {
+        if ((c & 0xC0) != 0x80)
+            count++;
+    }
+    return count;
+}
+
+} // namespace
+
+// A ring keeps the last `window` samples, oldest first, after wrapping around
+TEST(ProcessHistoryTest, RingKeepsLatestWindow)
+{
+    ProcessHistory history(budgetFor(4, 5), 5);
+    for (int epoch = 0; epoch < 12; ++epoch)
+    {
+        history.recordEpoch({{42, static_cast<double>(epoch), 100.0 + epoch}});
+    }
+
+    std::vector<HistorySample> samples;
+    ASSERT_TRUE(history.samples(42, samples));
+    ASSERT_EQ(samples.size(), 5u);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(samples[i].cpuUsage, 7.0f + i);
+        EXPECT_FLOAT_EQ(samples[i].memoryUsage, 107.0f + i);
+    }
+    EXPECT_FALSE(history.samples(43, samples));
+    EXPECT_TRUE(samples.empty());
+}
+
+// The number of tracked processes is bounded by the budget, whatever the number of processes
+TEST(ProcessHistoryTest, CapacityStaysWithinBudget)
+{
+    ProcessHistory history(budgetFor(100, 120), 120);
+    EXPECT_EQ(history.capacity(), 100u);
+
+    std::vector<HistoryUpdate> updates;
+    for (int pid = 1; pid <= 1000; ++pid)
+    {
+        updates.push_back({pid, 1.0, 10.0});
+    }
+    history.recordEpoch(updates);
+
+    EXPECT_EQ(history.trackedCount(), 100u);
+    EXPECT_EQ(history.evictions(), 900u);
+
+    ProcessHistory tiny(16, 120);
+    EXPECT_EQ(tiny.capacity(), 0u);
+    tiny.recordEpoch(updates);
+    EXPECT_EQ(tiny.trackedCount(), 0u);
+}
+
+// Processes missing from the latest epoch are evicted before processes that are still running
+TEST(ProcessHistoryTest, EvictsExitedProcessesFirst)
+{
+    ProcessHistory history(budgetFor(3, 10), 10);
+    history.recordEpoch({{1, 5.0, 10.0}, {2, 0.0, 10.0}, {3, 5.0, 10.0}});
+
+    // PID 2 exits; PID 1 goes idle and so becomes the least recently active ring
+    history.recordEpoch({{1, 0.0, 10.0}, {3, 5.0, 10.0}});
+    history.recordEpoch({{1, 0.0, 10.0}, {3, 5.0, 10.0}, {4, 1.0, 20.0}});
+
+    std::vector<HistorySample> samples;
+    EXPECT_TRUE(history.samples(1, samples));
+    EXPECT_FALSE(history.samples(2, samples));
+    EXPECT_TRUE(history.samples(3, samples));
+    EXPECT_TRUE(history.samples(4, samples));
+
+    // With no exited process left, the process idle the longest makes room
+    history.recordEpoch({{1, 0.0, 10.0}, {3, 5.0, 10.0}, {4, 1.0, 20.0}, {5, 2.0, 30.0}});
+    EXPECT_FALSE(history.samples(1, samples));
+    EXPECT_TRUE(history.samples(3, samples));
+    EXPECT_TRUE(history.samples(4, samples));
+    EXPECT_TRUE(history.samples(5, samples));
+    EXPECT_EQ(history.evictions(), 2u);
+}
+
+// Reconfiguring discards samples and applies the new window
+TEST(ProcessHistoryTest, ConfigureResets)
+{
+    ProcessHistory history(budgetFor(10, 10), 10);
+    history.recordEpoch({{7, 1.0, 1.0}});
+    history.configure(budgetFor(20, 4), 4);
+
+    std::vector<HistorySample> samples;
+    EXPECT_FALSE(history.samples(7, samples));
+    EXPECT_EQ(history.window(), 4u);
+    EXPECT_EQ(history.capacity(), 20u);
+}
+
+TEST(ProcessHistoryTest, ComputeStats)
+{
+    std::vector<double> values;
+    for (int i = 1; i <= 100; ++i)
+    {
+        values.push_back(101 - i); // Order must not matter
+    }
+
+    HistoryStats stats = ProcessHistory::computeStats(values);
+    EXPECT_EQ(stats.count, 100u);
+    EXPECT_DOUBLE_EQ(stats.min, 1.0);
+    EXPECT_DOUBLE_EQ(stats.max, 100.0);
+    EXPECT_DOUBLE_EQ(stats.avg, 50.5);
+    EXPECT_DOUBLE_EQ(stats.p95, 95.0);
+
+    EXPECT_EQ(ProcessHistory::computeStats({}).count, 0u);
+}
+
+TEST(ProcessHistoryTest, Sparkline)
+{
+    std::vector<double> ramp;
+    for (int i = 0; i < 8; ++i)
+    {
+        ramp.push_back(i);
+    }
+    EXPECT_EQ(ProcessHistory::sparkline(ramp, 8), "▁▂▃▄▅▆▇█");
+
+    std::vector<double> longSeries(120, 3.0);
+    EXPECT_EQ(codePoints(ProcessHistory::sparkline(longSeries, 60)), 60u);
+    EXPECT_EQ(ProcessHistory::sparkline({}, 60), "");
+}
@@ -0,0 +1,90 @@
+/**
+ * @file test_process_snapshot.cpp
+ *
+ * This test suite verifies the snapshots published by the sampling threads: interpolation between
+ * two snapshots (including processes that appear, exit or reuse a PID) and publication to readers
+ * that keep using a snapshot while a newer one is published.
+ */
+
+#include "process_snapshot.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+Process makeProcess(int pid, double cpu, double memory, const std::string& command = "cmd")
+{
+    return Process{pid, "root", cpu, memory, 0, command};
+}
+
+} // namespace
+
+// Values move linearly from the previous snapshot to the latest one
+TEST(ProcessSnapshotTest, Interpolation)
+{
+    auto previous = makeSnapshot({makeProcess(3, 10.0, 100.0), makeProcess(1, 0.0, 50.0), makeProcess(7, 5.0, 1.0),
+                                  makeProcess(9, 80.0, 10.0, "old")},
+                                 1000, true);
+    auto latest = makeSnapshot({makeProcess(9, 20.0, 20.0, "new"), makeProcess(1, 40.0, 50.0),
+                                makeProcess(3, 30.0, 200.0), makeProcess(5, 60.0, 5.0)},
+                               3000, true);
+    ASSERT_EQ(latest->processes.front().pid, 1); // Sorted by PID
+
+    std::vector<Process> shown;
+    interpolateSnapshots(*previous, *latest, 0.25, shown);
+    ASSERT_EQ(shown.size(), 4u); // PID 7 exited
+    EXPECT_EQ(shown[0].pid, 1);
+    EXPECT_DOUBLE_EQ(shown[0].cpuUsage, 10.0);
+    EXPECT_DOUBLE_EQ(shown[1].cpuUsage, 15.0);    // PID 3
+    EXPECT_DOUBLE_EQ(shown[1].memoryUsage, 125.0);
+    EXPECT_DOUBLE_EQ(shown[2].cpuUsage, 60.0);    // PID 5 is new
+    EXPECT_DOUBLE_EQ(shown[3].cpuUsage, 20.0);    // PID 9 runs another program
+    EXPECT_EQ(shown[3].command, "new");
+
+    // The fraction is clamped to the two snapshots
+    interpolateSnapshots(*previous, *latest, -1.0, shown);
+    EXPECT_DOUBLE_EQ(shown[0].cpuUsage, 0.0);
+    interpolateSnapshots(*previous, *latest, 3.0, shown);
+    EXPECT_DOUBLE_EQ(shown[0].cpuUsage, 40.0);
+}
+
+// Readers keep their snapshot alive while newer ones are published
+TEST(ProcessSnapshotTest, Publication)
+{
+    SnapshotPublisher publisher;
+    EXPECT_EQ(publisher.latest(), nullptr);
+
+    std::thread writer([&]() {
+        for (int epoch = 1; epoch <= 2000; ++epoch)
+        {
+            std::vector<Process> processes;
+            for (int pid = 1; pid <= 20; ++pid)
+            {
+                processes.push_back(makeProcess(pid, epoch, epoch));
+            }
+            publisher.publish(makeSnapshot(std::move(processes), epoch, true));
+        }
+    });
+
+    int64_t lastSeen = 0;
+    while (lastSeen < 2000)
+    {
+        auto snapshot = publisher.latest();
+        if (!snapshot)
+            continue;
+        // Snapshots are complete and consistent, and never go back in time
+        ASSERT_GE(snapshot->timestampMs, lastSeen);
+        ASSERT_EQ(snapshot->processes.size(), 20u);
+        for (const auto& process : snapshot->processes)
+        {
+            ASSERT_EQ(process.cpuUsage, static_cast<double>(snapshot->timestampMs));
+        }
+        lastSeen = snapshot->timestampMs;
+    }
+    writer.join();
+
+    publisher.reset();
+    EXPECT_EQ(publisher.latest(), nullptr);
+}
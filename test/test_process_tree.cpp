@@ -0,0 +1,304 @@
+/**
+ * @file test_process_tree.cpp
+ *
+ * This test suite verifies the process tree. It checks that the subtree sums follow processes that
+ * change usage, exit, reuse a PID or move to another parent, that the incremental updates agree
+ * with sums recomputed from scratch over random epochs, the layout used by the tree view, and that
+ * the tree read from a synthetic procfs has the scripted parent links.
+ */
+
+#include "globals.h"
+#include "process_control.h"
+#include "process_tree.h"
+#include "synthetic_proc.h"
+#include <algorithm>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+Process makeProcess(int pid, int ppid, double cpuUsage, double memoryUsage, unsigned long long startTime = 1)
+{
+    Process process = {};
+    process.pid = pid;
+    process.ppid = ppid;
+    process.cpuUsage = cpuUsage;
+    process.memoryUsage = memoryUsage;
+    process.startTime = startTime;
+    process.command = "cmd" + std::to_string(pid);
+    process.user = pid % 2 == 0 ? "root" : "alice";
+    return process;
+}
+
+// Reads the sums of a subtree, failing the test if the process is not in the tree
+void expectSubtree(const ProcessTree& tree, int pid, double cpuUsage, double memoryUsage, size_t count)
+{
+    double cpu = 0, memory = 0;
+    size_t processes = 0;
+    ASSERT_TRUE(tree.subtreeUsage(pid, cpu, memory, processes)) << "PID " << pid;
+    EXPECT_NEAR(cpu, cpuUsage, 1e-6) << "PID " << pid;
+    EXPECT_NEAR(memory, memoryUsage, 1e-3) << "PID " << pid;
+    EXPECT_EQ(processes, count) << "PID " << pid;
+}
+
+std::vector<int> pidsOf(const std::vector<Process>& processes)
+{
+    std::vector<int> pids;
+    for (const Process& process : processes)
+    {
+        pids.push_back(process.pid);
+    }
+    return pids;
+}
+
+} // namespace
+
+// Sums cover the process and its descendants and follow changes of usage and exits
+TEST(ProcessTreeTest, SumsFollowChangesAndExits)
+{
+    ProcessTree tree;
+    tree.update({makeProcess(1, 0, 1.0, 10.0), makeProcess(2, 1, 5.0, 20.0), makeProcess(3, 2, 2.5, 30.0),
+                 makeProcess(4, 2, 0.5, 40.0)});
+    ASSERT_EQ(tree.size(), 4u);
+    expectSubtree(tree, 1, 9.0, 100.0, 4);
+    expectSubtree(tree, 2, 8.0, 90.0, 3);
+    expectSubtree(tree, 3, 2.5, 30.0, 1);
+
+    // 3 gets busier, 4 exits
+    tree.update({makeProcess(1, 0, 1.0, 10.0), makeProcess(2, 1, 5.0, 20.0), makeProcess(3, 2, 12.5, 35.0)});
+    EXPECT_EQ(tree.size(), 3u);
+    expectSubtree(tree, 1, 18.5, 65.0, 3);
+    expectSubtree(tree, 2, 17.5, 55.0, 2);
+
+    // 2 exits: its child stays as a root until an epoch reports its new parent
+    tree.update({makeProcess(1, 0, 1.0, 10.0), makeProcess(3, 2, 12.5, 35.0)});
+    expectSubtree(tree, 1, 1.0, 10.0, 1);
+    expectSubtree(tree, 3, 12.5, 35.0, 1);
+    tree.update({makeProcess(1, 0, 1.0, 10.0), makeProcess(3, 1, 12.5, 35.0)});
+    expectSubtree(tree, 1, 13.5, 45.0, 2);
+
+    double cpu = 0, memory = 0;
+    size_t count = 0;
+    EXPECT_FALSE(tree.subtreeUsage(2, cpu, memory, count));
+    tree.clear();
+    EXPECT_EQ(tree.size(), 0u);
+}
+
+// A child listed before its parent is linked once the whole epoch is known
+TEST(ProcessTreeTest, ChildrenBeforeParents)
+{
+    ProcessTree tree;
+    tree.update({makeProcess(7, 5, 1.0, 1.0), makeProcess(6, 5, 2.0, 1.0), makeProcess(5, 0, 3.0, 1.0)});
+    expectSubtree(tree, 5, 6.0, 3.0, 3);
+    EXPECT_EQ(pidsOf(tree.subtree(5)).front(), 5);
+    EXPECT_EQ(tree.subtree(5).size(), 3u);
+    EXPECT_TRUE(tree.subtree(8).empty());
+}
+
+// A PID with another start time is a new process, even if its parent did not change
+TEST(ProcessTreeTest, ReusedPidIsANewProcess)
+{
+    ProcessTree tree;
+    tree.update({makeProcess(10, 0, 1.0, 1.0, 100), makeProcess(11, 10, 2.0, 2.0, 200)});
+    expectSubtree(tree, 10, 3.0, 3.0, 2);
+
+    // 10 was replaced by a process that started later; the old children of 10 keep reporting it as parent
+    tree.update({makeProcess(10, 0, 4.0, 4.0, 300), makeProcess(11, 10, 2.0, 2.0, 200)});
+    ASSERT_EQ(tree.size(), 2u);
+    expectSubtree(tree, 10, 6.0, 6.0, 2);
+    EXPECT_EQ(tree.subtree(10).front().startTime, 300u);
+}
+
+// Parent links that form a cycle (possible in a torn read) do not loop the tree
+TEST(ProcessTreeTest, CycleIsBroken)
+{
+    ProcessTree tree;
+    tree.update({makeProcess(1, 2, 1.0, 1.0), makeProcess(2, 1, 1.0, 1.0)});
+    ASSERT_EQ(tree.size(), 2u);
+
+    std::vector<Process> rows;
+    tree.layout("cpu", {"", ""}, 10, rows);
+    EXPECT_EQ(rows.size(), 2u);
+
+    // Moving a process under its own descendant is refused the same way
+    tree.update({makeProcess(1, 0, 1.0, 1.0), makeProcess(2, 1, 1.0, 1.0), makeProcess(3, 2, 1.0, 1.0)});
+    tree.update({makeProcess(1, 3, 1.0, 1.0), makeProcess(2, 1, 1.0, 1.0), makeProcess(3, 2, 1.0, 1.0)});
+    expectSubtree(tree, 1, 3.0, 3.0, 3);
+}
+
+// Incremental updates give the sums of a tree built from scratch, over random epochs
+TEST(ProcessTreeTest, IncrementalMatchesRecomputed)
+{
+    std::mt19937 random(42);
+    std::map<int, Process> running;
+    int nextPid = 2;
+    running[1] = makeProcess(1, 0, 0.5, 4.0); // Memory in multiples of 1/8 MB, which are exact in kB
+    for (; nextPid < 300; ++nextPid)
+    {
+        int ppid = 1 + static_cast<int>(random() % static_cast<unsigned>(nextPid - 1));
+        running[nextPid] = makeProcess(nextPid, ppid, (random() % 1000) / 100.0, (random() % 5000) / 8.0);
+    }
+
+    ProcessTree tree;
+    for (int epoch = 0; epoch < 50; ++epoch)
+    {
+        std::vector<int> pids;
+        for (const auto& entry : running)
+            pids.push_back(entry.first);
+        auto pick = [&]() { return pids[random() % pids.size()]; };
+
+        for (int i = 0; i < 10; ++i) // Changes of usage
+        {
+            Process& process = running[pick()];
+            process.cpuUsage = (random() % 1000) / 100.0;
+            process.memoryUsage = (random() % 5000) / 8.0;
+        }
+        for (int i = 0; i < 3; ++i) // Exits; the children of an exited process keep its PID as parent
+        {
+            int pid = pick();
+            if (pid != 1)
+                running.erase(pid);
+        }
+        for (int i = 0; i < 3; ++i) // Forks
+        {
+            int ppid = std::next(running.begin(), static_cast<long>(random() % running.size()))->first;
+            running[nextPid] = makeProcess(nextPid, ppid, 1.0, 1.0);
+            nextPid++;
+        }
+        for (int i = 0; i < 2; ++i) // Orphans adopted by init
+        {
+            auto it = std::next(running.begin(), static_cast<long>(random() % running.size()));
+            if (it->first != 1)
+                it->second.ppid = 1;
+        }
+
+        std::vector<Process> processes;
+        for (const auto& entry : running)
+            processes.push_back(entry.second);
+        std::shuffle(processes.begin(), processes.end(), random);
+        tree.update(processes);
+        ASSERT_EQ(tree.size(), running.size());
+
+        // Recompute every sum by walking up from each process
+        std::map<int, double> cpu, memory;
+        std::map<int, size_t> count;
+        for (const auto& entry : running)
+        {
+            for (int pid = entry.first; pid != 0;)
+            {
+                cpu[pid] += entry.second.cpuUsage;
+                memory[pid] += entry.second.memoryUsage;
+                count[pid]++;
+                int ppid = running.at(pid).ppid;
+                pid = running.count(ppid) != 0 ? ppid : 0;
+            }
+        }
+        for (const auto& entry : running)
+        {
+            expectSubtree(tree, entry.first, cpu[entry.first], memory[entry.first], count[entry.first]);
+        }
+    }
+}
+
+// Rows come depth first with siblings by descending subtree usage, indented by depth
+TEST(ProcessTreeTest, LayoutOrdersAndIndents)
+{
+    ProcessTree tree;
+    tree.update({makeProcess(1, 0, 1.0, 100.0), makeProcess(2, 1, 5.0, 300.0), makeProcess(3, 1, 20.0, 10.0),
+                 makeProcess(4, 3, 1.0, 10.0)});
+
+    std::vector<Process> rows;
+    tree.layout("cpu", {"", ""}, 10, rows);
+    EXPECT_EQ(pidsOf(rows), (std::vector<int>{1, 3, 4, 2}));
+    EXPECT_EQ(rows[0].command, "cmd1");
+    EXPECT_EQ(rows[1].command, "\\_ cmd3");
+    EXPECT_EQ(rows[2].command, "  \\_ cmd4");
+    EXPECT_NEAR(rows[0].cpuUsage, 27.0, 1e-6);
+    EXPECT_NEAR(rows[1].cpuUsage, 21.0, 1e-6);
+
+    tree.layout("memory", {"", ""}, 10, rows);
+    EXPECT_EQ(pidsOf(rows), (std::vector<int>{1, 2, 3, 4}));
+
+    tree.layout("cpu", {"", ""}, 2, rows);
+    EXPECT_EQ(pidsOf(rows), (std::vector<int>{1, 3}));
+
+    // Subtrees at or below the threshold are pruned with their descendants
+    tree.layout("cpu", {"cpu", "6"}, 10, rows);
+    EXPECT_EQ(pidsOf(rows), (std::vector<int>{1, 3}));
+
+    // A user filter hides rows but keeps walking below them
+    tree.layout("cpu", {"user", "root"}, 10, rows);
+    EXPECT_EQ(pidsOf(rows), (std::vector<int>{4, 2}));
+}
+
+/**
+ * @brief Fixture that writes a fake procfs tree and points `procRoot` at it for the test duration.
+ */
+class ProcessTreeScanTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_faketree_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+
+        SyntheticProcOptions options;
+        options.pidCount = 200;
+        options.firstPid = 100;
+        tree = new SyntheticProcTree(dirTemplate, options);
+        ASSERT_TRUE(tree->writeTick(0));
+
+        savedRoot = procRoot;
+        procRoot = tree->root();
+    }
+
+    void TearDown() override
+    {
+        procRoot = savedRoot;
+        tree->remove();
+        delete tree;
+    }
+
+    SyntheticProcTree* tree = nullptr;
+    std::string savedRoot;
+};
+
+// The tree read from the stat files has the scripted parents, and a subtree selects exactly the descendants
+TEST_F(ProcessTreeScanTest, ScanMatchesScriptedParents)
+{
+    ProcessTree scanned;
+    scanProcessTree(scanned);
+    ASSERT_EQ(scanned.size(), 200u);
+    EXPECT_EQ(scanned.subtree(100).size(), 200u);
+
+    // Pick the process with the most descendants besides init
+    std::map<int, std::set<int>> descendants;
+    for (int pid = 101; pid < 300; ++pid)
+    {
+        for (int parent = tree->parentOf(pid); parent > 100; parent = tree->parentOf(parent))
+            descendants[parent].insert(pid);
+    }
+    ASSERT_FALSE(descendants.empty());
+    auto largest = std::max_element(descendants.begin(), descendants.end(),
+                                    [](const auto& a, const auto& b) { return a.second.size() < b.second.size(); });
+    int root = largest->first;
+
+    std::vector<KillTarget> targets = selectProcessTree(root);
+    ASSERT_EQ(targets.size(), largest->second.size() + 1);
+    EXPECT_EQ(targets.front().pid, root);
+    std::set<int> selected;
+    for (const KillTarget& target : targets)
+    {
+        EXPECT_NE(target.startTime, 0u) << "PID " << target.pid;
+        selected.insert(target.pid);
+    }
+    selected.erase(root);
+    EXPECT_EQ(selected, largest->second);
+    EXPECT_TRUE(selectProcessTree(99).empty());
+}
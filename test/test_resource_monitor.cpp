@@ -46,3 +46,32 @@ TEST(ResourceMonitorTest, GetProcessTotalTime) {
         GTEST_SKIP() << "No processes available to test";
     }
 }
+
+/**
+ * @brief Tests that selecting the top processes gives the head of a full sort.
+ *
+ * The display only sorts as many processes as fit on the screen. For every limit, the selected
+ * processes must be exactly the first ones of the fully sorted list, in the same order.
+ */
+TEST(ResourceMonitorTest, SortProcessesTopK) {
+    std::vector<Process> all;
+    for (int pid = 1; pid <= 500; ++pid) {
+        all.push_back(Process{pid, "root", static_cast<double>((pid * 7919) % 1000), static_cast<double>(pid % 37), 0,
+                              "cmd"});
+    }
+
+    for (const std::string criterion : {"cpu", "memory"}) {
+        std::vector<Process> sorted = all;
+        sortProcesses(sorted, criterion);
+        for (size_t limit : {0u, 1u, 30u, 499u, 500u, 1000u}) {
+            std::vector<Process> top = all;
+            sortProcesses(top, criterion, limit);
+            ASSERT_EQ(top.size(), std::min(limit, all.size()));
+            for (size_t i = 0; i < top.size(); ++i) {
+                // Memory values have ties, so compare the key rather than the PID
+                EXPECT_EQ(criterion == "cpu" ? top[i].cpuUsage : top[i].memoryUsage,
+                          criterion == "cpu" ? sorted[i].cpuUsage : sorted[i].memoryUsage);
+            }
+        }
+    }
+}
@@ -0,0 +1,241 @@
+/**
+ * @file test_screen_renderer.cpp
+ *
+ * This test suite verifies the diff-based screen renderer. The escape sequences it produces are
+ * replayed on a minimal terminal emulator, and the emulated screen is compared with the composed
+ * frames after full repaints, partial updates, shrinking tables and invalidation. The size of the
+ * updates is checked as well.
+ */
+
+#include "process_display.h"
+#include "screen_renderer.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief Terminal emulator understanding the sequences emitted by the renderer (CUP, ED, EL, SGR).
+ */
+class FakeTerminal
+{
+  public:
+    FakeTerminal(int rows, int columns) : m_rows(rows), m_columns(columns), m_text(rows, std::string(columns, ' ')),
+                                          m_colors(rows, std::string(columns, '0'))
+    {
+    }
+
+    void feed(const std::string& data)
+    {
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            if (data[i] != '\033')
+            {
+                if (m_row < m_rows && m_column < m_columns)
+                {
+                    m_text[m_row][m_column] = data[i];
+                    m_colors[m_row][m_column] = m_color;
+                }
+                m_column++;
+                continue;
+            }
+
+            // Parse a CSI sequence: ESC [ params final
+            ASSERT_EQ(data[++i], '[');
+            std::string params;
+            while (!isalpha(static_cast<unsigned char>(data[++i])))
+            {
+                params += data[i];
+            }
+            int first = 0, second = 0;
+            sscanf(params.c_str(), "%d;%d", &first, &second);
+            switch (data[i])
+            {
+            case 'H':
+                m_row = params.empty() ? 0 : first - 1;
+                m_column = params.empty() ? 0 : second - 1;
+                break;
+            case 'J':
+                ASSERT_EQ(first, 2);
+                for (int row = 0; row < m_rows; ++row)
+                {
+                    m_text[row].assign(m_columns, ' ');
+                    m_colors[row].assign(m_columns, '0');
+                }
+                break;
+            case 'K':
+                for (int column = m_column; column < m_columns && m_row < m_rows; ++column)
+                {
+                    m_text[m_row][column] = ' ';
+                    m_colors[m_row][column] = '0';
+                }
+                break;
+            case 'm':
+                m_color = first == 0 ? '0' : static_cast<char>('0' + first - 30);
+                break;
+            default:
+                FAIL() << "Unexpected sequence " << data[i];
+            }
+        }
+    }
+
+    std::string line(int row) const
+    {
+        return m_text[row];
+    }
+
+    char colorAt(int row, int column) const
+    {
+        return m_colors[row][column];
+    }
+
+    int cursorRow() const
+    {
+        return m_row;
+    }
+
+  private:
+    int m_rows;
+    int m_columns;
+    std::vector<std::string> m_text;
+    std::vector<std::string> m_colors; /**< '0' for the default color, else the SGR code minus 30 */
+    int m_row = 0;
+    int m_column = 0;
+    char m_color = '0';
+};
+
+std::vector<Process> makeTable(int count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<Process> processes;
+    for (int i = 0; i < count; ++i)
+    {
+        processes.push_back(Process{1000 + i, i % 2 ? "root" : "postgres", (rng() % 4000) / 100.0,
+                                    (rng() % 100000) / 100.0, 0, "command" + std::to_string(i)});
+    }
+    return processes;
+}
+
+// Text of a table row as printed by printProcesses() once std::left is in effect
+std::string expectedRow(const Process& process)
+{
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "%-8d | %-14s | %-8.2f%% | %-13.2f MB | %s", process.pid, process.user.c_str(),
+             process.cpuUsage, process.memoryUsage, process.command.c_str());
+    return buffer;
+}
+
+} // namespace
+
+// The emulated screen always matches the last composed frame
+TEST(ScreenRendererTest, EmulatedScreenMatchesFrames)
+{
+    ScreenRenderer screen(32, 100);
+    FakeTerminal terminal(40, 100);
+    FrameBuffer output;
+
+    for (unsigned frame = 0; frame < 20; ++frame)
+    {
+        // Tables of varying length, so rows appear and disappear
+        std::vector<Process> processes = makeTable(frame % 3 == 2 ? 12 : 30, frame / 4);
+        if (frame % 4 != 0)
+        {
+            processes[frame % processes.size()].cpuUsage += 25.0; // A few cells change between frames
+        }
+        if (frame == 10)
+        {
+            screen.invalidate();
+            terminal.feed("\033[5;1Hgarbage written by someone else");
+        }
+
+        output.clear();
+        screen.beginFrame();
+        composeProcessTable(processes, screen);
+        screen.render(output);
+        terminal.feed(std::string(output.data(), output.size()));
+
+        EXPECT_EQ(terminal.line(0).substr(0, 7), "PID    ");
+        for (size_t i = 0; i < 32 - 2; ++i)
+        {
+            std::string line = terminal.line(static_cast<int>(i) + 2);
+            line.erase(line.find_last_not_of(' ') + 1);
+            EXPECT_EQ(line, i < processes.size() ? expectedRow(processes[i]) : "") << "frame " << frame;
+        }
+        EXPECT_EQ(terminal.cursorRow(), static_cast<int>(processes.size()) + 2);
+    }
+}
+
+// CPU cells are colored by usage, and the rest of the row uses the default color
+TEST(ScreenRendererTest, Colors)
+{
+    ScreenRenderer screen(32, 100);
+    FakeTerminal terminal(40, 100);
+    std::vector<Process> processes = makeTable(3, 1);
+    processes[0].cpuUsage = 50.0;
+    processes[1].cpuUsage = 15.0;
+    processes[2].cpuUsage = 1.0;
+
+    FrameBuffer output;
+    screen.beginFrame();
+    composeProcessTable(processes, screen);
+    screen.render(output);
+    terminal.feed(std::string(output.data(), output.size()));
+
+    const int cpuColumn = 28;
+    EXPECT_EQ(terminal.colorAt(2, cpuColumn), '1'); // Red
+    EXPECT_EQ(terminal.colorAt(3, cpuColumn), '3'); // Yellow
+    EXPECT_EQ(terminal.colorAt(4, cpuColumn), '2'); // Green
+    EXPECT_EQ(terminal.colorAt(2, 0), '0');
+    EXPECT_EQ(terminal.colorAt(2, cpuColumn + 12), '0');
+}
+
+// Unchanged frames cost nothing, and a single changed value costs far less than a repaint
+TEST(ScreenRendererTest, UpdatesAreMinimal)
+{
+    ScreenRenderer screen(32, 100);
+    std::vector<Process> processes = makeTable(30, 7);
+    FrameBuffer output;
+
+    screen.beginFrame();
+    composeProcessTable(processes, screen);
+    size_t fullRepaint = screen.render(output);
+    EXPECT_GT(fullRepaint, 2000u);
+
+    output.clear();
+    screen.beginFrame();
+    composeProcessTable(processes, screen);
+    EXPECT_EQ(screen.render(output), 0u);
+
+    processes[5].memoryUsage += 1.0;
+    output.clear();
+    screen.beginFrame();
+    composeProcessTable(processes, screen);
+    EXPECT_LT(screen.render(output), 40u);
+}
+
+// The table fills the area: separator and command column follow its width, rows its height
+TEST(ScreenRendererTest, TableFitsArea)
+{
+    ScreenRenderer screen(12, 72);
+    FakeTerminal terminal(20, 80);
+    std::vector<Process> processes = makeTable(30, 3);
+    processes[0].command = std::string(40, 'x');
+    EXPECT_EQ(tableRowsFor(screen), 10u);
+
+    FrameBuffer output;
+    screen.beginFrame();
+    composeProcessTable(processes, screen);
+    screen.render(output);
+    terminal.feed(std::string(output.data(), output.size()));
+
+    EXPECT_EQ(terminal.line(1), std::string(72, '=') + std::string(8, ' '));
+    std::string first = terminal.line(2);
+    EXPECT_EQ(first.substr(59, 13), std::string(10, 'x') + "..."); // 13 columns left of 72
+    EXPECT_EQ(first.substr(72), std::string(8, ' '));
+    EXPECT_EQ(terminal.line(11).substr(0, 4), "1009");
+    EXPECT_EQ(terminal.line(12), std::string(80, ' ')); // Rows beyond the area are not drawn
+}
@@ -0,0 +1,278 @@
+/**
+ * @file test_session_record.cpp
+ *
+ * This test suite verifies the session recording format. Sessions are written with the
+ * SessionRecorder and read back with the SessionReader, checking that key and delta frames decode
+ * to the recorded snapshots, that frames can be located by timestamp, and that appending to an
+ * existing file, truncated files and failed writes are handled.
+ */
+
+#include "session_record.h"
+#include <csignal>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// Builds the snapshot of epoch `epoch`: processes come and go, and their usage changes slowly
+std::vector<Process> makeEpoch(int epoch)
+{
+    std::vector<Process> snapshot;
+    for (int pid = 1 + epoch; pid < 60 + epoch; pid += 3)
+    {
+        Process process;
+        process.pid = pid;
+        process.user = pid % 2 ? "root" : "postgres";
+        process.cpuUsage = (pid * 7 + epoch) % 100 / 4.0;
+        process.memoryUsage = (pid * 1000 + (pid % 5 == 0 ? epoch * 64 : 0)) / 1024.0;
+        process.prevTotalTime = 0;
+        process.command = "cmd" + std::to_string(pid % 11);
+        snapshot.push_back(process);
+    }
+    return snapshot;
+}
+
+// Checks that a decoded frame matches a recorded snapshot (both sorted by PID)
+void expectSameProcesses(const std::vector<Process>& expected, const std::vector<Process>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].pid, actual[i].pid);
+        EXPECT_EQ(expected[i].user, actual[i].user);
+        EXPECT_EQ(expected[i].command, actual[i].command);
+        EXPECT_NEAR(expected[i].cpuUsage, actual[i].cpuUsage, 0.005);
+        EXPECT_DOUBLE_EQ(expected[i].memoryUsage, actual[i].memoryUsage);
+    }
+}
+
+std::string tempSessionPath()
+{
+    return "/tmp/pm_session_test_" + std::to_string(getpid()) + ".pmrec";
+}
+
+} // namespace
+
+// Every frame, key or delta, decodes to the snapshot that was recorded
+TEST(SessionRecordTest, RoundTrip)
+{
+    std::string path = tempSessionPath();
+    std::remove(path.c_str());
+
+    const int epochs = SessionRecorder::kKeyFrameInterval * 2 + 10;
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        for (int epoch = 0; epoch < epochs; ++epoch)
+        {
+            ASSERT_TRUE(recorder.append(1000000 + epoch * 1000, makeEpoch(epoch)));
+        }
+        EXPECT_EQ(recorder.framesWritten(), static_cast<uint64_t>(epochs));
+    }
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frameCount(), static_cast<size_t>(epochs));
+
+    SessionFrame frame;
+    for (int epoch = 0; epoch < epochs; ++epoch)
+    {
+        ASSERT_TRUE(reader.readFrame(epoch, frame));
+        EXPECT_EQ(frame.timestampMs, 1000000 + epoch * 1000);
+        expectSameProcesses(makeEpoch(epoch), frame.processes);
+    }
+
+    // Random access backwards and across key frames
+    for (int epoch : {137, 3, 64, 65, 0, 127})
+    {
+        ASSERT_TRUE(reader.readFrame(epoch, frame));
+        expectSameProcesses(makeEpoch(epoch), frame.processes);
+    }
+    std::remove(path.c_str());
+}
+
+// Frames can be located by timestamp
+TEST(SessionRecordTest, FindFrameByTimestamp)
+{
+    std::string path = tempSessionPath();
+    std::remove(path.c_str());
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        for (int epoch = 0; epoch < 10; ++epoch)
+        {
+            recorder.append(5000 + epoch * 2000, makeEpoch(epoch));
+        }
+    }
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.findFrame(0), 0u);
+    EXPECT_EQ(reader.findFrame(5000), 0u);
+    EXPECT_EQ(reader.findFrame(6999), 0u);
+    EXPECT_EQ(reader.findFrame(7000), 1u);
+    EXPECT_EQ(reader.findFrame(100000), 9u);
+    std::remove(path.c_str());
+}
+
+// Reopening a file appends a new key frame, and a truncated last frame is ignored
+TEST(SessionRecordTest, AppendAndTruncation)
+{
+    std::string path = tempSessionPath();
+    std::remove(path.c_str());
+    for (int run = 0; run < 2; ++run)
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        for (int epoch = run * 5; epoch < run * 5 + 5; ++epoch)
+        {
+            recorder.append(epoch * 1000, makeEpoch(epoch));
+        }
+    }
+
+    // Chop a few bytes off the end to simulate a crash while writing the last frame
+    FILE* file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    ASSERT_EQ(truncate(path.c_str(), size - 3), 0);
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frameCount(), 9u);
+    SessionFrame frame;
+    for (int epoch = 0; epoch < 9; ++epoch)
+    {
+        ASSERT_TRUE(reader.readFrame(epoch, frame));
+        expectSameProcesses(makeEpoch(epoch), frame.processes);
+    }
+    std::remove(path.c_str());
+}
+
+// Reopening a file that ends with a partial frame cuts it off before appending
+TEST(SessionRecordTest, ReopenAfterCrashMidFrame)
+{
+    std::string path = tempSessionPath();
+    std::remove(path.c_str());
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        for (int epoch = 0; epoch < 3; ++epoch)
+        {
+            recorder.append(epoch * 1000, makeEpoch(epoch));
+        }
+    }
+    FILE* file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    ASSERT_EQ(truncate(path.c_str(), size - 3), 0);
+
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        for (int epoch = 3; epoch < 6; ++epoch)
+        {
+            recorder.append(epoch * 1000, makeEpoch(epoch));
+        }
+    }
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frameCount(), 5u);
+    SessionFrame frame;
+    for (int i = 0; i < 5; ++i)
+    {
+        int epoch = i < 2 ? i : i + 1; // Epoch 2 was the partial frame
+        ASSERT_TRUE(reader.readFrame(i, frame));
+        EXPECT_EQ(frame.timestampMs, epoch * 1000);
+        expectSameProcesses(makeEpoch(epoch), frame.processes);
+    }
+    std::remove(path.c_str());
+}
+
+// A frame that cannot be written completely leaves no bytes behind, and the next one is a key frame
+TEST(SessionRecordTest, FailedWriteLeavesNoPartialFrame)
+{
+    std::string path = tempSessionPath();
+    std::remove(path.c_str());
+
+    // Large epochs fill the stdio buffer, so writes reach the file size limit
+    std::vector<Process> large;
+    for (int pid = 1; pid <= 20000; ++pid)
+    {
+        Process process = makeEpoch(0)[0];
+        process.pid = pid;
+        process.cpuUsage = pid % 97;
+        large.push_back(process);
+    }
+
+    struct rlimit previous;
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &previous), 0);
+    void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    int written = 0;
+    {
+        SessionRecorder recorder;
+        ASSERT_TRUE(recorder.open(path));
+        struct rlimit limit = previous;
+        limit.rlim_cur = 3 << 20;
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+        bool failed = false;
+        for (int epoch = 0; epoch < 100 && !failed; ++epoch)
+        {
+            for (Process& process : large)
+            {
+                process.cpuUsage += 1;
+            }
+            failed = !recorder.append(epoch * 1000, large);
+            written += failed ? 0 : 1;
+        }
+        setrlimit(RLIMIT_FSIZE, &previous);
+        EXPECT_TRUE(failed);
+
+        // Recording goes on with a key frame once the disk takes writes again
+        EXPECT_TRUE(recorder.append(1000000, makeEpoch(1)));
+        EXPECT_TRUE(recorder.append(1001000, makeEpoch(2)));
+    }
+    signal(SIGXFSZ, handler);
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_GE(reader.frameCount(), 2u);
+    ASSERT_LE(reader.frameCount(), static_cast<size_t>(written) + 2);
+    SessionFrame frame;
+    for (size_t i = 0; i < reader.frameCount(); ++i)
+    {
+        ASSERT_TRUE(reader.readFrame(i, frame)) << i;
+    }
+    size_t last = reader.frameCount() - 1;
+    ASSERT_TRUE(reader.readFrame(last - 1, frame));
+    EXPECT_EQ(frame.timestampMs, 1000000);
+    expectSameProcesses(makeEpoch(1), frame.processes);
+    ASSERT_TRUE(reader.readFrame(last, frame));
+    expectSameProcesses(makeEpoch(2), frame.processes);
+    std::remove(path.c_str());
+}
+
+// Files that are not sessions are rejected
+TEST(SessionRecordTest, RejectsForeignFiles)
+{
+    std::string path = tempSessionPath();
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fputs("not a session file", file);
+    fclose(file);
+
+    SessionRecorder recorder;
+    EXPECT_FALSE(recorder.open(path));
+    SessionReader reader;
+    EXPECT_FALSE(reader.open(path));
+    std::remove(path.c_str());
+}
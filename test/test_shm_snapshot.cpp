@@ -0,0 +1,203 @@
+/**
+ * @file test_shm_snapshot.cpp
+ *
+ * This test suite verifies the shared-memory snapshot export: the round trip of an epoch from the
+ * writer to the reader library, truncation at the capacity of the region, the errors of the
+ * reader, and that a reader racing a writer never accepts a torn epoch.
+ */
+
+#include "cli_options.h"
+#include "shm_snapshot.h"
+#include <atomic>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// Shared-memory object name private to this test process
+std::string testObjectName()
+{
+    return "/pm_test_shm_" + std::to_string(getpid());
+}
+
+} // namespace
+
+// The export is requested on the command line, and has nothing to publish to in one-shot mode
+TEST(ShmSnapshotOptionsTest, CommandLine)
+{
+    const char* args[] = {"pm", "--daemon", "--shm-export", "pm_snapshot"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(4, args, options, error)) << error;
+    EXPECT_EQ(options.shmExport, "pm_snapshot");
+
+    const char* conflicting[] = {"pm", "--once", "--shm-export", "pm_snapshot"};
+    CliOptions other;
+    EXPECT_FALSE(parseCommandLine(4, conflicting, other, error));
+}
+
+// An epoch is read back, in place or as a copy, with its values and strings
+TEST(ShmSnapshotTest, RoundTrip)
+{
+    ShmSnapshotWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.open(testObjectName(), 16, error)) << error;
+
+    ShmSnapshotReader reader;
+    ASSERT_TRUE(reader.open(testObjectName(), error)) << error;
+    EXPECT_EQ(reader.epoch(), 0u);
+    ShmSnapshotCopy copy;
+    EXPECT_FALSE(reader.read(copy)); // Nothing published yet
+
+    writer.publish({{1, "root", 5.5, 100.25, 0, "init"}, {42, "alice", 50.0, 10.0, 0, "busy"},
+                    {43, "alice", 0.0, 1.5, 0, ""}},
+                   1700000000123);
+    EXPECT_EQ(reader.epoch(), 1u);
+    ASSERT_TRUE(reader.read(copy));
+    const ShmSnapshotView& view = copy.view;
+    EXPECT_EQ(view.epoch, 1u);
+    EXPECT_EQ(view.timestampMs, 1700000000123);
+    ASSERT_EQ(view.count, 3u);
+    EXPECT_FALSE(view.truncated);
+    EXPECT_EQ(view.pid[1], 42);
+    EXPECT_FLOAT_EQ(view.cpu[0], 5.5f);
+    EXPECT_FLOAT_EQ(view.memory[0], 100.25f);
+    EXPECT_STREQ(view.user(1), "alice");
+    EXPECT_STREQ(view.user(2), "alice");
+    EXPECT_STREQ(view.command(1), "busy");
+    EXPECT_STREQ(view.command(2), "");
+
+    // The next epoch goes to the other buffer; the copy is unaffected
+    writer.publish({{7, "bob", 1.0, 2.0, 0, "idle"}}, 1700000001123);
+    EXPECT_EQ(view.count, 3u);
+    size_t visited = 0;
+    EXPECT_TRUE(reader.visit([&](const ShmSnapshotView& shared) {
+        EXPECT_EQ(shared.epoch, 2u);
+        EXPECT_EQ(shared.pid[0], 7);
+        EXPECT_STREQ(shared.command(0), "idle");
+        visited = shared.count;
+    }));
+    EXPECT_EQ(visited, 1u);
+
+    // Closing the writer removes the object
+    writer.close();
+    ShmSnapshotReader late;
+    EXPECT_FALSE(late.open(testObjectName(), error));
+}
+
+// Processes beyond the capacity and strings beyond the pool are left out, and the epoch is flagged
+TEST(ShmSnapshotTest, Truncation)
+{
+    ShmSnapshotWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.open(testObjectName(), 4, error)) << error;
+    ShmSnapshotReader reader;
+    ASSERT_TRUE(reader.open(testObjectName(), error)) << error;
+
+    std::vector<Process> processes;
+    for (int pid = 1; pid <= 6; ++pid)
+    {
+        processes.push_back({pid, "user", 1.0, 1.0, 0, "command"});
+    }
+    writer.publish(processes, 0);
+    ShmSnapshotCopy copy;
+    ASSERT_TRUE(reader.read(copy));
+    EXPECT_EQ(copy.view.count, 4u);
+    EXPECT_TRUE(copy.view.truncated);
+    EXPECT_EQ(copy.view.pid[3], 4);
+
+    // The pool holds 4 * 48 bytes: a long command is cut and the following ones are left empty
+    std::string longCommand(300, 'x');
+    writer.publish({{1, "root", 0.0, 0.0, 0, longCommand}, {2, "root", 0.0, 0.0, 0, "sh"}}, 0);
+    ASSERT_TRUE(reader.read(copy));
+    EXPECT_EQ(copy.view.count, 2u);
+    EXPECT_TRUE(copy.view.truncated);
+    std::string cut = copy.view.command(0);
+    EXPECT_LT(cut.size(), longCommand.size());
+    EXPECT_EQ(cut, longCommand.substr(0, cut.size()));
+    EXPECT_STREQ(copy.view.command(1), "");
+
+    writer.publish(processes, 0);
+    EXPECT_FALSE(writer.open(testObjectName(), 0, error));
+}
+
+// Objects that do not exist or are not snapshot regions are refused
+TEST(ShmSnapshotTest, OpenErrors)
+{
+    ShmSnapshotReader reader;
+    std::string error;
+    EXPECT_FALSE(reader.open("pm_test_shm_missing", error));
+    EXPECT_NE(error.find("Cannot open shared memory /pm_test_shm_missing"), std::string::npos);
+
+    std::string name = testObjectName() + "_other";
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 4096), 0);
+    close(fd);
+    EXPECT_FALSE(reader.open(name, error));
+    EXPECT_EQ(error, name + " is not a snapshot region of version 1");
+    EXPECT_FALSE(reader.isOpen());
+    shm_unlink(name.c_str());
+}
+
+// A reader racing a writer only accepts epochs whose columns all belong to the same epoch
+TEST(ShmSnapshotTest, ConcurrentReaderSeesConsistentEpochs)
+{
+    ShmSnapshotWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.open(testObjectName(), 4096, error)) << error;
+    ShmSnapshotReader reader;
+    ASSERT_TRUE(reader.open(testObjectName(), error)) << error;
+
+    // Every value of epoch N is N, and so is the number of processes (modulo the capacity)
+    std::atomic<bool> done(false);
+    std::thread publisher([&]() {
+        std::vector<Process> processes;
+        for (int epoch = 1; epoch <= 2000; ++epoch)
+        {
+            processes.assign(1 + epoch % 4000, {epoch, "user", double(epoch), double(epoch), 0, "cmd"});
+            writer.publish(processes, epoch);
+        }
+        done.store(true);
+    });
+
+    // Checks that every column of a view belongs to the epoch of the view
+    auto isConsistent = [](const ShmSnapshotView& view) {
+        bool consistent = view.count == 1 + view.epoch % 4000 && view.timestampMs == int64_t(view.epoch);
+        for (size_t i = 0; consistent && i < view.count; ++i)
+        {
+            consistent = view.pid[i] == int32_t(view.epoch) && view.cpu[i] == float(view.epoch) &&
+                         std::string(view.user(i)) == "user";
+        }
+        return consistent;
+    };
+
+    int accepted = 0;
+    int inconsistent = 0;
+    ShmSnapshotCopy copy;
+    while (!done.load())
+    {
+        if (reader.read(copy))
+        {
+            ++accepted;
+            inconsistent += isConsistent(copy.view) ? 0 : 1;
+        }
+        // In place, a result only counts when visit() confirms that the epoch was not rewritten
+        bool consistent = false;
+        if (reader.visit([&](const ShmSnapshotView& view) { consistent = isConsistent(view); }))
+        {
+            ++accepted;
+            inconsistent += consistent ? 0 : 1;
+        }
+    }
+    publisher.join();
+    EXPECT_GT(accepted, 0);
+    EXPECT_EQ(inconsistent, 0);
+    EXPECT_EQ(reader.epoch(), 2000u);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file test_stream_output.cpp
+ *
+ * This test suite verifies the headless stream mode: command-line parsing of its options, the
+ * JSON Lines and CSV records (including escaping of awkward user and command strings), top-N row
+ * selection, and the report of a reader that closed the pipe.
+ */
+
+#include "cli_options.h"
+#include "stream_output.h"
+#include <csignal>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// Writes one epoch through a pipe and returns what the reader receives
+std::string writeThroughPipe(StreamFormat format, const std::vector<Process>& processes, int epochs = 1)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    StreamWriter writer(fds[1], format);
+    std::vector<const Process*> rows;
+    selectStreamRows(processes, 0, "cpu", rows);
+    for (int epoch = 0; epoch < epochs; ++epoch)
+    {
+        EXPECT_TRUE(writer.writeEpoch(1700000000000LL + epoch * 500, rows));
+    }
+    close(fds[1]);
+
+    std::string received;
+    char chunk[4096];
+    for (ssize_t n; (n = read(fds[0], chunk, sizeof(chunk))) > 0;)
+    {
+        received.append(chunk, n);
+    }
+    close(fds[0]);
+    return received;
+}
+
+} // namespace
+
+// Stream options are parsed and validated up front
+TEST(StreamOutputTest, CommandLine)
+{
+    const char* args[] = {"pm", "--stream", "jsonl", "--interval", "500ms", "--top", "50", "--sort", "memory"};
+    CliOptions options;
+    std::string error;
+    ASSERT_TRUE(parseCommandLine(9, args, options, error)) << error;
+    EXPECT_EQ(options.streamFormat, StreamFormat::JsonLines);
+    EXPECT_EQ(options.intervalMs, 500);
+    EXPECT_EQ(options.top, 50u);
+    EXPECT_EQ(options.sortBy, "memory");
+
+    int milliseconds = 0;
+    EXPECT_TRUE(parseDuration("2s", milliseconds));
+    EXPECT_EQ(milliseconds, 2000);
+    EXPECT_TRUE(parseDuration("1.5", milliseconds));
+    EXPECT_EQ(milliseconds, 1500);
+    EXPECT_FALSE(parseDuration("0ms", milliseconds));
+    EXPECT_FALSE(parseDuration("5 parsecs", milliseconds));
+    EXPECT_FALSE(parseDuration("fast", milliseconds));
+
+    const char* badFormat[] = {"pm", "--stream", "xml"};
+    EXPECT_FALSE(parseCommandLine(3, badFormat, options, error));
+    const char* missingValue[] = {"pm", "--top"};
+    EXPECT_FALSE(parseCommandLine(2, missingValue, options, error));
+    EXPECT_EQ(error, "Missing value for --top");
+    const char* unknown[] = {"pm", "--colour"};
+    EXPECT_FALSE(parseCommandLine(2, unknown, options, error));
+}
+
+// One JSON object per process per epoch, with escaped strings
+TEST(StreamOutputTest, JsonLines)
+{
+    std::vector<Process> processes = {{42, "root", 12.345, 1024.5, 0, "nginx: worker \"main\"\\n"},
+                                      {7, "svc\tacct", 0.0, 3.0, 0, std::string("a\nb\x01", 4)}};
+    std::string output = writeThroughPipe(StreamFormat::JsonLines, processes, 2);
+    EXPECT_EQ(output,
+              "{\"ts\":1700000000000,\"pid\":42,\"user\":\"root\",\"cpu\":12.35,\"mem_mb\":1024.50,"
+              "\"command\":\"nginx: worker \\\"main\\\"\\\\n\"}\n"
+              "{\"ts\":1700000000000,\"pid\":7,\"user\":\"svc\\tacct\",\"cpu\":0.00,\"mem_mb\":3.00,"
+              "\"command\":\"a\\nb\\u0001\"}\n"
+              "{\"ts\":1700000000500,\"pid\":42,\"user\":\"root\",\"cpu\":12.35,\"mem_mb\":1024.50,"
+              "\"command\":\"nginx: worker \\\"main\\\"\\\\n\"}\n"
+              "{\"ts\":1700000000500,\"pid\":7,\"user\":\"svc\\tacct\",\"cpu\":0.00,\"mem_mb\":3.00,"
+              "\"command\":\"a\\nb\\u0001\"}\n");
+}
+
+// CSV output has a single header line and quotes fields when needed
+TEST(StreamOutputTest, Csv)
+{
+    std::vector<Process> processes = {{42, "root", 50.0, 1.0, 0, "sh -c \"a,b\""}, {7, "www", 1.5, 2.25, 0, "nginx"}};
+    std::string output = writeThroughPipe(StreamFormat::Csv, processes, 2);
+    EXPECT_EQ(output, "ts,pid,user,cpu,mem_mb,command\n"
+                      "1700000000000,42,root,50.00,1.00,\"sh -c \"\"a,b\"\"\"\n"
+                      "1700000000000,7,www,1.50,2.25,nginx\n"
+                      "1700000000500,42,root,50.00,1.00,\"sh -c \"\"a,b\"\"\"\n"
+                      "1700000000500,7,www,1.50,2.25,nginx\n");
+}
+
+// Top-N keeps the highest-ranking processes, highest first
+TEST(StreamOutputTest, TopSelection)
+{
+    std::vector<Process> processes;
+    for (int pid = 1; pid <= 100; ++pid)
+    {
+        processes.push_back({pid, "root", static_cast<double>((pid * 37) % 100), static_cast<double>(pid), 0, "cmd"});
+    }
+    std::vector<const Process*> rows;
+    selectStreamRows(processes, 3, "cpu", rows);
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0]->cpuUsage, 99.0);
+    EXPECT_EQ(rows[1]->cpuUsage, 98.0);
+    EXPECT_EQ(rows[2]->cpuUsage, 97.0);
+
+    selectStreamRows(processes, 2, "memory", rows);
+    ASSERT_EQ(rows.size(), 2u);
+    EXPECT_EQ(rows[0]->pid, 100);
+    EXPECT_EQ(rows[1]->pid, 99);
+
+    selectStreamRows(processes, 0, "cpu", rows);
+    ASSERT_EQ(rows.size(), 100u);
+    EXPECT_EQ(rows[0]->pid, 1); // All processes, in their original order
+}
+
+// A reader closing the pipe is reported as a failed write
+TEST(StreamOutputTest, ClosedPipe)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[0]);
+    auto previous = std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Process> processes = {{1, "root", 1.0, 1.0, 0, "init"}};
+    std::vector<const Process*> rows;
+    selectStreamRows(processes, 0, "cpu", rows);
+    StreamWriter writer(fds[1], StreamFormat::Csv);
+    EXPECT_FALSE(writer.writeEpoch(0, rows));
+
+    std::signal(SIGPIPE, previous);
+    close(fds[1]);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_synthetic_proc.cpp
+ *
+ * This test suite verifies the synthetic procfs generator and the configurable proc root.
+ * A small fake tree is written to a temporary directory, the readers of the Process Info and
+ * Resource Monitor modules are pointed at it, and the values they report are compared with the
+ * values scripted by the generator.
+ */
+
+#include "globals.h"
+#include "process_info.h"
+#include "resource_monitor.h"
+#include "synthetic_proc.h"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+
+/**
+ * @brief Fixture that writes a fake procfs tree and points `procRoot` at it for the test duration.
+ */
+class SyntheticProcTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/pm_fakeproc_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+
+        SyntheticProcOptions options;
+        options.pidCount = 200;
+        options.firstPid = 100;
+        options.cpuCount = 4;
+        tree = new SyntheticProcTree(dirTemplate, options);
+        ASSERT_TRUE(tree->writeTick(0));
+
+        savedRoot = procRoot;
+        procRoot = tree->root();
+    }
+
+    void TearDown() override
+    {
+        procRoot = savedRoot;
+        tree->remove();
+        delete tree;
+    }
+
+    SyntheticProcTree* tree = nullptr;
+    std::string savedRoot;
+};
+
+// The scan sees exactly the generated PIDs with the scripted command and memory usage
+TEST_F(SyntheticProcTest, ScanMatchesGeneratedTree)
+{
+    std::vector<Process> processes = getActiveProcesses();
+    ASSERT_EQ(processes.size(), 200u);
+
+    for (const auto& process : processes)
+    {
+        EXPECT_GE(process.pid, 100);
+        EXPECT_LT(process.pid, 300);
+        EXPECT_EQ(process.command, tree->commandOf(process.pid));
+        EXPECT_DOUBLE_EQ(process.memoryUsage, tree->rssKbAt(process.pid, 0) / 1024.0);
+    }
+}
+
+// CPU times advance according to the script, and the usage calculation reports the scripted rate
+TEST_F(SyntheticProcTest, TicksFollowScript)
+{
+    long totalBefore = getTotalCpuTime();
+    EXPECT_EQ(totalBefore, tree->totalTimeAt(0));
+
+    int steadyPid = -1;
+    for (int pid = 100; pid < 300 && steadyPid < 0; ++pid)
+    {
+        if (tree->profileOf(pid) == SyntheticProfile::STEADY)
+        {
+            steadyPid = pid;
+        }
+    }
+    ASSERT_GT(steadyPid, 0) << "The generated tree should contain a steady process";
+
+    long before = getProcessTotalTime(steadyPid);
+    ASSERT_TRUE(tree->advance());
+    long after = getProcessTotalTime(steadyPid);
+    long totalAfter = getTotalCpuTime();
+
+    EXPECT_EQ(before, tree->processTimeAt(steadyPid, 0));
+    EXPECT_EQ(after, tree->processTimeAt(steadyPid, 1));
+
+    double usage = calculateCpuUsage(after - before, totalAfter - totalBefore, tree->cpuCount());
+    EXPECT_NEAR(usage, (after - before), 1e-9) << "One jiffy per tick should read as one percent of CPU";
+}
+
+// Writing the same tick twice produces the same values (the generator is deterministic)
+TEST_F(SyntheticProcTest, Deterministic)
+{
+    SyntheticProcOptions options;
+    options.pidCount = 200;
+    options.firstPid = 100;
+    options.cpuCount = 4;
+    SyntheticProcTree other("/nonexistent", options);
+
+    for (int pid = 100; pid < 300; ++pid)
+    {
+        EXPECT_EQ(tree->processTimeAt(pid, 7), other.processTimeAt(pid, 7));
+        EXPECT_EQ(tree->rssKbAt(pid, 7), other.rssKbAt(pid, 7));
+        EXPECT_LT(tree->parentOf(pid), pid);
+    }
+}
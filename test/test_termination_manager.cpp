@@ -0,0 +1,166 @@
+/**
+ * @file test_termination_manager.cpp
+ *
+ * This test suite verifies the graceful termination of real child processes: children that exit on
+ * SIGTERM are reported as such as soon as they exit, children that ignore it are killed once their
+ * grace period is over, a request returns before any of this happens, and a request still completes
+ * when the manager thread cannot be started.
+ */
+
+#include "process_info.h"
+#include "termination_manager.h"
+#include <chrono>
+#include <csignal>
+#include <future>
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+// Forks a child that waits for a signal, ignoring SIGTERM if asked, and returns once it is ready
+KillTarget spawnChild(bool ignoreTerm)
+{
+    int ready[2];
+    EXPECT_EQ(pipe(ready), 0);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        if (ignoreTerm)
+            signal(SIGTERM, SIG_IGN);
+        (void)!write(ready[1], "x", 1);
+        for (;;)
+            pause();
+    }
+    char byte;
+    EXPECT_EQ(read(ready[0], &byte, 1), 1);
+    close(ready[0]);
+    close(ready[1]);
+    KillTarget target{pid};
+    EXPECT_TRUE(readProcessStartTime(pid, target.startTime));
+    return target;
+}
+
+// Queues a termination and waits for its report
+KillReport terminateAndWait(std::vector<KillTarget> targets, int graceMs, double& returnedAfterMs)
+{
+    std::promise<KillReport> done;
+    auto start = std::chrono::steady_clock::now();
+    TerminationManager::getInstance().terminate(std::move(targets), graceMs,
+                                                [&done](const KillReport& report) { done.set_value(report); });
+    returnedAfterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return done.get_future().get();
+}
+
+int reapSignal(pid_t pid)
+{
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+}
+
+} // namespace
+
+// SIGTERM ends one child within the grace period; the other ignores it and is killed afterwards
+TEST(TerminationManagerTest, EscalatesAfterGracePeriod)
+{
+    KillTarget polite = spawnChild(false);
+    KillTarget stubborn = spawnChild(true);
+    KillTarget stale = spawnChild(false);
+    KillTarget recycled = stale;
+    recycled.startTime += 1; // Stands for a process that reused the PID
+
+    auto start = std::chrono::steady_clock::now();
+    double returnedAfterMs;
+    KillReport report = terminateAndWait({polite, stubborn, recycled}, 300, returnedAfterMs);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_LT(returnedAfterMs, 100.0) << "terminate() waited for the processes";
+    EXPECT_GE(elapsedMs, 290.0);
+    ASSERT_EQ(report.results.size(), 3u);
+    EXPECT_EQ(report.results[0].outcome, KillOutcome::Terminated);
+    EXPECT_EQ(report.results[1].outcome, KillOutcome::Killed);
+    EXPECT_EQ(report.results[2].outcome, KillOutcome::Recycled);
+    EXPECT_EQ(TerminationManager::getInstance().pending(), 0u);
+    EXPECT_EQ(reapSignal(polite.pid), SIGTERM);
+    EXPECT_EQ(reapSignal(stubborn.pid), SIGKILL);
+
+    EXPECT_EQ(kill(stale.pid, 0), 0) << "A process with another start time was signalled";
+    kill(stale.pid, SIGKILL);
+    EXPECT_EQ(reapSignal(stale.pid), SIGKILL);
+}
+
+// Hundreds of children exiting on SIGTERM are all reported long before a long grace period ends
+TEST(TerminationManagerTest, ManyConcurrentTerminations)
+{
+    std::vector<KillTarget> targets;
+    for (int i = 0; i < 500; ++i)
+    {
+        targets.push_back(spawnChild(false));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    double returnedAfterMs;
+    KillReport report = terminateAndWait(targets, 60000, returnedAfterMs);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_LT(elapsedMs, 30000.0);
+    EXPECT_EQ(report.count(KillOutcome::Terminated), targets.size());
+    for (const KillTarget& target : targets)
+    {
+        EXPECT_EQ(reapSignal(target.pid), SIGTERM);
+    }
+}
+
+// A request whose targets cannot be signalled completes at once
+TEST(TerminationManagerTest, NothingToWaitFor)
+{
+    double returnedAfterMs;
+    KillReport report = terminateAndWait({KillTarget{getpid()}, KillTarget{0}}, 60000, returnedAfterMs);
+    ASSERT_EQ(report.results.size(), 2u);
+    EXPECT_EQ(report.count(KillOutcome::Refused), 2u);
+    EXPECT_EQ(terminateAndWait({}, 60000, returnedAfterMs).results.size(), 0u);
+}
+
+// Without descriptors for the epoll set, the request completes at once instead of waiting for a
+// thread that never started; the descriptor limit of the process is left alone
+TEST(TerminationManagerTest, CompletesWithoutEpoll)
+{
+    TerminationManager::getInstance().stop();
+    KillTarget stubborn = spawnChild(true);
+
+    struct rlimit previous;
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &previous), 0);
+    int lowest = dup(0);
+    ASSERT_GE(lowest, 0);
+    close(lowest);
+    struct rlimit limit = previous;
+    limit.rlim_cur = static_cast<rlim_t>(lowest); // No new descriptor can be opened
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+
+    bool called = false;
+    KillReport report;
+    TerminationManager::getInstance().terminate({stubborn}, 60000, [&](const KillReport& result) {
+        called = true;
+        report = result;
+    });
+    struct rlimit after;
+    getrlimit(RLIMIT_NOFILE, &after);
+    setrlimit(RLIMIT_NOFILE, &previous);
+
+    EXPECT_EQ(after.rlim_cur, limit.rlim_cur);
+    ASSERT_TRUE(called) << "The request was queued without a thread to run it";
+    ASSERT_EQ(report.results.size(), 1u);
+    EXPECT_NE(report.results[0].outcome, KillOutcome::Terminated); // SIGKILL, or no descriptor to send it
+    kill(stubborn.pid, SIGKILL);
+    EXPECT_EQ(reapSignal(stubborn.pid), SIGKILL);
+
+    // With descriptors back, requests go through the thread again
+    double returnedAfterMs;
+    KillTarget polite = spawnChild(false);
+    EXPECT_EQ(terminateAndWait({polite}, 60000, returnedAfterMs).count(KillOutcome::Terminated), 1u);
+    EXPECT_EQ(reapSignal(polite.pid), SIGTERM);
+}
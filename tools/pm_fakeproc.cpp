@@ -0,0 +1,112 @@
+/**
+ * @file pm_fakeproc.cpp
+ *
+ * Command-line front end for the synthetic procfs generator. It writes a fake `/proc` tree with
+ * the requested number of PIDs and can keep advancing it tick by tick, so that the Process Manager
+ * (started with `--proc-root <dir>`) observes scripted CPU and memory evolution.
+ *
+ * Usage:
+ *   pm_fakeproc <dir> [--pids N] [--seed S] [--cpus C] [--tick T] [--ticks K] [--interval-ms M] [--cgroups G]
+ *
+ * With `--cgroups`, the processes are spread over G containers whose cgroup v2 counters are written
+ * to `<dir>-cgroup` (for the Process Manager's `--cgroup-root`).
+ */
+
+#include "synthetic_proc.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Prints the usage message of the tool
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <dir> [options]\n"
+              << "  --pids N          Number of processes to generate (default 10000)\n"
+              << "  --seed S          Seed of the scripted behaviour (default 42)\n"
+              << "  --cpus C          Cores reported in <dir>/stat (default: host cores)\n"
+              << "  --tick T          First tick to write (default 0)\n"
+              << "  --ticks K         Number of ticks to write (default 1)\n"
+              << "  --interval-ms M   Delay between ticks when K > 1 (default 1000)\n"
+              << "  --cgroups G       Spread the processes over G containers, in <dir>-cgroup (default 0)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0)
+    {
+        printUsage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    std::string root = argv[1];
+    SyntheticProcOptions options;
+    long firstTick = 0;
+    long tickCount = 1;
+    long intervalMs = 1000;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        const char* text = argv[++i];
+        char* end = nullptr;
+        errno = 0;
+        long value = std::strtol(text, &end, 10);
+        if (end == text || *end != '\0' || errno != 0)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << text << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (arg == "--pids")
+            options.pidCount = static_cast<int>(value);
+        else if (arg == "--seed")
+            options.seed = static_cast<uint64_t>(value);
+        else if (arg == "--cpus")
+            options.cpuCount = static_cast<int>(value);
+        else if (arg == "--tick")
+            firstTick = value;
+        else if (arg == "--ticks")
+            tickCount = value;
+        else if (arg == "--interval-ms")
+            intervalMs = value;
+        else if (arg == "--cgroups")
+            options.cgroupCount = static_cast<int>(value);
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    options.cgroupRoot = root + "-cgroup";
+    SyntheticProcTree tree(root, options);
+    for (long tick = firstTick; tick < firstTick + tickCount; ++tick)
+    {
+        auto started = std::chrono::steady_clock::now();
+        if (!tree.writeTick(tick))
+        {
+            std::cerr << "Failed to write tick " << tick << " under " << root << "\n";
+            return 1;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        std::cout << "Wrote tick " << tick << " (" << options.pidCount << " PIDs) in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms\n";
+
+        if (tick + 1 < firstTick + tickCount)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        }
+    }
+    return 0;
+}
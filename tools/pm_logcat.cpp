@@ -0,0 +1,142 @@
+/**
+ * @file pm_logcat.cpp
+ *
+ * Decoder of the binary logs written with `--log-format binary`. It prints the messages as the
+ * text log would have shown them, keeping only those at or above a level, inside a time range or
+ * about a process (messages whose `{pid}` placeholder holds that PID).
+ *
+ * Usage:
+ *   pm_logcat [--level <level>] [--since <time>] [--until <time>] [--pid <PID>] <file>...
+ *
+ * Times are local, as `YYYY-MM-DD`, `YYYY-MM-DD HH:MM[:SS]` (or with a `T`), or `@<seconds since
+ * the Unix epoch>`. `--until` is exclusive.
+ */
+
+#include "log_record.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Parses a time argument; returns false if it has none of the accepted forms
+bool parseTime(const std::string& text, int64_t& seconds)
+{
+    if (!text.empty() && text[0] == '@')
+    {
+        char* end = nullptr;
+        seconds = std::strtoll(text.c_str() + 1, &end, 10);
+        return end != text.c_str() + 1 && *end == '\0';
+    }
+    static const char* const formats[] = {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M",
+                                          "%Y-%m-%dT%H:%M", "%Y-%m-%d"};
+    for (const char* format : formats)
+    {
+        std::tm tm{};
+        const char* end = strptime(text.c_str(), format, &tm);
+        if (end != nullptr && *end == '\0')
+        {
+            tm.tm_isdst = -1; // Let mktime() decide
+            seconds = static_cast<int64_t>(std::mktime(&tm));
+            return true;
+        }
+    }
+    return false;
+}
+
+void usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--level <info|warning|error|critical>] [--since <time>] [--until <time>] "
+                 "[--pid <PID>] <file>...\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    LogLevel minLevel = LogLevel::INFO;
+    int64_t since = std::numeric_limits<int64_t>::min();
+    int64_t until = std::numeric_limits<int64_t>::max();
+    int64_t pid = -1;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option.rfind("--", 0) != 0)
+        {
+            files.push_back(option);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        bool valid = false;
+        if (option == "--level")
+            valid = parseLogLevel(value, minLevel);
+        else if (option == "--since")
+            valid = parseTime(value, since);
+        else if (option == "--until")
+            valid = parseTime(value, until);
+        else if (option == "--pid")
+            valid = (pid = std::atoll(value.c_str())) > 0;
+        if (!valid)
+        {
+            std::fprintf(stderr, "Invalid option: %s %s\n", option.c_str(), value.c_str());
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (files.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int status = 0;
+    std::string line;
+    for (const std::string& file : files)
+    {
+        BinaryLogReader reader;
+        std::string error;
+        if (!reader.open(file, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            status = 1;
+            continue;
+        }
+        LogEntry entry;
+        while (reader.next(entry))
+        {
+            if (entry.level < minLevel || entry.time < since || entry.time >= until || (pid > 0 && entry.pid != pid))
+                continue;
+            auto time = static_cast<std::time_t>(entry.time);
+            std::tm tm;
+            localtime_r(&time, &tm);
+            char date[32];
+            size_t length = std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+            line.assign(date, length);
+            line += " [";
+            line += logLevelName(entry.level);
+            line += "] ";
+            line += entry.message;
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), stdout);
+        }
+        if (reader.damaged())
+        {
+            std::fprintf(stderr, "%s: stopped at a damaged or truncated record\n", file.c_str());
+            status = 1;
+        }
+    }
+    return status;
+}
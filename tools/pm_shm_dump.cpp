@@ -0,0 +1,60 @@
+/**
+ * @file pm_shm_dump.cpp
+ *
+ * Example consumer of the shared-memory export, built only on the `pm_shm_reader` library. It
+ * prints the processes of the latest epoch published with `--shm-export <name>`, highest CPU usage
+ * first.
+ *
+ * Usage:
+ *   pm_shm_dump <name> [N]
+ */
+
+#include "shm_snapshot_reader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "Usage: %s <name> [N]\n", argv[0]);
+        return 1;
+    }
+    size_t limit = argc == 3 ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10)) : 20;
+
+    ShmSnapshotReader reader;
+    std::string error;
+    if (!reader.open(argv[1], error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    ShmSnapshotCopy copy;
+    if (!reader.read(copy))
+    {
+        std::fprintf(stderr, "No epoch published yet\n");
+        return 1;
+    }
+
+    const ShmSnapshotView& view = copy.view;
+    std::vector<size_t> order(view.count);
+    std::iota(order.begin(), order.end(), 0);
+    limit = std::min(limit, order.size());
+    std::partial_sort(order.begin(), order.begin() + limit, order.end(),
+                      [&](size_t a, size_t b) { return view.cpu[a] > view.cpu[b]; });
+
+    std::printf("epoch %llu, %zu processes%s\n", static_cast<unsigned long long>(view.epoch), view.count,
+                view.truncated ? " (truncated)" : "");
+    std::printf("%8s %-12s %8s %10s  %s\n", "PID", "USER", "CPU%", "MEM(MB)", "COMMAND");
+    for (size_t i = 0; i < limit; ++i)
+    {
+        size_t row = order[i];
+        std::printf("%8d %-12s %8.2f %10.2f  %s\n", view.pid[row], view.user(row), view.cpu[row], view.memory[row],
+                    view.command(row));
+    }
+    return 0;
+}